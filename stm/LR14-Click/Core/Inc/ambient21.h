@@ -43,6 +43,18 @@ int8_t ambient_Is(I2C_HandleTypeDef *hi2c, int8_t tryInit);
  */
 HAL_StatusTypeDef ambient_Init(I2C_HandleTypeDef *hi2c);
 
+/**
+ * @brief warm boot initialization, sensor has been initialized before MCU reset, only presence is checked
+ * @param gain - the last gain (ambient_GetGain) stored before reset
+ * @retval HAL_OK - sensor is present, HAL_ERROR
+ */
+HAL_StatusTypeDef ambient_InitWarm(I2C_HandleTypeDef *hi2c, uint8_t gain);
+
+/**
+ * @brief the current gain of sensor (auto-ranging), for storing before reset
+ */
+uint8_t ambient_GetGain();
+
 /**
  * @brief check if sensor is turned on or not
  * @param onOff - on output contains 1-on 0-off, but only if status is HAL_OK
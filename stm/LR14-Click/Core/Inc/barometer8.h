@@ -42,6 +42,11 @@ int8_t barometer_Is(I2C_HandleTypeDef *hi2c, int8_t tryInit);
  */
 HAL_StatusTypeDef barometer_Init(I2C_HandleTypeDef *hi2c);
 
+/**
+ * @brief - warm boot initialization, sensor has been initialized before MCU reset, only presence is checked
+ */
+HAL_StatusTypeDef barometer_InitWarm(I2C_HandleTypeDef *hi2c);
+
 /**
  * @brief check if sensor is turned on or not
  * @param onOff - on output contains 1-on 0-off, but only if status is HAL_OK
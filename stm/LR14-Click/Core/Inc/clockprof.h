@@ -0,0 +1,69 @@
+/*
+ * clockprof.h
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * clock profiles: SYSCLK (MSI range) and the voltage scale
+ * - FULL (48 MHz, scale 1) is the default, radio (LoRaMac, SUBGHZ) and crypto run in it,
+ *   the lower profile is refused while the radio is in TX/RX
+ * - the I/O bound work (I2C, flash, conversion waits, logging) is switched to the lower profile by the caller,
+ *   the previous profile is restored by the caller: prev = clockProf_Set(CLOCK_LOW); ... clockProf_Set(prev);
+ * - the timings of the peripherals (I2C TIMINGR, SPI prescaler, UART BRR) are recomputed for the new clock,
+ *   bus rates are kept (max. SPI clock, UART baud rate)
+ * - I2C runs in the lower profiles too, the device speed is capped by the profile (clockProf_I2CMaxHz):
+ *   FULL 1 MHz, MID 400 kHz, LOW 100 kHz - the kernel clock is too slow for the faster modes;
+ *   the speed is capped at the switch and by the caller of I2C_SetSpeed (sensors_Bus)
+ * - the profile is not held across STOP2, SystemClock_Config restores FULL after the wakeup
+ * - energy of the work (model of test_clockprof): LOW saves 70 % of the busy waits against FULL, the bus bursts
+ *   (NFC mailbox, flash) cost the same in MID and FULL and twice as much in LOW (slower I2C, longer pull-up current)
+ */
+
+#ifndef INC_CLOCKPROF_H_
+#define INC_CLOCKPROF_H_
+
+#include "stm32wlxx_hal.h"
+#include "pwrdomain.h"
+
+typedef enum
+{
+	CLOCK_FULL = 0,	// MSI 48 MHz, scale 1
+	CLOCK_MID,		// MSI 16 MHz, scale 2 - faster I2C, flash
+	CLOCK_LOW,		// MSI 4 MHz, scale 2 - slow I/O, waits
+	CLOCK_NBR
+} clockProfile_t;
+
+#define CLOCK_SPI_MAX_HZ	6000000		// max. SPI1 clock (generated prescaler 8 at 48 MHz)
+
+/**
+ * @brief Initialization, FULL profile (SystemClock_Config), the timings of the ready peripherals are computed
+ */
+void clockProf_Init(void);
+
+/**
+ * @brief switch of the profile, the ready peripherals are retimed
+ * @retval previous profile
+ */
+clockProfile_t clockProf_Set(clockProfile_t profile);
+
+/**
+ * @brief current profile
+ */
+clockProfile_t clockProf_Get(void);
+
+/**
+ * @brief max. I2C speed (SCL) of the current profile
+ */
+uint32_t clockProf_I2CMaxHz(void);
+
+/**
+ * @brief timings of the peripheral for the current clock (called by pwrdomain after the initialization)
+ */
+void clockProf_Retime(pwrDomainId_t id);
+
+/**
+ * @brief after STOP2 (PWR_ExitStopMode), SystemClock_Config has set FULL profile
+ */
+void clockProf_OnWake(void);
+
+#endif /* INC_CLOCKPROF_H_ */
@@ -52,6 +52,17 @@ HAL_StatusTypeDef flash_Read(const flashCS_t *s, uint32_t addr, uint8_t *buffer,
  */
 HAL_StatusTypeDef flash_WritePage(const flashCS_t *s, uint32_t addr, const uint8_t *data, uint16_t size);
 
+/**
+ * @brief write buffer to address, the write is split by 256-byte pages
+ * @retval HAL_OK, otherwise error
+ */
+HAL_StatusTypeDef flash_WriteBuffer(const flashCS_t *s, uint32_t addr, uint8_t *buffer, uint32_t size);
+
+/**
+ * @brief erase of the 4 KB sector (bytes are 0xFF)
+ * @retval HAL_OK, otherwise error
+ */
+HAL_StatusTypeDef flash_EraseSector(const flashCS_t *s, uint32_t addr);
 
 
 
@@ -35,7 +35,7 @@ extern "C" {
 extern I2C_HandleTypeDef hi2c2;
 
 /* USER CODE BEGIN Private defines */
-
+#define I2C_SPEED_DEFAULT	100000	// SCL of the devices without the speed profile (standard mode)
 /* USER CODE END Private defines */
 
 void MX_I2C2_Init(void);
@@ -48,10 +48,68 @@ void MX_I2C2_Init(void);
 void MX_I2C2_DeInit(void);
 
 /**
- * @brief Helper for calling of default HAL_I2C_IsDeviceReady, if HAL bus is busy, the restart of Hal is invoked
+ * @brief Helper for calling of default HAL_I2C_IsDeviceReady, if HAL bus is busy, the bus recovery is invoked
  */
 HAL_StatusTypeDef I2C_IsDeviceReadyMT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint32_t Trials, uint32_t Timeout);
 
+/**
+ * @brief I2C bus recovery, SDA held low by the slave is released by up to 9 SCL pulses (GPIO), STOP is issued
+ * and the peripheral is reinitialized (without delay)
+ * @retval HAL_OK, HAL_ERROR - the bus is still stuck
+ */
+HAL_StatusTypeDef I2C_BusRecovery(I2C_HandleTypeDef *hi2c);
+
+/**
+ * @brief count of bus recoveries caused by the device address
+ */
+uint16_t I2C_GetRecoveryCount(uint16_t DevAddress);
+
+/**
+ * @brief SCL frequency of the next transactions (speed profile of the device), TIMINGR is recomputed
+ * for the kernel clock (PCLK1) only if the speed or the clock has been changed
+ * @retval HAL_OK, HAL_ERROR - no TIMINGR for the clock, HAL_BUSY - transfer is running
+ */
+HAL_StatusTypeDef I2C_SetSpeed(I2C_HandleTypeDef *hi2c, uint32_t sclHz);
+
+/**
+ * @brief TIMINGR of the current speed for the kernel clock (after the initialization or the change of the clock)
+ */
+HAL_StatusTypeDef I2C_Retime(I2C_HandleTypeDef *hi2c);
+
+/**
+ * @brief expected SCL frequency of TIMINGR in the peripheral, 0 - generated TIMINGR
+ */
+uint32_t I2C_GetSpeed(I2C_HandleTypeDef *hi2c);
+
+/*
+ * i2cTiming - TIMINGR of the I2C peripheral (PRESC, SCLDEL, SDADEL, SCLH, SCLL) for the kernel clock
+ * The limits of the mode (standard <= 100 kHz, fast <= 400 kHz, fast plus <= 1 MHz) are kept for the rise and fall
+ * times of the bus and the filters (reference manual, I2C timings). The finest prescaler is used,
+ * the bus is slower than requested if the clock is too low for the mode or the bus is too slow (rise time).
+ * Each mode needs min. kernel clock (standard 2 MHz, fast 9 MHz, fast plus 19 MHz), the fastest mode
+ * of the clock is used instead, under 2 MHz there is no setting.
+ */
+typedef struct
+{
+	uint32_t ClkHz;			// I2C kernel clock
+	uint16_t RiseNs;		// rise and fall times of the bus (pull-ups, capacitance)
+	uint16_t FallNs;
+	uint8_t AnalogFilter;	// 1 - analog filter on
+	uint8_t DigitalFilter;	// DNF, 0..15 kernel clocks
+} i2cTimingCfg_t;
+
+/**
+ * @brief TIMINGR for the SCL frequency
+ * @param sclHz - [in] requested SCL frequency, [out] expected SCL frequency, 0 - no setting for the clock
+ * @retval TIMINGR (0 is valid setting, sclHz tells the result)
+ */
+uint32_t i2cTiming_Calc(const i2cTimingCfg_t *cfg, uint32_t *sclHz);
+
+/**
+ * @brief expected SCL frequency of TIMINGR (rise and fall times and the synchronization of SCL are included)
+ */
+uint32_t i2cTiming_SclHz(const i2cTimingCfg_t *cfg, uint32_t timingr);
+
 
 /* USER CODE END Prototypes */
 
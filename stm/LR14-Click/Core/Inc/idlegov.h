@@ -0,0 +1,60 @@
+/*
+ * idlegov.h
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * idle governor: low power mode of the idle time to the next timer deadline (UTIL_SEQ_Idle of sys_app.c)
+ * - STOP2 pays the entry and exit (clocks, peripherals) at run current, the sleep is kept at sleep current
+ * - STOP2 is used when the idle time is over the break-even: overhead * (run - stop) / (sleep - stop)
+ * - the overhead is learned from the measured STOP2 entries/exits (mean, weight 1/8)
+ */
+
+#ifndef INC_IDLEGOV_H_
+#define INC_IDLEGOV_H_
+
+#include <stdint.h>
+
+typedef enum
+{
+	IDLE_AWAKE = 0,	// the deadline is due, no low power
+	IDLE_SLEEP,
+	IDLE_STOP2,
+	IDLE_MODE_NBR
+} idleMode_t;
+
+/**
+ * @brief state and statistics of the governor
+ */
+typedef struct
+{
+	uint32_t OverheadUS;	// learned overhead of STOP2 (us)
+	uint32_t BreakEvenUS;	// STOP2 for the longer idle time
+	uint32_t AwakeUS;		// shorter idle time is not worth of sleep
+	uint16_t RunUA;			// currents (uA)
+	uint16_t SleepUA;
+	uint16_t StopUA;
+	uint32_t Samples;		// measured overheads
+	uint32_t Count[IDLE_MODE_NBR];	// statistics of modes
+} idleGov_t;
+
+/**
+ * @brief Initialization
+ * @param runUA, sleepUA, stopUA - currents of modes
+ * @param overheadUS - expected overhead of STOP2, it is replaced by the first measurement
+ * @param awakeUS - the idle time without sleep
+ */
+void idleGov_Inic(idleGov_t *v, uint16_t runUA, uint16_t sleepUA, uint16_t stopUA, uint32_t overheadUS, uint32_t awakeUS);
+
+/**
+ * @brief mode of the idle time
+ * @param idleUS - time to the next deadline (us), UINT32_MAX - no deadline
+ */
+idleMode_t idleGov_Decide(idleGov_t *v, uint32_t idleUS);
+
+/**
+ * @brief measured overhead of STOP2 (entry + exit), the break-even is updated
+ */
+void idleGov_Learn(idleGov_t *v, uint32_t overheadUS);
+
+#endif /* INC_IDLEGOV_H_ */
@@ -18,6 +18,23 @@
 #include "sps30.h"
 #include "scd41.h"
 
+#define SENS_PAYLOAD_SIZE	(1 + 2 * SENS_CH_NBR)	// max. size of the uplink with values (sensors_GetPayload)
+#define SENS_TS_RESOLUTION	250		// resolution of the record timestamp offset (ms), 16-bit offset = 4.5 hours
+
+// battery governor, the power tiers by the supply voltage (mV)
+#define SENS_GOV_TIER1_MV	2800	// SPS30 off, intervals x2
+#define SENS_GOV_TIER2_MV	2600	// SCD41 off, intervals x4
+#define SENS_GOV_TIER3_MV	2400	// temperature/humidity only, intervals x8
+#define SENS_GOV_HYST_MV	100		// return to the upper tier over EnterMV + hysteresis
+#define SENS_SCD41_MIN_MV	2700	// SCD41 is not started (heating) under this voltage
+
+// per-sensor cadence, the sensor is read in the cycle when its deadline is closer than SENS_COALESCE_MS (one wakeup)
+#define SENS_COALESCE_MS	5000
+#define SENS_WAKEUP_MIN_MS	1000	// min. pause between cycles
+
+// latest readings published as NDEF text in the user EEPROM of NFC4 tag (readable by any phone)
+#define SENS_NDEF_SIZE			160		// NDEF area from address 0 (bytes, multiple of EEPROM block)
+#define SENS_NDEF_INTERVAL_MS	600000	// min. interval between the EEPROM updates (endurance)
 
 /**
  * @brief process of sensor reading
@@ -31,6 +48,45 @@ typedef enum
 	SENS_DONE		// finish process
 } SENS_ProcessDef;
 
+/**
+ * @brief channels of the send-on-delta reporting, values are x100 (as logged)
+ */
+typedef enum
+{
+	SENS_CH_TEMP = 0,	// temperature (x100 °C)
+	SENS_CH_HUM,		// relative humidity (x100 %)
+	SENS_CH_PRESSURE,	// pressure (x100)
+	SENS_CH_LUX,		// ambient light (x100 lux)
+	SENS_CH_CO2,		// CO2 (ppm)
+	SENS_CH_PM25,		// PM2.5 mass (x100 ug/m3)
+	SENS_CH_BAT,		// battery (%)
+	SENS_CH_NBR
+} SENS_ChannelDef;
+
+/**
+ * @brief summary of the channel over one reading cycle
+ */
+typedef struct
+{
+	int32_t min;
+	int32_t max;
+	int32_t mean;
+	int32_t stdDev;
+	uint16_t count;		// accepted samples
+	uint16_t rejected;	// rejected samples (outliers)
+} sensStat_t;
+
+/**
+ * @brief configuration of reading, it can be changed remotely (lora_config.c)
+ */
+typedef struct
+{
+	uint32_t interval;		// interval of reading cycles (ms), own timer only (not coordinated)
+	uint16_t readPause;		// pause between readings in cycle (ms)
+	uint8_t readingMax;		// max. readings in cycle
+	uint8_t enabled;		// enabled sensors, bitmap: 0 - tempHum, 1 - ambient, 2 - barometer, 3 - scd41, 4 - sps30
+} sensConfig_t;
+
 
 
 
@@ -48,6 +104,59 @@ void sensors_Init(I2C_HandleTypeDef* hi2c);
  */
 void sensorsSeq_Init(uint32_t sensortAppBit);
 
+/**
+ * @brief reading is coordinated with the uplink (just-in-time sensing)
+ * - the own periodic timer is not used, reading is started via sensors_StartAt
+ * - sensors_OnReadDone is called when data are ready
+ * @param onOff - 1 coordinated, 0 periodic reading every _sensorTimeout
+ */
+void sensors_SetCoordinated(uint8_t onOff);
+
+/**
+ * @brief current configuration of reading
+ */
+void sensors_GetConfig(sensConfig_t *cfg);
+
+/**
+ * @brief new configuration of reading, applied without reboot (the reading timer is rescheduled)
+ * @retval HAL_OK, HAL_ERROR - value out of range (nothing is changed)
+ */
+HAL_StatusTypeDef sensors_SetConfig(const sensConfig_t *cfg);
+
+/**
+ * @brief the effective interval of reading (ms), the configured interval stretched by the power tier
+ * Each sensor is read every interval x own cadence (registry in mysensors.c).
+ */
+uint32_t sensors_GetInterval();
+
+/**
+ * @brief battery governor, the power tier by the battery voltage (called at the start of the reading cycle)
+ * Sensors of the cycle are enabled by the configuration and the tier, the change of tier is reported via sensors_OnPowerTier
+ * @param mV - battery voltage, 0 - not measured (nothing is changed)
+ */
+void sensors_Govern(uint16_t mV);
+
+/**
+ * @brief the time (ms) from the start of reading to the data ready (I2C on, sensors warm-up, readings)
+ */
+uint32_t sensors_GetCycleTime();
+
+/**
+ * @brief start of reading after delay, 0 - start now
+ */
+void sensors_StartAt(uint32_t delayMS);
+
+/**
+ * @brief callback, reading has been finished in coordinated mode (weak, overridden by coordinator)
+ */
+void sensors_OnReadDone();
+
+/**
+ * @brief callback, the power tier has been changed (weak, overridden by coordinator)
+ * @param scale - the multiplier of the intervals (1 - full battery)
+ */
+void sensors_OnPowerTier(uint8_t scale);
+
 
 /**
  * @brief The interrupt of NFC4 tag
@@ -66,18 +175,63 @@ void sensors_NFCInt();
  */
 
 /**
- * @brief possible to I2C turn on/off
+ * @brief possible to I2C turn on/off (power domain, the peripheral is gated before STOP2 when it is not used)
  */
 void i2c_OnOff(uint8_t onOff);
 
 /**
- * @brief sensors On/Off
+ * @brief possible to SPI (flash) turn on/off (power domain)
+ */
+void spi_OnOff(uint8_t onOff);
+
+/**
+ * @brief sensors On/Off, on - the sensors due in the current cycle
  */
 void sensors_OnOff(int8_t onOff);
 
 /**
- * @brief reading sensor one by one
+ * @brief reading sensors of the current cycle one by one
  */
 void sensors_Read();
 
+/**
+ * @brief statistics (min/max/mean/stddev) of the channel from the last reading cycle
+ * @retval HAL_OK, HAL_ERROR - channel doesn't exist or has no data
+ */
+HAL_StatusTypeDef sensors_GetStat(SENS_ChannelDef ch, sensStat_t *stat);
+
+/**
+ * @brief timestamp of the last record (reading cycle), the batch is started after each report
+ * @param base - [out] base time of the batch (unix epoch, s, SysTime)
+ * @param offset - [out] offset of the record from the base (x SENS_TS_RESOLUTION ms)
+ * @retval HAL_OK, HAL_ERROR - no record yet
+ */
+HAL_StatusTypeDef sensors_GetTimestamp(uint32_t *base, uint16_t *offset);
+
+/**
+ * @brief cached presence of devices (bitmap), the absent devices are re-initialized with exponential backoff
+ */
+uint16_t sensors_GetPresence();
+
+/**
+ * @brief send-on-delta, any channel is out of its deadband or heartbeat has been elapsed
+ * @retval 1 - the uplink with values is required, 0 - nothing changed
+ */
+int8_t sensors_IsReport();
+
+/**
+ * @brief uplink with the current values (big endian), only the channels with the value are included
+ * 	[0] - bitmap of channels (SENS_ChannelDef), then 16-bit field per present channel:
+ * 	temperature int16 x100 °C, humidity x100 %, pressure x10 hPa, light lux, CO2 ppm, PM2.5 x10 ug/m3, battery %
+ * 	the values out of the range are saturated
+ * @param size - size of buffer, min. SENS_PAYLOAD_SIZE
+ * @retval length of the payload, 0 - small buffer
+ */
+uint8_t sensors_GetPayload(uint8_t *buffer, uint8_t size);
+
+/**
+ * @brief current values have been sent, the deadbands are compared against them now
+ */
+void sensors_Reported();
+
 #endif /* INC_MYSENSORS_H_ */
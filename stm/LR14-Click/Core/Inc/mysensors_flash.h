@@ -0,0 +1,61 @@
+/*
+ * mysensors_flash.h
+ *
+ *  Created on: 15. 1. 2026
+ *      Author: Milan
+ *
+ * history of the measure data in FLASH12 (ring of records)
+ * - one record per reading cycle: sequence number, time and the means of channels
+ * - the ring is made of 4 KB sectors, the oldest sector is erased before it is overwritten
+ * - the head is found by the scan of the sector heads at boot, no index is stored
+ */
+
+#ifndef INC_MYSENSORS_FLASH_H_
+#define INC_MYSENSORS_FLASH_H_
+
+#include "stm32wlxx_hal.h"
+#include "flash12.h"
+#include "mysensors.h"
+
+#define SFLASH_START		0x1000		// first sector of the history, sector 0 is reserved
+#define SFLASH_END			0x80000		// end of the flash (512 KB)
+#define SFLASH_SECTOR		4096		// erase unit
+#define SFLASH_NO_VALUE		INT32_MIN	// the channel has no data in the cycle
+
+/**
+ * @brief record of the reading cycle, erased flash (seq 0xFFFFFFFF) is empty slot
+ */
+typedef struct
+{
+	uint32_t seq;					// sequence number of the record, from 0
+	uint32_t time;					// start of the reading cycle (epoch, s)
+	int32_t value[SENS_CH_NBR];		// means of channels (x100 as reported), SFLASH_NO_VALUE - no data
+} sensRecord_t;
+
+#define SFLASH_RECORDS_PER_SECTOR	(SFLASH_SECTOR / sizeof(sensRecord_t))
+#define SFLASH_SECTORS				((SFLASH_END - SFLASH_START) / SFLASH_SECTOR)
+
+/**
+ * @brief Initialization of the history, the head of the ring is found
+ * @retval HAL_OK, HAL_ERROR - flash is not present
+ */
+HAL_StatusTypeDef sensorsFlash_Init(const flashCS_t *flash);
+
+/**
+ * @brief the record is appended, the sector is erased when the record is the first one in the sector
+ * @param values - SENS_CH_NBR values
+ */
+HAL_StatusTypeDef sensorsFlash_Append(uint32_t time, const int32_t *values);
+
+/**
+ * @brief the range of readable records [first, next)
+ */
+void sensorsFlash_GetRange(uint32_t *first, uint32_t *next);
+
+/**
+ * @brief reading of the record
+ * @retval HAL_OK, HAL_ERROR - the record is out of range or damaged
+ */
+HAL_StatusTypeDef sensorsFlash_Read(uint32_t seq, sensRecord_t *rec);
+
+#endif /* INC_MYSENSORS_FLASH_H_ */
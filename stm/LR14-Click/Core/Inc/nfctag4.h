@@ -5,16 +5,13 @@
  *      Author: Milan
  *
  *  NFC 4 tag click,  ST25R3916.pdf  https://download.mikroe.com/documents/datasheets/ST25R3916%20Datasheet.pdf
- *  nfc - write and read via EEPROM, via mail box it doesn't work, so for now it makes no sense to activate via INT to avoid unnecessary consumption
+ *  nfc - write and read via EEPROM, fast transfer mode via 256-byte mailbox
  *  password default is 8x 0h
  *
- *  EEPROM works....
- *
- *
- *  but MailBox doesn't work - I can't read and write to MailBox.
- *  I tried it via ChatGPT and Gemini, but couldn't transfer data, so it probably makes no sense. RF is static anyway
- *
- *  It's not entirely clear yet how it will work
+ *  Mailbox (fast transfer mode):
+ *  - MB_MODE (static) is written once in the I2C security session (the password 0x0900 is [PWD] 0x09 [PWD]), the dynamic registers are at 0x2000
+ *  - GPO (INT) signals the events RF_PUT_MSG, RF_GET_MSG and FIELD_CHANGE, it is processed by nfc4_ProcessMailBox
+ *  - the message of host is written only when the mailbox is free (no HOST_PUT_MSG and RF_PUT_MSG)
  *
  */
 
@@ -36,16 +33,41 @@ int8_t nfc4_Is(I2C_HandleTypeDef *hi2c, int8_t tryInit);
  */
 HAL_StatusTypeDef nfc4_Init(I2C_HandleTypeDef *hi2c);
 
+/**
+ * @brief warm boot initialization, tag has been initialized before MCU reset, only presence is checked
+ */
+HAL_StatusTypeDef nfc4_InitWarm(I2C_HandleTypeDef *hi2c);
+
 /**
  * @bried Reset celej EEPROM
  */
 void nfc4_ResetEEPROM(I2C_HandleTypeDef *hi2c, uint16_t len);
 
 /**
- * @brief Write to address
+ * @brief Write to address, sequential writes within 256-byte pages, the programming is ACK polled
  */
 HAL_StatusTypeDef nfc4_WriteEEPROM(I2C_HandleTypeDef *hi2c, uint16_t addr, uint8_t *pData, uint16_t len);
 
+/**
+ * @brief Fill of EEPROM area with the value (erase), page by page
+ */
+HAL_StatusTypeDef nfc4_FillEEPROM(I2C_HandleTypeDef *hi2c, uint16_t addr, uint8_t value, uint16_t len);
+
+/**
+ * @brief Update of EEPROM area, only the blocks different from the shadow copy are written
+ * @param image - new content, shadow - [in/out] content of EEPROM, updated by the written blocks
+ * @param written - [out] count of written bytes, can be NULL
+ */
+HAL_StatusTypeDef nfc4_UpdateEEPROM(I2C_HandleTypeDef *hi2c, uint16_t addr, const uint8_t *image, uint8_t *shadow, uint16_t len, uint16_t *written);
+
+/**
+ * @brief NDEF image of the user EEPROM from address 0: Capability Container, NDEF TLV with one text record, terminator
+ * the rest of image is cleared
+ * @param size - size of image, the text must fit (size - 14 bytes)
+ * @retval used length, 0 - the text is too long
+ */
+uint16_t nfc4_BuildNDEFText(uint8_t *image, uint16_t size, const char *text);
+
 /**
  * @brief Read from EEPROM
  */
@@ -57,8 +79,7 @@ HAL_StatusTypeDef nfc4_ReadEEPROM(I2C_HandleTypeDef *hi2c, uint16_t addr, uint8_
 HAL_StatusTypeDef nfc4_IsOn(I2C_HandleTypeDef *hi2c, uint8_t *onOff);
 
 /**
- * @brief Turn on sensor for sending INT that NFC was activated. Increases consumption. Not necessary, reads via EEPROM anyway
- * I don't see why this would make sense
+ * @brief Turn on GPO (INT) for the mailbox events (NFC4_GPO_CONFIG)
  */
 HAL_StatusTypeDef nfc4_On(I2C_HandleTypeDef *hi2c);
 
@@ -68,16 +89,42 @@ HAL_StatusTypeDef nfc4_On(I2C_HandleTypeDef *hi2c);
 HAL_StatusTypeDef nfc4_Off(I2C_HandleTypeDef *hi2c);
 
 
-/*
- * MailBox doesn't work.... so giving up on these....
+#define NFC4_MAILBOX_SIZE	256		// fast transfer mailbox (bytes)
+
+/**
+ * @brief fast transfer mode is enabled (nfc4_Init)
  */
+int8_t nfc4_IsMailbox();
 
+/**
+ * @brief processing of GPO interrupt: field change, our message has been read, message from RF
+ * calls nfc4_OnFieldChange, nfc4_OnMailboxRead and nfc4_OnMailboxData
+ */
 HAL_StatusTypeDef nfc4_ProcessMailBox(I2C_HandleTypeDef *hi2c);
-HAL_StatusTypeDef nfc4_WriteMailBoxNDEF(I2C_HandleTypeDef *hi2c, char *text);
+
+/**
+ * @brief message to the mailbox for RF reader
+ * @param len - 1 .. NFC4_MAILBOX_SIZE
+ * @retval HAL_OK, HAL_BUSY - the mailbox is not free (previous message has not been read yet or RF message is waiting)
+ */
+HAL_StatusTypeDef nfc4_WriteMailbox(I2C_HandleTypeDef *hi2c, const uint8_t *data, uint16_t len);
+
 HAL_StatusTypeDef nfc4_SetRFMgmt(I2C_HandleTypeDef *hi2c, uint8_t enable);
 
-// Weak callback for main.c
-__weak void nfc4_OnMailboxData(uint8_t *data, uint16_t len);
+/**
+ * @brief message from RF reader (weak), the mailbox is freed by reading
+ */
+void nfc4_OnMailboxData(uint8_t *data, uint16_t len);
+
+/**
+ * @brief the message of host has been read by RF reader (weak), next message can be written
+ */
+void nfc4_OnMailboxRead();
+
+/**
+ * @brief RF field has risen (1) or fallen (0) (weak)
+ */
+void nfc4_OnFieldChange(uint8_t onOff);
 
 
 
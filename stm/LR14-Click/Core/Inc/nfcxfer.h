@@ -0,0 +1,113 @@
+/*
+ * nfcxfer.h
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * download of the measure history by NFC phone via the mailbox of NFC4 tag (fast transfer mode)
+ *
+ * message: [code][tag][payload], multi-byte values are little endian, tag is copied from the request to the response
+ * requests (phone -> tag):
+ *   INFO    0x01                      -> 0x81 [first u32][next u32][record size u8][records per frame u8]
+ *   GET     0x02 [from u32][count u16] -> DATA frames, count 0xFFFF - up to the last record
+ *   RESUME  0x03 [from u32]           -> DATA frames of the running download from the record 'from'
+ *   STOP    0x04                      -> 0x84
+ * DATA 0x82 [from u32][count u8][records], count 0 - end of download
+ * ERROR 0xFF [error u8]
+ *
+ * flow control: the next frame is written when the previous one has been read by the phone (RF_GET_MSG),
+ * the field loss pauses the download, the phone continues by RESUME with the next record it needs
+ * the download without any event for NFCX_TIMEOUT_MS is ended (the phone is gone, the frame has been released
+ * by MB_WDG of the tag and RF_GET_MSG never comes), RESUME is answered by NFCX_ERR_STATE
+ */
+
+#ifndef INC_NFCXFER_H_
+#define INC_NFCXFER_H_
+
+#include "stm32wlxx_hal.h"
+
+#define NFCX_CMD_INFO		0x01
+#define NFCX_CMD_GET		0x02
+#define NFCX_CMD_RESUME		0x03
+#define NFCX_CMD_STOP		0x04
+#define NFCX_RESPONSE		0x80	// response = request | NFCX_RESPONSE
+#define NFCX_DATA			(NFCX_CMD_GET | NFCX_RESPONSE)
+#define NFCX_ERROR			0xFF
+
+#define NFCX_ERR_CMD		0x01	// unknown request
+#define NFCX_ERR_LEN		0x02	// short request
+#define NFCX_ERR_RANGE		0x03	// no records in the range
+#define NFCX_ERR_STATE		0x04	// no download to resume
+#define NFCX_ERR_READ		0x05	// history read error
+
+#define NFCX_HEADER			2		// code, tag
+#define NFCX_DATA_HEADER	(NFCX_HEADER + 5)
+#define NFCX_FRAME_MAX		256		// mailbox size
+#define NFCX_TIMEOUT_MS		60000	// max. time between the events of the download
+
+/**
+ * @brief the access to the mailbox and the history
+ */
+typedef struct
+{
+	HAL_StatusTypeDef (*put)(const uint8_t *data, uint16_t len);		// message to mailbox, HAL_BUSY - mailbox is not free
+	void (*range)(uint32_t *first, uint32_t *next);						// readable records [first, next)
+	HAL_StatusTypeDef (*read)(uint32_t seq, uint8_t *record);			// record of recSize bytes
+	uint8_t recSize;
+} nfcXferIO_t;
+
+typedef enum
+{
+	NFCX_IDLE = 0,
+	NFCX_STREAM,	// DATA frame is in the mailbox, waiting for the read by phone
+	NFCX_PAUSED		// field lost during download, waiting for RESUME
+} nfcXferState_t;
+
+typedef struct
+{
+	const nfcXferIO_t *io;
+	nfcXferState_t State;
+	uint8_t Tag;			// tag of the download request
+	uint8_t Field;			// RF field is present
+	uint8_t Chunk;			// records of the frame in the mailbox
+	uint8_t Waiting;		// the response could not be written (mailbox busy), it is written on the next event
+	uint32_t Cursor;		// first record of the frame in the mailbox
+	uint32_t End;			// end of download (record after the last one)
+	uint32_t EventTick;		// time of the last event of the download (ms)
+	uint32_t Frames;		// statistics: DATA frames written, frames written again (RESUME), downloads timed out
+	uint32_t Resent;
+	uint32_t Timeouts;
+} nfcXfer_t;
+
+/**
+ * @brief Initialization of the transfer
+ */
+void nfcXfer_Inic(nfcXfer_t *x, const nfcXferIO_t *io);
+
+/**
+ * @brief records per DATA frame
+ */
+uint8_t nfcXfer_PerFrame(const nfcXfer_t *x);
+
+/**
+ * @brief request from phone (message from mailbox)
+ */
+void nfcXfer_OnData(nfcXfer_t *x, const uint8_t *data, uint16_t len);
+
+/**
+ * @brief the message in the mailbox has been read by phone, next frame is written
+ */
+void nfcXfer_OnRead(nfcXfer_t *x);
+
+/**
+ * @brief RF field change, the field loss pauses the download
+ */
+void nfcXfer_OnField(nfcXfer_t *x, uint8_t onOff);
+
+/**
+ * @brief the download without any event for NFCX_TIMEOUT_MS is ended (called periodically)
+ * @retval 1 - the download has been ended
+ */
+uint8_t nfcXfer_CheckTimeout(nfcXfer_t *x);
+
+#endif /* INC_NFCXFER_H_ */
@@ -0,0 +1,76 @@
+/*
+ * pwrdomain.h
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * reference counted power domains of the peripherals not retained in STOP2 (I2C2, SPI1, USART1, ADC)
+ * - the peripheral is initialized by the first pwrDomain_Acquire after the wakeup (lazy), not by every wakeup
+ * - pwrDomain_Release only decrements the count, the unused peripherals are gated before STOP2 (pwrDomain_OnStop),
+ *   so more uses within one wakeup initialize the peripheral once
+ * - the domain held across STOP2 (count > 0) is initialized again right after the wakeup (pwrDomain_OnWake)
+ * - Acquire/Release can be called from interrupt (UART DMA)
+ */
+
+#ifndef INC_PWRDOMAIN_H_
+#define INC_PWRDOMAIN_H_
+
+#include "stm32wlxx_hal.h"
+
+typedef enum
+{
+	PWR_DOMAIN_I2C2 = 0,	// sensors, NFC tag
+	PWR_DOMAIN_SPI1,		// flash
+	PWR_DOMAIN_USART1,		// log, console
+	PWR_DOMAIN_ADC,			// battery, temperature
+	PWR_DOMAIN_NBR
+} pwrDomainId_t;
+
+/**
+ * @brief state and statistics of the domain
+ */
+typedef struct
+{
+	uint8_t Refs;		// count of users
+	uint8_t Ready;		// the peripheral is initialized
+	uint32_t Inits;		// count of initializations and gatings since boot
+	uint32_t DeInits;
+} pwrDomain_t;
+
+/**
+ * @brief Initialization of the domains
+ * @param readyMask - domains initialized by main (bitmap of pwrDomainId_t), they are gated by the first STOP2
+ */
+void pwrDomain_Init(uint32_t readyMask);
+
+/**
+ * @brief the peripheral is used, it is initialized if it is not ready
+ */
+void pwrDomain_Acquire(pwrDomainId_t id);
+
+/**
+ * @brief the peripheral is not used, it is gated before STOP2 when no user holds it
+ */
+void pwrDomain_Release(pwrDomainId_t id);
+
+/**
+ * @brief before STOP2 (PWR_EnterStopMode): unused peripherals are gated, held ones are marked to re-init
+ */
+void pwrDomain_OnStop(void);
+
+/**
+ * @brief after STOP2 (PWR_ExitStopMode): the held peripherals are initialized again, others on the first use
+ */
+void pwrDomain_OnWake(void);
+
+/**
+ * @brief state and statistics of the domain
+ */
+const pwrDomain_t* pwrDomain_Get(pwrDomainId_t id);
+
+/**
+ * @brief callback, the peripheral has been initialized (weak), e.g. UART receiving is started again
+ */
+void pwrDomain_OnReady(pwrDomainId_t id);
+
+#endif /* INC_PWRDOMAIN_H_ */
@@ -48,6 +48,12 @@ int8_t scd41_Is(I2C_HandleTypeDef *hi2c, int8_t tryInit);
  */
 HAL_StatusTypeDef scd41_Init(I2C_HandleTypeDef *hi2c);
 
+/**
+ * @brief warm boot initialization, sensor has been initialized before MCU reset, only presence is checked
+ * @retval HAL_OK - sensor is present, HAL_ERROR - error
+ */
+HAL_StatusTypeDef scd41_InitWarm(I2C_HandleTypeDef *hi2c);
+
 /**
  * @brief start reading - turn on sensor, reading mode can be:
  * SCD41_CMD_START_PERIODIC - every 5s - this is probably most accurate
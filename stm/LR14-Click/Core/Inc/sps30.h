@@ -99,6 +99,12 @@ int8_t sps30_Is(I2C_HandleTypeDef *hi2c, int8_t tryInit);
  */
 HAL_StatusTypeDef sps30_Init(I2C_HandleTypeDef *hi2c);
 
+/**
+ * @brief warm boot initialization, sensor has been initialized (sleeping) before MCU reset
+ * @retval HAL_OK
+ */
+HAL_StatusTypeDef sps30_InitWarm(I2C_HandleTypeDef *hi2c);
+
 /**
  * @brief Turn on laser and fan to allow measurements
  * @retval HAL_OK, HAL_ERROR
@@ -106,6 +106,11 @@ void GetUniqueId(uint8_t *id);
 void GetDevAddr(uint32_t *devAddr);
 
 /* USER CODE BEGIN EFP */
+/**
+  * @brief  measured overhead of STOP2 (entry + exit), it is learned by the idle governor
+  * @param  cycles CPU cycles of the entry and the exit (without the wakeup of regulator)
+  */
+void SYS_IdleLearn(uint32_t cycles);
 
 /* USER CODE END EFP */
 
@@ -0,0 +1,52 @@
+/*
+ * timesync.h
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * time synchronization from the network (DeviceTimeReq/Ans) with RTC drift calibration
+ * - the drift is estimated from successive corrections against the elapsed RTC time
+ * - the drift is compensated by RTC smooth calibration (CALR), resolution 0.95 ppm
+ * - the sync interval is lengthened as the residual drift falls (1 h .. 7 days)
+ */
+
+#ifndef INC_TIMESYNC_H_
+#define INC_TIMESYNC_H_
+
+#include "stm32wlxx_hal.h"
+
+/**
+ * @brief Initialization of the time sync, the sequencer task and timer of next sync
+ * @param taskId - id of the sequencer task for the sync request (CFG_SEQ_Task_xxx)
+ */
+void timeSync_Init(uint32_t taskId);
+
+/**
+ * @brief the time sync request (DeviceTimeReq), it is sent with the next uplink
+ * @retval HAL_OK, HAL_ERROR - the request is not accepted (not joined)
+ */
+HAL_StatusTypeDef timeSync_Request(void);
+
+/**
+ * @brief the time was updated by the network (OnSysTimeUpdate), the drift is estimated and calibrated
+ */
+void timeSync_OnUpdate(void);
+
+/**
+ * @brief the estimated drift of RTC (ppm x 100), + the RTC is slow
+ */
+int32_t timeSync_GetDrift(void);
+
+/**
+ * @brief current time for the timestamps of records (SysTime, unix epoch)
+ * @param ms - [out] milliseconds, can be NULL
+ * @retval seconds of the epoch
+ */
+uint32_t timeSync_Now(uint16_t *ms);
+
+/**
+ * @brief the time was set by the network (after the power-on the SysTime starts from 0)
+ */
+int8_t timeSync_IsValid(void);
+
+#endif /* INC_TIMESYNC_H_ */
@@ -0,0 +1,152 @@
+/*
+ * trace.h
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * event trace: begin/end of sequencer tasks, LPM, radio TX/RX, I2C/SPI transfers and reading of sensors
+ * - the events are stored to the ring in RAM (TRACE_SIZE), the oldest ones are overwritten
+ * - the time is the cycle counter (DWT), it is tied to RTC after STOP2 and to the clock after the switch
+ *   of the clock profile
+ * - console command "trace" dumps the ring to UART, tools/trace2json.py converts the dump to Chrome/Perfetto JSON
+ * - traceRing_t is the ring alone (the time of the caller, no HAL), tested on the host (test_trace)
+ * - the header is included by utilities_conf.h (sequencer hooks), only stdint is used here
+ */
+
+#ifndef INC_TRACE_H_
+#define INC_TRACE_H_
+
+#include <stdint.h>
+
+#ifndef TRACE_EVENTS
+#define TRACE_EVENTS	1		// 0 - the calls are removed
+#endif
+#define TRACE_SIZE		256		// count of events in the ring (power of 2), 8 B per event
+
+// activities, the names are in tools/trace2json.py
+typedef enum
+{
+	TRACE_TASK = 0,		// sequencer task, arg - CFG_SEQ_Task_Id_t
+	TRACE_STOP2,		// low power modes
+	TRACE_SLEEP,
+	TRACE_RADIO_TX,
+	TRACE_RADIO_RX,
+	TRACE_I2C,			// operation of the device, arg - sensId_t, SENS_DEV_xxx
+	TRACE_SPI,			// flash
+	TRACE_SENSOR,		// sensor is reading in the cycle, arg - sensId_t
+	TRACE_ID_NBR
+} traceId_t;
+
+/*
+ * traceRing - ring of timestamped events (begin/end of the activity), the oldest events are overwritten
+ * The time is a free running counter of the caller (core cycles), it is tied to the real time by
+ * SYNC + RTC events and to the clock by SYNC and CLOCK events. The caller serializes traceRing_Put (interrupts).
+ * Dump line: "TRC " + events as hex TTTTTTTTIIIIYYAA (time, id, type, arg), converted by tools/trace2json.py.
+ */
+typedef enum
+{
+	TRACE_EV_BEGIN = 0,	// activity Id (Arg) begins
+	TRACE_EV_END,		// activity Id (Arg) ends
+	TRACE_EV_INSTANT,	// point event
+	TRACE_EV_SYNC,		// Id - clock (kHz), the next event RTC has the real time of this one
+	TRACE_EV_RTC,		// Time - RTC ticks of SYNC
+	TRACE_EV_CLOCK		// Id - new clock (kHz), the time is rebased
+} traceType_t;
+
+typedef struct
+{
+	uint32_t Time;		// counter of the caller
+	uint16_t Id;		// activity, clock (SYNC, CLOCK)
+	uint8_t Type;		// traceType_t
+	uint8_t Arg;		// instance of the activity (task, device)
+} traceEvent_t;
+
+typedef struct
+{
+	traceEvent_t *Events;
+	uint32_t Mask;		// size - 1, the size is power of 2
+	uint32_t Head;		// count of events since the initialization
+} traceRing_t;
+
+#define TRACE_LINE_EVENTS	8	// events per dump line
+#define TRACE_LINE_SIZE		(4 + TRACE_LINE_EVENTS * 17 + 3)
+
+#if TRACE_EVENTS
+#define TRACE_BEGIN(id, arg)	trace_Event((id), TRACE_EV_BEGIN, (arg))
+#define TRACE_END(id, arg)		trace_Event((id), TRACE_EV_END, (arg))
+#define TRACE_INSTANT(id, arg)	trace_Event((id), TRACE_EV_INSTANT, (arg))
+#else
+#define TRACE_BEGIN(id, arg)
+#define TRACE_END(id, arg)
+#define TRACE_INSTANT(id, arg)
+#endif
+
+/**
+ * @brief Initialization of the ring
+ * @param size - count of events, power of 2
+ */
+void traceRing_Inic(traceRing_t *r, traceEvent_t *events, uint32_t size);
+
+/**
+ * @brief the event is stored, the oldest one is overwritten in the full ring
+ */
+void traceRing_Put(traceRing_t *r, uint32_t time, uint16_t id, uint8_t type, uint8_t arg);
+
+/**
+ * @brief count of events in the ring
+ */
+uint32_t traceRing_Count(const traceRing_t *r);
+
+/**
+ * @brief count of overwritten events
+ */
+uint32_t traceRing_Lost(const traceRing_t *r);
+
+/**
+ * @brief i-th event in the ring, 0 - the oldest one
+ */
+const traceEvent_t* traceRing_Get(const traceRing_t *r, uint32_t i);
+
+/**
+ * @brief dump line of events from i-th one (max. TRACE_LINE_EVENTS), "TRC ...\r\n"
+ * @param line - buffer of TRACE_LINE_SIZE
+ * @retval count of events in the line, 0 - end of the ring
+ */
+uint32_t traceRing_Line(const traceRing_t *r, uint32_t i, char *line);
+
+/**
+ * @brief Initialization, the ring is cleared, the time is synchronized (cycle counter must run)
+ */
+void trace_Init(void);
+
+/**
+ * @brief event is stored (traceType_t), callable from interrupt
+ */
+void trace_Event(uint16_t id, uint8_t type, uint8_t arg);
+
+/**
+ * @brief the time of cycle counter is tied to RTC (after STOP2)
+ */
+void trace_Sync(void);
+
+/**
+ * @brief the clock (SystemCoreClock) has been changed
+ */
+void trace_Clock(void);
+
+/**
+ * @brief dump of the ring to UART, the tracing is paused during the dump
+ */
+void trace_Dump(void);
+
+/**
+ * @brief the ring is cleared
+ */
+void trace_Clear(void);
+
+/**
+ * @brief cycles of one trace_Event (measured by the cycle counter)
+ */
+uint32_t trace_Bench(void);
+
+#endif /* INC_TRACE_H_ */
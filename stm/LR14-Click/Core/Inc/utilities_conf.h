@@ -37,7 +37,7 @@ extern "C" {
 /* enum number of task and priority*/
 #include "utilities_def.h"
 /* USER CODE BEGIN Includes */
-
+#include "trace.h"
 /* USER CODE END Includes */
 
 /* Exported types ------------------------------------------------------------*/
@@ -162,7 +162,11 @@ extern "C" {
 #define UTIL_ADV_TRACE_VSNPRINTF(...)              tiny_vsnprintf_like(__VA_ARGS__)      /*!< vsnprintf utilities interface to trace feature */
 
 /* USER CODE BEGIN EM */
-
+/**
+  * @brief event trace of the sequencer tasks (trace.h)
+  */
+#define UTIL_SEQ_TASK_BEGIN( id )   TRACE_BEGIN(TRACE_TASK, (id))
+#define UTIL_SEQ_TASK_END( id )     TRACE_END(TRACE_TASK, (id))
 /* USER CODE END EM */
 
 /* Exported functions prototypes ---------------------------------------------*/
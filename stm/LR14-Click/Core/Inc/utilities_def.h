@@ -48,6 +48,7 @@ typedef enum
   CFG_LPM_APPLI_Id,
   CFG_LPM_UART_TX_Id,
   /* USER CODE BEGIN CFG_LPM_Id_t */
+  CFG_LPM_IDLE_Id,    /* idle governor, sleep instead of STOP2 for the short idle time */
 
   /* USER CODE END CFG_LPM_Id_t */
 } CFG_LPM_Id_t;
@@ -83,6 +84,8 @@ typedef enum
   CFG_SEQ_Task_Sensors,			// MT 13.1.2026
   CFG_SEQ_Task_Uart_RX,			// MT 14.1.2026 UART data receive ready
   CFG_SEQ_Task_NFC_INT,			// interrupt from NFC
+  CFG_SEQ_Task_LoRaJoinRetry,	// next attempt of the join (lora_join.c)
+  CFG_SEQ_Task_TimeSync,		// time sync request (timesync.c)
 
   /* USER CODE END CFG_SEQ_Task_Id_t */
   CFG_SEQ_Task_NBR
@@ -23,7 +23,7 @@
 #include "sys_app.h"
 
 /* USER CODE BEGIN Includes */
-
+#include "pwrdomain.h"
 /* USER CODE END Includes */
 
 /* External variables ---------------------------------------------------------*/
@@ -45,7 +45,9 @@ extern ADC_HandleTypeDef hadc;
 #define TEMPSENSOR_TYP_AVGSLOPE        (( int32_t) 2500)        /*!< Internal temperature sensor, parameter Avg_Slope (unit: uV/DegCelsius). Refer to device datasheet for min/typ/max values. */
 
 /* USER CODE BEGIN PD */
-
+#define ADC_MEASURE_VALIDITY_MS        1000U                    /*!< the cached VDDA and temperature are served within this window */
+#define ADC_CALIB_PERIOD_MS            (24U * 3600U * 1000U)    /*!< the calibration is repeated (drift of the offset with temperature) */
+#define ADC_CONV_TIMEOUT_MS            10U                      /*!< timeout of one oversampled conversion (16 x 160.5 cycles at 4 MHz = 0.7 ms) */
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -56,7 +58,20 @@ extern ADC_HandleTypeDef hadc;
 /* Private variables ---------------------------------------------------------*/
 
 /* USER CODE BEGIN PV */
+/**
+  * @brief calibration factor, kept across ADC_DeInit (the factor is lost with the ADC regulator)
+  */
+static uint32_t AdcCalibFactor = 0;
+static uint32_t AdcCalibTick = 0;
+static uint8_t AdcCalibValid = 0;
 
+/**
+  * @brief the last scan of VREFINT and TEMPSENSOR
+  */
+static uint32_t AdcMeasureTick = 0;
+static uint8_t AdcMeasureValid = 0;
+static uint16_t AdcVddaMv = 0;
+static int16_t AdcTemperature = 0;
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -68,7 +83,22 @@ extern ADC_HandleTypeDef hadc;
 static uint32_t ADC_ReadChannels(uint32_t channel);
 
 /* USER CODE BEGIN PFP */
+/**
+  * @brief Scan of VREFINT and TEMPSENSOR in one ADC session (hardware oversampling x16),
+  *        the cached values are used within ADC_MEASURE_VALIDITY_MS
+  * @return HAL_OK, HAL_ERROR - the conversion failed, the previous values are kept
+  */
+static HAL_StatusTypeDef ADC_Measure(void);
 
+/**
+  * @brief VDDA (mV) from the VREFINT conversion
+  */
+static uint16_t ADC_CalcVdda(uint32_t vrefint);
+
+/**
+  * @brief chip temperature (degree Celsius) from the TEMPSENSOR conversion
+  */
+static int16_t ADC_CalcTemperature(uint16_t vddaMv, uint32_t tempsensor);
 /* USER CODE END PFP */
 
 /* Exported functions --------------------------------------------------------*/
@@ -97,7 +127,9 @@ void SYS_DeInitMeasurement(void)
 int16_t SYS_GetTemperatureLevel(void)
 {
   /* USER CODE BEGIN SYS_GetTemperatureLevel_1 */
-
+  /* one ADC session for both channels, the battery level is not converted again */
+  ADC_Measure();
+  return (int16_t)(AdcTemperature << 8);
   /* USER CODE END SYS_GetTemperatureLevel_1 */
   __IO int16_t temperatureDegreeC = 0;
   uint32_t measuredLevel = 0;
@@ -139,7 +171,8 @@ int16_t SYS_GetTemperatureLevel(void)
 uint16_t SYS_GetBatteryLevel(void)
 {
   /* USER CODE BEGIN SYS_GetBatteryLevel_1 */
-
+  ADC_Measure();
+  return AdcVddaMv;
   /* USER CODE END SYS_GetBatteryLevel_1 */
   uint16_t batteryLevelmV = 0;
   uint32_t measuredLevel = 0;
@@ -175,7 +208,116 @@ uint16_t SYS_GetBatteryLevel(void)
 
 /* Private Functions Definition -----------------------------------------------*/
 /* USER CODE BEGIN PrFD */
+static HAL_StatusTypeDef ADC_Measure(void)
+{
+  ADC_ChannelConfTypeDef sConfig = {0};
+  uint32_t now = HAL_GetTick();
+  uint32_t vrefint = 0;
+  uint32_t tempsensor = 0;
+  HAL_StatusTypeDef status = HAL_ERROR;
+
+  if (AdcMeasureValid && (now - AdcMeasureTick) < ADC_MEASURE_VALIDITY_MS)
+  {
+    return HAL_OK;
+  }
+
+  /* VREFINT (rank 1) is configured by MX_ADC_Init (first use after the wakeup), the sequence and the oversampling are added */
+  pwrDomain_Acquire(PWR_DOMAIN_ADC);
+  hadc.Init.ScanConvMode = ADC_SCAN_ENABLE;
+  hadc.Init.NbrOfConversion = 2;
+  hadc.Init.OversamplingMode = ENABLE;
+  hadc.Init.Oversampling.Ratio = ADC_OVERSAMPLING_RATIO_16;
+  hadc.Init.Oversampling.RightBitShift = ADC_RIGHTBITSHIFT_4;
+  hadc.Init.Oversampling.TriggeredMode = ADC_TRIGGEREDMODE_SINGLE_TRIGGER;
+  if (HAL_ADC_Init(&hadc) != HAL_OK)
+  {
+    goto done;
+  }
+  sConfig.Channel = ADC_CHANNEL_VREFINT;
+  sConfig.Rank = ADC_REGULAR_RANK_1;
+  sConfig.SamplingTime = ADC_SAMPLINGTIME_COMMON_1;
+  if (HAL_ADC_ConfigChannel(&hadc, &sConfig) != HAL_OK)
+  {
+    goto done;
+  }
+  sConfig.Channel = ADC_CHANNEL_TEMPSENSOR;
+  sConfig.Rank = ADC_REGULAR_RANK_2;
+  if (HAL_ADC_ConfigChannel(&hadc, &sConfig) != HAL_OK)
+  {
+    goto done;
+  }
+
+  if (!AdcCalibValid || (now - AdcCalibTick) >= ADC_CALIB_PERIOD_MS)
+  {
+    /* the calibration needs the ADC disabled */
+    if (HAL_ADCEx_Calibration_Start(&hadc) != HAL_OK)
+    {
+      goto done;
+    }
+    AdcCalibFactor = HAL_ADCEx_Calibration_GetValue(&hadc);
+    AdcCalibTick = now;
+    AdcCalibValid = 1;
+  }
+  else
+  {
+    /* the cached factor is written to the enabled ADC */
+    if (ADC_Enable(&hadc) != HAL_OK || HAL_ADCEx_Calibration_SetValue(&hadc, AdcCalibFactor) != HAL_OK)
+    {
+      goto done;
+    }
+  }
+
+  if (HAL_ADC_Start(&hadc) != HAL_OK)
+  {
+    goto done;
+  }
+  if (HAL_ADC_PollForConversion(&hadc, ADC_CONV_TIMEOUT_MS) == HAL_OK)
+  {
+    vrefint = HAL_ADC_GetValue(&hadc);
+    if (HAL_ADC_PollForConversion(&hadc, ADC_CONV_TIMEOUT_MS) == HAL_OK)
+    {
+      tempsensor = HAL_ADC_GetValue(&hadc);
+      status = HAL_OK;
+    }
+  }
+  HAL_ADC_Stop(&hadc);   /* it calls also ADC_Disable() */
+
+done:
+  pwrDomain_Release(PWR_DOMAIN_ADC);   /* the ADC is gated before STOP2 */
+  if (status == HAL_OK && vrefint != 0)
+  {
+    AdcVddaMv = ADC_CalcVdda(vrefint);
+    AdcTemperature = ADC_CalcTemperature(AdcVddaMv, tempsensor);
+    AdcMeasureTick = now;
+    AdcMeasureValid = 1;
+    return HAL_OK;
+  }
+  AdcCalibValid = 0;    /* calibrated again by the next session */
+  return HAL_ERROR;
+}
+
+static uint16_t ADC_CalcVdda(uint32_t vrefint)
+{
+  if ((uint32_t)*VREFINT_CAL_ADDR != (uint32_t)0xFFFFU)
+  {
+    /* Device with Reference voltage calibrated in production */
+    return __LL_ADC_CALC_VREFANALOG_VOLTAGE(vrefint, ADC_RESOLUTION_12B);
+  }
+  /* Device with Reference voltage not calibrated in production */
+  return (VREFINT_CAL_VREF * 1510) / vrefint;
+}
 
+static int16_t ADC_CalcTemperature(uint16_t vddaMv, uint32_t tempsensor)
+{
+  if (((int32_t)*TEMPSENSOR_CAL2_ADDR - (int32_t)*TEMPSENSOR_CAL1_ADDR) != 0)
+  {
+    /* Device with temperature sensor calibrated in production */
+    return __LL_ADC_CALC_TEMPERATURE(vddaMv, tempsensor, LL_ADC_RESOLUTION_12B);
+  }
+  /* Device with temperature sensor not calibrated in production */
+  return __LL_ADC_CALC_TEMPERATURE_TYP_PARAMS(TEMPSENSOR_TYP_AVGSLOPE, TEMPSENSOR_TYP_CAL1_V, TEMPSENSOR_CAL1_TEMP,
+                                              vddaMv, tempsensor, LL_ADC_RESOLUTION_12B);
+}
 /* USER CODE END PrFD */
 
 static uint32_t ADC_ReadChannels(uint32_t channel)
@@ -66,11 +66,10 @@ HAL_StatusTypeDef ambient_On(I2C_HandleTypeDef *hi2c)
 			if (status != HAL_OK)
 				break;
 
-			// 2. Set Initial Gain and Timing (Config register)
-			// We match our 'currentGain' variable (TSL2591_GAIN_MED = 0x10)
+			// 2. Set Gain and Timing (Config register)
+			// We match our 'currentGain' variable (the last gain, TSL2591_GAIN_MED = 0x10 after reset)
 			// And set Integration Time to 100ms (0x01)
 			// Result: 0x11
-			_currentGain = TSL2591_GAIN_MED;
 			data = (uint8_t) _currentGain | 0x01;
 
 			status = HAL_I2C_Mem_Write(hi2c, AMBIENT_ADDR, TSL2591_COMMAND | REG_CONFIG, I2C_MEMADD_SIZE_8BIT, &data, 1, 100);
@@ -127,6 +126,20 @@ HAL_StatusTypeDef ambient_Init(I2C_HandleTypeDef *hi2c)
 	return status;
 }
 
+HAL_StatusTypeDef ambient_InitWarm(I2C_HandleTypeDef *hi2c, uint8_t gain)
+{
+	HAL_StatusTypeDef status = I2C_IsDeviceReadyMT(hi2c, AMBIENT_ADDR, 2, 2);	// presence only, no calibration
+
+	_currentGain = (TSL2591_Gain_t) (gain & TSL2591_GAIN_MAX);
+	_isAmbientSensor = (status == HAL_OK);
+	return status;
+}
+
+uint8_t ambient_GetGain()
+{
+	return (uint8_t) _currentGain;
+}
+
 /**
  * @brief This function checks the raw channel 0 value. If it is near the 16-bit limit (65535), it drops the gain. If it is too low, it boosts it.
  */
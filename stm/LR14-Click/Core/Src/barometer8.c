@@ -108,6 +108,14 @@ HAL_StatusTypeDef barometer_Init(I2C_HandleTypeDef *hi2c)
 	return status;
 }
 
+HAL_StatusTypeDef barometer_InitWarm(I2C_HandleTypeDef *hi2c)
+{
+	HAL_StatusTypeDef status = I2C_IsDeviceReadyMT(hi2c, ILPS22QS_I2C_ADDR, 2, 2);	// presence only, who am'I has been checked
+
+	_isBarometer = (status == HAL_OK);
+	return status;
+}
+
 HAL_StatusTypeDef barometer_Read(I2C_HandleTypeDef *hi2c)
 {
 	uint8_t raw_data[5]; // 3 bytes for pressure, 2 for temperature
@@ -0,0 +1,138 @@
+/*
+ * clockprof.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ */
+
+#include "clockprof.h"
+#include "i2c.h"
+#include "spi.h"
+#include "usart.h"
+#include "radio.h"
+#include "trace.h"
+
+#define CLOCK_UART_TIMEOUT	100		// ms, end of the transmission before the switch
+
+typedef struct
+{
+	uint32_t MsiRange;
+	uint32_t Scale;		// voltage scale
+	uint32_t I2CMaxHz;	// max. SCL, the fastest I2C mode of the kernel clock (I2CCLK min.: Fm+ 19 MHz, Fm 9 MHz)
+} clockProfDef_t;
+
+static const clockProfDef_t _profileDefs[CLOCK_NBR] = {
+	{ RCC_MSIRANGE_11, PWR_REGULATOR_VOLTAGE_SCALE1, 1000000 },	// 48 MHz, fast plus
+	{ RCC_MSIRANGE_8, PWR_REGULATOR_VOLTAGE_SCALE2, 400000 },	// 16 MHz, fast
+	{ RCC_MSIRANGE_6, PWR_REGULATOR_VOLTAGE_SCALE2, 100000 }	// 4 MHz, standard
+};
+
+static clockProfile_t _profile = CLOCK_FULL;
+
+/**
+ * @brief finest prescaler of SPI for the max. clock
+ */
+static uint32_t clockProf_SpiPrescaler(uint32_t pclk)
+{
+	uint32_t br = 0;	// 2 << br
+
+	while (br < 7 && (pclk >> (br + 1)) > CLOCK_SPI_MAX_HZ)
+		br++;
+	return br << SPI_CR1_BR_Pos;
+}
+
+/**
+ * @brief the transmission of the log is finished, BRR is not changed during the frame
+ */
+static void clockProf_UartIdle(void)
+{
+	uint32_t tick = HAL_GetTick();
+
+	while ((huart1.gState != HAL_UART_STATE_READY || !__HAL_UART_GET_FLAG(&huart1, UART_FLAG_TC)) && HAL_GetTick() - tick < CLOCK_UART_TIMEOUT)
+		;
+}
+
+void clockProf_Init(void)
+{
+	_profile = CLOCK_FULL;
+	for (int i = 0; i < PWR_DOMAIN_NBR; i++)
+		if (pwrDomain_Get(i)->Ready)
+			clockProf_Retime(i);
+}
+
+clockProfile_t clockProf_Set(clockProfile_t profile)
+{
+	clockProfile_t prev = _profile;
+	const clockProfDef_t *d;
+	RCC_OscInitTypeDef osc = { 0 };
+
+	if (profile != CLOCK_FULL && Radio.GetStatus() != RF_IDLE)
+		profile = CLOCK_FULL;	// TX/RX is running, the radio interrupt is served at full speed
+	if (profile == _profile)
+		return prev;
+	d = &_profileDefs[profile];
+	if (pwrDomain_Get(PWR_DOMAIN_USART1)->Ready)
+		clockProf_UartIdle();
+
+	// the scale 1 before the higher clock, the scale 2 after the lower one (flash latency is set by HAL_RCC_OscConfig)
+	if (d->Scale == PWR_REGULATOR_VOLTAGE_SCALE1)
+		HAL_PWREx_ControlVoltageScaling(PWR_REGULATOR_VOLTAGE_SCALE1);
+	osc.OscillatorType = RCC_OSCILLATORTYPE_MSI;
+	osc.MSIState = RCC_MSI_ON;
+	osc.MSICalibrationValue = RCC_MSICALIBRATION_DEFAULT;
+	osc.MSIClockRange = d->MsiRange;
+	osc.PLL.PLLState = RCC_PLL_NONE;
+	if (HAL_RCC_OscConfig(&osc) != HAL_OK)	// SystemCoreClock is updated
+		return prev;
+	if (d->Scale == PWR_REGULATOR_VOLTAGE_SCALE2)
+		HAL_PWREx_ControlVoltageScaling(PWR_REGULATOR_VOLTAGE_SCALE2);
+	_profile = profile;
+	trace_Clock();
+
+	for (int i = 0; i < PWR_DOMAIN_NBR; i++)
+		if (pwrDomain_Get(i)->Ready)
+			clockProf_Retime(i);
+	return prev;
+}
+
+clockProfile_t clockProf_Get(void)
+{
+	return _profile;
+}
+
+uint32_t clockProf_I2CMaxHz(void)
+{
+	return _profileDefs[_profile].I2CMaxHz;
+}
+
+void clockProf_Retime(pwrDomainId_t id)
+{
+	switch (id)
+	{
+		case PWR_DOMAIN_I2C2:
+			// speed of the device (I2C_SetSpeed), capped by the profile
+			if (I2C_GetSpeed(&hi2c2) > clockProf_I2CMaxHz())
+				I2C_SetSpeed(&hi2c2, clockProf_I2CMaxHz());
+			else
+				I2C_Retime(&hi2c2);
+		break;
+		case PWR_DOMAIN_SPI1:
+			hspi1.Init.BaudRatePrescaler = clockProf_SpiPrescaler(HAL_RCC_GetPCLK2Freq());
+			__HAL_SPI_DISABLE(&hspi1);
+			MODIFY_REG(hspi1.Instance->CR1, SPI_CR1_BR, hspi1.Init.BaudRatePrescaler);
+		break;
+		case PWR_DOMAIN_USART1:
+			// BRR is written with UE off, the receiving (RXNEIE) is kept
+			__HAL_UART_DISABLE(&huart1);
+			huart1.Instance->BRR = UART_DIV_SAMPLING16(HAL_RCC_GetPCLK2Freq(), huart1.Init.BaudRate, huart1.Init.ClockPrescaler);
+			__HAL_UART_ENABLE(&huart1);
+		break;
+		default:	// ADC is clocked by HSI
+		break;
+	}
+}
+
+void clockProf_OnWake(void)
+{
+	_profile = CLOCK_FULL;
+}
@@ -21,7 +21,54 @@
 #include "i2c.h"
 
 /* USER CODE BEGIN 0 */
+#define I2C_RECOVERY_ADDR_MAX	8	// count of tracked device addresses
+#define I2C_RECOVERY_PULSES		9	// max. SCL pulses to release SDA
 
+// bus recovery counter per device address
+typedef struct
+{
+	uint16_t addr;
+	uint16_t count;
+} i2cRecovery_t;
+
+static i2cRecovery_t _i2cRecovery[I2C_RECOVERY_ADDR_MAX] = { };
+
+// bus of the board (pull-ups of clicks), filters as MX_I2C2_Init (analog on, digital off)
+#define I2C_RISE_NS				250
+#define I2C_FALL_NS				30
+#define I2C_TIMING_CACHE		6	// speeds x clock profiles
+
+// I2C specification (ns): tLOW, tHIGH, tSU;DAT min., tHD;DAT max., min. kernel clock of the mode (RM, I2CCLK)
+typedef struct
+{
+	uint32_t MaxHz;
+	uint16_t Low, High, SuDat, HdDat;
+	uint32_t MinClkHz;
+} i2cMode_t;
+
+static const i2cMode_t _i2cModes[] = {
+	{ 100000, 4700, 4000, 250, 3450, 2000000 },	// standard
+	{ 400000, 1300, 600, 100, 900, 9000000 },	// fast
+	{ 1000000, 500, 260, 50, 450, 19000000 }	// fast plus
+};
+
+#define I2C_AF_MIN_NS	50		// analog filter delay
+#define I2C_AF_MAX_NS	260
+#define I2C_SYNC_CLK	3		// synchronization of SCL (max. kernel clocks), each edge
+
+// computed TIMINGR
+typedef struct
+{
+	uint32_t clkHz;
+	uint32_t reqHz;		// requested SCL
+	uint32_t sclHz;		// expected SCL
+	uint32_t timingr;
+} i2cTimingCache_t;
+
+static i2cTimingCache_t _i2cTimings[I2C_TIMING_CACHE] = { };
+static uint8_t _i2cTimingNext = 0;
+static uint32_t _i2cReqHz = I2C_SPEED_DEFAULT;	// speed of the next transactions (I2C2)
+static const i2cTimingCache_t *_i2cTiming = NULL;	// TIMINGR in the peripheral
 /* USER CODE END 0 */
 
 I2C_HandleTypeDef hi2c2;
@@ -155,14 +202,257 @@ void MX_I2C2_DeInit(void)
 	HAL_GPIO_WritePin(GPIOA, GPIO_PIN_12, GPIO_PIN_SET);
 }
 
+// half period of SCL during recovery (~5 us, 100 kHz at 48 MHz)
+static void I2C_RecoveryPause(void)
+{
+	for (volatile uint32_t i = 0; i < 40; i++)
+		;
+}
+
+// recovery counter of the device address
+static void I2C_RecoveryCount(uint16_t DevAddress)
+{
+	i2cRecovery_t *free = NULL;
+
+	for (int i = 0; i < I2C_RECOVERY_ADDR_MAX; i++)
+	{
+		if (_i2cRecovery[i].count != 0 && _i2cRecovery[i].addr == DevAddress)
+		{
+			if (_i2cRecovery[i].count < UINT16_MAX)
+				_i2cRecovery[i].count++;
+			return;
+		}
+		if (free == NULL && _i2cRecovery[i].count == 0)
+			free = &_i2cRecovery[i];
+	}
+	if (free != NULL)
+	{
+		free->addr = DevAddress;
+		free->count = 1;
+	}
+}
+
+HAL_StatusTypeDef I2C_BusRecovery(I2C_HandleTypeDef *hi2c)
+{
+	HAL_StatusTypeDef status = HAL_OK;
+
+	HAL_I2C_DeInit(hi2c);
+	if (hi2c->Instance == I2C2)
+	{
+		// SDA - PA11, SCL - PA12 as open drain outputs, external pull-ups
+		GPIO_InitTypeDef GPIO_InitStruct = { 0 };
+
+		HAL_GPIO_WritePin(GPIOA, GPIO_PIN_11 | GPIO_PIN_12, GPIO_PIN_SET);
+		GPIO_InitStruct.Pin = GPIO_PIN_11 | GPIO_PIN_12;
+		GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_OD;
+		GPIO_InitStruct.Pull = GPIO_NOPULL;
+		GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+		HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+		I2C_RecoveryPause();
+
+		// slave holds SDA low, clock it out
+		for (int i = 0; i < I2C_RECOVERY_PULSES && HAL_GPIO_ReadPin(GPIOA, GPIO_PIN_11) == GPIO_PIN_RESET; i++)
+		{
+			HAL_GPIO_WritePin(GPIOA, GPIO_PIN_12, GPIO_PIN_RESET);
+			I2C_RecoveryPause();
+			HAL_GPIO_WritePin(GPIOA, GPIO_PIN_12, GPIO_PIN_SET);
+			I2C_RecoveryPause();
+		}
+
+		// STOP condition, SDA low->high while SCL is high
+		HAL_GPIO_WritePin(GPIOA, GPIO_PIN_12, GPIO_PIN_RESET);
+		I2C_RecoveryPause();
+		HAL_GPIO_WritePin(GPIOA, GPIO_PIN_11, GPIO_PIN_RESET);
+		I2C_RecoveryPause();
+		HAL_GPIO_WritePin(GPIOA, GPIO_PIN_12, GPIO_PIN_SET);
+		I2C_RecoveryPause();
+		HAL_GPIO_WritePin(GPIOA, GPIO_PIN_11, GPIO_PIN_SET);
+		I2C_RecoveryPause();
+
+		if (HAL_GPIO_ReadPin(GPIOA, GPIO_PIN_11) == GPIO_PIN_RESET || HAL_GPIO_ReadPin(GPIOA, GPIO_PIN_12) == GPIO_PIN_RESET)
+			status = HAL_ERROR;	// bus is still stuck
+	}
+	// reinit, MspInit switches pins back to I2C
+	if (HAL_I2C_Init(hi2c) != HAL_OK)
+		status = HAL_ERROR;
+	return status;
+}
+
+uint16_t I2C_GetRecoveryCount(uint16_t DevAddress)
+{
+	for (int i = 0; i < I2C_RECOVERY_ADDR_MAX; i++)
+		if (_i2cRecovery[i].count != 0 && _i2cRecovery[i].addr == DevAddress)
+			return _i2cRecovery[i].count;
+	return 0;
+}
+
+/*
+ * @brief mode of the SCL frequency, the fastest mode allowed by the kernel clock at most
+ * @retval NULL - the clock is too slow for the standard mode
+ */
+static const i2cMode_t* i2cTiming_Mode(uint32_t sclHz, uint32_t clkHz)
+{
+	int i = 0;
+
+	while (i < (int) (sizeof(_i2cModes) / sizeof(_i2cModes[0])) - 1 && sclHz > _i2cModes[i].MaxHz)
+		i++;
+	while (i >= 0 && clkHz < _i2cModes[i].MinClkHz)
+		i--;
+	return (i < 0) ? NULL : &_i2cModes[i];
+}
+
+/*
+ * @brief ns to the count of periods (ps), rounded up, min. 1
+ * @param creditPs - part of the time given by the bus (synchronization of SCL edge)
+ */
+static uint32_t i2cTiming_Count(uint32_t ns, uint32_t periodPs, uint32_t creditPs)
+{
+	uint64_t ps = (uint64_t) ns * 1000;
+
+	if (ps <= creditPs)
+		return 1;
+	return (ps - creditPs + periodPs - 1) / periodPs;
+}
+
+/*
+ * @brief SCL period (ps) without SCLL and SCLH: rise, fall and synchronization of both edges (filters, kernel clock)
+ */
+static uint64_t i2cTiming_BusPs(const i2cTimingCfg_t *cfg, uint32_t clkPs)
+{
+	uint32_t afNs = cfg->AnalogFilter ? I2C_AF_MIN_NS : 0;
+
+	return (uint64_t) (cfg->RiseNs + cfg->FallNs + 2 * afNs) * 1000 + 2 * (uint64_t) (cfg->DigitalFilter + I2C_SYNC_CLK) * clkPs;
+}
+
+uint32_t i2cTiming_Calc(const i2cTimingCfg_t *cfg, uint32_t *sclHz)
+{
+	const i2cMode_t *m = i2cTiming_Mode(*sclHz, cfg->ClkHz);
+
+	if (m == NULL)
+	{
+		*sclHz = 0;
+		return 0;
+	}
+	if (*sclHz > m->MaxHz)
+		*sclHz = m->MaxHz;	// slower mode of the kernel clock
+
+	uint32_t clkPs = (uint32_t) (1000000000000ULL / cfg->ClkHz);
+	uint64_t periodPs = 1000000000000ULL / *sclHz;
+	uint64_t busPs = i2cTiming_BusPs(cfg, clkPs);
+	int64_t afMinPs = cfg->AnalogFilter ? I2C_AF_MIN_NS * 1000 : 0;
+	int64_t afMaxPs = cfg->AnalogFilter ? I2C_AF_MAX_NS * 1000 : 0;
+	// SDA delay: tSDADEL >= tf - tAF(min) - (DNF + 3) x tI2CCLK, tSDADEL <= tHD;DAT(max) - tr - tAF(max) - (DNF + 4) x tI2CCLK
+	int64_t sdaMinPs = (int64_t) cfg->FallNs * 1000 - afMinPs - (int64_t) (cfg->DigitalFilter + 3) * clkPs;
+	int64_t sdaMaxPs = ((int64_t) m->HdDat - cfg->RiseNs) * 1000 - afMaxPs - (int64_t) (cfg->DigitalFilter + 4) * clkPs;
+	// tLOW and tHIGH on the bus include min. synchronization: edge, analog filter, DNF + 2 kernel clocks
+	uint32_t syncPs = (uint32_t) afMinPs + (cfg->DigitalFilter + 2) * clkPs;
+	uint32_t syncLowPs = cfg->FallNs * 1000 + syncPs;
+	uint32_t syncHighPs = cfg->RiseNs * 1000 + syncPs;
+
+	for (uint32_t presc = 0; presc < 16; presc++)
+	{
+		uint32_t prescPs = clkPs * (presc + 1);
+		// SCL delay: tSCLDEL >= tr + tSU;DAT(min)
+		uint32_t sclDel = i2cTiming_Count(cfg->RiseNs + m->SuDat, prescPs, 0);
+		uint32_t sdaDel = (sdaMinPs <= 0) ? 0 : (uint32_t) ((sdaMinPs + prescPs - 1) / prescPs);
+		uint32_t low = i2cTiming_Count(m->Low, prescPs, syncLowPs);
+		uint32_t high = i2cTiming_Count(m->High, prescPs, syncHighPs);
+		uint32_t total = (periodPs > busPs) ? (uint32_t) ((periodPs - busPs + prescPs - 1) / prescPs) : 0;
+
+		if (sclDel == 0)
+			sclDel = 1;
+		if (sclDel > 16 || sdaDel > 15 || (sdaDel > 0 && (int64_t) sdaDel * prescPs > sdaMaxPs))
+			continue;
+		if (low + high < total)
+		{
+			// the rest of period by the ratio of minimums
+			uint32_t rest = total - low - high;
+			uint32_t addLow = (uint32_t) (((uint64_t) rest * m->Low) / (m->Low + m->High));
+
+			low += addLow;
+			high += rest - addLow;
+		}
+		if (low > 256 || high > 256)
+			continue;	// coarser prescaler
+		*sclHz = (uint32_t) (1000000000000ULL / ((uint64_t) (low + high) * prescPs + busPs));
+		return (presc << 28) | ((sclDel - 1) << 20) | (sdaDel << 16) | ((high - 1) << 8) | (low - 1);
+	}
+	*sclHz = 0;
+	return 0;
+}
+
+uint32_t i2cTiming_SclHz(const i2cTimingCfg_t *cfg, uint32_t timingr)
+{
+	uint32_t clkPs = (uint32_t) (1000000000000ULL / cfg->ClkHz);
+	uint32_t prescPs = clkPs * ((timingr >> 28) + 1);
+	uint32_t counts = ((timingr >> 8) & 0xFF) + 1 + (timingr & 0xFF) + 1;
+
+	return (uint32_t) (1000000000000ULL / ((uint64_t) counts * prescPs + i2cTiming_BusPs(cfg, clkPs)));
+}
+
+/**
+ * @brief TIMINGR of the speed for the kernel clock, computed or from the cache
+ */
+static const i2cTimingCache_t* I2C_Timing(uint32_t clkHz, uint32_t reqHz)
+{
+	i2cTimingCache_t *t;
+	i2cTimingCfg_t cfg = { .ClkHz = clkHz, .RiseNs = I2C_RISE_NS, .FallNs = I2C_FALL_NS, .AnalogFilter = 1, .DigitalFilter = 0 };
+
+	for (int i = 0; i < I2C_TIMING_CACHE; i++)
+		if (_i2cTimings[i].clkHz == clkHz && _i2cTimings[i].reqHz == reqHz)
+			return &_i2cTimings[i];
+	t = &_i2cTimings[_i2cTimingNext];
+	_i2cTimingNext = (_i2cTimingNext + 1) % I2C_TIMING_CACHE;
+	t->clkHz = clkHz;
+	t->reqHz = reqHz;
+	t->sclHz = reqHz;
+	t->timingr = i2cTiming_Calc(&cfg, &t->sclHz);
+	if (t->sclHz == 0)
+		t->clkHz = 0;	// no setting, not cached
+	return (t->sclHz != 0) ? t : NULL;
+}
+
+HAL_StatusTypeDef I2C_SetSpeed(I2C_HandleTypeDef *hi2c, uint32_t sclHz)
+{
+	if (sclHz == _i2cReqHz && _i2cTiming != NULL && _i2cTiming->clkHz == HAL_RCC_GetPCLK1Freq() && hi2c->Init.Timing == _i2cTiming->timingr)
+		return HAL_OK;
+	_i2cReqHz = sclHz;
+	return I2C_Retime(hi2c);
+}
+
+HAL_StatusTypeDef I2C_Retime(I2C_HandleTypeDef *hi2c)
+{
+	const i2cTimingCache_t *t = I2C_Timing(HAL_RCC_GetPCLK1Freq(), _i2cReqHz);
+
+	if (t == NULL)
+		return HAL_ERROR;
+	_i2cTiming = t;
+	hi2c->Init.Timing = t->timingr;
+	if (hi2c->State == HAL_I2C_STATE_RESET)
+		return HAL_OK;	// gated, TIMINGR is written by HAL_I2C_Init
+	if (hi2c->State != HAL_I2C_STATE_READY)
+		return HAL_BUSY;
+	// TIMINGR is written with PE off
+	__HAL_I2C_DISABLE(hi2c);
+	hi2c->Instance->TIMINGR = t->timingr;
+	__HAL_I2C_ENABLE(hi2c);
+	return HAL_OK;
+}
+
+uint32_t I2C_GetSpeed(I2C_HandleTypeDef *hi2c)
+{
+	return (_i2cTiming != NULL && hi2c->Init.Timing == _i2cTiming->timingr) ? _i2cTiming->sclHz : 0;
+}
+
 HAL_StatusTypeDef I2C_IsDeviceReadyMT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint32_t Trials, uint32_t Timeout)
 {
 	HAL_StatusTypeDef status = HAL_I2C_IsDeviceReady(hi2c, DevAddress, Trials, Timeout);
 	if (status == HAL_BUSY)
 	{
-		HAL_I2C_DeInit(hi2c);
-		HAL_Delay(100);
-		HAL_I2C_Init(hi2c);
+		// bus recovery instead of DeInit/HAL_Delay(100)/Init, then one more try
+		I2C_RecoveryCount(DevAddress);
+		if (I2C_BusRecovery(hi2c) == HAL_OK)
+			status = HAL_I2C_IsDeviceReady(hi2c, DevAddress, Trials, Timeout);
 	}
 	return status;
 }
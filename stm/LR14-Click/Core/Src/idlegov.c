@@ -0,0 +1,51 @@
+/*
+ * idlegov.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ */
+
+#include "idlegov.h"
+
+static void idleGov_BreakEven(idleGov_t *v)
+{
+	uint32_t gain = (v->SleepUA > v->StopUA) ? v->SleepUA - v->StopUA : 1;
+
+	v->BreakEvenUS = (uint32_t) (((uint64_t) v->OverheadUS * (v->RunUA - v->StopUA) + gain - 1) / gain);
+	if (v->BreakEvenUS < v->OverheadUS)
+		v->BreakEvenUS = v->OverheadUS;	// STOP2 cannot end before the deadline
+}
+
+void idleGov_Inic(idleGov_t *v, uint16_t runUA, uint16_t sleepUA, uint16_t stopUA, uint32_t overheadUS, uint32_t awakeUS)
+{
+	v->RunUA = runUA;
+	v->SleepUA = sleepUA;
+	v->StopUA = stopUA;
+	v->OverheadUS = overheadUS;
+	v->AwakeUS = awakeUS;
+	v->Samples = 0;
+	for (int i = 0; i < IDLE_MODE_NBR; i++)
+		v->Count[i] = 0;
+	idleGov_BreakEven(v);
+}
+
+idleMode_t idleGov_Decide(idleGov_t *v, uint32_t idleUS)
+{
+	idleMode_t mode = IDLE_STOP2;
+
+	if (idleUS < v->AwakeUS)
+		mode = IDLE_AWAKE;
+	else if (idleUS < v->BreakEvenUS)
+		mode = IDLE_SLEEP;
+	v->Count[mode]++;
+	return mode;
+}
+
+void idleGov_Learn(idleGov_t *v, uint32_t overheadUS)
+{
+	if (v->Samples++ == 0)
+		v->OverheadUS = overheadUS;
+	else
+		v->OverheadUS = (v->OverheadUS * 7 + overheadUS + 4) / 8;
+	idleGov_BreakEven(v);
+}
@@ -33,6 +33,11 @@
 #include "usart_if.h"
 #include "stm32_seq.h"
 #include "LmHandler.h"
+#include "timesync.h"
+#include "utils/utils.h"
+#include "pwrdomain.h"
+#include "clockprof.h"
+#include "trace.h"
 
 /* USER CODE END Includes */
 
@@ -135,23 +140,50 @@ void Uart_Start()
 {
 	HAL_StatusTypeDef status;
 
+#if defined(DEBUG)
+	pwrDomain_Acquire(PWR_DOMAIN_USART1);	// console is held, UART is initialized again after every wakeup
+#endif
 	writeLog("start UUART read");
 	status = Uart_StartReceving(&huart1);
 	writeLog("UART read: %d", (int) status);
 }
 
+/**
+ * @brief the peripheral is initialized again (pwrdomain.c), the receiving of the console is started again
+ */
+void pwrDomain_OnReady(pwrDomainId_t id)
+{
+	if (id == PWR_DOMAIN_USART1 && pwrDomain_Get(id)->Refs > 0)
+		Uart_StartReceving(&huart1);
+}
+
 static void Uart_RxProcessing()
 {
 	writeLog("from:%s!", (const char*) uart_req_buf);
+	// console commands: trace - dump of the event trace, trace clear
+	if (strncmp(uart_req_buf, "trace", 5) == 0)
+	{
+		if (strncmp(uart_req_buf + 5, " clear", 6) == 0)
+			trace_Clear();
+		else
+			trace_Dump();
+	}
 	Uart_NextReceving();		// a pokracujeme v citani portu, data su nachystane v uart_req_buf
 }
 
 static void GetTimeDate()
 {
-	// 1. Calling this LOCKS the shadow registers
-	HAL_RTC_GetTime(&hrtc, &_currentTime, RTC_FORMAT_BIN);
-	// 2. Calling this UNLOCKS the shadow registers
-	HAL_RTC_GetDate(&hrtc, &_currentDate, RTC_FORMAT_BIN);
+	// the RTC is in binary mode (timer_if.c), the calendar is computed from SysTime
+	static calendar_t cal = { .DayStart = 0xFFFFFFFF };
+
+	calendar_Set(&cal, timeSync_Now(NULL));
+	_currentTime.Hours = cal.Hours;
+	_currentTime.Minutes = cal.Minutes;
+	_currentTime.Seconds = cal.Seconds;
+	_currentDate.Year = (cal.Year >= 2000) ? cal.Year - 2000 : 0;
+	_currentDate.Month = cal.Month;
+	_currentDate.Date = cal.Day;
+	_currentDate.WeekDay = cal.WeekDay;
 }
 
 /**
@@ -168,16 +200,7 @@ void OnLoRaWanConnected(void)
 	/* Request time synchronization from the LoRaWAN server */
 	/* This will trigger the DeviceTimeReq MAC command */
 	/* The response will automatically update the system time via OnSysTimeUpdate callback */
-	LmHandlerErrorStatus_t status = LmHandlerDeviceTimeReq();
-
-	if (status == LORAMAC_HANDLER_SUCCESS)
-	{
-		writeLog("Time synchronization request sent");
-	}
-	else
-	{
-		writeLog("Failed to send time synchronization request");
-	}
+	timeSync_Request();
 }
 
 /**
@@ -193,6 +216,7 @@ void OnLoRaWanConnected(void)
  */
 void OnTimeSynchronized(void)
 {
+	timeSync_OnUpdate();	// drift estimation, next sync
 	GetTimeDate();
 	writeLog("Time synchronized: %04d-%02d-%02d %02d:%02d:%02d",
 			 2000 + _currentDate.Year, _currentDate.Month, _currentDate.Date,
@@ -238,11 +262,15 @@ int main(void)
 	MX_RTC_Init();
 	MX_LoRaWAN_Init();
 	/* USER CODE BEGIN 2 */
+	pwrDomain_Init((1 << PWR_DOMAIN_I2C2) | (1 << PWR_DOMAIN_SPI1) | (1 << PWR_DOMAIN_USART1));
+	clockProf_Init();
+	trace_Init();
 
 	// pripadne cistanie ser-portu
 	Uart_Start();
 	UTIL_SEQ_RegTask((1 << CFG_SEQ_Task_Uart_RX), UTIL_SEQ_RFU, Uart_RxProcessing);
 	UTIL_SEQ_RegTask((1 << CFG_SEQ_Task_NFC_INT), UTIL_SEQ_RFU, sensors_NFCInt);
+	timeSync_Init(CFG_SEQ_Task_TimeSync);
 
 	//I2C_Scan(&hi2c2);
 
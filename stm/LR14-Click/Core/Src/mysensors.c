@@ -9,13 +9,21 @@
 #include "mysensors.h"
 #include "flash12.h"
 #include "nfctag4.h"
+#include "nfcxfer.h"
+#include "mysensors_flash.h"
 #include "i2c.h"
 #include "spi.h"
+#include "rtc.h"
+#include "timesync.h"
 #include "utils/utils.h"
 
 #include "stm32_timer.h"
 #include "stm32_seq.h"
 #include "sys_app.h"
+#include "adc_if.h"
+#include "pwrdomain.h"
+#include "clockprof.h"
+#include "trace.h"
 
 
 #include <stdio.h>
@@ -24,12 +32,11 @@
 
 static I2C_HandleTypeDef *_hi2c = NULL;	// current I2C handler -
 static char _sensBuffer[1024] = { };	// sensor buffer
-static int8_t _tryInit = 1;			// xxx_Is - pokus o volanie init
 static flashCS_t _flash = { .csPort = SPI1_CS_GPIO_Port, .csPin = SPI1_CS_Pin, .spi = &hspi1, .is = 0 };
 
 static SENS_ProcessDef _processDef = SENS_DONE;	// process reading sensor data, sensor Reading sequence must start via sensors_Start
 static sleeper_t _processDelay = { };	// process delay....
-static const int _processReadingMax = 10;	// count of reading data from sensors -
+static int _processReadingMax = 10;	// count of reading data from sensors -
 static int _processReadingCount = 0;			// reading count
 static int _processReadTimeout = 3000;	// pause between reading data from sensors
 
@@ -37,6 +44,126 @@ static int _processReadTimeout = 3000;	// pause between reading data from sensor
 static UTIL_TIMER_Object_t _sensorTimerReading = { };
 static uint32_t _sensorTimeout = 30000;	// interval reading data from sensor
 static uint32_t _sensorSeqID = 0;
+static uint8_t _sensEnabled = 0x1F;		// enabled sensors (bitmap of sensId_t), remote configuration
+static uint8_t _sensorCoordinated = 0;	// 1 - reading is started by the uplink coordinator (lora_app.c), not by own timer
+static deltaReporter_t _report = { };	// send-on-delta filter of the uplink
+static const uint32_t _reportHeartbeat = 3600000;	// max. silent interval (ms)
+static deltaReporter_t _history = { };	// send-on-delta filter of the flash records, the full cycle is always stored
+static const uint16_t _payloadDiv[SENS_CH_NBR] = { 1, 1, 10, 100, 1, 10, 1 };	// value of channel / div = 16-bit uplink field
+static statAgg_t _stats[SENS_CH_NBR] = { };	// statistics of channels during one reading cycle
+static tsBatch_t _tsBatch = { };			// timestamps of records (cycles) since the last report
+static uint32_t _cycleTime = 0;				// start of the reading cycle (epoch, s)
+static uint16_t _cycleMs = 0;
+static uint32_t _cycleBase = 0;				// timestamp of the last record, base of batch
+static uint16_t _cycleOffset = 0;			// and offset in batch
+static uint8_t _cycleStamped = 0;			// the last record has the timestamp
+static uint8_t _sensPowered = 0x1F;			// sensors enabled by the configuration and the power tier
+static uint8_t _sensDue = 0;				// sensors read in the current cycle (own cadence)
+static uint8_t _sensDueChannels = 0;		// channels of the current cycle (bitmap of SENS_ChannelDef)
+static uint8_t _ambientWarmGain = 0;		// ambient gain from the snapshot, for the warm init
+static nfcXfer_t _nfcXfer = { };			// download of the history by NFC phone
+static uint8_t _historyReady = 0;			// history in flash is initialized
+static uint8_t _ndefImage[SENS_NDEF_SIZE];	// NDEF of the latest readings
+static uint8_t _ndefShadow[SENS_NDEF_SIZE];	// content of the NDEF area in EEPROM
+static uint8_t _ndefShadowValid = 0;		// the shadow has been read from the tag
+static uint32_t _ndefLast = 0;				// tick of the last EEPROM update
+static uint8_t _ndefWritten = 0;			// the NDEF has been written since boot
+static calendar_t _ndefCalendar = { .DayStart = 0xFFFFFFFF };
+
+// measuring sensors, the reading of sensor is finished when its readings are settled
+typedef enum
+{
+	SENS_ID_TEMPHUM = 0,
+	SENS_ID_AMBIENT,
+	SENS_ID_BAROMETER,
+	SENS_ID_SCD41,
+	SENS_ID_SPS30,
+	SENS_ID_NBR
+} sensId_t;
+
+// power tiers, the high-power sensors are dropped first (SPS30 fan, SCD41 heating), the intervals are stretched
+static const govTier_t _govTiers[] =
+{
+	{ 0, 0x1F, 1 },		// full battery
+	{ SENS_GOV_TIER1_MV, (1 << SENS_ID_TEMPHUM) | (1 << SENS_ID_AMBIENT) | (1 << SENS_ID_BAROMETER) | (1 << SENS_ID_SCD41), 2 },
+	{ SENS_GOV_TIER2_MV, (1 << SENS_ID_TEMPHUM) | (1 << SENS_ID_AMBIENT) | (1 << SENS_ID_BAROMETER), 4 },
+	{ SENS_GOV_TIER3_MV, (1 << SENS_ID_TEMPHUM), 8 }
+};
+// power tier by the battery voltage, valid before sensors_Init (configuration is restored by LoRaWAN init)
+static batGovernor_t _governor = { .Tiers = _govTiers, .Count = sizeof(_govTiers) / sizeof(_govTiers[0]), .Tier = 0, .HystMV = SENS_GOV_HYST_MV };
+
+// registry of the measuring sensors, operations and metadata of the sensor
+typedef struct
+{
+	const char *name;
+	SENS_ChannelDef ch;		// channel for the convergence check
+	uint8_t chMask;			// channels of the sensor (bitmap of SENS_ChannelDef)
+	uint16_t powerUA;		// consumption of the measuring sensor (uA)
+	uint16_t latencyMS;		// warm-up, from on to the first valid reading
+	uint16_t settleMaxMS;	// max. time of reading, 0 - the reading count only
+	int32_t slopeMax;		// settled readings: slope and variance (units of channel)
+	int32_t varMax;
+	uint8_t cadence;		// reading interval of the sensor = interval of reading x cadence
+	uint32_t i2cHz;			// max. SCL of the sensor, the bus is switched before the operations (I2C_SetSpeed)
+	HAL_StatusTypeDef (*init)(I2C_HandleTypeDef *hi2c);		// cold boot
+	HAL_StatusTypeDef (*initWarm)(I2C_HandleTypeDef *hi2c);	// warm boot (present before reset), NULL - init
+	int8_t (*is)(I2C_HandleTypeDef *hi2c, int8_t tryInit);	// presence, tryInit - re-init of absent sensor
+	HAL_StatusTypeDef (*on)(I2C_HandleTypeDef *hi2c);		// start of measurement
+	HAL_StatusTypeDef (*read)(I2C_HandleTypeDef *hi2c);		// HAL_BUSY - data not ready yet
+	void (*sample)(HAL_StatusTypeDef status);				// read data to channels and log
+	HAL_StatusTypeDef (*off)(I2C_HandleTypeDef *hi2c);		// individual switch off
+} sensOps_t;
+
+// state of the sensor in the cycle
+typedef struct
+{
+	convDetector_t conv;	// settled readings detector
+	uint8_t isOn;			// 1 - sensor is reading in current cycle
+} sensState_t;
+
+// devices for the presence cache, measuring sensors (sensId_t) and others
+#define SENS_DEV_FLASH		SENS_ID_NBR
+#define SENS_DEV_NFC4		(SENS_ID_NBR + 1)
+#define SENS_NFC4_I2C_HZ	1000000		// ST25DV, Fm+
+
+static presence_t _presence = { };	// presence of devices, absent device is re-initialized with backoff (instead of every xxx_Is)
+static const uint32_t _presenceBackoffMin = 30000;		// first re-init of absent device
+static const uint32_t _presenceBackoffMax = 3600000;	// hot-plug rescan of absent device
+
+// warm boot snapshot in RTC backup registers (RTC_BKP_DR0..DR2 are used by timer_if.c)
+#define SENS_BKP_PRESENCE	RTC_BKP_DR3		// magic (high 16 bits) | presence bitmap
+#define SENS_BKP_STATE		RTC_BKP_DR4		// ambient gain
+#define SENS_BKP_CHECK		RTC_BKP_DR5		// check of DR3, DR4
+#define SENS_BKP_MAGIC		0x5E45
+
+static void sensors_SampleTempHum(HAL_StatusTypeDef status);
+static void sensors_SampleAmbient(HAL_StatusTypeDef status);
+static void sensors_SampleBarometer(HAL_StatusTypeDef status);
+static void sensors_SampleSCD41(HAL_StatusTypeDef status);
+static void sensors_SampleSPS30(HAL_StatusTypeDef status);
+static HAL_StatusTypeDef sensors_AmbientInitWarm(I2C_HandleTypeDef *hi2c);
+
+// per-sensor cadence (x interval of reading): pressure 30 s, temperature and light 1 min, CO2 5 min, PM2.5 15 min
+static const sensOps_t _sensOps[SENS_ID_NBR] = {
+	{ .name = "tempHum23", .ch = SENS_CH_TEMP, .chMask = (1 << SENS_CH_TEMP) | (1 << SENS_CH_HUM), .powerUA = 300,
+		.latencyMS = 1000, .settleMaxMS = 0, .slopeMax = 5, .varMax = 25, .cadence = 2, .i2cHz = 1000000,	// 0.05 °C, Fm+
+		.init = tempHum_Init, .initWarm = NULL, .is = tempHum_Is, .on = tempHum_On, .read = tempHum_Read, .sample = sensors_SampleTempHum, .off = tempHum_Off },
+	{ .name = "ambient21", .ch = SENS_CH_LUX, .chMask = (1 << SENS_CH_LUX), .powerUA = 300,
+		.latencyMS = 1000, .settleMaxMS = 0, .slopeMax = 500, .varMax = 250000, .cadence = 2, .i2cHz = 400000,	// 5 lux, Fm
+		.init = ambient_Init, .initWarm = sensors_AmbientInitWarm, .is = ambient_Is, .on = ambient_On, .read = ambient_ReadLux, .sample = sensors_SampleAmbient, .off = ambient_Off },
+	{ .name = "barometer8", .ch = SENS_CH_PRESSURE, .chMask = (1 << SENS_CH_PRESSURE), .powerUA = 20,
+		.latencyMS = 1000, .settleMaxMS = 0, .slopeMax = 10, .varMax = 100, .cadence = 1, .i2cHz = 1000000,	// 0.1 hPa, Fm+
+		.init = barometer_Init, .initWarm = barometer_InitWarm, .is = barometer_Is, .on = barometer_On, .read = barometer_Read, .sample = sensors_SampleBarometer, .off = barometer_Off },
+	{ .name = "scd41", .ch = SENS_CH_CO2, .chMask = (1 << SENS_CH_CO2), .powerUA = 15000,
+		.latencyMS = 10000, .settleMaxMS = 0, .slopeMax = 20, .varMax = 400, .cadence = 10, .i2cHz = 100000,	// 20 ppm, 2 measurement periods, Sm
+		.init = scd41_Init, .initWarm = scd41_InitWarm, .is = scd41_Is, .on = scd41_On, .read = scd41_Read, .sample = sensors_SampleSCD41, .off = scd41_Off },
+	{ .name = "sps30", .ch = SENS_CH_PM25, .chMask = (1 << SENS_CH_PM25), .powerUA = 60000,
+		.latencyMS = 8000, .settleMaxMS = 24000, .slopeMax = 50, .varMax = 2500, .cadence = 30, .i2cHz = 100000,	// 0.5 ug/m3, fan spin-up, Sm
+		.init = sps30_Init, .initWarm = sps30_InitWarm, .is = sps30_Is, .on = sps30_On, .read = sps30_Read, .sample = sensors_SampleSPS30, .off = sps30_Off },
+};
+
+static sensState_t _sensState[SENS_ID_NBR] = { };
+static cadenceItem_t _sensCadence[SENS_ID_NBR] = { };	// deadlines of sensors
 
 // because of power consumtion, the high powered sensor cannot be measure, must be divide to more loops
 /*enum
@@ -62,128 +189,470 @@ static void sensBuffer_Add(const char *format, ...)
 void i2c_OnOff(uint8_t onOff)
 {
 	if (onOff)
-		MX_I2C2_Init();		// reinit
+		pwrDomain_Acquire(PWR_DOMAIN_I2C2);		// reinit, if it has been gated by STOP2
 	else
-		MX_I2C2_DeInit();	// deinit - low power
+		pwrDomain_Release(PWR_DOMAIN_I2C2);		// deinit - low power, before STOP2
 }
 
-void sensors_OnOff(int8_t onOff)
+void spi_OnOff(uint8_t onOff)
 {
 	if (onOff)
 	{
-		writeLog("Sensors:on");
-		tempHum_On(_hi2c);
-		ambient_On(_hi2c);
-		barometer_On(_hi2c);
-		nfc4_On(_hi2c);
-		scd41_On(_hi2c);
-		sps30_On(_hi2c);
+		pwrDomain_Acquire(PWR_DOMAIN_SPI1);
+		TRACE_BEGIN(TRACE_SPI, SENS_DEV_FLASH);
 	}
 	else
 	{
-		writeLog("Sensors:off");
-		tempHum_Off(_hi2c);
-		ambient_Off(_hi2c);
-		barometer_Off(_hi2c);
-		nfc4_Off(_hi2c);
-		scd41_Off(_hi2c);
-		sps30_Off(_hi2c);
+		TRACE_END(TRACE_SPI, SENS_DEV_FLASH);
+		pwrDomain_Release(PWR_DOMAIN_SPI1);
 	}
 }
 
 /**
- * @brief reading sensor one by one
+ * @brief SCL of the device (sensId_t or SENS_DEV_NFC4) for the next transactions, the slow devices share the bus with the fast ones
  */
-void sensors_Read()
+static void sensors_Bus(uint8_t dev)
 {
-	HAL_StatusTypeDef status;
-	uint8_t bat = GetBatteryLevel();
+	uint32_t hz = (dev < SENS_ID_NBR) ? _sensOps[dev].i2cHz : SENS_NFC4_I2C_HZ;
 
-	sensBuffer_Reset();
+	I2C_SetSpeed(_hi2c, (hz > clockProf_I2CMaxHz()) ? clockProf_I2CMaxHz() : hz);	// speed of the clock profile
+}
 
-	sensBuffer_Add("bat:%d%% ", (int)(((double)bat / 254.0) * 100.0));
+/**
+ * @brief adding the sample to the statistics of channel, the summary is done at the end of cycle (sensors_Summary)
+ * the readings within the warm-up of the sensor (latencyMS) are given to the detector only, they are not valid
+ */
+static void sensors_AddSample(SENS_ChannelDef ch, int32_t value)
+{
+	int8_t valid = 1;
+
+	for (int i = 0; i < SENS_ID_NBR; i++)
+	{
+		if (!_sensState[i].isOn || !(_sensOps[i].chMask & (1 << ch)))
+			continue;
+		if (_sensOps[i].ch == ch)
+			convDetector_Add(&_sensState[i].conv, value);
+		if (!convDetector_IsWarm(&_sensState[i].conv))
+			valid = 0;
+	}
+	if (valid)
+		statAgg_Add(&_stats[ch], value);
+}
+
+/**
+ * @brief the sensor is in reading
+ */
+static int8_t sensors_IsOn(sensId_t id)
+{
+	return _sensState[id].isOn;
+}
+
+/**
+ * @brief the reading of sensor is finished, sensor is switched off individually
+ */
+static void sensors_Settle(sensId_t id)
+{
+	sensState_t *s = &_sensState[id];
+
+	if (!s->isOn)
+		return;
+	s->isOn = 0;
+	TRACE_END(TRACE_SENSOR, id);
+	sensors_Bus(id);
+	_sensOps[id].off(_hi2c);
+	writeLog("%s:off, reading %d", _sensOps[id].name, _processReadingCount);
+}
+
+/**
+ * @brief init of absent device can be called (xxx_Is tryInit), the backoff has been elapsed
+ */
+static int8_t sensors_TryInit(uint8_t dev)
+{
+	return presence_IsProbe(&_presence, dev) ? 1 : 0;
+}
 
-	if (tempHum_Is(_hi2c, _tryInit))
+/**
+ * @brief the presence of device is stored, absent sensor is finished (nothing to wait for)
+ */
+static int8_t sensors_Present(uint8_t dev, int8_t isPresent)
+{
+	presence_Set(&_presence, dev, isPresent);
+	if (!isPresent && dev < SENS_ID_NBR && _sensState[dev].isOn)
 	{
-		status = tempHum_Read(_hi2c);
-		if (status == HAL_OK) //
-			sensBuffer_Add("temp:%d hum:%d ", (int) (_tempHumData.temperature * 100.0f), (int) (_tempHumData.humidity * 100.0f));
+		_sensState[dev].isOn = 0;
+		TRACE_END(TRACE_SENSOR, dev);
 	}
+	return isPresent;
+}
+
+/**
+ * @brief settled sensors are switched off
+ * @retval 1 - all sensors are finished
+ */
+static int8_t sensors_CheckSettled()
+{
+	int8_t allDone = 1;
 
-	if (ambient_Is(_hi2c, _tryInit))
+	for (int i = 0; i < SENS_ID_NBR; i++)
 	{
-		status = ambient_ReadLux(_hi2c);
-		if (status == HAL_OK) //
-			sensBuffer_Add("lux:%d ", (int) (_ambientData.lux * 100.0f));
+		if (!_sensState[i].isOn)
+			continue;
+		if (convDetector_IsSettled(&_sensState[i].conv))
+			sensors_Settle(i);
+		else
+			allDone = 0;
 	}
+	return allDone;
+}
 
-	if (barometer_Is(_hi2c, _tryInit))
+/**
+ * @brief start of cycle, the sensors due by own cadence are reading (close deadlines are coalesced)
+ */
+static void sensors_ConvStart()
+{
+	uint32_t interval = sensors_GetInterval();
+
+	for (int i = 0; i < SENS_ID_NBR; i++)
+		_sensCadence[i].Interval = interval * _sensOps[i].cadence;
+	_sensDue = (uint8_t) cadence_Take(_sensCadence, SENS_ID_NBR, _sensPowered, HAL_GetTick(), SENS_COALESCE_MS);
+	_sensDueChannels = (1 << SENS_CH_BAT);
+	for (int i = 0; i < SENS_ID_NBR; i++)
 	{
-		status = barometer_Read(_hi2c);
-		if (status == HAL_OK)
-			sensBuffer_Add("pressure:%d, temp:%d ", (int) (_tempBarometerData.pressure * 100.0f), (int) (_tempBarometerData.temperature * 100.0f));
+		_sensState[i].isOn = (_sensDue >> i) & 1;
+		if (_sensState[i].isOn)
+		{
+			_sensDueChannels |= _sensOps[i].chMask;
+			TRACE_BEGIN(TRACE_SENSOR, i);
+		}
+		convDetector_Start(&_sensState[i].conv);
 	}
+}
+
+/**
+ * @brief time (ms) to the next cycle, the nearest deadline of sensors
+ */
+static uint32_t sensors_NextDelay()
+{
+	uint32_t delay = cadence_NextDelay(_sensCadence, SENS_ID_NBR, _sensPowered, HAL_GetTick());
+
+	if (delay == UINT32_MAX)	// no sensor, the battery only
+		return sensors_GetInterval();
+	return (delay < SENS_WAKEUP_MIN_MS) ? SENS_WAKEUP_MIN_MS : delay;
+}
+
+/**
+ * @brief start of cycle, statistics are cleared
+ */
+static void sensors_StatReset()
+{
+	for (int i = 0; i < SENS_CH_NBR; i++)
+		statAgg_Reset(&_stats[i]);
+}
 
-	if (flash_Is(&_flash, _tryInit))
+/**
+ * @brief the value of channel (x div) with decimals, right aligned to width, "--" - no value
+ */
+static void sensors_NDEFField(char *out, SENS_ChannelDef ch, int32_t div, uint8_t decimals, uint8_t width)
+{
+	char txt[16] = "--";
+
+	if (_report.ValidMask & (1 << ch))
 	{
-		char buf1[20] = { }, buf2[20] = { };
-		sprintf(buf1, "tick:%" PRIu32, HAL_GetTick());
-		status = flash_WritePage(&_flash, 0x400, (const uint8_t*) buf1, strlen(buf1) + 1);
-		writeLog("flash wr data:'%s' error:%d", buf1, (int) status);
-		// reading test
-		status = flash_Read(&_flash, 0x400, (uint8_t*) buf2, sizeof(buf2) - 1);
-		writeLog("flash rd data:'%s' error:%d", buf2, (int) status);
+		int32_t v = _report.Value[ch];
+		uint32_t unit = (decimals > 0) ? div / 10 : div;	// resolution of the printed value
+		uint32_t r = ((uint32_t) ((v < 0) ? -v : v) + unit / 2) / unit;
+
+		if (decimals > 0)
+			sprintf(txt, "%s%lu.%lu", (v < 0) ? "-" : "", (unsigned long) (r / 10), (unsigned long) (r % 10));
+		else
+			sprintf(txt, "%s%lu", (v < 0) ? "-" : "", (unsigned long) r);
 	}
+	sprintf(out, "%*s", width, txt);
+}
 
-	if (nfc4_Is(_hi2c, _tryInit))
+/**
+ * @brief the latest readings and health to NDEF text in the tag, only changed blocks are written
+ * the fields have fixed width, so the change of value doesn't move the rest of text
+ */
+static void sensors_PublishNDEF()
+{
+	char text[SENS_NDEF_SIZE];
+	char t[8], h[8], p[8], l[8], co2[8], pm[8], bat[8];
+	uint32_t first = 0, next = 0, now = HAL_GetTick();	// the start of the update, the write does not shift the interval
+	uint16_t written = 0;
+	HAL_StatusTypeDef status;
+
+	if (!presence_Is(&_presence, SENS_DEV_NFC4))
+		return;
+	if (_ndefWritten && now - _ndefLast < SENS_NDEF_INTERVAL_MS)
+		return;
+	sensors_Bus(SENS_DEV_NFC4);
+	// content of EEPROM after reset, the unchanged blocks are not written again
+	if (!_ndefShadowValid)
 	{
-		uint8_t dat;
+		if (nfc4_ReadEEPROM(_hi2c, 0, _ndefShadow, SENS_NDEF_SIZE) != HAL_OK)
+			return;
+		_ndefShadowValid = 1;
+	}
 
-		// uint16_t addr, uint8_t *pData, uint16_t len
-		status = nfc4_ReadEEPROM(_hi2c, 0, &dat, 1);
-		if (status == HAL_OK)
-			sensBuffer_Add("nfc4 read:%d ", (int) dat);
+	sensors_NDEFField(t, SENS_CH_TEMP, 100, 1, 5);
+	sensors_NDEFField(h, SENS_CH_HUM, 100, 0, 3);
+	sensors_NDEFField(p, SENS_CH_PRESSURE, 100, 1, 6);
+	sensors_NDEFField(l, SENS_CH_LUX, 100, 0, 6);
+	sensors_NDEFField(co2, SENS_CH_CO2, 1, 0, 5);
+	sensors_NDEFField(pm, SENS_CH_PM25, 100, 1, 5);
+	sensors_NDEFField(bat, SENS_CH_BAT, 1, 0, 3);
+	if (_historyReady)
+		sensorsFlash_GetRange(&first, &next);
+	calendar_Set(&_ndefCalendar, _cycleTime);
+	sprintf(text, "T %s C  RH %s %%\nP %s hPa  L %s lx\nCO2 %s ppm  PM2.5 %s\nBat %s %%  tier %u  dev %02X\n#%7lu  %04u-%02u-%02u %02u:%02u",
+		t, h, p, l, co2, pm, bat, (unsigned) _governor.Tier, (unsigned) _presence.Present, (unsigned long) next,
+		(unsigned) _ndefCalendar.Year, (unsigned) _ndefCalendar.Month, (unsigned) _ndefCalendar.Day,
+		(unsigned) _ndefCalendar.Hours, (unsigned) _ndefCalendar.Minutes);
+
+	if (nfc4_BuildNDEFText(_ndefImage, SENS_NDEF_SIZE, text) == 0)
+		return;
+	TRACE_BEGIN(TRACE_I2C, SENS_DEV_NFC4);
+	status = nfc4_UpdateEEPROM(_hi2c, 0, _ndefImage, _ndefShadow, SENS_NDEF_SIZE, &written);
+	TRACE_END(TRACE_I2C, SENS_DEV_NFC4);
+	if (status != HAL_OK)
+		_ndefShadowValid = 0;	// the blocks of the failed write are unknown
+	else if (written > 0)
+	{
+		_ndefLast = now;
+		_ndefWritten = 1;
 	}
+	sensBuffer_Add("ndef:%u B ", (unsigned) written);
+}
+
+/**
+ * @brief send-on-delta deadbands, values are x100
+ */
+static void sensors_SetBands(deltaReporter_t *v)
+{
+	deltaReporter_SetBand(v, SENS_CH_TEMP, 20, 0);		// 0.2 °C
+	deltaReporter_SetBand(v, SENS_CH_HUM, 200, 0);		// 2 %
+	deltaReporter_SetBand(v, SENS_CH_PRESSURE, 50, 0);	// 0.5 hPa
+	deltaReporter_SetBand(v, SENS_CH_LUX, 1000, 100);	// 10 %, min. 10 lux
+	deltaReporter_SetBand(v, SENS_CH_CO2, 50, 50);		// 5 %, min. 50 ppm
+	deltaReporter_SetBand(v, SENS_CH_PM25, 200, 100);	// 10 %, min. 2 ug/m3
+	deltaReporter_SetBand(v, SENS_CH_BAT, 5, 0);		// 5 %
+}
+
+/**
+ * @brief end of cycle, the mean of channels is used for the reporting
+ * the flash record (last values of all channels) is stored only if a channel is out of its deadband since the last
+ * record or in the full cycle (the sensor of the slowest cadence is read, all others are coalesced with it)
+ */
+static void sensors_Summary()
+{
+	int32_t values[SENS_CH_NBR];
 
-	if (scd41_Is(_hi2c, _tryInit))
+	sensBuffer_Reset();
+	// timestamp of the record, the batch is full - new base
+	if (!tsBatch_Add(&_tsBatch, _cycleTime, _cycleMs, &_cycleOffset))
 	{
-		status = scd41_Read(_hi2c);
-		switch (status)
+		tsBatch_Reset(&_tsBatch);
+		tsBatch_Add(&_tsBatch, _cycleTime, _cycleMs, &_cycleOffset);
+	}
+	_cycleBase = _tsBatch.Base;
+	_cycleStamped = 1;
+	sensBuffer_Add("t:%lu+%u ", (unsigned long) _cycleBase, (unsigned) _cycleOffset);
+	for (int i = 0; i < SENS_CH_NBR; i++)
+	{
+		const statAgg_t *st = &_stats[i];
+
+		if (st->Count == 0)
 		{
-			case HAL_OK:
-				sensBuffer_Add("scd41 co2:%d temp:%d hum:%d ", (int) _scd41Data.co2, (int) (_scd41Data.temperature * 100.0f), (int) (_scd41Data.humidity * 100.0f));
-			break;
-			case HAL_BUSY:
-				//sensBuffer_Add("scd41 busy ");
-			break;
-			default:
-				sensBuffer_Add("scd41 error:%d ", (int) status);
-			break;
+			// the sensor of channel is not due in this cycle - last value is kept
+			if (_sensDueChannels & (1 << i))
+			{
+				deltaReporter_Invalidate(&_report, i);
+				deltaReporter_Invalidate(&_history, i);
+			}
+			continue;
 		}
+		deltaReporter_SetValue(&_report, i, statAgg_GetMean(st));
+		deltaReporter_SetValue(&_history, i, statAgg_GetMean(st));
+		sensBuffer_Add("ch%d:%d/%d/%d sd:%d n:%d ", i, (int) st->Min, (int) statAgg_GetMean(st), (int) st->Max, (int) statAgg_GetStdDev(st), (int) st->Count);
+	}
+	// history of cycles for the NFC download, the full cycle or a change
+	if (_historyReady && (_sensDue == _sensPowered || deltaReporter_IsReport(&_history)))
+	{
+		for (int i = 0; i < SENS_CH_NBR; i++)
+			values[i] = (_history.ValidMask & (1 << i)) ? _history.Value[i] : SFLASH_NO_VALUE;
+		spi_OnOff(1);
+		if (sensorsFlash_Append(_cycleTime, values) != HAL_OK)
+			sensBuffer_Add("history error ");
+		else
+			deltaReporter_Reported(&_history);
+		spi_OnOff(0);
 	}
+	sensors_PublishNDEF();
+	if (nfcXfer_CheckTimeout(&_nfcXfer))
+		sensBuffer_Add("nfc timeout:%lu ", (unsigned long) _nfcXfer.Timeouts);
+	if (_sensBuffer[0])
+	{
+		strcat(_sensBuffer, "\r\n");
+		writeLogNL(_sensBuffer);
+	}
+}
 
-	if (sps30_Is(_hi2c, 1))
+HAL_StatusTypeDef sensors_GetTimestamp(uint32_t *base, uint16_t *offset)
+{
+	if (!_cycleStamped)
+		return HAL_ERROR;
+	*base = _cycleBase;
+	*offset = _cycleOffset;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef sensors_GetStat(SENS_ChannelDef ch, sensStat_t *stat)
+{
+	if (ch >= SENS_CH_NBR || _stats[ch].Count == 0)
+		return HAL_ERROR;
+
+	const statAgg_t *st = &_stats[ch];
+
+	stat->min = st->Min;
+	stat->max = st->Max;
+	stat->mean = statAgg_GetMean(st);
+	stat->stdDev = statAgg_GetStdDev(st);
+	stat->count = st->Count;
+	stat->rejected = st->Rejected;
+	return HAL_OK;
+}
+
+void sensors_OnOff(int8_t onOff)
+{
+	if (onOff)
 	{
-		status = sps30_Read(_hi2c);
-		switch (status)
-		{
-			case HAL_OK:
+		writeLog("Sensors:on");
+		for (int i = 0; i < SENS_ID_NBR; i++)
+			if (_sensState[i].isOn)
 			{
-				char *txt = NULL;
-
-				sps30_ClassifyPM25(&txt);
-				sensBuffer_Add("sps30: %s ", ((txt != NULL) ? txt : "(none)"));
+				sensors_Bus(i);
+				_sensOps[i].on(_hi2c);
 			}
-			break;
-			case HAL_BUSY:
-				//sensBuffer_Add("sps30 busy ");
-			break;
-			default:
-				sensBuffer_Add("sps30 error:%d ", (int) status);
-			break;
+	}
+	else
+	{
+		writeLog("Sensors:off");
+		for (int i = 0; i < SENS_ID_NBR; i++)
+		{
+			sensors_Bus(i);
+			_sensOps[i].off(_hi2c);
+		}
+	}
+}
+
+static void sensors_SampleTempHum(HAL_StatusTypeDef status)
+{
+	if (status != HAL_OK)
+		return;
+	sensBuffer_Add("temp:%d hum:%d ", (int) (_tempHumData.temperature * 100.0f), (int) (_tempHumData.humidity * 100.0f));
+	sensors_AddSample(SENS_CH_TEMP, (int32_t) (_tempHumData.temperature * 100.0f));
+	sensors_AddSample(SENS_CH_HUM, (int32_t) (_tempHumData.humidity * 100.0f));
+}
+
+static void sensors_SampleAmbient(HAL_StatusTypeDef status)
+{
+	if (status != HAL_OK)
+		return;
+	sensBuffer_Add("lux:%d ", (int) (_ambientData.lux * 100.0f));
+	sensors_AddSample(SENS_CH_LUX, (int32_t) (_ambientData.lux * 100.0f));
+}
+
+static void sensors_SampleBarometer(HAL_StatusTypeDef status)
+{
+	if (status != HAL_OK)
+		return;
+	sensBuffer_Add("pressure:%d, temp:%d ", (int) (_tempBarometerData.pressure * 100.0f), (int) (_tempBarometerData.temperature * 100.0f));
+	sensors_AddSample(SENS_CH_PRESSURE, (int32_t) (_tempBarometerData.pressure * 100.0f));
+}
+
+static void sensors_SampleSCD41(HAL_StatusTypeDef status)
+{
+	switch (status)
+	{
+		case HAL_OK:
+			sensBuffer_Add("scd41 co2:%d temp:%d hum:%d ", (int) _scd41Data.co2, (int) (_scd41Data.temperature * 100.0f), (int) (_scd41Data.humidity * 100.0f));
+			sensors_AddSample(SENS_CH_CO2, (int32_t) _scd41Data.co2);
+		break;
+		case HAL_BUSY:
+			//sensBuffer_Add("scd41 busy ");
+		break;
+		default:
+			sensBuffer_Add("scd41 error:%d ", (int) status);
+		break;
+	}
+}
+
+static void sensors_SampleSPS30(HAL_StatusTypeDef status)
+{
+	switch (status)
+	{
+		case HAL_OK:
+		{
+			char *txt = NULL;
+
+			sps30_ClassifyPM25(&txt);
+			sensBuffer_Add("sps30: %s ", ((txt != NULL) ? txt : "(none)"));
+			sensors_AddSample(SENS_CH_PM25, (int32_t) (_sps30Data.mass_pm2_5 * 100.0f));
 		}
+		break;
+		case HAL_BUSY:
+			//sensBuffer_Add("sps30 busy ");
+		break;
+		default:
+			sensBuffer_Add("sps30 error:%d ", (int) status);
+		break;
+	}
+}
+
+static HAL_StatusTypeDef sensors_AmbientInitWarm(I2C_HandleTypeDef *hi2c)
+{
+	return ambient_InitWarm(hi2c, _ambientWarmGain);
+}
+
+/**
+ * @brief reading sensor one by one
+ */
+void sensors_Read()
+{
+	uint8_t bat = GetBatteryLevel();
+
+	sensBuffer_Reset();
+
+	sensBuffer_Add("bat:%d%% ", (int)(((double)bat / 254.0) * 100.0));
+	sensors_AddSample(SENS_CH_BAT, (int32_t)(((uint32_t) bat * 100) / 254));
+
+	for (int i = 0; i < SENS_ID_NBR; i++)
+	{
+		const sensOps_t *op = &_sensOps[i];
+
+		if (!sensors_IsOn(i))
+			continue;
+		sensors_Bus(i);
+		TRACE_BEGIN(TRACE_I2C, i);
+		if (sensors_Present(i, op->is(_hi2c, sensors_TryInit(i))))
+			op->sample(op->read(_hi2c));
+		TRACE_END(TRACE_I2C, i);
 	}
 
+	// flash has been plugged later, the head of history
+	spi_OnOff(1);
+	if (sensors_Present(SENS_DEV_FLASH, flash_Is(&_flash, sensors_TryInit(SENS_DEV_FLASH))) && !_historyReady)
+		_historyReady = (sensorsFlash_Init(&_flash) == HAL_OK);
+	spi_OnOff(0);
+
+	// the tag can be plugged later, NDEF area is read again (sensors_PublishNDEF)
+	sensors_Bus(SENS_DEV_NFC4);
+	TRACE_BEGIN(TRACE_I2C, SENS_DEV_NFC4);
+	if (!sensors_Present(SENS_DEV_NFC4, nfc4_Is(_hi2c, sensors_TryInit(SENS_DEV_NFC4))))
+		_ndefShadowValid = 0;
+	TRACE_END(TRACE_I2C, SENS_DEV_NFC4);
+
 	if (_sensBuffer[0])
 	{
 		strcat(_sensBuffer, "\r\n");
@@ -193,51 +662,204 @@ void sensors_Read()
 
 
 
+static uint32_t sensors_SnapshotCheck(uint32_t presence, uint32_t state)
+{
+	return ((presence ^ 0xA5C3E10F) + (state << 7)) ^ (presence >> 11);
+}
+
+/**
+ * @brief reading of the snapshot stored before reset
+ * @retval 1 - snapshot is valid (warm boot), 0 - cold boot (power on, backup domain reset)
+ */
+static int8_t sensors_LoadSnapshot(uint16_t *presence, uint8_t *gain)
+{
+	uint32_t pres = HAL_RTCEx_BKUPRead(&hrtc, SENS_BKP_PRESENCE);
+	uint32_t state = HAL_RTCEx_BKUPRead(&hrtc, SENS_BKP_STATE);
+
+	if ((pres >> 16) != SENS_BKP_MAGIC || HAL_RTCEx_BKUPRead(&hrtc, SENS_BKP_CHECK) != sensors_SnapshotCheck(pres, state))
+		return 0;
+	*presence = (uint16_t) pres;
+	*gain = (uint8_t) state;
+	return 1;
+}
+
+/**
+ * @brief the snapshot of devices (presence, gain) for warm boot, written only if changed
+ */
+static void sensors_SaveSnapshot()
+{
+	uint32_t pres = ((uint32_t) SENS_BKP_MAGIC << 16) | _presence.Present;
+	uint32_t state = ambient_GetGain();
+
+	if (HAL_RTCEx_BKUPRead(&hrtc, SENS_BKP_PRESENCE) == pres && HAL_RTCEx_BKUPRead(&hrtc, SENS_BKP_STATE) == state)
+		return;
+	HAL_RTCEx_BKUPWrite(&hrtc, SENS_BKP_PRESENCE, pres);
+	HAL_RTCEx_BKUPWrite(&hrtc, SENS_BKP_STATE, state);
+	HAL_RTCEx_BKUPWrite(&hrtc, SENS_BKP_CHECK, sensors_SnapshotCheck(pres, state));
+}
+
+static HAL_StatusTypeDef sensors_NFCPut(const uint8_t *data, uint16_t len)
+{
+	return nfc4_WriteMailbox(_hi2c, data, len);
+}
+
+static HAL_StatusTypeDef sensors_NFCRecord(uint32_t seq, uint8_t *record)
+{
+	return sensorsFlash_Read(seq, (sensRecord_t*) record);
+}
+
+// the history in flash, downloaded by mailbox of NFC4 tag
+static const nfcXferIO_t _nfcXferIO = { .put = sensors_NFCPut, .range = sensorsFlash_GetRange, .read = sensors_NFCRecord, .recSize = sizeof(sensRecord_t) };
+
 void sensors_Init(I2C_HandleTypeDef *hi2c)
 {
 	HAL_StatusTypeDef status;
+	uint32_t bootTick = HAL_GetTick();
+	uint16_t warmPresence = 0;
+	int8_t warm = sensors_LoadSnapshot(&warmPresence, &_ambientWarmGain);
 
 	_hi2c = hi2c;
+	presence_Inic(&_presence, _presenceBackoffMin, _presenceBackoffMax);
 	// initialization of individual sensors
-	status = tempHum_Init(_hi2c);
-	writeLog((status == HAL_OK) ? "tempHum23 sensor: Init OK" : "tempHum23 sensor: Init failed.");
-
-	status = ambient_Init(_hi2c);
-	writeLog((status == HAL_OK) ? "ambient21 sensor: Init OK" : "ambient21 sensor: Init failed.");
+	// warm boot - the sensors were initialized before reset, only presence is checked,
+	// absent devices are not initialized (presence backoff re-initializes them later)
+	_scd41Data.altitude = 340;	// RV
+	for (int i = 0; i < SENS_ID_NBR; i++)
+	{
+		const sensOps_t *op = &_sensOps[i];
 
-	status = barometer_Init(_hi2c);
-	writeLog((status == HAL_OK) ? "barometer8 sensor: Init OK" : "barometer8 sensor: Init failed.");
+		sensors_Bus(i);
+		if (!warm || op->initWarm == NULL)
+			status = op->init(_hi2c);
+		else
+			status = (warmPresence & (1 << i)) ? op->initWarm(_hi2c) : HAL_ERROR;
+		presence_Set(&_presence, i, status == HAL_OK);
+		writeLog("%s sensor: %s", op->name, (status == HAL_OK) ? "Init OK" : "Init failed.");
+	}
 
+	spi_OnOff(1);
 	status = flash_Init(&_flash);
+	presence_Set(&_presence, SENS_DEV_FLASH, status == HAL_OK);
 	writeLog((status == HAL_OK) ? "flash12 sensor: Init OK" : "flash12 sensor: Init failed.");
+	if (status == HAL_OK)
+	{
+		uint32_t first, next;
 
-	status = nfc4_Init(_hi2c);
+		_historyReady = (sensorsFlash_Init(&_flash) == HAL_OK);
+		sensorsFlash_GetRange(&first, &next);
+		writeLog("history: %lu records from %lu", (unsigned long) (next - first), (unsigned long) first);
+	}
+	spi_OnOff(0);
+
+	sensors_Bus(SENS_DEV_NFC4);
+	if (!warm)
+		status = nfc4_Init(_hi2c);
+	else
+		status = (warmPresence & (1 << SENS_DEV_NFC4)) ? nfc4_InitWarm(_hi2c) : HAL_ERROR;
+	presence_Set(&_presence, SENS_DEV_NFC4, status == HAL_OK);
 	writeLog((status == HAL_OK) ? "nfc4 tag: Init OK" : "nfc4 tag: Init failed.");
 
-	_scd41Data.altitude = 340;	// RV
-	status = scd41_Init(_hi2c);
-	writeLog((status == HAL_OK) ? "sdc41 senzor: Init OK" : "sdc41 senzor: Init failed.");
+	sensors_OnOff(0);	// on start, all sensors OFF
+	nfcXfer_Inic(&_nfcXfer, &_nfcXferIO);	// the download is driven by NFC_INT (GPO of mailbox events)
+	sensors_SaveSnapshot();
+	writeLog("Sensors init (%s boot): %d ms", warm ? "warm" : "cold", (int) (HAL_GetTick() - bootTick));
 
-	status = sps30_Init(_hi2c);
-	writeLog((status == HAL_OK) ? "sps30 senzor: Init OK" : "sps30 senzor: Init failed.");
+	tsBatch_Inic(&_tsBatch, SENS_TS_RESOLUTION);
 
-	sensors_OnOff(0);	// on start, all sensors OFF
+	// send-on-delta deadbands of the uplink and of the flash history
+	deltaReporter_Inic(&_report, SENS_CH_NBR, _reportHeartbeat);
+	sensors_SetBands(&_report);
+	deltaReporter_Inic(&_history, SENS_CH_NBR, 0);
+	sensors_SetBands(&_history);
+
+	// statistics of cycle, median of 5 samples for outlier rejection (same units as deadbands)
+	for (int i = 0; i < SENS_CH_NBR; i++)
+		statAgg_Inic(&_stats[i], 5, 0);
+	statAgg_Inic(&_stats[SENS_CH_TEMP], 5, 200);		// 2 °C
+	statAgg_Inic(&_stats[SENS_CH_HUM], 5, 1000);		// 10 %
+	statAgg_Inic(&_stats[SENS_CH_PRESSURE], 5, 500);	// 5 hPa
+	statAgg_Inic(&_stats[SENS_CH_CO2], 5, 500);		// 500 ppm
+
+	// settled readings: warm-up, max. time, slope and variance (units of channels)
+	for (int i = 0; i < SENS_ID_NBR; i++)
+	{
+		const sensOps_t *op = &_sensOps[i];
+
+		convDetector_Inic(&_sensState[i].conv, op->latencyMS, op->settleMaxMS, op->slopeMax, op->varMax);
+	}
+}
+
+uint16_t sensors_GetPresence()
+{
+	return _presence.Present;
+}
+
+int8_t sensors_IsReport()
+{
+	return deltaReporter_IsReport(&_report) ? 1 : 0;
+}
+
+uint8_t sensors_GetPayload(uint8_t *buffer, uint8_t size)
+{
+	uint8_t len = 1;
+
+	if (size < SENS_PAYLOAD_SIZE)
+		return 0;
+	buffer[0] = (uint8_t) _report.ValidMask;
+	for (int i = 0; i < SENS_CH_NBR; i++)
+	{
+		if (!(_report.ValidMask & (1 << i)))
+			continue;
+		int32_t v = _report.Value[i] / _payloadDiv[i];
+		if (i == SENS_CH_TEMP)	// only signed channel
+			v = (v < INT16_MIN) ? INT16_MIN : (v > INT16_MAX) ? INT16_MAX : v;
+		else
+			v = (v < 0) ? 0 : (v > UINT16_MAX) ? UINT16_MAX : v;
+		buffer[len++] = (uint8_t) ((uint32_t) v >> 8);
+		buffer[len++] = (uint8_t) v;
+	}
+	return len;
+}
+
+void sensors_Reported()
+{
+	deltaReporter_Reported(&_report);
+	tsBatch_Reset(&_tsBatch);	// next record starts new batch
 }
 
 
 
 void sensors_NFCInt()
 {
-	writeLog("nfc4 tag interrupt");	// don't know what to do with this.... and whether it makes sense
-	nfc4_ProcessMailBox(&hi2c2);
-	//nfc4_WriteMailBoxNDEF(&hi2c2, "picus");
+	// I2C of the tag, SPI of the history download, initialized only if they have been gated by STOP2
+	clockProfile_t clock = clockProf_Set(CLOCK_MID);	// I/O bound
+
+	i2c_OnOff(1);
+	spi_OnOff(1);
+	sensors_Bus(SENS_DEV_NFC4);
+	TRACE_BEGIN(TRACE_I2C, SENS_DEV_NFC4);
+	if (nfc4_ProcessMailBox(_hi2c) != HAL_OK)
+		writeLog("nfc4 tag interrupt: mailbox error");
+	TRACE_END(TRACE_I2C, SENS_DEV_NFC4);
+	spi_OnOff(0);
+	i2c_OnOff(0);
+	clockProf_Set(clock);
 }
 
 void nfc4_OnMailboxData(uint8_t *data, uint16_t len)
 {
-//	int stop=0;
-//	writeLog("mam data");
-	// this doesn't work, MailBox just doesn't work, giving up on it.....
+	nfcXfer_OnData(&_nfcXfer, data, len);
+}
+
+void nfc4_OnMailboxRead()
+{
+	nfcXfer_OnRead(&_nfcXfer);
+}
+
+void nfc4_OnFieldChange(uint8_t onOff)
+{
+	nfcXfer_OnField(&_nfcXfer, onOff);
+	writeLog("nfc4 field:%d, frames:%lu resent:%lu", (int) onOff, (unsigned long) _nfcXfer.Frames, (unsigned long) _nfcXfer.Resent);
 }
 
 ///////////////////////////////////////////////////////////////////
@@ -258,11 +880,14 @@ SENS_ProcessDef sensors_Work()
 		switch (_processDef)
 		{
 			case SENS_BEGIN:
-				i2c_OnOff(1);	// I2C on
 				sleeper_SetSleepMS(&_processDelay, 500);	// little pause after init after
 				_processDef = SENS_START;
 			break;
 			case SENS_START:
+				_cycleTime = timeSync_Now(&_cycleMs);
+				sensors_Govern(SYS_GetBatteryLevel());	// battery without load of sensors
+				sensors_StatReset();
+				sensors_ConvStart();
 				sensors_OnOff(1);	// start sensors
 				sleeper_SetSleepMS(&_processDelay, _processReadTimeout);	// reading data from sensor every x seconds
 				_processDef = SENS_READ;
@@ -273,17 +898,19 @@ SENS_ProcessDef sensors_Work()
 					sensors_Read();
 					sleeper_Next(&_processDelay);
 					HAL_GPIO_TogglePin(USER_LED_GPIO_Port, USER_LED_Pin);
+					if (!sensors_CheckSettled())
+						break;	// next reading, otherwise all readings are settled - finish now
 				}
-				else
-				{
-					_processDef = SENS_STOP;
-					_processDelay.SleepMS = 0;	// stop timer
-					HAL_GPIO_WritePin(USER_LED_GPIO_Port, USER_LED_Pin, GPIO_PIN_RESET);
-				}
+				_processDef = SENS_STOP;
+				_processDelay.SleepMS = 0;	// stop timer
+				HAL_GPIO_WritePin(USER_LED_GPIO_Port, USER_LED_Pin, GPIO_PIN_RESET);
 			break;
 			case SENS_STOP:
-				sensors_OnOff(0);	// stop sensors
-				i2c_OnOff(0);
+				sensors_Summary();
+				for (int i = 0; i < SENS_ID_NBR; i++)	// stop sensors not settled yet
+					sensors_Settle(i);
+				writeLog("Sensors:off");
+				sensors_SaveSnapshot();
 				_processDef = SENS_DONE;
 				_processDelay.SleepMS = 0;	// stop timer
 			break;
@@ -300,15 +927,31 @@ SENS_ProcessDef sensors_Work()
  */
 static void tasksensors_Work()
 {
-	SENS_ProcessDef s = sensors_Work();
+	SENS_ProcessDef s;
+	clockProfile_t clock = clockProf_Set(CLOCK_LOW);	// I2C, conversion waits, logging - I/O bound
 
-	if (SENS_DONE == s)	// reading has been finished, start timer
-		UTIL_TIMER_Start(&_sensorTimerReading);
+	// I2C is held only by the step, it is not initialized again by the wakeups between readings
+	i2c_OnOff(1);
+	s = sensors_Work();
+	i2c_OnOff(0);
+	clockProf_Set(clock);
+
+	if (SENS_DONE == s)	// reading has been finished
+	{
+		if (_sensorCoordinated)
+			sensors_OnReadDone();	// data are fresh, the uplink can be sent in the same active window
+		else
+		{
+			// next cycle at the nearest deadline of sensors
+			UTIL_TIMER_SetPeriod(&_sensorTimerReading, sensors_NextDelay());
+			UTIL_TIMER_Start(&_sensorTimerReading);	// start timer
+		}
+	}
 	else
 		UTIL_SEQ_SetTask((1 << _sensorSeqID), CFG_SEQ_Prio_0);	// next calling of tasksensors_Work
 }
 
-static void tasksensors_OnTimeout()
+static void tasksensors_OnTimeout(void *context)
 {
 	sensors_Start();
 	UTIL_SEQ_SetTask((1 << _sensorSeqID), CFG_SEQ_Prio_0);	// start of tasksensors_Work
@@ -321,6 +964,97 @@ void sensorsSeq_Init(uint32_t sensortAppBit)
 {
 	_sensorSeqID = sensortAppBit;
 	UTIL_SEQ_RegTask((1 << _sensorSeqID), UTIL_SEQ_RFU, tasksensors_Work);
-	UTIL_TIMER_Create(&_sensorTimerReading, _sensorTimeout, UTIL_TIMER_ONESHOT, tasksensors_OnTimeout, NULL);
-	UTIL_TIMER_Start(&_sensorTimerReading);
+	UTIL_TIMER_Create(&_sensorTimerReading, sensors_GetInterval(), UTIL_TIMER_ONESHOT, tasksensors_OnTimeout, NULL);
+	if (!_sensorCoordinated)
+		UTIL_TIMER_Start(&_sensorTimerReading);
+}
+
+void sensors_SetCoordinated(uint8_t onOff)
+{
+	_sensorCoordinated = onOff;
+	if (_sensorCoordinated)
+		UTIL_TIMER_Stop(&_sensorTimerReading);
+}
+
+void sensors_GetConfig(sensConfig_t *cfg)
+{
+	cfg->interval = _sensorTimeout;
+	cfg->readPause = (uint16_t) _processReadTimeout;
+	cfg->readingMax = (uint8_t) _processReadingMax;
+	cfg->enabled = _sensEnabled;
+}
+
+HAL_StatusTypeDef sensors_SetConfig(const sensConfig_t *cfg)
+{
+	if (cfg->interval < 1000 || cfg->readPause == 0 || cfg->readingMax == 0)
+		return HAL_ERROR;
+	_processReadTimeout = cfg->readPause;	// next reading in cycle
+	_processReadingMax = cfg->readingMax;
+	_sensEnabled = cfg->enabled & ((1 << SENS_ID_NBR) - 1);	// next cycle
+	_sensPowered = _sensEnabled & batGovernor_Get(&_governor)->Enabled;
+	if (_sensorTimeout != cfg->interval)
+	{
+		_sensorTimeout = cfg->interval;
+		for (int i = 0; i < SENS_ID_NBR; i++)	// all sensors are due in the next cycle
+			_sensCadence[i].Started = 0;
+		// the waiting for next cycle is restarted (running timer), otherwise the timer is started by the end of cycle
+		// coordinated reading - the timer is planned by sensors_StartAt
+		if (!_sensorCoordinated)
+			UTIL_TIMER_SetPeriod(&_sensorTimerReading, sensors_GetInterval());
+	}
+	return HAL_OK;
+}
+
+uint32_t sensors_GetInterval()
+{
+	return _sensorTimeout * batGovernor_Get(&_governor)->Scale;
+}
+
+void sensors_Govern(uint16_t mV)
+{
+	const govTier_t *tier;
+
+	if (mV == 0)	// ADC failed
+		return;
+	if (batGovernor_Update(&_governor, mV))
+	{
+		tier = batGovernor_Get(&_governor);
+		writeLog("Power tier %d: %d mV, sensors 0x%02X, interval x%d", (int) _governor.Tier, (int) mV, (int) tier->Enabled, (int) tier->Scale);
+		sensors_OnPowerTier(tier->Scale);
+	}
+	_sensPowered = _sensEnabled & batGovernor_Get(&_governor)->Enabled;
+	// SCD41 heating needs the supply voltage, the reading would brown-out the board
+	if (mV < SENS_SCD41_MIN_MV)
+		_sensPowered &= ~(1 << SENS_ID_SCD41);
+}
+
+uint32_t sensors_GetCycleTime()
+{
+	// SENS_BEGIN pause + SENS_START pause + pauses after each reading (the last one ends in SENS_STOP)
+	// it is the upper bound, the reading finishes earlier when the readings are settled
+	return 500 + (uint32_t) _processReadTimeout * (_processReadingMax + 1);
+}
+
+void sensors_StartAt(uint32_t delayMS)
+{
+	UTIL_TIMER_Stop(&_sensorTimerReading);
+	if (_processDef != SENS_DONE)	// reading is running, the result comes via sensors_OnReadDone
+		return;
+	if (delayMS == 0)
+		tasksensors_OnTimeout(NULL);
+	else
+	{
+		UTIL_TIMER_SetPeriod(&_sensorTimerReading, delayMS);
+		UTIL_TIMER_Start(&_sensorTimerReading);
+	}
+}
+
+__weak void sensors_OnReadDone()
+{
+	// for the coordinated reading, must be overridden by the uplink coordinator
+}
+
+__weak void sensors_OnPowerTier(uint8_t scale)
+{
+	// the uplink rate is lowered by the coordinator
 }
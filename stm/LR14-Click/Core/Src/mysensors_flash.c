@@ -5,8 +5,115 @@
  * The LoRa is not connected, measure data are save to flash
  * The LoRa is just connected, the measure data are read from flash and remove after send to gateway
  *
+ * The records are appended to the ring, the history is read by NFC (nfcxfer.h)
+ *
  *  Created on: 15. 1. 2026
  *      Author: Milan
  */
 
+#include "mysensors_flash.h"
+
+static const flashCS_t *_sflash = NULL;	// NULL - no flash
+static uint32_t _sflashNext = 0;		// sequence number of the next record
+
+/**
+ * @brief address of the record in the ring
+ */
+static uint32_t sensorsFlash_Addr(uint32_t seq)
+{
+	uint32_t sector = (seq / SFLASH_RECORDS_PER_SECTOR) % SFLASH_SECTORS;
+
+	return SFLASH_START + sector * SFLASH_SECTOR + (seq % SFLASH_RECORDS_PER_SECTOR) * sizeof(sensRecord_t);
+}
+
+/**
+ * @brief sequence number of the slot, 0xFFFFFFFF - empty
+ */
+static uint32_t sensorsFlash_ReadSeq(uint32_t addr)
+{
+	uint32_t seq = 0xFFFFFFFF;
+
+	if (flash_Read(_sflash, addr, (uint8_t*) &seq, sizeof(seq)) != HAL_OK)
+		return 0xFFFFFFFF;
+	return seq;
+}
+
+HAL_StatusTypeDef sensorsFlash_Init(const flashCS_t *flash)
+{
+	uint32_t head = 0xFFFFFFFF;
+
+	_sflash = NULL;
+	_sflashNext = 0;
+	if (flash == NULL || flash->is <= 0)
+		return HAL_ERROR;
+	_sflash = flash;
+
+	// the sector with the highest sequence number at its head (the sequence must belong to the sector)
+	for (uint32_t i = 0; i < SFLASH_SECTORS; i++)
+	{
+		uint32_t seq = sensorsFlash_ReadSeq(SFLASH_START + i * SFLASH_SECTOR);
+
+		if (seq == 0xFFFFFFFF || sensorsFlash_Addr(seq) != SFLASH_START + i * SFLASH_SECTOR)
+			continue;
+		if (head == 0xFFFFFFFF || seq > head)
+			head = seq;
+	}
+	if (head == 0xFFFFFFFF)	// empty history
+		return HAL_OK;
+
+	// the last written slot of the head sector
+	_sflashNext = head + 1;
+	for (uint32_t seq = head + 1; seq < head + SFLASH_RECORDS_PER_SECTOR; seq++)
+	{
+		if (sensorsFlash_ReadSeq(sensorsFlash_Addr(seq)) != seq)
+			break;
+		_sflashNext = seq + 1;
+	}
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef sensorsFlash_Append(uint32_t time, const int32_t *values)
+{
+	sensRecord_t rec;
+	uint32_t addr;
+	HAL_StatusTypeDef status;
+
+	if (_sflash == NULL)
+		return HAL_ERROR;
+	addr = sensorsFlash_Addr(_sflashNext);
+	// the first record of the sector, the oldest records are erased
+	if (_sflashNext % SFLASH_RECORDS_PER_SECTOR == 0)
+		if ((status = flash_EraseSector(_sflash, addr)) != HAL_OK)
+			return status;
+
+	rec.seq = _sflashNext;
+	rec.time = time;
+	for (int i = 0; i < SENS_CH_NBR; i++)
+		rec.value[i] = values[i];
+	if ((status = flash_WriteBuffer(_sflash, addr, (uint8_t*) &rec, sizeof(rec))) != HAL_OK)
+		return status;
+	_sflashNext++;
+	return HAL_OK;
+}
+
+void sensorsFlash_GetRange(uint32_t *first, uint32_t *next)
+{
+	// the records of the other sectors and the written part of the head sector, the sector of next record can be erased
+	uint32_t headStart = _sflashNext - (_sflashNext % SFLASH_RECORDS_PER_SECTOR);
+	uint32_t keep = (SFLASH_SECTORS - 1) * SFLASH_RECORDS_PER_SECTOR;
+
+	*first = (headStart > keep) ? headStart - keep : 0;
+	*next = _sflashNext;
+}
+
+HAL_StatusTypeDef sensorsFlash_Read(uint32_t seq, sensRecord_t *rec)
+{
+	uint32_t first, next;
 
+	sensorsFlash_GetRange(&first, &next);
+	if (_sflash == NULL || seq < first || seq >= next)
+		return HAL_ERROR;
+	if (flash_Read(_sflash, sensorsFlash_Addr(seq), (uint8_t*) rec, sizeof(*rec)) != HAL_OK)
+		return HAL_ERROR;
+	return (rec->seq == seq) ? HAL_OK : HAL_ERROR;
+}
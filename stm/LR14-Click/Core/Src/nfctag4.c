@@ -9,17 +9,47 @@
 #define NFC4_I2C_ADDR_USER    (0x53 << 1) // User Memory/EEPROM
 #define NFC4_I2C_ADDR_SYSTEM  (0x57 << 1) // System Configuration
 
-// Register Addresses
+// Register Addresses, dynamic registers (user address)
 #define REG_GPO_CTRL_DYN      0x2000
-#define REG_MB_CTRL_DYN       0x000D //0x200D
-#define REG_MB_LEN_DYN        0x200E
+#define REG_I2C_SSO_DYN       0x2004	// bit 0 - I2C security session open
+#define REG_IT_STS_DYN        0x2005	// interrupt status, cleared by reading
+#define REG_MB_CTRL_DYN       0x2006
+#define REG_MB_LEN_DYN        0x2007	// length of message - 1
 #define REG_MB_RAM_START      0x2008
 
+// static registers (system address, EEPROM), written in the I2C security session
+#define REG_GPO               0x0000
+#define REG_MB_MODE           0x000D	// bit 0 - fast transfer mode authorized
+#define REG_I2C_PWD           0x0900
+
+// MB_CTRL_Dyn bits
+#define MB_CTRL_EN            0x01
+#define MB_CTRL_HOST_PUT_MSG  0x02	// message from I2C host is in mailbox
+#define MB_CTRL_RF_PUT_MSG    0x04	// message from RF is in mailbox
+
+// IT_STS_Dyn bits
+#define NFC4_IT_FIELD_FALLING 0x08
+#define NFC4_IT_FIELD_RISING  0x10
+#define NFC4_IT_RF_PUT_MSG    0x20
+#define NFC4_IT_RF_GET_MSG    0x40
+
+// GPO events: GPO_EN, RF_GET_MSG, RF_PUT_MSG, FIELD_CHANGE
+#define NFC4_GPO_CONFIG       0xB8
+
+// user EEPROM writing
+#define NFC4_EEPROM_SIZE      512	// ST25DV04K
+#define NFC4_PAGE_SIZE        256	// max. sequential write, the write does not cross the page
+#define NFC4_BLOCK_SIZE       4		// EEPROM is programmed by 4-byte blocks
+#define NFC4_BLOCK_WRITE_MS   5		// programming time of one block
+
 #include "i2c.h"
 #include "nfctag4.h"
+#include "utils/utils.h"
 #include <string.h>
 
 static int8_t _isNfctag4 = 0;	// indicator whether sensor is active
+static int8_t _isMailbox = 0;	// fast transfer mode is enabled
+static uint8_t _fillBuffer[NFC4_PAGE_SIZE];	// page of the fill value (nfc4_FillEEPROM)
 
 int8_t nfc4_Is(I2C_HandleTypeDef *hi2c, int8_t tryInit)
 {
@@ -30,13 +60,21 @@ int8_t nfc4_Is(I2C_HandleTypeDef *hi2c, int8_t tryInit)
 
 static HAL_StatusTypeDef nfc4_PresentPassword(I2C_HandleTypeDef *hi2c)
 {
-	// Total 17 bytes: [0x09 (Validation Code)] + [8-byte PWD] + [8-byte PWD]
+	// Total 17 bytes: [8-byte PWD] + [0x09 (Validation Code)] + [8-byte PWD]
 	uint8_t pwd_payload[17];
-	pwd_payload[0] = 0x09;
-	memset(&pwd_payload[1], 0x00, 16); // Default 8x 00h, repeated twice
+	uint8_t sso = 0;
+	HAL_StatusTypeDef status;
+
+	memset(pwd_payload, 0x00, sizeof(pwd_payload)); // Default 8x 00h, repeated twice
+	pwd_payload[8] = 0x09;
 
 	// MUST be written to 0x0900 in SYSTEM address space
-	return HAL_I2C_Mem_Write(hi2c, NFC4_I2C_ADDR_SYSTEM, 0x0900, 2, pwd_payload, 17, 200);
+	if ((status = HAL_I2C_Mem_Write(hi2c, NFC4_I2C_ADDR_SYSTEM, REG_I2C_PWD, 2, pwd_payload, 17, 200)) != HAL_OK)
+		return status;
+	// session is open - the password is correct
+	if ((status = HAL_I2C_Mem_Read(hi2c, NFC4_I2C_ADDR_USER, REG_I2C_SSO_DYN, 2, &sso, 1, 100)) != HAL_OK)
+		return status;
+	return (sso & 0x01) ? HAL_OK : HAL_ERROR;
 }
 
 static HAL_StatusTypeDef nfc4_onOff(I2C_HandleTypeDef *hi2c, uint8_t onOff)
@@ -107,15 +145,12 @@ static HAL_StatusTypeDef nfc4_onOff(I2C_HandleTypeDef *hi2c, uint8_t onOff)
 
 HAL_StatusTypeDef nfc4_On(I2C_HandleTypeDef *hi2c)
 {
-	// Configure GPO for ALL events:
-	// 0x95 = GPO_EN(1), MsgReady(1), WriteEEPROM(1), FieldChange(1)
-	return nfc4_onOff(hi2c, 0x95);
+	// GPO_CTRL_Dyn: GPO_EN(1), the events are selected by static GPO register (NFC4_GPO_CONFIG)
+	return nfc4_onOff(hi2c, 0x01);
 }
 
 HAL_StatusTypeDef nfc4_Off(I2C_HandleTypeDef *hi2c)
 {
-	// Configure GPO for ALL events:
-	// 0x95 = GPO_EN(1), MsgReady(1), WriteEEPROM(1), FieldChange(1)
 	return nfc4_onOff(hi2c, 0x00);
 }
 
@@ -129,64 +164,97 @@ HAL_StatusTypeDef nfc4_IsOn(I2C_HandleTypeDef *hi2c, uint8_t *onOff)
 		status = HAL_I2C_Mem_Read(hi2c, NFC4_I2C_ADDR_USER, REG_GPO_CTRL_DYN, I2C_MEMADD_SIZE_16BIT, &reg_val, 1, 100);
 		if (status == HAL_OK)
 			if (onOff != NULL)
-				*onOff = (reg_val & 0x80) != 0;
+				*onOff = (reg_val & 0x01) != 0;
 	}
 	return status;
 }
 
+/**
+ * @brief ACK polling of the EEPROM programming, the tag NACKs its address until the write cycle is finished
+ * @param blocks - count of programmed blocks, the timeout is 2x the programming time
+ */
+static HAL_StatusTypeDef nfc4_WaitWrite(I2C_HandleTypeDef *hi2c, uint16_t devAddr, uint16_t blocks)
+{
+	uint32_t timeout = 2 * NFC4_BLOCK_WRITE_MS * (uint32_t) blocks + 2;
+	uint32_t start = HAL_GetTick();
+
+	while (HAL_I2C_IsDeviceReady(hi2c, devAddr, 1, 1) != HAL_OK)
+	{
+		if (HAL_GetTick() - start > timeout)
+			return HAL_TIMEOUT;
+		HAL_Delay(1);
+	}
+	return HAL_OK;
+}
+
+/**
+ * @brief write of the static register (system EEPROM) if changed, the I2C security session must be open
+ */
+static HAL_StatusTypeDef nfc4_WriteStatic(I2C_HandleTypeDef *hi2c, uint16_t reg, uint8_t value)
+{
+	uint8_t current = 0;
+	HAL_StatusTypeDef status = HAL_I2C_Mem_Read(hi2c, NFC4_I2C_ADDR_SYSTEM, reg, 2, &current, 1, 100);
+
+	if (status != HAL_OK || current == value)
+		return status;
+	if ((status = HAL_I2C_Mem_Write(hi2c, NFC4_I2C_ADDR_SYSTEM, reg, 2, &value, 1, 100)) != HAL_OK)
+		return status;
+	return nfc4_WaitWrite(hi2c, NFC4_I2C_ADDR_SYSTEM, 1);
+}
+
+/**
+ * @brief fast transfer mode: MB_MODE and GPO events (static, once), the mailbox is enabled and cleared (dynamic)
+ */
+static HAL_StatusTypeDef nfc4_MailboxInit(I2C_HandleTypeDef *hi2c)
+{
+	HAL_StatusTypeDef status;
+	uint8_t reg_val;
+
+	if ((status = nfc4_PresentPassword(hi2c)) != HAL_OK)
+		return status;
+	if ((status = nfc4_WriteStatic(hi2c, REG_MB_MODE, 0x01)) != HAL_OK)
+		return status;
+	if ((status = nfc4_WriteStatic(hi2c, REG_GPO, NFC4_GPO_CONFIG)) != HAL_OK)
+		return status;
+
+	// MB_EN 0 -> 1 clears the mailbox (message of previous session)
+	reg_val = 0x00;
+	if ((status = HAL_I2C_Mem_Write(hi2c, NFC4_I2C_ADDR_USER, REG_MB_CTRL_DYN, I2C_MEMADD_SIZE_16BIT, &reg_val, 1, 100)) != HAL_OK)
+		return status;
+	reg_val = MB_CTRL_EN;
+	return HAL_I2C_Mem_Write(hi2c, NFC4_I2C_ADDR_USER, REG_MB_CTRL_DYN, I2C_MEMADD_SIZE_16BIT, &reg_val, 1, 100);
+}
+
 HAL_StatusTypeDef nfc4_Init(I2C_HandleTypeDef *hi2c)
 {
 	HAL_StatusTypeDef status;
-	uint8_t reg_val, i; //, session_status = 0;
 
 	do
 	{
 		// 1. Wait for device to be ready
 		if ((status = I2C_IsDeviceReadyMT(hi2c, NFC4_I2C_ADDR_USER, 10, 100)) != HAL_OK)
 			break;
-#if 0
-		// 2. Present Password to modify system registers
-		if ((status = nfc4_PresentPassword(hi2c)) != HAL_OK)
-			break;
-
-		// --- CRITICAL: Wait for the Session to stabilize ---
-		HAL_Delay(50);
-
-		// 3. Requires Password presentation first - this doesn't work
-
-		 reg_val = 0x01;
-		 if ((status = HAL_I2C_Mem_Write(hi2c, NFC4_I2C_ADDR_SYSTEM, 0x000D, 2, &reg_val, 1, 100)) != HAL_OK)
-		 break;
-#endif
-
-		// 4. Enable Mailbox (Dynamic RAM)
-		// We use a small loop because the RF field might cause a NACK
-		reg_val = 0x01;
-		for (i = 0; i < 5; i++)
-		{
-			status = HAL_I2C_Mem_Write(hi2c, NFC4_I2C_ADDR_USER, REG_MB_CTRL_DYN, I2C_MEMADD_SIZE_16BIT, &reg_val, 1, 100);
-			if (status == HAL_OK)
-				break;	// for
-			HAL_Delay(10);
-		}
-		if (status != HAL_OK)
-			break;
+		_isNfctag4 = 1;
 
-		// --- CRITICAL: Wait for the Session to stabilize ---
-		HAL_Delay(50);
+		// 2. fast transfer mode, the EEPROM works without it (wrong password)
+		_isMailbox = (nfc4_MailboxInit(hi2c) == HAL_OK);
+		// GPO stays enabled for the mailbox events (INT), it signals only on RF activity
+		if (_isMailbox)
+			nfc4_On(hi2c);
+		else
+			nfc4_Off(hi2c);
+	} while (0);
+	return status;
+}
 
-		// 5. FORCE CLEAR the status (The "Deadlock Breaker")
-		// This forces Bit 0 (Host Put) and Bit 1 (RF Put) to 0.
-		reg_val = 0x00;
-		if ((status = HAL_I2C_Mem_Write(hi2c, NFC4_I2C_ADDR_USER, REG_MB_CTRL_DYN, I2C_MEMADD_SIZE_16BIT, &reg_val, 1, 100)) != HAL_OK)
-			break;
+HAL_StatusTypeDef nfc4_InitWarm(I2C_HandleTypeDef *hi2c)
+{
+	// mailbox has been enabled before MCU reset (tag is powered), presence only
+	HAL_StatusTypeDef status = I2C_IsDeviceReadyMT(hi2c, NFC4_I2C_ADDR_USER, 2, 2);
+	uint8_t mbCtrl = 0;
 
-		// --- MANDATORY DELAY ---
-		// The chip needs time to process the Mailbox Enable before changing GPO settings
-		HAL_Delay(20);
-		_isNfctag4 = 1;
-		nfc4_Off(hi2c);
-	} while (0);
+	_isNfctag4 = (status == HAL_OK);
+	_isMailbox = (_isNfctag4 && HAL_I2C_Mem_Read(hi2c, NFC4_I2C_ADDR_USER, REG_MB_CTRL_DYN, 2, &mbCtrl, 1, 100) == HAL_OK && (mbCtrl & MB_CTRL_EN));
 	return status;
 }
 
@@ -195,75 +263,199 @@ HAL_StatusTypeDef nfc4_ReadEEPROM(I2C_HandleTypeDef *hi2c, uint16_t addr, uint8_
 	return (_isNfctag4) ? HAL_I2C_Mem_Read(hi2c, NFC4_I2C_ADDR_USER, addr, 2, pData, len, 500) : HAL_ERROR;
 }
 
+/**
+ * @brief sequential write within one page, blocks are programmed after the stop condition
+ */
+static HAL_StatusTypeDef nfc4_WritePage(I2C_HandleTypeDef *hi2c, uint16_t addr, uint8_t *pData, uint16_t len)
+{
+	// blocks touched by the write (unaligned start/end are programmed as the whole block)
+	uint16_t blocks = (uint16_t) ((addr + len + NFC4_BLOCK_SIZE - 1) / NFC4_BLOCK_SIZE - addr / NFC4_BLOCK_SIZE);
+	HAL_StatusTypeDef status = HAL_I2C_Mem_Write(hi2c, NFC4_I2C_ADDR_USER, addr, 2, pData, len, 100 + len);
+
+	if (status != HAL_OK)
+		return status;
+	return nfc4_WaitWrite(hi2c, NFC4_I2C_ADDR_USER, blocks);
+}
+
 HAL_StatusTypeDef nfc4_WriteEEPROM(I2C_HandleTypeDef *hi2c, uint16_t addr, uint8_t *pData, uint16_t len)
 {
 	HAL_StatusTypeDef status = HAL_ERROR;
 
 	if (_isNfctag4)
-		for (uint16_t i = 0; i < len; i += 4)
-		{ // ST25DV writes in blocks
-			uint16_t chunk = (len - i) > 4 ? 4 : (len - i);
-			status = HAL_I2C_Mem_Write(hi2c, NFC4_I2C_ADDR_USER, addr + i, 2, &pData[i], chunk, 100);
-			HAL_Delay(5); // EEPROM write cycle time
-			if (status != HAL_OK)
+		while (len > 0)
+		{
+			// up to the end of page, then next page
+			uint16_t chunk = NFC4_PAGE_SIZE - (addr % NFC4_PAGE_SIZE);
+
+			if (chunk > len)
+				chunk = len;
+			if ((status = nfc4_WritePage(hi2c, addr, pData, chunk)) != HAL_OK)
 				return status;
+			addr += chunk;
+			pData += chunk;
+			len -= chunk;
 		}
 	return status;
 }
 
-void nfc4_ResetEEPROM(I2C_HandleTypeDef *hi2c, uint16_t len)
+HAL_StatusTypeDef nfc4_FillEEPROM(I2C_HandleTypeDef *hi2c, uint16_t addr, uint8_t value, uint16_t len)
 {
-	uint8_t zero = 0;
+	HAL_StatusTypeDef status = HAL_ERROR;
 
+	memset(_fillBuffer, value, sizeof(_fillBuffer));
 	if (_isNfctag4)
-		for (uint16_t i = 0; i < len; i++)
+		while (len > 0)
 		{
-			nfc4_WriteEEPROM(hi2c, i, &zero, 1);
+			uint16_t chunk = NFC4_PAGE_SIZE - (addr % NFC4_PAGE_SIZE);
+
+			if (chunk > len)
+				chunk = len;
+			if ((status = nfc4_WritePage(hi2c, addr, _fillBuffer, chunk)) != HAL_OK)
+				return status;
+			addr += chunk;
+			len -= chunk;
 		}
+	return status;
+}
+
+void nfc4_ResetEEPROM(I2C_HandleTypeDef *hi2c, uint16_t len)
+{
+	nfc4_FillEEPROM(hi2c, 0, 0, len);
 }
 
 HAL_StatusTypeDef nfc4_ProcessMailBox(I2C_HandleTypeDef *hi2c)
 {
-	uint8_t mb_ctrl, mb_len;
+	uint8_t itSts = 0, mbCtrl = 0, mbLen = 0;
+	HAL_StatusTypeDef status;
 
-	if (_isNfctag4)
+	if (!_isMailbox)
+		return HAL_ERROR;
+
+	// events since the last interrupt (cleared by reading)
+	if ((status = HAL_I2C_Mem_Read(hi2c, NFC4_I2C_ADDR_USER, REG_IT_STS_DYN, 2, &itSts, 1, 100)) != HAL_OK)
+		return status;
+	if (itSts & NFC4_IT_FIELD_RISING)
+		nfc4_OnFieldChange(1);
+	if (itSts & NFC4_IT_RF_GET_MSG)	// our message has been read by RF, the mailbox is free
+		nfc4_OnMailboxRead();
+
+	// message from RF (phone)
+	if ((status = HAL_I2C_Mem_Read(hi2c, NFC4_I2C_ADDR_USER, REG_MB_CTRL_DYN, 2, &mbCtrl, 1, 100)) != HAL_OK)
+		return status;
+	if (mbCtrl & MB_CTRL_RF_PUT_MSG)
 	{
-		// Check if Mailbox has a message from RF (Phone)
-		HAL_I2C_Mem_Read(hi2c, NFC4_I2C_ADDR_USER, REG_MB_CTRL_DYN, 2, &mb_ctrl, 1, 100);
-
-		if (mb_ctrl & 0x02)
-		{ // RF Put Msg bit
-			HAL_I2C_Mem_Read(hi2c, NFC4_I2C_ADDR_USER, REG_MB_LEN_DYN, 2, &mb_len, 1, 100);
-			uint8_t buffer[256];
-			uint16_t msg_len = mb_len + 1;
-
-			HAL_I2C_Mem_Read(hi2c, NFC4_I2C_ADDR_USER, REG_MB_RAM_START, 2, buffer, msg_len, 200);
-			nfc4_OnMailboxData(buffer, msg_len);
-			return HAL_OK;
-		}
+		uint8_t buffer[NFC4_MAILBOX_SIZE];
+		uint16_t msg_len;
+
+		if ((status = HAL_I2C_Mem_Read(hi2c, NFC4_I2C_ADDR_USER, REG_MB_LEN_DYN, 2, &mbLen, 1, 100)) != HAL_OK)
+			return status;
+		msg_len = (uint16_t) mbLen + 1;
+		if ((status = HAL_I2C_Mem_Read(hi2c, NFC4_I2C_ADDR_USER, REG_MB_RAM_START, 2, buffer, msg_len, 200)) != HAL_OK)
+			return status;
+		nfc4_OnMailboxData(buffer, msg_len);
 	}
-	return HAL_ERROR;
+	if (itSts & NFC4_IT_FIELD_FALLING)
+		nfc4_OnFieldChange(0);
+	return HAL_OK;
 }
 
-HAL_StatusTypeDef nfc4_WriteMailBoxNDEF(I2C_HandleTypeDef *hi2c, char *text)
+HAL_StatusTypeDef nfc4_WriteMailbox(I2C_HandleTypeDef *hi2c, const uint8_t *data, uint16_t len)
 {
-	if (!_isNfctag4)
+	uint8_t mbCtrl = 0;
+	HAL_StatusTypeDef status;
+
+	if (!_isMailbox || len == 0 || len > NFC4_MAILBOX_SIZE)
 		return HAL_ERROR;
+	if ((status = HAL_I2C_Mem_Read(hi2c, NFC4_I2C_ADDR_USER, REG_MB_CTRL_DYN, 2, &mbCtrl, 1, 100)) != HAL_OK)
+		return status;
+	// previous message has not been read yet, or RF request is waiting
+	if (mbCtrl & (MB_CTRL_HOST_PUT_MSG | MB_CTRL_RF_PUT_MSG))
+		return HAL_BUSY;
+	// RF communication can NACK the I2C access
+	for (uint8_t i = 0; i < 5; i++)
+	{
+		status = HAL_I2C_Mem_Write(hi2c, NFC4_I2C_ADDR_USER, REG_MB_RAM_START, 2, (uint8_t*) data, len, 100 + len);
+		if (status == HAL_OK)
+			break;
+		HAL_Delay(2);
+	}
+	return status;
+}
 
-	uint8_t payload[128];
-	uint8_t text_len = strlen(text);
+int8_t nfc4_IsMailbox()
+{
+	return _isMailbox;
+}
+
+__weak void nfc4_OnMailboxData(uint8_t *data, uint16_t len)
+{
+}
+
+__weak void nfc4_OnMailboxRead()
+{
+}
+
+__weak void nfc4_OnFieldChange(uint8_t onOff)
+{
+}
+
+uint16_t nfc4_BuildNDEFText(uint8_t *image, uint16_t size, const char *text)
+{
+	uint16_t text_len = strlen(text);
+	uint16_t msg_len = text_len + 7;	// record header, status and language
+	uint16_t pos = 0;
+
+	// CC + TLV (short length) + record + terminator
+	if (msg_len > 254 || 4 + 2 + msg_len + 1 > size)
+		return 0;
+
+	// Capability Container of Type 5 tag: magic, version 1.0 read/write, memory size / 8, no special features
+	image[pos++] = 0xE1;
+	image[pos++] = 0x40;
+	image[pos++] = NFC4_EEPROM_SIZE / 8;
+	image[pos++] = 0x00;
+
+	// NDEF message TLV
+	image[pos++] = 0x03;
+	image[pos++] = (uint8_t) msg_len;
 
 	// Simple NDEF Text Record Wrapper
-	payload[0] = 0xD1; // MB=1, ME=1, SR=1, Tnf=1 (NFC Forum Well-known type)
-	payload[1] = 0x01; // Type Length
-	payload[2] = text_len + 3; // Payload Length (3 bytes for status/lang + text)
-	payload[3] = 'T';  // Type: Text
-	payload[4] = 0x02; // Status: UTF-8, "en" length = 2
-	payload[5] = 'e';  // 'e'
-	payload[6] = 'n';  // 'n'
-	memcpy(&payload[7], text, text_len);
-
-	return HAL_I2C_Mem_Write(hi2c, NFC4_I2C_ADDR_USER, REG_MB_RAM_START, 2, payload, text_len + 7, 200);
+	image[pos++] = 0xD1; // MB=1, ME=1, SR=1, Tnf=1 (NFC Forum Well-known type)
+	image[pos++] = 0x01; // Type Length
+	image[pos++] = text_len + 3; // Payload Length (3 bytes for status/lang + text)
+	image[pos++] = 'T';  // Type: Text
+	image[pos++] = 0x02; // Status: UTF-8, "en" length = 2
+	image[pos++] = 'e';  // 'e'
+	image[pos++] = 'n';  // 'n'
+	memcpy(&image[pos], text, text_len);
+	pos += text_len;
+	image[pos++] = 0xFE;	// terminator TLV
+
+	// the rest is cleared, the unused blocks stay the same between updates
+	memset(&image[pos], 0x00, size - pos);
+	return pos;
+}
+
+HAL_StatusTypeDef nfc4_UpdateEEPROM(I2C_HandleTypeDef *hi2c, uint16_t addr, const uint8_t *image, uint8_t *shadow, uint16_t len, uint16_t *written)
+{
+	HAL_StatusTypeDef status = HAL_OK;
+	uint16_t pos = 0, start = 0, run;
+
+	if (written != NULL)
+		*written = 0;
+	if (!_isNfctag4)
+		return HAL_ERROR;
+	// only the changed blocks are programmed (addr is aligned to the block)
+	while ((run = blockDiff_Run(shadow, image, len, pos, NFC4_BLOCK_SIZE, &start)) > 0)
+	{
+		if ((status = nfc4_WriteEEPROM(hi2c, addr + start, (uint8_t*) &image[start], run)) != HAL_OK)
+			break;
+		memcpy(&shadow[start], &image[start], run);
+		if (written != NULL)
+			*written += run;
+		pos = start + run;
+	}
+	return status;
 }
 
 HAL_StatusTypeDef nfc4_SetRFMgmt(I2C_HandleTypeDef *hi2c, uint8_t enable)
@@ -0,0 +1,213 @@
+/*
+ * nfcxfer.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ */
+
+#include "nfcxfer.h"
+
+static uint8_t _frame[NFCX_FRAME_MAX];	// message for mailbox
+
+static void nfcXfer_Put32(uint8_t *p, uint32_t value)
+{
+	p[0] = (uint8_t) value;
+	p[1] = (uint8_t) (value >> 8);
+	p[2] = (uint8_t) (value >> 16);
+	p[3] = (uint8_t) (value >> 24);
+}
+
+static uint32_t nfcXfer_Get32(const uint8_t *p)
+{
+	return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static void nfcXfer_Error(nfcXfer_t *x, uint8_t tag, uint8_t error)
+{
+	_frame[0] = NFCX_ERROR;
+	_frame[1] = tag;
+	_frame[2] = error;
+	x->io->put(_frame, NFCX_HEADER + 1);
+}
+
+/**
+ * @brief DATA frame from the cursor, count 0 - end of download
+ */
+static void nfcXfer_SendChunk(nfcXfer_t *x)
+{
+	uint32_t left = x->End - x->Cursor;
+	uint8_t count = nfcXfer_PerFrame(x);
+	uint16_t len = NFCX_DATA_HEADER;
+	HAL_StatusTypeDef status;
+
+	if (x->Cursor >= x->End)
+		count = 0;
+	else if (left < count)
+		count = (uint8_t) left;
+	_frame[0] = NFCX_DATA;
+	_frame[1] = x->Tag;
+	nfcXfer_Put32(&_frame[2], x->Cursor);
+	_frame[6] = count;
+	for (uint8_t i = 0; i < count; i++, len += x->io->recSize)
+		if (x->io->read(x->Cursor + i, &_frame[len]) != HAL_OK)
+		{
+			x->State = NFCX_IDLE;
+			nfcXfer_Error(x, x->Tag, NFCX_ERR_READ);
+			return;
+		}
+
+	x->Chunk = count;
+	status = x->io->put(_frame, len);
+	x->Waiting = (status == HAL_BUSY);	// written again on the next event
+	if (status == HAL_OK)
+		x->Frames++;
+	else if (status != HAL_BUSY)
+		x->State = NFCX_IDLE;
+}
+
+void nfcXfer_Inic(nfcXfer_t *x, const nfcXferIO_t *io)
+{
+	x->io = io;
+	x->State = NFCX_IDLE;
+	x->Tag = 0;
+	x->Field = 0;
+	x->Chunk = 0;
+	x->Waiting = 0;
+	x->Cursor = 0;
+	x->End = 0;
+	x->EventTick = 0;
+	x->Frames = 0;
+	x->Resent = 0;
+	x->Timeouts = 0;
+}
+
+uint8_t nfcXfer_PerFrame(const nfcXfer_t *x)
+{
+	uint16_t count = (NFCX_FRAME_MAX - NFCX_DATA_HEADER) / x->io->recSize;
+
+	return (count > 255) ? 255 : (uint8_t) count;
+}
+
+void nfcXfer_OnData(nfcXfer_t *x, const uint8_t *data, uint16_t len)
+{
+	uint32_t first, next, from;
+	uint8_t tag;
+
+	if (len < NFCX_HEADER)
+	{
+		nfcXfer_Error(x, 0, NFCX_ERR_LEN);
+		return;
+	}
+	tag = data[1];
+	x->EventTick = HAL_GetTick();
+	x->io->range(&first, &next);
+	switch (data[0])
+	{
+		case NFCX_CMD_INFO:
+			_frame[0] = NFCX_CMD_INFO | NFCX_RESPONSE;
+			_frame[1] = tag;
+			nfcXfer_Put32(&_frame[2], first);
+			nfcXfer_Put32(&_frame[6], next);
+			_frame[10] = x->io->recSize;
+			_frame[11] = nfcXfer_PerFrame(x);
+			x->io->put(_frame, 12);
+		break;
+		case NFCX_CMD_GET:
+		{
+			uint16_t count;
+
+			if (len < NFCX_HEADER + 6)
+			{
+				nfcXfer_Error(x, tag, NFCX_ERR_LEN);
+				break;
+			}
+			from = nfcXfer_Get32(&data[2]);
+			count = (uint16_t) data[6] | ((uint16_t) data[7] << 8);
+			if (from < first)	// the oldest records have been overwritten
+				from = first;
+			if (from >= next)
+			{
+				nfcXfer_Error(x, tag, NFCX_ERR_RANGE);
+				break;
+			}
+			x->End = (count == 0xFFFF || next - from < count) ? next : from + count;
+			x->Cursor = from;
+			x->Tag = tag;
+			x->State = NFCX_STREAM;
+			nfcXfer_SendChunk(x);
+		}
+		break;
+		case NFCX_CMD_RESUME:
+			if (len < NFCX_HEADER + 4)
+			{
+				nfcXfer_Error(x, tag, NFCX_ERR_LEN);
+				break;
+			}
+			if (x->State == NFCX_IDLE)
+			{
+				nfcXfer_Error(x, tag, NFCX_ERR_STATE);
+				break;
+			}
+			// the phone knows what it has received, the records can be sent again
+			from = nfcXfer_Get32(&data[2]);
+			x->Cursor = (from < first) ? first : from;
+			x->Tag = tag;
+			x->State = NFCX_STREAM;
+			x->Resent++;
+			nfcXfer_SendChunk(x);
+		break;
+		case NFCX_CMD_STOP:
+			x->State = NFCX_IDLE;
+			x->Waiting = 0;
+			_frame[0] = NFCX_CMD_STOP | NFCX_RESPONSE;
+			_frame[1] = tag;
+			x->io->put(_frame, NFCX_HEADER);
+		break;
+		default:
+			nfcXfer_Error(x, tag, NFCX_ERR_CMD);
+		break;
+	}
+}
+
+void nfcXfer_OnRead(nfcXfer_t *x)
+{
+	if (x->State != NFCX_STREAM)
+		return;
+	x->EventTick = HAL_GetTick();
+	if (!x->Waiting)	// otherwise the mailbox is free now, the frame has not been written yet
+	{
+		if (x->Chunk == 0)	// end of download has been read
+		{
+			x->State = NFCX_IDLE;
+			return;
+		}
+		x->Cursor += x->Chunk;
+	}
+	nfcXfer_SendChunk(x);
+}
+
+void nfcXfer_OnField(nfcXfer_t *x, uint8_t onOff)
+{
+	x->Field = onOff;
+	x->EventTick = HAL_GetTick();
+	if (!onOff)
+	{
+		// the frame in the mailbox can be lost, RESUME tells the next record
+		if (x->State == NFCX_STREAM)
+			x->State = NFCX_PAUSED;
+		x->Waiting = 0;
+	}
+	else if (x->State == NFCX_STREAM && x->Waiting)
+		nfcXfer_SendChunk(x);
+}
+
+uint8_t nfcXfer_CheckTimeout(nfcXfer_t *x)
+{
+	if (x->State == NFCX_IDLE || HAL_GetTick() - x->EventTick <= NFCX_TIMEOUT_MS)
+		return 0;
+	// the frame in the mailbox is not read any more, the phone starts again by GET
+	x->State = NFCX_IDLE;
+	x->Waiting = 0;
+	x->Timeouts++;
+	return 1;
+}
@@ -0,0 +1,127 @@
+/*
+ * pwrdomain.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ */
+
+#include "pwrdomain.h"
+#include "clockprof.h"
+#include "i2c.h"
+#include "spi.h"
+#include "usart.h"
+#include "adc.h"
+#include "utilities_conf.h"
+
+static void pwrDomain_UsartDeInit(void);
+static void pwrDomain_AdcDeInit(void);
+
+// operations of the domain
+typedef struct
+{
+	void (*init)(void);
+	void (*deInit)(void);
+} pwrDomainOps_t;
+
+static const pwrDomainOps_t _domainOps[PWR_DOMAIN_NBR] = {
+	{ MX_I2C2_Init, MX_I2C2_DeInit },
+	{ MX_SPI1_Init, MX_SPI1_DeInit },
+	{ MX_USART1_UART_Init, pwrDomain_UsartDeInit },	// DMA of TX is linked by MSP
+	{ MX_ADC_Init, pwrDomain_AdcDeInit }
+};
+
+static pwrDomain_t _domains[PWR_DOMAIN_NBR] = { };
+static uint8_t _domainStale[PWR_DOMAIN_NBR] = { };	// held across STOP2, registers are lost, not gated
+
+static void pwrDomain_UsartDeInit(void)
+{
+	HAL_UART_DeInit(&huart1);
+}
+
+static void pwrDomain_AdcDeInit(void)
+{
+	HAL_ADC_DeInit(&hadc);
+}
+
+/**
+ * @brief initialization of the peripheral, the held one is gated before (MSP is initialized again)
+ */
+static void pwrDomain_Up(pwrDomainId_t id)
+{
+	pwrDomain_t *d = &_domains[id];
+
+	if (_domainStale[id])
+	{
+		_domainOps[id].deInit();
+		_domainStale[id] = 0;
+	}
+	_domainOps[id].init();
+	clockProf_Retime(id);	// timings of the current clock profile
+	d->Ready = 1;
+	d->Inits++;
+	pwrDomain_OnReady(id);
+}
+
+void pwrDomain_Init(uint32_t readyMask)
+{
+	for (int i = 0; i < PWR_DOMAIN_NBR; i++)
+	{
+		_domains[i].Refs = 0;
+		_domains[i].Ready = (readyMask >> i) & 1;
+		_domains[i].Inits = 0;
+		_domains[i].DeInits = 0;
+		_domainStale[i] = 0;
+	}
+}
+
+void pwrDomain_Acquire(pwrDomainId_t id)
+{
+	UTILS_ENTER_CRITICAL_SECTION();
+	_domains[id].Refs++;
+	if (!_domains[id].Ready)
+		pwrDomain_Up(id);
+	UTILS_EXIT_CRITICAL_SECTION();
+}
+
+void pwrDomain_Release(pwrDomainId_t id)
+{
+	UTILS_ENTER_CRITICAL_SECTION();
+	if (_domains[id].Refs > 0)
+		_domains[id].Refs--;
+	UTILS_EXIT_CRITICAL_SECTION();
+}
+
+void pwrDomain_OnStop(void)
+{
+	for (int i = 0; i < PWR_DOMAIN_NBR; i++)
+	{
+		pwrDomain_t *d = &_domains[i];
+
+		if (!d->Ready)
+			continue;
+		d->Ready = 0;
+		if (d->Refs > 0)
+			_domainStale[i] = 1;	// initialized again after the wakeup
+		else
+		{
+			_domainOps[i].deInit();
+			d->DeInits++;
+		}
+	}
+}
+
+void pwrDomain_OnWake(void)
+{
+	for (int i = 0; i < PWR_DOMAIN_NBR; i++)
+		if (_domains[i].Refs > 0 && !_domains[i].Ready)
+			pwrDomain_Up(i);
+}
+
+const pwrDomain_t* pwrDomain_Get(pwrDomainId_t id)
+{
+	return &_domains[id];
+}
+
+__weak void pwrDomain_OnReady(pwrDomainId_t id)
+{
+}
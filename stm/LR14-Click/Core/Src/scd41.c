@@ -138,6 +138,14 @@ HAL_StatusTypeDef scd41_Init(I2C_HandleTypeDef *hi2c)
 	return ret;
 }
 
+HAL_StatusTypeDef scd41_InitWarm(I2C_HandleTypeDef *hi2c)
+{
+	HAL_StatusTypeDef ret = I2C_IsDeviceReadyMT(hi2c, SCD41_ADDR, 2, 2);	// presence only, no reinit (altitude is kept in sensor)
+
+	_isScd41 = (ret == HAL_OK);
+	return ret;
+}
+
 /**
  * @brief check if data is available
  * @retval HAL_OK - data is available, can be read, HAL_BUSY - data not yet available, HAL_ERROR - error
@@ -120,6 +120,14 @@ HAL_StatusTypeDef sps30_Init(I2C_HandleTypeDef *hi2c)
 	return status;
 }
 
+HAL_StatusTypeDef sps30_InitWarm(I2C_HandleTypeDef *hi2c)
+{
+	// sensor is sleeping (I2C is off in sleep mode), no wake-up and soft reset
+	// the presence is verified by sps30_On
+	_isSps30 = 1;
+	return HAL_OK;
+}
+
 HAL_StatusTypeDef sps30_On(I2C_HandleTypeDef *hi2c)
 {
 	HAL_StatusTypeDef status = HAL_ERROR;
@@ -25,8 +25,11 @@
 #include "usart_if.h"
 
 /* USER CODE BEGIN Includes */
-#include "spi.h"
 #include "radio.h"
+#include "pwrdomain.h"
+#include "clockprof.h"
+#include "sys_app.h"
+#include "trace.h"
 /* USER CODE END Includes */
 
 /* External variables ---------------------------------------------------------*/
@@ -66,7 +69,7 @@ const struct UTIL_LPM_Driver_s UTIL_PowerDriver =
 
 /* Private variables ---------------------------------------------------------*/
 /* USER CODE BEGIN PV */
-
+static uint32_t StopEntryCycles = 0;	/* entry overhead of STOP2, CPU cycles */
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -94,9 +97,10 @@ void PWR_EnterStopMode(void)
 {
   /* USER CODE BEGIN EnterStopMode_1 */
 //return;
-	// Deinitialize peripherals before entering stop mode
-	//MX_I2C2_DeInit();	// MT 10.1.2026 is in SensorOFF
-	MX_SPI1_DeInit();
+	// unused peripherals (I2C2, SPI1, USART1, ADC) are gated, the held ones are initialized again after wakeup
+	StopEntryCycles = DWT->CYCCNT;
+	TRACE_BEGIN(TRACE_STOP2, 0);
+	pwrDomain_OnStop();
 
   /* USER CODE END EnterStopMode_1 */
   HAL_SuspendTick();
@@ -104,7 +108,7 @@ void PWR_EnterStopMode(void)
   LL_PWR_ClearFlag_C1STOP_C1STB();
 
   /* USER CODE BEGIN EnterStopMode_2 */
-
+	StopEntryCycles = DWT->CYCCNT - StopEntryCycles;
   /* USER CODE END EnterStopMode_2 */
   HAL_PWREx_EnterSTOP2Mode(PWR_STOPENTRY_WFI);
   /* USER CODE BEGIN EnterStopMode_3 */
@@ -115,7 +119,18 @@ void PWR_EnterStopMode(void)
 void PWR_ExitStopMode(void)
 {
   /* USER CODE BEGIN ExitStopMode_1 */
-//return;
+	// After wakeup from stop mode, reconfigure system clock
+	// the peripherals (USART1 instead of vcom_Resume, SPI1) are initialized by the first use, not by every wakeup
+	uint32_t wake = DWT->CYCCNT;	// the counter is stopped in STOP2
+
+	HAL_ResumeTick();
+	SystemClock_Config();
+	clockProf_OnWake();
+	trace_Sync();	// the time of STOP2 is given by RTC
+	TRACE_END(TRACE_STOP2, 0);
+	pwrDomain_OnWake();
+	SYS_IdleLearn(StopEntryCycles + DWT->CYCCNT - wake);	// idle governor (sys_app.c)
+	return;
   /* USER CODE END ExitStopMode_1 */
   /* Resume sysTick : work around for debugger problem in dual core */
   HAL_ResumeTick();
@@ -127,10 +142,6 @@ void PWR_ExitStopMode(void)
   /* Resume not retained USARTx and DMA */
   vcom_Resume();
   /* USER CODE BEGIN ExitStopMode_2 */
-	// After wakeup from stop mode, reconfigure system clock
-	SystemClock_Config();
-	MX_SPI1_Init();
-	Uart_Start();
 
   /* USER CODE END ExitStopMode_2 */
 }
@@ -138,7 +149,7 @@ void PWR_ExitStopMode(void)
 void PWR_EnterSleepMode(void)
 {
   /* USER CODE BEGIN EnterSleepMode_1 */
-
+	TRACE_BEGIN(TRACE_SLEEP, 0);	// the cycle counter runs in Sleep
   /* USER CODE END EnterSleepMode_1 */
   /* Suspend sysTick */
   HAL_SuspendTick();
@@ -154,7 +165,7 @@ void PWR_EnterSleepMode(void)
 void PWR_ExitSleepMode(void)
 {
   /* USER CODE BEGIN ExitSleepMode_1 */
-
+	TRACE_END(TRACE_SLEEP, 0);
   /* USER CODE END ExitSleepMode_1 */
   /* Resume sysTick */
   HAL_ResumeTick();
@@ -32,7 +32,7 @@
 #include "sys_sensors.h"
 
 /* USER CODE BEGIN Includes */
-
+#include "idlegov.h"
 /* USER CODE END Includes */
 
 /* External variables ---------------------------------------------------------*/
@@ -54,7 +54,13 @@
 #define LORAWAN_MAX_BAT   254
 
 /* USER CODE BEGIN PD */
-
+/* currents of the idle governor (uA, 3.3 V, MSI 48 MHz, range 1) */
+#define IDLE_RUN_UA             3450
+#define IDLE_SLEEP_UA           1100
+#define IDLE_STOP2_UA           2       /* RTC on LSE */
+#define IDLE_STOP2_WAKEUP_US    5       /* regulator and MSI, not measured by the cycle counter */
+#define IDLE_OVERHEAD_US        300     /* expected overhead of STOP2 before the first measurement */
+#define IDLE_AWAKE_US           30      /* the timer interrupt is pending */
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -66,7 +72,7 @@
 static uint8_t SYS_TimerInitialisedFlag = 0;
 
 /* USER CODE BEGIN PV */
-
+static idleGov_t IdleGov;
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -83,7 +89,10 @@ static void TimestampNow(uint8_t *buff, uint16_t *size);
 static void tiny_snprintf_like(char *buf, uint32_t maxsize, const char *strFormat, ...);
 
 /* USER CODE BEGIN PFP */
-
+/**
+  * @brief time to the first timer deadline (us), 0 - the timer interrupt is pending, UINT32_MAX - no timer is running
+  */
+static uint32_t SYS_IdleTime(void);
 /* USER CODE END PFP */
 
 /* Exported functions ---------------------------------------------------------*/
@@ -131,6 +140,11 @@ void SystemApp_Init(void)
 #endif /* LOW_POWER_DISABLE */
 
   /* USER CODE BEGIN SystemApp_Init_2 */
+  /* the cycle counter measures the overhead of STOP2 */
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  idleGov_Inic(&IdleGov, IDLE_RUN_UA, IDLE_SLEEP_UA, IDLE_STOP2_UA, IDLE_OVERHEAD_US, IDLE_AWAKE_US);
 
   /* USER CODE END SystemApp_Init_2 */
 }
@@ -142,6 +156,20 @@ void UTIL_SEQ_Idle(void)
 {
   /* USER CODE BEGIN UTIL_SEQ_Idle_1 */
 //return;	//kokot
+  /* called with interrupts masked, the pending interrupt wakes up WFI or it is served after the return */
+  switch (idleGov_Decide(&IdleGov, SYS_IdleTime()))
+  {
+    case IDLE_AWAKE:
+      return;
+    case IDLE_SLEEP:
+      /* STOP2 does not pay off before the deadline */
+      UTIL_LPM_SetStopMode((1 << CFG_LPM_IDLE_Id), UTIL_LPM_DISABLE);
+      UTIL_LPM_EnterLowPower();
+      UTIL_LPM_SetStopMode((1 << CFG_LPM_IDLE_Id), UTIL_LPM_ENABLE);
+      return;
+    default:
+      break;
+  }
   /* USER CODE END UTIL_SEQ_Idle_1 */
   UTIL_LPM_EnterLowPower();
   /* USER CODE BEGIN UTIL_SEQ_Idle_2 */
@@ -253,6 +281,10 @@ void GetDevAddr(uint32_t *devAddr)
 }
 
 /* USER CODE BEGIN EF */
+void SYS_IdleLearn(uint32_t cycles)
+{
+  idleGov_Learn(&IdleGov, cycles / (SystemCoreClock / 1000000) + IDLE_STOP2_WAKEUP_US);
+}
 
 /* USER CODE END EF */
 
@@ -309,7 +341,24 @@ static void tiny_snprintf_like(char *buf, uint32_t maxsize, const char *strForma
 }
 
 /* USER CODE BEGIN PrFD */
+static uint32_t SYS_IdleTime(void)
+{
+  uint32_t ticks = UTIL_TIMER_GetFirstRemainingTime();
+  uint64_t us;
 
+  if (ticks == 0xFFFFFFFFU)
+  {
+    return UINT32_MAX;
+  }
+  if (HAL_NVIC_GetPendingIRQ(RTC_Alarm_IRQn))
+  {
+    return 0;   /* the deadline has elapsed */
+  }
+  /* the deadline is within the tick, half of the tick is expected */
+  us = (((uint64_t)ticks * 2 + 1) * 1000000) >> (RTC_N_PREDIV_S + 1);
+  /* saturated, the deadline is farther than ~71 minutes */
+  return (us > UINT32_MAX) ? UINT32_MAX : (uint32_t)us;
+}
 /* USER CODE END PrFD */
 
 /* HAL overload functions ---------------------------------------------------------*/
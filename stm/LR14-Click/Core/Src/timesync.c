@@ -0,0 +1,146 @@
+/*
+ * timesync.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ */
+
+#include "main.h"
+#include "timesync.h"
+#include "rtc.h"
+#include "timer_if.h"
+#include "utils/utils.h"
+
+#include "stm32_timer.h"
+#include "stm32_seq.h"
+#include "stm32_systime.h"
+#include "LmHandler.h"
+
+#define TSYNC_INTERVAL_MIN		3600000			// first sync interval (1 h)
+#define TSYNC_INTERVAL_MAX		604800000		// max. sync interval (7 days)
+#define TSYNC_MAX_ERROR			1000			// allowed time error at the end of interval (ms)
+#define TSYNC_ELAPSED_MAX		(30 * 24 * 3600)	// longer interval is not used for the estimate (s)
+#define TSYNC_EPOCH_VALID		1735689600		// 1.1.2025, older time was not set by the network
+#define TSYNC_CALIB_PULSES		1048576			// RTCCLK pulses of the 32 s calibration window, 1 pulse = 0.954 ppm
+
+static driftEst_t _drift;
+static UTIL_TIMER_Object_t _syncTimer;
+static uint32_t _syncTaskId = 0;
+static SysTime_t _syncOffset = { };		// offset of SysTime (network - RTC) at the last used sync
+static SysTime_t _syncRtc = { };		// RTC time at the last used sync
+static int8_t _syncValid = 0;			// the reference of sync is valid
+
+static void timeSync_OnTimer(void *context)
+{
+	UTIL_SEQ_SetTask((1 << _syncTaskId), CFG_SEQ_Prio_0);
+}
+
+static void timeSync_Schedule(uint32_t interval)
+{
+	UTIL_TIMER_Stop(&_syncTimer);
+	UTIL_TIMER_SetPeriod(&_syncTimer, interval);
+	UTIL_TIMER_Start(&_syncTimer);
+}
+
+/**
+ * @brief the applied smooth calibration (ppm x 100), the CALR is kept over the reset
+ */
+static int32_t timeSync_GetCalib()
+{
+	uint32_t calr = hrtc.Instance->CALR;
+	int32_t pulses = ((calr & RTC_CALR_CALP) ? 512 : 0) - (int32_t) (calr & RTC_CALR_CALM);
+
+	return (int32_t) (((int64_t) pulses * 100000000) / TSYNC_CALIB_PULSES);
+}
+
+/**
+ * @brief smooth calibration of RTC, + the RTC is speed up
+ */
+static HAL_StatusTypeDef timeSync_SetCalib(int32_t ppm)
+{
+	int32_t pulses = (int32_t) (((int64_t) ppm * TSYNC_CALIB_PULSES + (ppm >= 0 ? 50000000 : -50000000)) / 100000000);
+
+	if (pulses > 512)
+		pulses = 512;
+	if (pulses < -511)
+		pulses = -511;
+	if (pulses > 0)
+		return HAL_RTCEx_SetSmoothCalib(&hrtc, RTC_SMOOTHCALIB_PERIOD_32SEC, RTC_SMOOTHCALIB_PLUSPULSES_SET, 512 - pulses);
+	return HAL_RTCEx_SetSmoothCalib(&hrtc, RTC_SMOOTHCALIB_PERIOD_32SEC, RTC_SMOOTHCALIB_PLUSPULSES_RESET, -pulses);
+}
+
+static void timeSync_Task()
+{
+	if (timeSync_Request() != HAL_OK)
+		timeSync_Schedule(TSYNC_INTERVAL_MIN);
+}
+
+void timeSync_Init(uint32_t taskId)
+{
+	_syncTaskId = taskId;
+	_syncValid = 0;
+	driftEst_Inic(&_drift, TSYNC_INTERVAL_MIN, TSYNC_INTERVAL_MAX, TSYNC_MAX_ERROR);
+	UTIL_SEQ_RegTask((1 << _syncTaskId), UTIL_SEQ_RFU, timeSync_Task);
+	UTIL_TIMER_Create(&_syncTimer, TSYNC_INTERVAL_MIN, UTIL_TIMER_ONESHOT, timeSync_OnTimer, NULL);
+}
+
+HAL_StatusTypeDef timeSync_Request(void)
+{
+	if (LmHandlerDeviceTimeReq() != LORAMAC_HANDLER_SUCCESS)
+	{
+		writeLog("Failed to send time synchronization request");
+		return HAL_ERROR;
+	}
+	writeLog("Time synchronization request sent");
+	return HAL_OK;
+}
+
+void timeSync_OnUpdate(void)
+{
+	SysTime_t offset = { .Seconds = TIMER_IF_BkUp_Read_Seconds(), .SubSeconds = (int16_t) TIMER_IF_BkUp_Read_SubSeconds() };
+	SysTime_t rtc = SysTimeGetMcuTime();
+
+	if (_syncValid)
+	{
+		SysTime_t correction = SysTimeSub(offset, _syncOffset);
+		SysTime_t elapsed = SysTimeSub(rtc, _syncRtc);
+
+		if (elapsed.Seconds > TSYNC_ELAPSED_MAX)
+			_syncValid = 0;	// too long without sync, the reference is restarted
+		else
+		{
+			int32_t correctionMS = (int32_t) correction.Seconds * 1000 + correction.SubSeconds;
+			uint32_t elapsedMS = elapsed.Seconds * 1000 + elapsed.SubSeconds;
+
+			// too short interval (jitter of the correction), the reference is kept
+			if (!driftEst_Add(&_drift, elapsedMS, correctionMS, timeSync_GetCalib()))
+				return;
+			timeSync_SetCalib(_drift.Ppm);
+			writeLog("Time sync: correction %d ms / %u s, drift %d.%02d ppm, next sync %u s", (int) correctionMS, (unsigned) (elapsedMS / 1000),
+					(int) (_drift.Ppm / 100), (int) ((_drift.Ppm < 0 ? -_drift.Ppm : _drift.Ppm) % 100), (unsigned) (_drift.Interval / 1000));
+		}
+	}
+	_syncOffset = offset;
+	_syncRtc = rtc;
+	_syncValid = 1;
+	timeSync_Schedule(_drift.Interval);
+}
+
+int32_t timeSync_GetDrift(void)
+{
+	return _drift.Ppm;
+}
+
+uint32_t timeSync_Now(uint16_t *ms)
+{
+	SysTime_t now = SysTimeGet();
+
+	if (ms != NULL)
+		*ms = (uint16_t) now.SubSeconds;
+	return now.Seconds;
+}
+
+int8_t timeSync_IsValid(void)
+{
+	return SysTimeGet().Seconds >= TSYNC_EPOCH_VALID;
+}
@@ -0,0 +1,160 @@
+/*
+ * trace.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ */
+
+#include "trace.h"
+#include "main.h"
+#include "timer_if.h"
+#include "usart_if.h"
+#include "utilities_conf.h"
+
+#include <stdio.h>
+
+#define TRACE_BENCH_EVENTS	64	// events of trace_Bench
+
+static traceEvent_t _traceEvents[TRACE_SIZE];
+static traceRing_t _trace = { .Events = _traceEvents, .Mask = TRACE_SIZE - 1, .Head = 0 };
+static volatile uint8_t _tracePaused = 0;	// the dump is running
+
+void traceRing_Inic(traceRing_t *r, traceEvent_t *events, uint32_t size)
+{
+	r->Events = events;
+	r->Mask = size - 1;
+	r->Head = 0;
+}
+
+void traceRing_Put(traceRing_t *r, uint32_t time, uint16_t id, uint8_t type, uint8_t arg)
+{
+	traceEvent_t *e = &r->Events[r->Head++ & r->Mask];
+
+	e->Time = time;
+	e->Id = id;
+	e->Type = type;
+	e->Arg = arg;
+}
+
+uint32_t traceRing_Count(const traceRing_t *r)
+{
+	return (r->Head > r->Mask) ? r->Mask + 1 : r->Head;
+}
+
+uint32_t traceRing_Lost(const traceRing_t *r)
+{
+	return r->Head - traceRing_Count(r);
+}
+
+const traceEvent_t* traceRing_Get(const traceRing_t *r, uint32_t i)
+{
+	return &r->Events[(traceRing_Lost(r) + i) & r->Mask];
+}
+
+static char* traceRing_Hex(char *p, uint32_t value, int digits)
+{
+	static const char hex[] = "0123456789ABCDEF";
+
+	while (digits-- > 0)
+		*p++ = hex[(value >> (digits * 4)) & 0xF];
+	return p;
+}
+
+uint32_t traceRing_Line(const traceRing_t *r, uint32_t i, char *line)
+{
+	uint32_t count = traceRing_Count(r);
+	uint32_t n = 0;
+	char *p = line;
+
+	*p = '\0';
+	if (i >= count)
+		return 0;
+	*p++ = 'T';
+	*p++ = 'R';
+	*p++ = 'C';
+	for (; n < TRACE_LINE_EVENTS && i + n < count; n++)
+	{
+		const traceEvent_t *e = traceRing_Get(r, i + n);
+
+		*p++ = ' ';
+		p = traceRing_Hex(p, e->Time, 8);
+		p = traceRing_Hex(p, e->Id, 4);
+		p = traceRing_Hex(p, e->Type, 2);
+		p = traceRing_Hex(p, e->Arg, 2);
+	}
+	*p++ = '\r';
+	*p++ = '\n';
+	*p = '\0';
+	return n;
+}
+
+void trace_Init(void)
+{
+	trace_Clear();
+#ifdef DEBUG
+	writeLog("trace: %lu events, %lu cycles/event", (unsigned long) TRACE_SIZE, (unsigned long) trace_Bench());
+#endif
+}
+
+void trace_Event(uint16_t id, uint8_t type, uint8_t arg)
+{
+	uint32_t time = DWT->CYCCNT;
+
+	if (_tracePaused)
+		return;
+	UTILS_ENTER_CRITICAL_SECTION();
+	traceRing_Put(&_trace, time, id, type, arg);
+	UTILS_EXIT_CRITICAL_SECTION();
+}
+
+void trace_Sync(void)
+{
+	if (_tracePaused)
+		return;
+	// SYNC and RTC are adjacent, the RTC event is the newer one (a lost SYNC is detected by the converter)
+	UTILS_ENTER_CRITICAL_SECTION();
+	traceRing_Put(&_trace, DWT->CYCCNT, (uint16_t) (SystemCoreClock / 1000), TRACE_EV_SYNC, 0);
+	traceRing_Put(&_trace, TIMER_IF_GetTimerValue(), 0, TRACE_EV_RTC, 0);
+	UTILS_EXIT_CRITICAL_SECTION();
+}
+
+void trace_Clock(void)
+{
+	trace_Event((uint16_t) (SystemCoreClock / 1000), TRACE_EV_CLOCK, 0);
+}
+
+void trace_Dump(void)
+{
+	char line[TRACE_LINE_SIZE];
+	uint32_t count, n;
+
+	_tracePaused = 1;
+	count = traceRing_Count(&_trace);
+	snprintf(line, sizeof(line), "trace: %lu events, lost %lu, rtc %lu Hz\r\n", (unsigned long) count,
+		(unsigned long) traceRing_Lost(&_trace), (unsigned long) TIMER_IF_Convert_ms2Tick(1000));
+	Uart_Info(line);
+	for (uint32_t i = 0; (n = traceRing_Line(&_trace, i, line)) > 0; i += n)
+		Uart_Info(line);
+	Uart_Info("trace: end\r\n");
+	_tracePaused = 0;
+	trace_Sync();	// the dump has taken time
+}
+
+void trace_Clear(void)
+{
+	UTILS_ENTER_CRITICAL_SECTION();
+	traceRing_Inic(&_trace, _traceEvents, TRACE_SIZE);
+	UTILS_EXIT_CRITICAL_SECTION();
+	trace_Sync();
+}
+
+uint32_t trace_Bench(void)
+{
+	uint32_t cycles = DWT->CYCCNT;
+
+	for (int i = 0; i < TRACE_BENCH_EVENTS; i++)
+		trace_Event(TRACE_TASK, TRACE_EV_INSTANT, (uint8_t) i);
+	cycles = DWT->CYCCNT - cycles;
+	trace_Clear();	// the events of the benchmark are removed
+	return cycles / TRACE_BENCH_EVENTS;
+}
@@ -23,6 +23,7 @@
 
 /* USER CODE BEGIN Includes */
 #include "stm32_seq.h"
+#include "pwrdomain.h"
 /* USER CODE END Includes */
 
 /* External variables ---------------------------------------------------------*/
@@ -143,11 +144,11 @@ UTIL_ADV_TRACE_Status_t vcom_DeInit(void)
 void vcom_Trace(uint8_t *p_data, uint16_t size)
 {
   /* USER CODE BEGIN vcom_Trace_1 */
-
+  pwrDomain_Acquire(PWR_DOMAIN_USART1);	// MT 19.10.2026 - UART is gated in STOP2, initialized by the first use
   /* USER CODE END vcom_Trace_1 */
   HAL_UART_Transmit(&huart1, p_data, size, 1000);
   /* USER CODE BEGIN vcom_Trace_2 */
-
+  pwrDomain_Release(PWR_DOMAIN_USART1);
   /* USER CODE END vcom_Trace_2 */
 }
 
@@ -155,6 +156,7 @@ UTIL_ADV_TRACE_Status_t vcom_Trace_DMA(uint8_t *p_data, uint16_t size)
 {
   /* USER CODE BEGIN vcom_Trace_DMA_1 */
 	//return HAL_UART_Transmit(&huart1, p_data, size, 10000);	// MT 13.1.2026 - no DMA
+  pwrDomain_Acquire(PWR_DOMAIN_USART1);	// released by HAL_UART_TxCpltCallback
 
   /* USER CODE END vcom_Trace_DMA_1 */
   HAL_UART_Transmit_DMA(&huart1, p_data, size);
@@ -224,7 +226,8 @@ void vcom_Resume(void)
 void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
 {
   /* USER CODE BEGIN HAL_UART_TxCpltCallback_1 */
-
+  if (huart->Instance == USART1)
+    pwrDomain_Release(PWR_DOMAIN_USART1);
   /* USER CODE END HAL_UART_TxCpltCallback_1 */
   /* buffer transmission complete*/
   if (huart->Instance == USART1)
@@ -89,6 +89,570 @@ TVAL valueChanger_GetValue(const valueChanger_t *v) //
 	return v->LastValue;
 }
 
+////////////////////////////////////////////////////////////////
+// deltaReporter /////////////////////////////////////////////////////
+void deltaReporter_Inic(deltaReporter_t *v, uint8_t count, uint32_t heartbeatMS) //
+{
+	if (count > DELTA_CHANNELS_MAX)
+		count = DELTA_CHANNELS_MAX;
+	for (uint8_t i = 0; i < DELTA_CHANNELS_MAX; i++)
+	{
+		v->Value[i] = 0;
+		v->Reported[i] = 0;
+		v->Band[i].AbsDelta = 0;
+		v->Band[i].RelDelta = 0;
+	}
+	v->ValidMask = 0;
+	v->ReportedMask = 0;
+	v->Count = count;
+	sleeper_Init(&v->Heartbeat, heartbeatMS);
+	if (heartbeatMS == 0)
+		sleeper_Stop(&v->Heartbeat);
+}
+
+void deltaReporter_SetBand(deltaReporter_t *v, uint8_t channel, int32_t absDelta, uint16_t relDelta) //
+{
+	if (channel >= v->Count)
+		return;
+	v->Band[channel].AbsDelta = absDelta;
+	v->Band[channel].RelDelta = relDelta;
+}
+
+void deltaReporter_SetValue(deltaReporter_t *v, uint8_t channel, int32_t newValue) //
+{
+	if (channel >= v->Count)
+		return;
+	v->Value[channel] = newValue;
+	v->ValidMask |= (1 << channel);
+}
+
+void deltaReporter_Invalidate(deltaReporter_t *v, uint8_t channel) //
+{
+	if (channel < v->Count)
+		v->ValidMask &= ~(1 << channel);
+}
+
+// the channel is out of the deadband
+static int deltaReporter_IsOut(const deltaReporter_t *v, uint8_t channel) //
+{
+	const deltaBand_t *band = &v->Band[channel];
+	int64_t diff = (int64_t) v->Value[channel] - v->Reported[channel];
+	int64_t ref = v->Reported[channel];
+
+	if (diff < 0)
+		diff = -diff;
+	if (ref < 0)
+		ref = -ref;
+	if (band->AbsDelta == 0 && band->RelDelta == 0)
+		return diff != 0;	// no deadband, every change
+	// out of the wider band
+	return diff > band->AbsDelta && diff * 1000 > ref * band->RelDelta;
+}
+
+int deltaReporter_IsReport(const deltaReporter_t *v) //
+{
+	if (sleeper_IsElapsed(&v->Heartbeat) && v->Heartbeat.SleepMS != 0)
+		return 1;	// max. silent interval
+	for (uint8_t i = 0; i < v->Count; i++)
+	{
+		uint16_t bit = (1 << i);
+
+		if (!(v->ValidMask & bit))
+			continue;
+		if (!(v->ReportedMask & bit) || deltaReporter_IsOut(v, i))
+			return 1;	// new channel or out of deadband
+	}
+	return 0;
+}
+
+void deltaReporter_Reported(deltaReporter_t *v) //
+{
+	for (uint8_t i = 0; i < v->Count; i++)
+		if (v->ValidMask & (1 << i))
+			v->Reported[i] = v->Value[i];
+	v->ReportedMask = v->ValidMask;
+	if (v->Heartbeat.SleepMS != 0)
+		sleeper_Next(&v->Heartbeat);
+}
+
+////////////////////////////////////////////////////////////////
+// statAgg /////////////////////////////////////////////////////
+void statAgg_Inic(statAgg_t *v, uint8_t ringSize, int32_t outlierDelta) //
+{
+	if (ringSize > STAT_RING_MAX)
+		ringSize = STAT_RING_MAX;
+	v->RingSize = ringSize;
+	v->OutlierDelta = outlierDelta;
+	statAgg_Reset(v);
+}
+
+void statAgg_Reset(statAgg_t *v) //
+{
+	v->Min = INT32_MAX;
+	v->Max = INT32_MIN;
+	v->MeanQ = 0;
+	v->M2Q = 0;
+	v->Count = 0;
+	v->Rejected = 0;
+	v->RingCount = 0;
+	v->RingPos = 0;
+}
+
+int32_t statAgg_GetMedian(const statAgg_t *v) //
+{
+	int32_t sorted[STAT_RING_MAX];
+	uint8_t n = v->RingCount;
+
+	if (n == 0)
+		return statAgg_GetMean(v);
+	// insertion sort, the window is small
+	for (uint8_t i = 0; i < n; i++)
+	{
+		int32_t x = v->Ring[i];
+		int8_t j = i - 1;
+
+		while (j >= 0 && sorted[j] > x)
+		{
+			sorted[j + 1] = sorted[j];
+			j--;
+		}
+		sorted[j + 1] = x;
+	}
+	return sorted[n / 2];
+}
+
+int statAgg_Add(statAgg_t *v, int32_t sample) //
+{
+	if (v->RingSize > 1)
+	{
+		// outlier check against the median of previous samples (at least half of the window is full)
+		int reject = 0;
+
+		if (v->OutlierDelta > 0 && v->RingCount > v->RingSize / 2)
+		{
+			int64_t diff = (int64_t) sample - statAgg_GetMedian(v);
+
+			reject = (diff > v->OutlierDelta || -diff > v->OutlierDelta);
+		}
+		v->Ring[v->RingPos] = sample;	// the window contains all samples, the step change is accepted after N/2 samples
+		v->RingPos = (v->RingPos + 1) % v->RingSize;
+		if (v->RingCount < v->RingSize)
+			v->RingCount++;
+		if (reject)
+		{
+			v->Rejected++;
+			return 0;
+		}
+	}
+	else
+	{
+		v->Ring[0] = sample;	// last sample
+		v->RingCount = 1;
+	}
+
+	if (sample < v->Min)
+		v->Min = sample;
+	if (sample > v->Max)
+		v->Max = sample;
+
+	// Welford
+	int64_t x = (int64_t) sample << STAT_FRAC_BITS;
+	int64_t delta = x - v->MeanQ;
+
+	v->Count++;
+	v->MeanQ += delta / v->Count;
+	v->M2Q += (delta * (x - v->MeanQ)) >> STAT_FRAC_BITS;
+	return 1;
+}
+
+int32_t statAgg_GetMean(const statAgg_t *v) //
+{
+	int64_t half = (int64_t) 1 << (STAT_FRAC_BITS - 1);
+
+	return (int32_t) ((v->MeanQ >= 0) ? (v->MeanQ + half) >> STAT_FRAC_BITS : -((-v->MeanQ + half) >> STAT_FRAC_BITS));
+}
+
+int32_t statAgg_GetStdDev(const statAgg_t *v) //
+{
+	if (v->Count < 2 || v->M2Q <= 0)
+		return 0;
+
+	// variance in Q8, integer sqrt of variance << 8 gives stddev in Q8
+	uint64_t var = ((uint64_t) v->M2Q / (v->Count - 1)) << STAT_FRAC_BITS;
+	uint64_t res = 0, bit = (uint64_t) 1 << 62;
+
+	while (bit > var)
+		bit >>= 2;
+	while (bit != 0)
+	{
+		if (var >= res + bit)
+		{
+			var -= res + bit;
+			res = (res >> 1) + bit;
+		}
+		else
+			res >>= 1;
+		bit >>= 2;
+	}
+	return (int32_t) ((res + ((uint64_t) 1 << (STAT_FRAC_BITS - 1))) >> STAT_FRAC_BITS);
+}
+
+////////////////////////////////////////////////////////////////
+// convDetector /////////////////////////////////////////////////////
+void convDetector_Inic(convDetector_t *v, uint32_t warmupMS, uint32_t maxMS, int32_t slopeMax, int32_t varMax) //
+{
+	v->SlopeMax = slopeMax;
+	v->VarMax = varMax;
+	sleeper_Init(&v->Warmup, warmupMS);
+	sleeper_Init(&v->MaxTime, maxMS);
+	convDetector_Start(v);
+}
+
+void convDetector_Start(convDetector_t *v) //
+{
+	v->Count = 0;
+	v->Pos = 0;
+	v->Settled = 0;
+	sleeper_Next(&v->Warmup);
+	sleeper_Next(&v->MaxTime);
+}
+
+int convDetector_Add(convDetector_t *v, int32_t sample) //
+{
+	v->Window[v->Pos] = sample;
+	v->Pos = (v->Pos + 1) % CONV_WINDOW;
+	if (v->Count < CONV_WINDOW)
+		v->Count++;
+
+	if (!v->Settled && v->Count == CONV_WINDOW && sleeper_IsElapsed(&v->Warmup))
+	{
+		// v->Pos is the oldest sample now
+		int64_t first = v->Window[v->Pos];
+		int64_t last = sample;
+		int64_t slope = (last > first ? last - first : first - last) / (CONV_WINDOW - 1);
+		int64_t sum = 0, var = 0;
+
+		for (uint8_t i = 0; i < CONV_WINDOW; i++)
+			sum += v->Window[i];
+		for (uint8_t i = 0; i < CONV_WINDOW; i++)
+		{
+			int64_t d = (int64_t) v->Window[i] * CONV_WINDOW - sum;	// difference x CONV_WINDOW
+
+			var += d * d;
+		}
+		var /= (int64_t) CONV_WINDOW * CONV_WINDOW * (CONV_WINDOW - 1);
+		if (slope <= v->SlopeMax && var <= v->VarMax)
+			v->Settled = 1;
+	}
+	return convDetector_IsSettled(v);
+}
+
+int convDetector_IsSettled(const convDetector_t *v) //
+{
+	return v->Settled || (v->MaxTime.SleepMS != 0 && sleeper_IsElapsed(&v->MaxTime));
+}
+
+int convDetector_IsWarm(const convDetector_t *v) //
+{
+	return sleeper_IsElapsed(&v->Warmup);
+}
+
+////////////////////////////////////////////////////////////////
+// presence /////////////////////////////////////////////////////
+void presence_Inic(presence_t *v, uint32_t backoffMin, uint32_t backoffMax) //
+{
+	v->Present = 0;
+	v->Known = 0;
+	v->BackoffMin = backoffMin;
+	v->BackoffMax = backoffMax;
+	for (uint8_t i = 0; i < PRESENCE_DEV_MAX; i++)
+	{
+		v->LastProbe[i] = 0;
+		v->Backoff[i] = backoffMin;
+	}
+}
+
+int presence_IsProbe(const presence_t *v, uint8_t dev) //
+{
+	uint16_t bit = (1 << dev);
+
+	if (dev >= PRESENCE_DEV_MAX || (v->Present & bit))
+		return 0;
+	if (!(v->Known & bit))
+		return 1;	// first probe
+	return HAL_GetTick() - v->LastProbe[dev] >= v->Backoff[dev];
+}
+
+void presence_Set(presence_t *v, uint8_t dev, int8_t isPresent) //
+{
+	uint16_t bit = (1 << dev);
+
+	if (dev >= PRESENCE_DEV_MAX)
+		return;
+	if (isPresent)
+	{
+		v->Present |= bit;
+		v->Backoff[dev] = v->BackoffMin;
+	}
+	else if ((v->Present & bit) || !(v->Known & bit))
+	{
+		// device has been lost or is not found first time
+		v->Present &= ~bit;
+		v->Backoff[dev] = v->BackoffMin;
+		v->LastProbe[dev] = HAL_GetTick();
+	}
+	else if (presence_IsProbe(v, dev))
+	{
+		// failed probe, next backoff
+		v->Backoff[dev] = (v->Backoff[dev] >= v->BackoffMax / 2) ? v->BackoffMax : v->Backoff[dev] * 2;
+		v->LastProbe[dev] = HAL_GetTick();
+	}
+	v->Known |= bit;
+}
+
+int presence_Is(const presence_t *v, uint8_t dev) //
+{
+	return dev < PRESENCE_DEV_MAX && (v->Present & (1 << dev));
+}
+
+////////////////////////////////////////////////////////////////
+// driftEst /////////////////////////////////////////////////////
+#define DRIFT_WEIGHT_MAX	(7 * 24 * 3600)	// max. weight of estimate (s)
+
+void driftEst_Inic(driftEst_t *v, uint32_t intervalMin, uint32_t intervalMax, uint32_t maxError) //
+{
+	v->Ppm = 0;
+	v->Residual = 0;
+	v->ResidualMax = 0;
+	v->Weight = 0;
+	v->Count = 0;
+	v->IntervalMin = intervalMin;
+	v->IntervalMax = intervalMax;
+	v->Interval = intervalMin;
+	v->MaxError = maxError;
+}
+
+int driftEst_Add(driftEst_t *v, uint32_t elapsedMS, int32_t correctionMS, int32_t appliedPpm) //
+{
+	if (elapsedMS < v->IntervalMin / 2)
+		return 0;
+
+	// residual drift of interval, ppm x 100 = correction / elapsed * 1e8
+	v->Residual = (int32_t) (((int64_t) correctionMS * 100000000) / elapsedMS);
+	int32_t measured = appliedPpm + v->Residual;
+	uint32_t w = elapsedMS / 1000;
+
+	if (v->Count == 0)
+		v->Ppm = measured;
+	else
+		v->Ppm = (int32_t) (((int64_t) v->Ppm * v->Weight + (int64_t) measured * w) / (v->Weight + w));
+	v->Weight = (v->Weight + w > DRIFT_WEIGHT_MAX) ? DRIFT_WEIGHT_MAX : v->Weight + w;
+	if (v->Count < 255)
+		v->Count++;
+
+	// interval with error MaxError at the peak of residual drift (temperature changes), max. 2x of previous
+	uint32_t residual = (v->Residual < 0) ? -v->Residual : v->Residual;
+	v->ResidualMax = (residual > v->ResidualMax * 3 / 4) ? residual : v->ResidualMax * 3 / 4;
+	uint64_t interval = (v->ResidualMax == 0) ? v->IntervalMax : ((uint64_t) v->MaxError * 100000000) / v->ResidualMax;
+	if (interval > (uint64_t) v->Interval * 2)
+		interval = (uint64_t) v->Interval * 2;
+	if (interval > v->IntervalMax)
+		interval = v->IntervalMax;
+	if (interval < v->IntervalMin)
+		interval = v->IntervalMin;
+	v->Interval = (uint32_t) interval;
+	return 1;
+}
+
+////////////////////////////////////////////////////////////////
+// tsBatch //////////////////////////////////////////////////////
+void tsBatch_Inic(tsBatch_t *v, uint16_t resolutionMS) //
+{
+	v->Resolution = (resolutionMS == 0) ? 1 : resolutionMS;
+	tsBatch_Reset(v);
+}
+
+void tsBatch_Reset(tsBatch_t *v) //
+{
+	v->Base = 0;
+	v->BaseMs = 0;
+	v->Valid = 0;
+}
+
+int tsBatch_Add(tsBatch_t *v, uint32_t epoch, uint16_t ms, uint16_t *offset) //
+{
+	if (!v->Valid)
+	{
+		v->Base = epoch;
+		v->BaseMs = ms;
+		v->Valid = 1;
+		*offset = 0;
+		return 1;
+	}
+	if (epoch < v->Base || (epoch == v->Base && ms < v->BaseMs))
+		return 0;
+
+	uint64_t delta = (uint64_t) (epoch - v->Base) * 1000 + ms - v->BaseMs;
+	uint64_t off = (delta + v->Resolution / 2) / v->Resolution;
+	if (off > 0xFFFF)
+		return 0;
+	*offset = (uint16_t) off;
+	return 1;
+}
+
+void tsBatch_GetTime(const tsBatch_t *v, uint16_t offset, uint32_t *epoch, uint16_t *ms) //
+{
+	uint32_t delta = (uint32_t) offset * v->Resolution + v->BaseMs;
+
+	*epoch = v->Base + delta / 1000;
+	*ms = delta % 1000;
+}
+
+////////////////////////////////////////////////////////////////
+// batGovernor //////////////////////////////////////////////////
+void batGovernor_Inic(batGovernor_t *v, const govTier_t *tiers, uint8_t count, uint16_t hystMV) //
+{
+	v->Tiers = tiers;
+	v->Count = count;
+	v->Tier = 0;
+	v->HystMV = hystMV;
+}
+
+int batGovernor_Update(batGovernor_t *v, uint16_t mV) //
+{
+	uint8_t tier = v->Tier;
+
+	while (tier + 1 < v->Count && mV < v->Tiers[tier + 1].EnterMV)
+		tier++;
+	while (tier > 0 && mV >= v->Tiers[tier].EnterMV + v->HystMV)
+		tier--;
+	if (tier == v->Tier)
+		return 0;
+	v->Tier = tier;
+	return 1;
+}
+
+const govTier_t* batGovernor_Get(const batGovernor_t *v) //
+{
+	return &v->Tiers[v->Tier];
+}
+
+////////////////////////////////////////////////////////////////
+// cadence //////////////////////////////////////////////////////
+uint32_t cadence_Take(cadenceItem_t *items, uint8_t count, uint32_t mask, uint32_t now, uint32_t windowMS) //
+{
+	uint32_t taken = 0;
+
+	for (uint8_t i = 0; i < count; i++)
+	{
+		cadenceItem_t *it = &items[i];
+
+		if (!(mask & (1UL << i)))
+			continue;
+		if (it->Started && (int32_t) (it->NextDue - now) > (int32_t) windowMS)
+			continue;
+		it->NextDue = now + it->Interval;
+		it->Started = 1;
+		taken |= 1UL << i;
+	}
+	return taken;
+}
+
+uint32_t cadence_NextDelay(const cadenceItem_t *items, uint8_t count, uint32_t mask, uint32_t now) //
+{
+	uint32_t delay = UINT32_MAX;
+
+	for (uint8_t i = 0; i < count; i++)
+	{
+		const cadenceItem_t *it = &items[i];
+		int32_t left;
+
+		if (!(mask & (1UL << i)))
+			continue;
+		if (!it->Started)
+			return 0;
+		left = (int32_t) (it->NextDue - now);
+		if (left <= 0)
+			return 0;
+		if ((uint32_t) left < delay)
+			delay = (uint32_t) left;
+	}
+	return delay;
+}
+
+////////////////////////////////////////////////////////////////
+// blockDiff ////////////////////////////////////////////////////
+
+/*
+ * @brief the block at pos is changed
+ */
+static int blockDiff_IsChanged(const uint8_t *shadow, const uint8_t *image, uint16_t len, uint16_t pos, uint8_t blockSize) //
+{
+	uint16_t end = (len - pos < blockSize) ? len : pos + blockSize;
+
+	for (uint16_t i = pos; i < end; i++)
+		if (shadow[i] != image[i])
+			return 1;
+	return 0;
+}
+
+uint16_t blockDiff_Run(const uint8_t *shadow, const uint8_t *image, uint16_t len, uint16_t pos, uint8_t blockSize, uint16_t *start) //
+{
+	uint16_t end;
+
+	pos -= pos % blockSize;
+	while (pos < len && !blockDiff_IsChanged(shadow, image, len, pos, blockSize))
+		pos += blockSize;
+	if (pos >= len)
+		return 0;
+	*start = pos;
+	for (end = pos; end < len && blockDiff_IsChanged(shadow, image, len, end, blockSize); end += blockSize)
+		;
+	return ((end > len) ? len : end) - pos;
+}
+
+////////////////////////////////////////////////////////////////
+// calendar /////////////////////////////////////////////////////
+#define CAL_DAY_SECONDS		86400
+
+void calendar_Inic(calendar_t *v) //
+{
+	v->Year = 1970;
+	v->Month = 1;
+	v->Day = 1;
+	v->WeekDay = 4;	// 1.1.1970 was Thursday
+	v->Hours = 0;
+	v->Minutes = 0;
+	v->Seconds = 0;
+	v->DayStart = 0xFFFFFFFF;
+}
+
+void calendar_Set(calendar_t *v, uint32_t epoch) //
+{
+	if (v->DayStart == 0xFFFFFFFF || epoch < v->DayStart || epoch - v->DayStart >= CAL_DAY_SECONDS)
+	{
+		// new day, the date from days since 1.1.1970 (H. Hinnant, civil_from_days), epoch 1.3.0000
+		uint32_t days = epoch / CAL_DAY_SECONDS;
+		uint32_t z = days + 719468;
+		uint32_t era = z / 146097;
+		uint32_t doe = z - era * 146097;
+		uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+		uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+		uint32_t mp = (5 * doy + 2) / 153;
+
+		v->Day = doy - (153 * mp + 2) / 5 + 1;
+		v->Month = (mp < 10) ? mp + 3 : mp - 9;
+		v->Year = yoe + era * 400 + (v->Month <= 2 ? 1 : 0);
+		v->WeekDay = (days + 3) % 7 + 1;
+		v->DayStart = days * CAL_DAY_SECONDS;
+	}
+	uint32_t sec = epoch - v->DayStart;
+
+	v->Hours = sec / 3600;
+	sec -= (uint32_t) v->Hours * 3600;
+	v->Minutes = sec / 60;
+	v->Seconds = sec - (uint32_t) v->Minutes * 60;
+}
 
 /////////////////////////////////////////////////////////////////////
 void clearFlash() //
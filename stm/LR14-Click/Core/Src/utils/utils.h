@@ -114,6 +114,414 @@ void valueChanger_Lock(valueChanger_t *v);
  */
 TVAL valueChanger_GetValue(const valueChanger_t *v);
 
+//////////////////////////////////////////////////////////////////////////////////
+
+#define DELTA_CHANNELS_MAX	8	// max. count of channels in deltaReporter_t
+
+/*
+ * deltaBand_t - the deadband of one channel
+ * The change is reported, if |value - reported| > max(AbsDelta, RelDelta * |reported| / 1000),
+ * the absolute deadband is the floor of the relative one near zero
+ */
+typedef struct //
+{
+	int32_t AbsDelta;	// absolute deadband, 0 - not used
+	uint16_t RelDelta;	// relative deadband in 1/1000 of the reported value, 0 - not used
+} deltaBand_t;
+
+/*
+ * deltaReporter_t - send-on-delta filter, similar to valueChanger_t, but multi-channel int32_t values
+ * The caller sets new values of channels via deltaReporter_SetValue, deltaReporter_IsReport returns 1
+ * if any channel moves beyond its deadband (against the last reported value) or the heartbeat (max. silent time)
+ * has been elapsed. After the report (uplink), the caller must call deltaReporter_Reported.
+ */
+typedef struct //
+{
+	int32_t Value[DELTA_CHANNELS_MAX];		// current values
+	int32_t Reported[DELTA_CHANNELS_MAX];	// last reported values
+	deltaBand_t Band[DELTA_CHANNELS_MAX];	// deadbands of channels
+	uint16_t ValidMask;			// bit - channel has current value
+	uint16_t ReportedMask;		// bit - channel has been reported
+	uint8_t Count;				// count of channels
+	sleeper_t Heartbeat;		// max. silent interval
+} deltaReporter_t;
+
+/*
+ * @brief ctor - initialization of deltaReporter_t, all channels without deadband (every change is reported)
+ * @param count - count of channels (max. DELTA_CHANNELS_MAX)
+ * @param heartbeatMS - max. time without the report, 0 - heartbeat is not used
+ */
+void deltaReporter_Inic(deltaReporter_t *v, uint8_t count, uint32_t heartbeatMS);
+
+/*
+ * @brief setting of the channel deadband
+ */
+void deltaReporter_SetBand(deltaReporter_t *v, uint8_t channel, int32_t absDelta, uint16_t relDelta);
+
+/*
+ * @brief The set of new value of channel.
+ */
+void deltaReporter_SetValue(deltaReporter_t *v, uint8_t channel, int32_t newValue);
+
+/*
+ * @brief The channel value is not available (sensor is not present/error), the channel is not compared
+ */
+void deltaReporter_Invalidate(deltaReporter_t *v, uint8_t channel);
+
+/*
+ * @brief the report check
+ * @retval
+ * 		1 - any channel is out of deadband, is new or the heartbeat has been elapsed
+ * 		0 - nothing to report
+ */
+int deltaReporter_IsReport(const deltaReporter_t *v);
+
+/*
+ * @brief current values have been reported, they are new reference values, heartbeat is restarted
+ */
+void deltaReporter_Reported(deltaReporter_t *v);
+
+//////////////////////////////////////////////////////////////////////////////////
+
+#define STAT_FRAC_BITS		8	// fixed point of mean/M2 (Q8)
+#define STAT_RING_MAX		7	// max. size of the median window
+
+/*
+ * statAgg_t - streaming statistics (min/max/mean/stddev) of int32_t samples, Welford's algorithm
+ * in fixed point, without storing of samples.
+ * Optionally, the sample is compared to the median of last N samples (ring buffer) and rejected as outlier
+ * if the difference is greater than OutlierDelta.
+ * @note differences between samples must be < 2^19 (M2 in int64_t)
+ */
+typedef struct //
+{
+	int32_t Min;
+	int32_t Max;
+	int64_t MeanQ;		// mean << STAT_FRAC_BITS
+	int64_t M2Q;		// sum of squares of differences from the mean << STAT_FRAC_BITS
+	uint16_t Count;		// count of accepted samples
+	uint16_t Rejected;	// count of rejected samples (outliers)
+	int32_t Ring[STAT_RING_MAX];	// last samples for the median
+	uint8_t RingSize;	// size of median window, 0 - outlier rejection is not used
+	uint8_t RingCount;	// count of samples in Ring
+	uint8_t RingPos;	// next position in Ring
+	int32_t OutlierDelta;	// max. difference from the median
+} statAgg_t;
+
+/*
+ * @brief ctor - initialization of statAgg_t
+ * @param ringSize - median window (odd, max. STAT_RING_MAX), 0 - no outlier rejection
+ * @param outlierDelta - the sample is rejected, if |sample - median| > outlierDelta
+ */
+void statAgg_Inic(statAgg_t *v, uint8_t ringSize, int32_t outlierDelta);
+
+/*
+ * @brief start of new cycle, statistics and median window are cleared, the setting is kept
+ */
+void statAgg_Reset(statAgg_t *v);
+
+/*
+ * @brief adding of new sample
+ * @retval 1 - sample is accepted, 0 - sample is rejected (outlier)
+ */
+int statAgg_Add(statAgg_t *v, int32_t sample);
+
+/*
+ * @brief mean of accepted samples (rounded)
+ */
+int32_t statAgg_GetMean(const statAgg_t *v);
+
+/*
+ * @brief sample standard deviation of accepted samples (rounded), 0 - less than 2 samples
+ */
+int32_t statAgg_GetStdDev(const statAgg_t *v);
+
+/*
+ * @brief median of the samples in the window, or the last sample if the window is not used
+ */
+int32_t statAgg_GetMedian(const statAgg_t *v);
+
+//////////////////////////////////////////////////////////////////////////////////
+
+#define CONV_WINDOW		3	// count of last samples for the convergence check
+
+/*
+ * convDetector_t - detection of the settled sensor readings
+ * The sensor is settled, if the warm-up time has been elapsed and over last CONV_WINDOW samples
+ * the slope (|last - first| / (CONV_WINDOW - 1)) <= SlopeMax and the variance <= VarMax.
+ * After MaxMS, the detector reports settled always (max. duration of reading).
+ */
+typedef struct //
+{
+	int32_t Window[CONV_WINDOW];	// last samples
+	uint8_t Count;		// count of samples in Window
+	uint8_t Pos;		// next position in Window
+	uint8_t Settled;	// 1 - readings are settled
+	int32_t SlopeMax;	// max. slope per sample
+	int32_t VarMax;		// max. variance of the window
+	sleeper_t Warmup;	// min. time since start
+	sleeper_t MaxTime;	// max. time since start, 0 - not used
+} convDetector_t;
+
+/*
+ * @brief ctor - initialization of convDetector_t
+ * @param warmupMS - min. time after the sensor start
+ * @param maxMS - max. time after the sensor start, 0 - no limit
+ * @param slopeMax - max. change between samples
+ * @param varMax - max. variance of the window
+ */
+void convDetector_Inic(convDetector_t *v, uint32_t warmupMS, uint32_t maxMS, int32_t slopeMax, int32_t varMax);
+
+/*
+ * @brief the sensor has been started, warm-up and max. time are started
+ */
+void convDetector_Start(convDetector_t *v);
+
+/*
+ * @brief adding of new sample
+ * @retval 1 - readings are settled (or max. time elapsed), 0 - not yet
+ */
+int convDetector_Add(convDetector_t *v, int32_t sample);
+
+/*
+ * @brief readings are settled (or max. time elapsed)
+ */
+int convDetector_IsSettled(const convDetector_t *v);
+
+/*
+ * @brief the warm-up time has been elapsed, the readings are valid
+ */
+int convDetector_IsWarm(const convDetector_t *v);
+
+//////////////////////////////////////////////////////////////////////////////////
+
+#define PRESENCE_DEV_MAX	16	// max. count of devices in presence_t
+
+/*
+ * presence_t - cached presence of devices with exponential backoff of probing
+ * The present device is not probed (init is not called). The absent device is probed
+ * after backoff, the backoff is doubled after each failed probe up to BackoffMax (hot-plug rescan).
+ */
+typedef struct //
+{
+	uint16_t Present;	// bitmap of present devices
+	uint16_t Known;		// bitmap of devices probed at least once
+	uint32_t LastProbe[PRESENCE_DEV_MAX];	// time (tick) of last failed probe
+	uint32_t Backoff[PRESENCE_DEV_MAX];		// current backoff (ms)
+	uint32_t BackoffMin;
+	uint32_t BackoffMax;
+} presence_t;
+
+/*
+ * @brief ctor - initialization of presence_t, all devices are unknown (probed on first use)
+ * @param backoffMin - first backoff after the device is not found
+ * @param backoffMax - max. backoff, the rate of rescanning of absent devices
+ */
+void presence_Inic(presence_t *v, uint32_t backoffMin, uint32_t backoffMax);
+
+/*
+ * @brief the device can be probed (init can be called)
+ * @retval 1 - device is unknown or absent and backoff has been elapsed, 0 - device is present or backoff is running
+ */
+int presence_IsProbe(const presence_t *v, uint8_t dev);
+
+/*
+ * @brief the result of probe/use of the device
+ */
+void presence_Set(presence_t *v, uint8_t dev, int8_t isPresent);
+
+/*
+ * @brief the device is present
+ */
+int presence_Is(const presence_t *v, uint8_t dev);
+
+//////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * driftEst_t - estimation of the clock drift from the time corrections of the network (DeviceTimeAns)
+ * The drift is ppm x 100, + the local clock is slow. The estimate is weighted by the elapsed time
+ * (the latency jitter of the correction is less important over longer interval), the weight is limited
+ * so that the temperature change of the drift is followed.
+ * The sync interval grows (max. 2x) as the peak of residual drift after the correction falls.
+ */
+typedef struct //
+{
+	int32_t Ppm;			// estimated drift (ppm x 100)
+	int32_t Residual;		// residual drift of the last interval (ppm x 100), after the applied correction
+	uint32_t ResidualMax;	// decaying peak of the residual drift (ppm x 100), the interval is planned by it
+	uint32_t Weight;		// weight of the estimate (s)
+	uint32_t Interval;		// next sync interval (ms)
+	uint32_t IntervalMin;
+	uint32_t IntervalMax;
+	uint32_t MaxError;		// allowed time error at the end of interval (ms)
+	uint8_t Count;			// number of estimates
+} driftEst_t;
+
+/*
+ * @brief ctor - initialization of driftEst_t, drift is unknown, interval is IntervalMin
+ * @param intervalMin - first sync interval (ms), shorter measurements are ignored (latency jitter)
+ * @param intervalMax - max. sync interval (ms)
+ * @param maxError - allowed time error (ms)
+ */
+void driftEst_Inic(driftEst_t *v, uint32_t intervalMin, uint32_t intervalMax, uint32_t maxError);
+
+/*
+ * @brief adding of the time correction
+ * @param elapsedMS - elapsed local time from previous correction
+ * @param correctionMS - the correction (network time - local time)
+ * @param appliedPpm - the drift correction applied during the interval (ppm x 100)
+ * @retval 1 - estimate updated, 0 - interval too short
+ */
+int driftEst_Add(driftEst_t *v, uint32_t elapsedMS, int32_t correctionMS, int32_t appliedPpm);
+
+//////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * tsBatch_t - compact timestamps of the records in batch
+ * The batch carries the base time (32-bit epoch + ms) once, the records carry 16-bit offset
+ * from the base in units of Resolution (ms), e.g. 250 ms -> 4.5 hours of batch.
+ */
+typedef struct //
+{
+	uint32_t Base;			// base time of the batch (epoch, s)
+	uint16_t BaseMs;		// ms of the base time
+	uint16_t Resolution;	// resolution of the offset (ms)
+	uint8_t Valid;			// base is set (the first record of batch was added)
+} tsBatch_t;
+
+/*
+ * @brief ctor - initialization of tsBatch_t, the batch is empty
+ * @param resolutionMS - resolution of the record offset (ms)
+ */
+void tsBatch_Inic(tsBatch_t *v, uint16_t resolutionMS);
+
+/*
+ * @brief the batch is empty, the next record sets the base time
+ */
+void tsBatch_Reset(tsBatch_t *v);
+
+/*
+ * @brief the offset of the record in batch, the first record sets the base (offset 0)
+ * @param epoch, ms - time of the record
+ * @param offset - [out] offset from the base in Resolution units
+ * @retval 1 - OK, 0 - the time is out of batch (before the base or offset overflow), new batch must be started
+ */
+int tsBatch_Add(tsBatch_t *v, uint32_t epoch, uint16_t ms, uint16_t *offset);
+
+/*
+ * @brief the time of the record from the base and offset
+ */
+void tsBatch_GetTime(const tsBatch_t *v, uint16_t offset, uint32_t *epoch, uint16_t *ms);
+
+//////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * calendar_t - the conversion of the epoch (unix, s) to the calendar, the date of the day is cached
+ * Within the same day only the time is computed, the date is computed without loops (days from civil).
+ */
+typedef struct //
+{
+	uint16_t Year;		// 1970 ..
+	uint8_t Month;		// 1 .. 12
+	uint8_t Day;		// 1 .. 31
+	uint8_t WeekDay;	// 1 - Monday .. 7 - Sunday (as RTC_WEEKDAY_xxx)
+	uint8_t Hours;
+	uint8_t Minutes;
+	uint8_t Seconds;
+	uint32_t DayStart;	// epoch of the cached day, 0xFFFFFFFF - cache is empty
+} calendar_t;
+
+/*
+ * @brief ctor - initialization of calendar_t, the cache is empty
+ */
+void calendar_Inic(calendar_t *v);
+
+/*
+ * @brief the conversion of the epoch to the calendar
+ */
+void calendar_Set(calendar_t *v, uint32_t epoch);
+
+//////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * batGovernor_t - the power tier by the battery voltage with hysteresis
+ * Tiers are sorted from the full battery, the tier i (i > 0) is entered when the voltage falls under EnterMV,
+ * it is left (to the upper tier) when the voltage rises over EnterMV + HystMV.
+ */
+typedef struct //
+{
+	uint16_t EnterMV;	// the tier is entered under this voltage (tier 0 - not used)
+	uint8_t Enabled;	// enabled devices (bitmap) in the tier
+	uint8_t Scale;		// the intervals (reading, uplink) are multiplied
+} govTier_t;
+
+typedef struct //
+{
+	const govTier_t *Tiers;
+	uint8_t Count;
+	uint8_t Tier;		// current tier
+	uint16_t HystMV;
+} batGovernor_t;
+
+/*
+ * @brief ctor - initialization of batGovernor_t, tier 0 (full battery)
+ * @param tiers, count - the table of tiers sorted from the full battery
+ * @param hystMV - hysteresis of the return to the upper tier
+ */
+void batGovernor_Inic(batGovernor_t *v, const govTier_t *tiers, uint8_t count, uint16_t hystMV);
+
+/*
+ * @brief new voltage of the battery
+ * @retval 1 - the tier has been changed, 0 - the same tier
+ */
+int batGovernor_Update(batGovernor_t *v, uint16_t mV);
+
+/*
+ * @brief current tier
+ */
+const govTier_t* batGovernor_Get(const batGovernor_t *v);
+
+//////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * cadenceItem_t - independent reading interval of the item (sensor)
+ * The deadlines close to the wakeup (within the coalescing window) are taken in the same wakeup.
+ */
+typedef struct //
+{
+	uint32_t Interval;	// reading interval (ms), set by the caller before cadence_Take
+	uint32_t NextDue;	// tick of the next reading
+	uint8_t Started;	// 0 - never read, due now
+} cadenceItem_t;
+
+/*
+ * @brief the items due in the wakeup, their next deadline is planned (now + Interval)
+ * @param mask - enabled items (bitmap)
+ * @param windowMS - the item due within windowMS is taken now (coalescing of wakeups)
+ * @retval bitmap of items to read
+ */
+uint32_t cadence_Take(cadenceItem_t *items, uint8_t count, uint32_t mask, uint32_t now, uint32_t windowMS);
+
+/*
+ * @brief time (ms) to the nearest deadline of enabled items, 0 - due now
+ * @param mask - enabled items (bitmap), no item - UINT32_MAX
+ */
+uint32_t cadence_NextDelay(const cadenceItem_t *items, uint8_t count, uint32_t mask, uint32_t now);
+
+//////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * blockDiff - changed blocks of the memory image against its shadow copy (EEPROM is programmed by blocks)
+ */
+
+/*
+ * @brief next run of the changed blocks from pos, the run is aligned to blocks and cut by len
+ * @param shadow - content of the memory, image - new content
+ * @param start - [out] start of the run
+ * @retval length of the run (bytes), 0 - no change from pos
+ */
+uint16_t blockDiff_Run(const uint8_t *shadow, const uint8_t *image, uint16_t len, uint16_t pos, uint8_t blockSize, uint16_t *start);
+
 /////////////////////////////////////////////////////////////
 
 /*
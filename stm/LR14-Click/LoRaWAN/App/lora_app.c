@@ -40,6 +40,11 @@
 
 /* USER CODE BEGIN Includes */
 #include "main.h"
+#include "lora_planner.h"
+#include "lora_session.h"
+#include "lora_join.h"
+#include "lora_config.h"
+#include "mysensors.h"
 /* USER CODE END Includes */
 
 /* External variables ---------------------------------------------------------*/
@@ -218,6 +223,13 @@ static void OnPingSlotPeriodicityChanged(uint8_t pingSlotPeriodicity);
 static void OnSystemReset(void);
 
 /* USER CODE BEGIN PFP */
+#if APP_JIT_SENSING
+/**
+  * @brief schedule the sensor reading so that data are ready at the next uplink slot
+  */
+static void JitSchedule(void);
+static UTIL_TIMER_Time_t JitPeriod(UTIL_TIMER_Time_t periodicity);
+#endif
 
 /* USER CODE END PFP */
 
@@ -293,10 +305,68 @@ static UTIL_TIMER_Time_t TxPeriodicity = APP_TX_DUTYCYCLE;
 static UTIL_TIMER_Object_t StopJoinTimer;
 
 /* USER CODE BEGIN PV */
+#if APP_JIT_SENSING
+/**
+  * @brief 1 - sensor data are ready, TxTimer waits for the duty-cycle only
+  */
+static uint8_t JitSendPending = 0;
+
+/**
+  * @brief the raised uplink period (logged once), 0 - the period is kept
+  */
+static UTIL_TIMER_Time_t JitRaised = 0;
+#endif
+/**
+  * @brief RAM copy of the flash page for FLASH_IF_Write (NVM context, configuration)
+  */
+static uint8_t FlashPageBuffer[FLASH_PAGE_SIZE];
+
+/**
+  * @brief buffer of the application uplink (configuration acknowledge)
+  */
+static uint8_t AppDataBuffer[LORAWAN_APP_DATA_BUFFER_MAX_SIZE];
+static LmHandlerAppData_t AppData = { 0, 0, AppDataBuffer };
+
+/**
+  * @brief multiplier of the uplink period by the battery power tier
+  */
+static uint8_t TxPeriodScale = 1;
 /* USER CODE END PV */
 
 /* Exported functions ---------------------------------------------------------*/
 /* USER CODE BEGIN EF */
+#if APP_JIT_SENSING
+void sensors_OnReadDone(void)
+{
+  uint32_t delay = loraPlanner_NextTxDelay(APP_JIT_PAYLOAD_SIZE);
+
+  if (delay == 0)
+  {
+    /* uplink in the same active window as the sensors */
+    UTIL_SEQ_SetTask((1 << CFG_SEQ_Task_LoRaSendOnTxTimerOrButtonEvent), CFG_SEQ_Prio_0);
+  }
+  else
+  {
+    /* duty-cycle restricted, wait for the slot */
+    JitSendPending = 1;
+    UTIL_TIMER_Stop(&TxTimer);
+    UTIL_TIMER_SetPeriod(&TxTimer, delay);
+    UTIL_TIMER_Start(&TxTimer);
+  }
+}
+#endif
+
+void loraConfig_OnTxPeriodChanged(uint32_t txPeriod)
+{
+  OnTxPeriodicityChanged(txPeriod * TxPeriodScale);
+}
+
+void sensors_OnPowerTier(uint8_t scale)
+{
+  /* lower uplink rate on the weak battery */
+  TxPeriodScale = scale;
+  OnTxPeriodicityChanged(loraConfig_GetTxPeriod() * TxPeriodScale);
+}
 
 /* USER CODE END EF */
 
@@ -307,7 +377,7 @@ void LoRaWAN_Init(void)
   /* USER CODE END LoRaWAN_Init_LV */
 
   /* USER CODE BEGIN LoRaWAN_Init_1 */
-
+  FLASH_IF_Init(FlashPageBuffer);
   /* USER CODE END LoRaWAN_Init_1 */
 
   UTIL_TIMER_Create(&StopJoinTimer, JOIN_TIME, UTIL_TIMER_ONESHOT, OnStopJoinTimerEvent, NULL);
@@ -327,6 +397,20 @@ void LoRaWAN_Init(void)
   LmHandlerConfigure(&LmHandlerParams);
 
   /* USER CODE BEGIN LoRaWAN_Init_2 */
+  loraPlanner_Init();
+  loraJoin_Init();
+  /* remote configuration stored in the flash */
+  loraConfig_Init(TxPeriodicity);
+  TxPeriodicity = loraConfig_GetTxPeriod();
+  /* resume the stored session, rejoin only if the session is not valid */
+  if (!ForceRejoin && !loraSession_CanResume())
+  {
+    ForceRejoin = true;
+  }
+#if APP_JIT_SENSING
+  sensors_SetCoordinated(EventType == TX_ON_TIMER);
+  TxPeriodicity = JitPeriod(TxPeriodicity);
+#endif
   /* USER CODE END LoRaWAN_Init_2 */
 
   LmHandlerJoin(ActivationType, ForceRejoin);
@@ -345,6 +429,17 @@ void LoRaWAN_Init(void)
   }
 
   /* USER CODE BEGIN LoRaWAN_Init_Last */
+  if (!ForceRejoin)
+  {
+    /* OnJoinRequest is not called for the resumed session */
+    OnLoRaWanConnected();
+  }
+#if APP_JIT_SENSING
+  if (EventType == TX_ON_TIMER)
+  {
+    JitSchedule();
+  }
+#endif
 	APP_LOG(TS_OFF, VLEVEL_M, "LoRaWAN_Init OUT ...\r\n");
 
   /* USER CODE END LoRaWAN_Init_Last */
@@ -380,26 +475,99 @@ void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
 
 /* Private functions ---------------------------------------------------------*/
 /* USER CODE BEGIN PrFD */
+#if APP_JIT_SENSING
+/**
+  * @brief the uplink period is not shorter than the reading cycle and the reading interval of the sensors
+  */
+static UTIL_TIMER_Time_t JitPeriod(UTIL_TIMER_Time_t periodicity)
+{
+  UTIL_TIMER_Time_t period = loraPlanner_JitPeriod(periodicity, sensors_GetCycleTime(), sensors_GetInterval());
+
+  if (period != periodicity && period != JitRaised)
+  {
+    APP_LOG(TS_OFF, VLEVEL_M, "TX period %u ms raised to the sensor cycle + interval %u ms\r\n", (unsigned) periodicity,
+            (unsigned) period);
+  }
+  JitRaised = (period != periodicity) ? period : 0;
+  return period;
+}
+
+static void JitSchedule(void)
+{
+  /* the read cycle can be changed by the configuration */
+  uint32_t rest = loraPlanner_JitDelay(JitPeriod(TxPeriodicity), loraPlanner_NextTxDelay(APP_JIT_PAYLOAD_SIZE),
+                                       sensors_GetCycleTime(), sensors_GetInterval());
+
+  /* TxTimer wakes up the sensors, the uplink follows when data are ready */
+  JitSendPending = 0;
+  UTIL_TIMER_Stop(&TxTimer);
+  UTIL_TIMER_SetPeriod(&TxTimer, rest);
+  UTIL_TIMER_Start(&TxTimer);
+}
+#endif
 
 /* USER CODE END PrFD */
 
 static void OnRxData(LmHandlerAppData_t *appData, LmHandlerRxParams_t *params)
 {
   /* USER CODE BEGIN OnRxData_1 */
+  if ((appData != NULL) && (params != NULL) && (appData->Port == LORAWAN_CONFIG_PORT))
+  {
+    /* applied now, acknowledged by the next uplink */
+    loraConfig_Process(appData->Buffer, appData->BufferSize, params->DownlinkCounter);
+  }
   /* USER CODE END OnRxData_1 */
 }
 
 static void SendTxData(void)
 {
   /* USER CODE BEGIN SendTxData_1 */
-
+#if APP_JIT_SENSING
+  if (EventType == TX_ON_TIMER)
+  {
+    JitSchedule();
+  }
+#endif
+  if (loraConfig_IsAckPending())
+  {
+    AppData.Port = LORAWAN_CONFIG_PORT;
+    AppData.BufferSize = loraConfig_GetAck(AppDataBuffer, sizeof(AppDataBuffer));
+    if (LmHandlerSend(&AppData, LORAMAC_HANDLER_UNCONFIRMED_MSG, false) == LORAMAC_HANDLER_SUCCESS)
+    {
+      loraConfig_Acked();
+      /* one uplink per slot, MAC is busy now, the values are sent in the next slot */
+      return;
+    }
+  }
+  if (!sensors_IsReport())
+  {
+    /* send-on-delta, no channel is out of its deadband */
+    return;
+  }
+  AppData.Port = LORAWAN_USER_APP_PORT;
+  AppData.BufferSize = sensors_GetPayload(AppDataBuffer, sizeof(AppDataBuffer));
+  if (LmHandlerSend(&AppData, LORAWAN_DEFAULT_CONFIRMED_MSG_STATE, false) == LORAMAC_HANDLER_SUCCESS)
+  {
+    sensors_Reported();
+  }
+  /* not sent (busy, duty cycle): the values stay pending for the next slot */
   /* USER CODE END SendTxData_1 */
 }
 
 static void OnTxTimerEvent(void *context)
 {
   /* USER CODE BEGIN OnTxTimerEvent_1 */
-
+#if APP_JIT_SENSING
+  if (JitSendPending == 0)
+  {
+    /* start of the sensors, the uplink is requested via sensors_OnReadDone */
+    sensors_StartAt(0);
+    return;
+  }
+  JitSendPending = 0;
+  UTIL_SEQ_SetTask((1 << CFG_SEQ_Task_LoRaSendOnTxTimerOrButtonEvent), CFG_SEQ_Prio_0);
+  return;
+#endif
   /* USER CODE END OnTxTimerEvent_1 */
   UTIL_SEQ_SetTask((1 << CFG_SEQ_Task_LoRaSendOnTxTimerOrButtonEvent), CFG_SEQ_Prio_0);
 
@@ -417,14 +585,29 @@ static void OnTxTimerEvent(void *context)
 static void OnTxData(LmHandlerTxParams_t *params)
 {
   /* USER CODE BEGIN OnTxData_1 */
+  if ((params != NULL) && (params->IsMcpsConfirm != 0))
+  {
+    if (loraSession_OnTxDone(params->UplinkCounter))
+    {
+      UTIL_SEQ_SetTask((1 << CFG_SEQ_Task_LoRaStoreContextEvent), CFG_SEQ_Prio_0);
+    }
+  }
   /* USER CODE END OnTxData_1 */
 }
 
 static void OnJoinRequest(LmHandlerJoinParams_t *joinParams)
 {
   /* USER CODE BEGIN OnJoinRequest_1 */
+  if (joinParams != NULL && joinParams->Mode == ACTIVATION_TYPE_OTAA)
+  {
+    /* failed join is retried by the scheduler */
+    loraJoin_OnResult(joinParams->Status == LORAMAC_HANDLER_SUCCESS);
+  }
   if (joinParams != NULL && joinParams->Status == LORAMAC_HANDLER_SUCCESS)
   {
+    /* new session, the context is stored for the resume after reset */
+    loraSession_OnJoined();
+    UTIL_SEQ_SetTask((1 << CFG_SEQ_Task_LoRaStoreContextEvent), CFG_SEQ_Prio_0);
     /* Call the user function when LoRaWAN successfully connects */
     OnLoRaWanConnected();
   }
@@ -465,7 +648,10 @@ static void OnMacProcessNotify(void)
 static void OnTxPeriodicityChanged(uint32_t periodicity)
 {
   /* USER CODE BEGIN OnTxPeriodicityChanged_1 */
-
+#if APP_JIT_SENSING
+  /* the period cannot be set shorter than the sensor cycle and interval */
+  periodicity = JitPeriod((periodicity == 0) ? APP_TX_DUTYCYCLE : periodicity);
+#endif
   /* USER CODE END OnTxPeriodicityChanged_1 */
   TxPeriodicity = periodicity;
 
@@ -480,7 +666,12 @@ static void OnTxPeriodicityChanged(uint32_t periodicity)
   UTIL_TIMER_SetPeriod(&TxTimer, TxPeriodicity);
   UTIL_TIMER_Start(&TxTimer);
   /* USER CODE BEGIN OnTxPeriodicityChanged_2 */
-
+#if APP_JIT_SENSING
+  if (EventType == TX_ON_TIMER)
+  {
+    JitSchedule();
+  }
+#endif
   /* USER CODE END OnTxPeriodicityChanged_2 */
 }
 
@@ -523,7 +714,12 @@ static void OnSystemReset(void)
 static void StopJoin(void)
 {
   /* USER CODE BEGIN StopJoin_1 */
-
+  /* the OTAA/ABP toggle is replaced by the join retry scheduler */
+  if (LmHandlerJoinStatus() != LORAMAC_HANDLER_SET)
+  {
+    loraJoin_Restart();
+  }
+  return;
   /* USER CODE END StopJoin_1 */
 
   UTIL_TIMER_Stop(&TxTimer);
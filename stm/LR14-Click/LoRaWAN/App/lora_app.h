@@ -65,6 +65,12 @@ extern "C" {
  */
 #define LORAWAN_SWITCH_CLASS_PORT                   3
 
+/*!
+ * LoRaWAN remote configuration port (lora_config.c)
+ * @note do not use 224. It is reserved for certification
+ */
+#define LORAWAN_CONFIG_PORT                         10
+
 /*!
  * LoRaWAN default class
  */
@@ -103,7 +109,7 @@ extern "C" {
  * LoRaWAN force rejoin even if the NVM context is restored
  * @note useful only when context management is enabled by CONTEXT_MANAGEMENT_ENABLED
  */
-#define LORAWAN_FORCE_REJOIN_AT_BOOT                true
+#define LORAWAN_FORCE_REJOIN_AT_BOOT                false
 
 /*!
  * User application data buffer size
@@ -128,6 +134,34 @@ extern "C" {
 #define LORAWAN_DEFAULT_CLASS_B_C_RESP_TIMEOUT      8000
 
 /* USER CODE BEGIN EC */
+/*!
+ * Just-in-time sensing, the sensor reading is started so that data are ready just before the uplink slot,
+ * sensors and radio share one active window. 0 - sensors are read by own timer (mysensors.c)
+ * The uplink period is not shorter than the reading cycle plus the reading interval (the sensors are off
+ * at least the interval between the cycles), the shorter period (APP_TX_DUTYCYCLE, downlink) is raised to it.
+ */
+#define APP_JIT_SENSING                             1
+
+/*!
+ * Expected application payload size, used for the duty-cycle planning of the uplink
+ */
+#define APP_JIT_PAYLOAD_SIZE                        16
+
+/*!
+ * Rejoin policy, the restored session older than the interval is not resumed, value in [s] (7 days)
+ */
+#define LORAWAN_REJOIN_POLICY_INTERVAL              604800
+
+/*!
+ * The NVM context is stored every N uplinks (flash wear), after the power-on the uplink counter is moved by N
+ */
+#define LORAWAN_SESSION_STORE_PERIOD                32
+
+/*!
+ * Join retry backoff, the delay is doubled after each failed attempt up to the maximum, value in [ms]
+ */
+#define LORAWAN_JOIN_BACKOFF_MIN                    15000
+#define LORAWAN_JOIN_BACKOFF_MAX                    3600000
 
 /* USER CODE END EC */
 
@@ -0,0 +1,266 @@
+/*
+ * lora_config.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ */
+
+#include "lora_config.h"
+#include "mysensors.h"
+#include "flash_if.h"
+
+#include <string.h>
+#include <stddef.h>
+
+#define CFG_BASE_ADDRESS		((void *)0x0803E800UL)	// flash page before the LoRaWAN NVM (0x0803F000)
+#define CFG_MAGIC				0xC0F1
+#define CFG_VERSION				1
+#define CFG_ACK_SIZE			4		// tag, length, counter, rejected
+
+// the configuration stored in the flash, the size is aligned to 8 bytes (FLASH_IF_Write)
+typedef struct
+{
+	uint16_t magic;
+	uint8_t version;
+	uint8_t enabled;		// enabled sensors (bitmap)
+	uint32_t txPeriod;		// TX period (ms)
+	uint32_t interval;		// sensor reading interval (ms)
+	uint16_t readPause;		// pause between readings (ms)
+	uint8_t readingMax;		// max. readings in cycle
+	uint8_t reserved;
+	uint32_t check;			// check of the previous items
+	uint32_t reserved2;
+} cfgStore_t;
+
+static cfgStore_t _cfg = { };
+static cfgStore_t _cfgDefault = { };	// the configuration at boot (compiled values)
+static uint8_t _cfgAckPending = 0;
+static uint8_t _cfgAckCounter = 0;		// LSB of the downlink counter
+static uint8_t _cfgAckRejected = 0;		// bitmap of rejected TLVs
+
+static uint32_t config_Check(const cfgStore_t *cfg)
+{
+	const uint8_t *p = (const uint8_t*) cfg;
+	uint32_t a = 1, b = 0;
+
+	// Adler-32 of the items before check
+	for (uint32_t i = 0; i < offsetof(cfgStore_t, check); i++)
+	{
+		a = (a + p[i]) % 65521;
+		b = (b + a) % 65521;
+	}
+	return (b << 16) | a;
+}
+
+static void config_Store()
+{
+	cfgStore_t stored;
+
+	_cfg.magic = CFG_MAGIC;
+	_cfg.version = CFG_VERSION;
+	_cfg.check = config_Check(&_cfg);
+	// the flash page is erased only if the configuration was changed
+	FLASH_IF_Read(&stored, CFG_BASE_ADDRESS, sizeof(stored));
+	if (memcmp(&stored, &_cfg, sizeof(_cfg)) != 0)
+		FLASH_IF_Write(CFG_BASE_ADDRESS, &_cfg, sizeof(_cfg));
+}
+
+/**
+ * @brief the configuration of reading is set to the sensors
+ * @retval HAL_OK, HAL_ERROR - rejected by the sensors (their configuration is not changed)
+ */
+static HAL_StatusTypeDef config_ApplySensors()
+{
+	sensConfig_t sens;
+
+	sens.interval = _cfg.interval;
+	sens.readPause = _cfg.readPause;
+	sens.readingMax = _cfg.readingMax;
+	sens.enabled = _cfg.enabled;
+	return sensors_SetConfig(&sens);
+}
+
+static uint16_t config_Get16(const uint8_t *p)
+{
+	return (uint16_t) p[0] | ((uint16_t) p[1] << 8);
+}
+
+static uint8_t config_Put16(uint8_t *p, uint8_t tag, uint16_t value)
+{
+	p[0] = tag;
+	p[1] = 2;
+	p[2] = (uint8_t) value;
+	p[3] = (uint8_t) (value >> 8);
+	return 4;
+}
+
+static uint8_t config_Put8(uint8_t *p, uint8_t tag, uint8_t value)
+{
+	p[0] = tag;
+	p[1] = 1;
+	p[2] = value;
+	return 3;
+}
+
+/**
+ * @brief one TLV command, the value is checked and set to the configuration
+ * @retval HAL_OK, HAL_ERROR - unknown tag, wrong length or value out of range
+ */
+static HAL_StatusTypeDef config_Set(cfgStore_t *cfg, uint8_t tag, const uint8_t *value, uint8_t len)
+{
+	uint16_t v16 = (len == 2) ? config_Get16(value) : 0;
+
+	switch (tag)
+	{
+		case CFG_TAG_TX_PERIOD:
+			if (len != 2 || v16 < 10)
+				return HAL_ERROR;
+			cfg->txPeriod = (uint32_t) v16 * 1000;
+		break;
+		case CFG_TAG_INTERVAL:
+			if (len != 2 || v16 < 10)
+				return HAL_ERROR;
+			cfg->interval = (uint32_t) v16 * 1000;
+		break;
+		case CFG_TAG_READ_PAUSE:
+			if (len != 2 || v16 < 100 || v16 > 60000)
+				return HAL_ERROR;
+			cfg->readPause = v16;
+		break;
+		case CFG_TAG_READING_MAX:
+			if (len != 1 || value[0] == 0 || value[0] > 60)
+				return HAL_ERROR;
+			cfg->readingMax = value[0];
+		break;
+		case CFG_TAG_ENABLED:
+			if (len != 1)
+				return HAL_ERROR;
+			cfg->enabled = value[0];
+		break;
+		case CFG_TAG_DEFAULT:
+			if (len != 0)
+				return HAL_ERROR;
+			*cfg = _cfgDefault;
+		break;
+		default:
+			return HAL_ERROR;
+	}
+	return HAL_OK;
+}
+
+void loraConfig_Init(uint32_t txPeriod)
+{
+	sensConfig_t sens;
+	cfgStore_t stored;
+
+	sensors_GetConfig(&sens);
+	_cfgDefault.txPeriod = txPeriod;
+	_cfgDefault.interval = sens.interval;
+	_cfgDefault.readPause = sens.readPause;
+	_cfgDefault.readingMax = sens.readingMax;
+	_cfgDefault.enabled = sens.enabled;
+	_cfg = _cfgDefault;
+
+	FLASH_IF_Read(&stored, CFG_BASE_ADDRESS, sizeof(stored));
+	if (stored.magic == CFG_MAGIC && stored.version == CFG_VERSION && stored.check == config_Check(&stored))
+	{
+		_cfg = stored;
+		if (config_ApplySensors() != HAL_OK)
+			_cfg = _cfgDefault;	// the sensors keep the compiled values
+	}
+}
+
+uint32_t loraConfig_GetTxPeriod(void)
+{
+	return _cfg.txPeriod;
+}
+
+HAL_StatusTypeDef loraConfig_Process(const uint8_t *data, uint8_t size, uint32_t counter)
+{
+	cfgStore_t cfg = _cfg;
+	cfgStore_t previous = _cfg;
+	uint8_t rejected = 0;
+	uint8_t commands = 0;	// bitmap of all TLVs
+	uint8_t index = 0;
+	uint8_t i = 0;
+
+	while (i + 2 <= size)
+	{
+		uint8_t tag = data[i];
+		uint8_t len = data[i + 1];
+		uint8_t bit = (index < 8) ? (1 << index) : 0x80;
+
+		commands |= bit;
+		if (i + 2 + len > size)
+		{
+			rejected |= bit;	// truncated TLV
+			break;
+		}
+		if (config_Set(&cfg, tag, &data[i + 2], len) != HAL_OK)
+			rejected |= bit;
+		i += 2 + len;
+		index++;
+	}
+	if (i < size && i + 2 > size)
+	{
+		commands |= (index < 8) ? (1 << index) : 0x80;
+		rejected |= (index < 8) ? (1 << index) : 0x80;	// trailing byte
+	}
+
+	uint8_t txChanged = (cfg.txPeriod != _cfg.txPeriod);
+	_cfg = cfg;
+	if (config_ApplySensors() != HAL_OK)
+	{
+		// the sensors refused the combination, nothing is applied nor stored
+		_cfg = previous;
+		rejected = commands;
+	}
+	else
+	{
+		config_Store();
+		if (txChanged)
+			loraConfig_OnTxPeriodChanged(_cfg.txPeriod);
+	}
+
+	_cfgAckCounter = (uint8_t) counter;
+	_cfgAckRejected = rejected;
+	_cfgAckPending = 1;
+	return (rejected == 0) ? HAL_OK : HAL_ERROR;
+}
+
+int8_t loraConfig_IsAckPending(void)
+{
+	return _cfgAckPending;
+}
+
+uint8_t loraConfig_GetAck(uint8_t *buffer, uint8_t size)
+{
+	uint8_t len = 0;
+
+	if (!_cfgAckPending || size < CFG_ACK_SIZE)
+		return 0;
+	buffer[len++] = CFG_TAG_ACK;
+	buffer[len++] = 2;
+	buffer[len++] = _cfgAckCounter;
+	buffer[len++] = _cfgAckRejected;
+	// current configuration, if it fits
+	if (size - len >= 4 * 3 + 3 * 2)
+	{
+		len += config_Put16(&buffer[len], CFG_TAG_TX_PERIOD, (uint16_t) (_cfg.txPeriod / 1000));
+		len += config_Put16(&buffer[len], CFG_TAG_INTERVAL, (uint16_t) (_cfg.interval / 1000));
+		len += config_Put16(&buffer[len], CFG_TAG_READ_PAUSE, _cfg.readPause);
+		len += config_Put8(&buffer[len], CFG_TAG_READING_MAX, _cfg.readingMax);
+		len += config_Put8(&buffer[len], CFG_TAG_ENABLED, _cfg.enabled);
+	}
+	return len;
+}
+
+void loraConfig_Acked(void)
+{
+	_cfgAckPending = 0;
+}
+
+__weak void loraConfig_OnTxPeriodChanged(uint32_t txPeriod)
+{
+	// must be overridden by the application (TX timer)
+}
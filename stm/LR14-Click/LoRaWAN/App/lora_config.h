@@ -0,0 +1,73 @@
+/*
+ * lora_config.h
+ *
+ * Remote configuration by downlink (LORAWAN_CONFIG_PORT), TLV commands: tag (1 B), length (1 B), value (LE)
+ * - 0x01 TX period (2 B, s)
+ * - 0x02 sensor reading interval (2 B, s), own timer of sensors only (not just-in-time sensing)
+ * - 0x03 pause between readings in cycle (2 B, ms)
+ * - 0x04 max. readings in cycle (1 B)
+ * - 0x05 enabled sensors (1 B, bitmap: tempHum, ambient, barometer, scd41, sps30)
+ * - 0x7F default configuration (0 B)
+ * The configuration is applied without reboot and stored in the flash (only if changed).
+ * The next uplink on LORAWAN_CONFIG_PORT acknowledges it: 0x80 (2 B: downlink counter LSB, bitmap of rejected TLVs)
+ * followed by the current configuration (TLVs 0x01..0x05).
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ */
+
+#ifndef APP_LORA_CONFIG_H_
+#define APP_LORA_CONFIG_H_
+
+#include "stm32wlxx_hal.h"
+
+#define CFG_TAG_TX_PERIOD		0x01
+#define CFG_TAG_INTERVAL		0x02
+#define CFG_TAG_READ_PAUSE		0x03
+#define CFG_TAG_READING_MAX		0x04
+#define CFG_TAG_ENABLED			0x05
+#define CFG_TAG_DEFAULT			0x7F
+#define CFG_TAG_ACK				0x80
+
+/**
+ * @brief loading of the configuration from the flash, the sensors configuration is applied
+ * @param txPeriod - default TX period (ms), used if the configuration is not stored
+ */
+void loraConfig_Init(uint32_t txPeriod);
+
+/**
+ * @brief TX period (ms) of the configuration
+ */
+uint32_t loraConfig_GetTxPeriod(void);
+
+/**
+ * @brief processing of the configuration downlink
+ * @param data, size - TLV commands
+ * @param counter - downlink counter (for the acknowledge)
+ * @retval HAL_OK - all commands applied, HAL_ERROR - some command was rejected (see the acknowledge)
+ */
+HAL_StatusTypeDef loraConfig_Process(const uint8_t *data, uint8_t size, uint32_t counter);
+
+/**
+ * @brief the acknowledge of the configuration is waiting for the uplink
+ */
+int8_t loraConfig_IsAckPending(void);
+
+/**
+ * @brief the acknowledge payload, the pending flag is cleared by loraConfig_Acked
+ * @param buffer, size - the buffer for the payload
+ * @retval length of the payload, 0 - nothing to send (or too small buffer)
+ */
+uint8_t loraConfig_GetAck(uint8_t *buffer, uint8_t size);
+
+/**
+ * @brief the acknowledge was sent
+ */
+void loraConfig_Acked(void);
+
+/**
+ * @brief TX period was changed by the downlink, the TX timer must be rescheduled (overridden in lora_app.c)
+ */
+void loraConfig_OnTxPeriodChanged(uint32_t txPeriod);
+
+#endif /* APP_LORA_CONFIG_H_ */
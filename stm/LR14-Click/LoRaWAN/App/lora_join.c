@@ -0,0 +1,131 @@
+/*
+ * lora_join.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ */
+
+#include "lora_join.h"
+#include "main.h"
+#include "lora_app.h"
+#include "lora_planner.h"
+#include "sys_app.h"
+#include "stm32_seq.h"
+#include "stm32_timer.h"
+#include "utilities_def.h"
+#include "utilities.h"
+
+#define JOIN_REQUEST_SIZE		10		// join request 23 bytes = 10 + LoRaWAN frame overhead (planner)
+#define JOIN_BUSY_DELAY			1000	// the MAC is busy (pending RX windows)
+
+// aggregated join duty cycle, the off-time is time-on-air * factor
+typedef struct
+{
+	uint32_t until;		// time from the start of join (ms)
+	uint16_t factor;	// 1 / duty cycle
+} joinDutyCycle_t;
+
+static const joinDutyCycle_t _joinDutyCycle[] =
+{
+	{ 3600000, 100 },		// first hour 36 s / 1 h
+	{ 39600000, 1000 },		// up to 11 h 36 s / 10 h
+	{ 0, 10000 },			// later 8.7 s / 24 h
+};
+
+static UTIL_TIMER_Object_t _joinTimer;
+static UTIL_TIMER_Time_t _joinStart = 0;	// start of the join procedure
+static uint16_t _joinAttempt = 0;			// failed attempts
+static int8_t _joinDrMax = DR_0;			// the fastest datarate of the rotation
+static int8_t _joinDr = DR_0;				// datarate of the last attempt
+
+static void join_OnTimer(void *context)
+{
+	UTIL_SEQ_SetTask((1 << CFG_SEQ_Task_LoRaJoinRetry), CFG_SEQ_Prio_0);
+}
+
+static void join_Schedule(uint32_t delay)
+{
+	UTIL_TIMER_Stop(&_joinTimer);
+	UTIL_TIMER_SetPeriod(&_joinTimer, (delay > 0) ? delay : 1);
+	UTIL_TIMER_Start(&_joinTimer);
+}
+
+/**
+ * @brief the datarate of the attempt, from the fastest to DR0 (the farthest gateway)
+ */
+static int8_t join_GetDatarate(uint16_t attempt)
+{
+	return _joinDrMax - (int8_t) (attempt % (_joinDrMax + 1));
+}
+
+/**
+ * @brief next join attempt (sequencer task)
+ */
+static void join_Retry(void)
+{
+	if (LmHandlerJoinStatus() == LORAMAC_HANDLER_SET)
+		return;
+
+	_joinDr = join_GetDatarate(_joinAttempt);
+	if (LmHandlerJoinRetry(_joinDr) != LORAMAC_HANDLER_SUCCESS)
+	{
+		// duty cycle restricted or MAC busy, the attempt is repeated later
+		uint32_t wait = LmHandlerGetDutyCycleWaitTime();
+		join_Schedule((wait > JOIN_BUSY_DELAY) ? wait : JOIN_BUSY_DELAY);
+		return;
+	}
+	APP_LOG(TS_OFF, VLEVEL_M, "Join attempt %u, DR%d\r\n", _joinAttempt + 1, _joinDr);
+}
+
+uint32_t loraJoin_GetDelay(uint16_t attempt, uint32_t elapsed, uint32_t timeOnAir)
+{
+	uint32_t delay = LORAWAN_JOIN_BACKOFF_MIN;
+	uint8_t i = 0;
+
+	// doubled per attempt up to the cap, no shift of the signed constant (overflow from attempt 19)
+	for (uint16_t n = 1; n < attempt && delay < LORAWAN_JOIN_BACKOFF_MAX; n++)
+		delay *= 2;
+	if (delay > LORAWAN_JOIN_BACKOFF_MAX)
+		delay = LORAWAN_JOIN_BACKOFF_MAX;
+	while (_joinDutyCycle[i].until != 0 && elapsed >= _joinDutyCycle[i].until)
+		i++;
+	uint32_t offTime = timeOnAir * _joinDutyCycle[i].factor;
+	return (offTime > delay) ? offTime : delay;
+}
+
+void loraJoin_Init(void)
+{
+	LoRaMacRegion_t region = LORAMAC_REGION_EU868;
+
+	LmHandlerGetActiveRegion(&region);
+	// EU868 DR5 (SF7) .. DR0 (SF12), US915 DR3 (SF7) .. DR0 (SF10), the 125 kHz channels
+	_joinDrMax = (region == LORAMAC_REGION_US915) ? DR_3 : DR_5;
+	UTIL_SEQ_RegTask((1 << CFG_SEQ_Task_LoRaJoinRetry), UTIL_SEQ_RFU, join_Retry);
+	UTIL_TIMER_Create(&_joinTimer, LORAWAN_JOIN_BACKOFF_MIN, UTIL_TIMER_ONESHOT, join_OnTimer, NULL);
+	_joinStart = UTIL_TIMER_GetCurrentTime();
+	_joinAttempt = 0;
+	_joinDr = LORAWAN_DEFAULT_DATA_RATE;
+}
+
+void loraJoin_OnResult(int8_t success)
+{
+	if (success)
+	{
+		UTIL_TIMER_Stop(&_joinTimer);
+		_joinAttempt = 0;
+		return;
+	}
+	_joinAttempt++;
+	uint32_t delay = loraJoin_GetDelay(_joinAttempt, UTIL_TIMER_GetElapsedTime(_joinStart), loraPlanner_TimeOnAir(_joinDr, JOIN_REQUEST_SIZE));
+	// jitter up to 1/8 of delay, the devices after common power failure are not synchronized
+	delay += (uint32_t) randr(0, (int32_t) (delay >> 3));
+	APP_LOG(TS_OFF, VLEVEL_M, "Join failed, retry in %u s\r\n", delay / 1000);
+	join_Schedule(delay);
+}
+
+void loraJoin_Restart(void)
+{
+	// the backoff is restarted, the aggregated duty cycle is counted from the first join
+	_joinAttempt = 0;
+	join_Schedule(1);
+}
@@ -0,0 +1,44 @@
+/*
+ * lora_join.h
+ *
+ * Join retry scheduler (OTAA), the failed join is retried with bounded energy
+ * - capped exponential backoff with random jitter between attempts
+ * - the datarate is rotated for each attempt, the channel is chosen randomly by the MAC
+ * - the aggregated join duty cycle (1% first hour, 0.1% up to 11 h, 0.01% later)
+ * - the MCU is in STOP2 between attempts (UTIL_TIMER)
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ */
+
+#ifndef APP_LORA_JOIN_H_
+#define APP_LORA_JOIN_H_
+
+#include "stm32wlxx_hal.h"
+
+/**
+ * @brief Initialization of the scheduler, must be called after LmHandlerConfigure (the active region)
+ */
+void loraJoin_Init(void);
+
+/**
+ * @brief the result of the join request, failed join schedules next attempt
+ * @param success - 1 - joined (the scheduler is stopped), 0 - join failed
+ */
+void loraJoin_OnResult(int8_t success);
+
+/**
+ * @brief the join procedure is restarted from the first attempt
+ */
+void loraJoin_Restart(void);
+
+/**
+ * @brief the delay before the next join attempt
+ * @param attempt - number of the failed attempts (1 - first retry)
+ * @param elapsed - time (ms) from the start of the join procedure
+ * @param timeOnAir - time on air (ms) of the last join request
+ * @retval delay in ms (backoff without jitter, at least the off-time of the aggregated duty cycle)
+ */
+uint32_t loraJoin_GetDelay(uint16_t attempt, uint32_t elapsed, uint32_t timeOnAir);
+
+#endif /* APP_LORA_JOIN_H_ */
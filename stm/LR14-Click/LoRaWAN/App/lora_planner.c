@@ -0,0 +1,180 @@
+/*
+ * lora_planner.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ */
+
+#include "lora_planner.h"
+
+#define PLAN_DR_MAX				16		// size of the time-on-air table
+#define PLAN_PREAMBLE_LEN		8		// LoRaWAN preamble symbols
+#define PLAN_CR_DENOM			5		// coding rate 4/5
+#define PLAN_FSK_KBPS			50		// FSK datarate (kbps)
+
+// LoRa modulation of the datarate
+typedef struct
+{
+	uint8_t sf;		// spreading factor, 0 - datarate not used, 50 - FSK
+	uint16_t bw;	// bandwidth in kHz
+} planModem_t;
+
+// precomputed coefficients for time on air
+typedef struct
+{
+	uint8_t sf;				// 0 - datarate not supported
+	uint8_t den;			// denominator of the payload symbols (4 * SF, 4 * (SF - 2) with low datarate optimization)
+	uint16_t bw;			// bandwidth in kHz
+	int16_t numOffset;		// constant part of the payload symbols numerator
+	uint32_t fixed;			// fixed part of symbols * 4 (preamble, sync, header)
+} planToA_t;
+
+static const planModem_t _modemEU868[] =
+{
+	{ 12, 125 },	// DR0
+	{ 11, 125 },	// DR1
+	{ 10, 125 },	// DR2
+	{ 9, 125 },		// DR3
+	{ 8, 125 },		// DR4
+	{ 7, 125 },		// DR5
+	{ 7, 250 },		// DR6
+	{ 50, 0 }		// DR7 - FSK
+};
+
+static const planModem_t _modemUS915[] =
+{
+	{ 10, 125 },	// DR0
+	{ 9, 125 },		// DR1
+	{ 8, 125 },		// DR2
+	{ 7, 125 },		// DR3
+	{ 8, 500 },		// DR4
+	{ 0, 0 },		// DR5 - LR-FHSS
+	{ 0, 0 },		// DR6 - LR-FHSS
+	{ 0, 0 },		// DR7 - RFU
+	{ 12, 500 },	// DR8
+	{ 11, 500 },	// DR9
+	{ 10, 500 },	// DR10
+	{ 9, 500 },		// DR11
+	{ 8, 500 },		// DR12
+	{ 7, 500 }		// DR13
+};
+
+static planToA_t _toaTable[PLAN_DR_MAX];
+
+/**
+ * @brief fill the coefficients for the datarate, same formula as the radio driver (RadioGetLoRaTimeOnAirNumerator)
+ */
+static void planner_SetModem(planToA_t *toa, const planModem_t *modem)
+{
+	toa->sf = modem->sf;
+	toa->bw = modem->bw;
+	if (modem->sf == 0 || modem->sf == PLAN_FSK_KBPS)
+		return;
+
+	uint8_t sf = modem->sf;
+	// low datarate optimization
+	uint8_t lowDrOpt = ((modem->bw == 125 && sf >= 11) || (modem->bw == 250 && sf == 12)) ? 1 : 0;
+	// explicit header, CRC on
+	toa->numOffset = 16 - 4 * sf + 20;
+	toa->den = 4 * sf;
+	// preamble + 12 symbols (sync word, header), the quarter of symbol
+	toa->fixed = 4 * (PLAN_PREAMBLE_LEN + 12) + 1;
+	if (sf <= 6)
+		toa->fixed += 4 * 2;
+	else
+	{
+		toa->numOffset += 8;
+		if (lowDrOpt)
+			toa->den = 4 * (sf - 2);
+	}
+}
+
+void loraPlanner_Init(void)
+{
+	LoRaMacRegion_t region = LORAMAC_REGION_EU868;
+	const planModem_t *modem = _modemEU868;
+	uint8_t count = sizeof(_modemEU868) / sizeof(_modemEU868[0]);
+
+	LmHandlerGetActiveRegion(&region);
+	if (region == LORAMAC_REGION_US915)
+	{
+		modem = _modemUS915;
+		count = sizeof(_modemUS915) / sizeof(_modemUS915[0]);
+	}
+	for (uint8_t i = 0; i < PLAN_DR_MAX; i++)
+	{
+		planToA_t *toa = &_toaTable[i];
+		toa->sf = 0;
+		if (i < count)
+			planner_SetModem(toa, &modem[i]);
+	}
+}
+
+uint32_t loraPlanner_TimeOnAir(int8_t datarate, uint8_t size)
+{
+	if (datarate < 0 || datarate >= PLAN_DR_MAX)
+		return 0;
+
+	const planToA_t *toa = &_toaTable[datarate];
+	uint32_t len = (uint32_t) size + LORAMAC_FRAME_PAYLOAD_OVERHEAD_SIZE;
+
+	if (toa->sf == 0)
+		return 0;
+	if (toa->sf == PLAN_FSK_KBPS)
+	{
+		// preamble 5 bytes, sync word 3 bytes, length 1 byte, CRC 2 bytes
+		uint32_t bits = (5 + 3 + 1 + len + 2) * 8;
+		return (bits + PLAN_FSK_KBPS - 1) / PLAN_FSK_KBPS;
+	}
+
+	int32_t num = 8 * (int32_t) len + toa->numOffset;
+	uint32_t symbols = 0;
+	if (num > 0)
+		symbols = ((uint32_t) num + toa->den - 1) / toa->den * PLAN_CR_DENOM;
+	// symbols * 4 (quarter of the symbol), the symbol time is 2^SF / BW
+	uint32_t quarters = symbols * 4 + toa->fixed;
+	uint32_t numerator = quarters << (toa->sf - 2);
+	return (numerator + toa->bw - 1) / toa->bw;
+}
+
+uint32_t loraPlanner_NextTxDelay(uint8_t size)
+{
+	TimerTime_t delay = 0;
+
+	if (LmHandlerGetNextTxDelay(size, &delay) != LORAMAC_HANDLER_SUCCESS)
+		return LmHandlerGetDutyCycleWaitTime();
+	return delay;
+}
+
+uint32_t loraPlanner_JitPeriod(uint32_t period, uint32_t cycleTime, uint32_t interval)
+{
+	return (period < cycleTime + interval) ? cycleTime + interval : period;
+}
+
+uint32_t loraPlanner_JitDelay(uint32_t period, uint32_t txDelay, uint32_t cycleTime, uint32_t interval)
+{
+	uint32_t next = (txDelay > period) ? txDelay : period;
+
+	if (next < cycleTime)
+		next = cycleTime;
+	// the sensors are off at least the reading interval between the cycles
+	return (next - cycleTime > interval) ? next - cycleTime : interval;
+}
+
+HAL_StatusTypeDef loraPlanner_GetPlan(uint8_t size, loraPlan_t *plan)
+{
+	TimerTime_t delay = 0;
+
+	plan->Datarate = 0;
+	plan->MaxPayload = 0;
+	plan->TimeOnAir = 0;
+	plan->NextTxDelay = 0;
+	if (LmHandlerGetTxDatarate(&plan->Datarate) != LORAMAC_HANDLER_SUCCESS)
+		return HAL_ERROR;
+	LmHandlerGetMaxPayload(&plan->MaxPayload);
+	plan->TimeOnAir = loraPlanner_TimeOnAir(plan->Datarate, size);
+	if (LmHandlerGetNextTxDelay(size, &delay) != LORAMAC_HANDLER_SUCCESS)
+		return HAL_ERROR;
+	plan->NextTxDelay = delay;
+	return HAL_OK;
+}
@@ -0,0 +1,74 @@
+/*
+ * lora_planner.h
+ *
+ * Airtime and duty-cycle planner for the application
+ * - time-on-air of the application payload for the datarate (precomputed table per DR)
+ * - the time until the MAC allows next uplink (duty-cycle across enabled bands)
+ * - maximum application payload at the current datarate
+ *
+ * The sensor reading and the batching of data can be scheduled just before the next legal uplink.
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ */
+
+#ifndef APP_LORA_PLANNER_H_
+#define APP_LORA_PLANNER_H_
+
+#include "stm32wlxx_hal.h"
+#include "LmHandler.h"
+#include "LoRaMacHeaderTypes.h"
+
+/**
+ * @brief the plan of next uplink
+ */
+typedef struct
+{
+	int8_t Datarate;		// current TX datarate
+	uint8_t MaxPayload;		// maximum application payload at Datarate (pending MAC commands are included)
+	uint32_t TimeOnAir;		// time on air (ms) of requested payload at Datarate
+	uint32_t NextTxDelay;	// time (ms) until uplink is allowed, 0 - now
+} loraPlan_t;
+
+/**
+ * @brief Initialization of the time-on-air table for the active region, must be called after LmHandlerConfigure
+ */
+void loraPlanner_Init(void);
+
+/**
+ * @brief time on air of the uplink with application payload
+ * @param datarate - datarate DR_x of the active region
+ * @param size - application payload size, the LoRaWAN frame overhead (13 bytes) is added
+ * @retval time on air in ms, 0 - datarate is not supported
+ */
+uint32_t loraPlanner_TimeOnAir(int8_t datarate, uint8_t size);
+
+/**
+ * @brief the plan of the uplink with application payload at the current datarate
+ * @param size - application payload size
+ * @param plan - [out] plan of the uplink
+ * @retval HAL_OK, HAL_ERROR - the MAC cannot plan the uplink (no channel for datarate)
+ */
+HAL_StatusTypeDef loraPlanner_GetPlan(uint8_t size, loraPlan_t *plan);
+
+/**
+ * @brief time (ms) until the uplink with application payload is allowed, 0 - now
+ */
+uint32_t loraPlanner_NextTxDelay(uint8_t size);
+
+/**
+ * @brief just-in-time sensing: the uplink period (ms) kept by loraPlanner_JitDelay, the sensors are off at least
+ * the interval between the cycles, so the shorter period is raised to cycleTime + interval
+ */
+uint32_t loraPlanner_JitPeriod(uint32_t period, uint32_t cycleTime, uint32_t interval);
+
+/**
+ * @brief just-in-time sensing: time (ms) to the start of the sensors, the reading cycle ends at the next uplink
+ * @param period - uplink period (ms), not shorter than loraPlanner_JitPeriod (else stretched to it)
+ * @param txDelay - time (ms) until the uplink is allowed (loraPlanner_NextTxDelay)
+ * @param cycleTime - duration of the reading cycle (ms), the sensors start this time before the uplink
+ * @param interval - min. time (ms) of the sensors off between the cycles
+ */
+uint32_t loraPlanner_JitDelay(uint32_t period, uint32_t txDelay, uint32_t cycleTime, uint32_t interval);
+
+#endif /* APP_LORA_PLANNER_H_ */
@@ -0,0 +1,113 @@
+/*
+ * lora_session.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ */
+
+#include "lora_session.h"
+#include "lora_app.h"
+#include "sys_app.h"
+#include "stm32_systime.h"
+#include "rtc.h"
+
+// session watermarks in RTC backup registers (DR0..DR2 timer_if.c, DR3..DR5 mysensors.c)
+#define SESS_BKP_NONCE		RTC_BKP_DR6		// magic (high 16 bits) | DevNonce of the last join
+#define SESS_BKP_FCNT		RTC_BKP_DR7		// last sent uplink counter
+#define SESS_BKP_JOINED		RTC_BKP_DR8		// time of the join (RTC seconds, SysTime is moved by DeviceTimeAns)
+#define SESS_BKP_MAGIC		0x5E55
+
+static uint32_t _sessStoredFCnt = 0;	// uplink counter of the stored NVM (the last store request)
+
+/**
+ * @brief the NVM context of the MAC (restored, or current)
+ */
+static LoRaMacNvmData_t* session_GetNvm()
+{
+	MibRequestConfirm_t mibReq;
+
+	mibReq.Type = MIB_NVM_CTXS;
+	if (LoRaMacMibGetRequestConfirm(&mibReq) != LORAMAC_STATUS_OK)
+		return NULL;
+	return (LoRaMacNvmData_t*) mibReq.Param.Contexts;
+}
+
+/**
+ * @brief the watermarks of the current session to the backup registers
+ */
+static void session_SaveWatermarks(uint16_t devNonce, uint32_t fCnt, uint32_t joined)
+{
+	HAL_RTCEx_BKUPWrite(&hrtc, SESS_BKP_NONCE, ((uint32_t) SESS_BKP_MAGIC << 16) | devNonce);
+	HAL_RTCEx_BKUPWrite(&hrtc, SESS_BKP_FCNT, fCnt);
+	HAL_RTCEx_BKUPWrite(&hrtc, SESS_BKP_JOINED, joined);
+}
+
+int8_t loraSession_CanResume(void)
+{
+	// the context was not restored (or CRC failed) - the MAC is not activated
+	if (LmHandlerJoinStatus() != LORAMAC_HANDLER_SET)
+		return 0;
+
+	LoRaMacNvmData_t *nvm = session_GetNvm();
+	if (nvm == NULL)
+		return 0;
+
+	uint32_t now = SysTimeGetMcuTime().Seconds;
+	uint32_t nonce = HAL_RTCEx_BKUPRead(&hrtc, SESS_BKP_NONCE);
+	uint32_t stored = nvm->Crypto.FCntList.FCntUp;
+	uint32_t fCnt = stored;
+
+	if ((nonce >> 16) != SESS_BKP_MAGIC)
+	{
+		// power-on, the backup registers are lost - the counter is moved over the uplinks not stored to NVM,
+		// the age of session is unknown, it is counted from now
+		fCnt += LORAWAN_SESSION_STORE_PERIOD;
+		session_SaveWatermarks(nvm->Crypto.DevNonce, fCnt, now);
+	}
+	else
+	{
+		// the NVM is older than the last join (store failed), the session keys are not valid
+		if (nvm->Crypto.DevNonce != (uint16_t) nonce)
+		{
+			APP_LOG(TS_OFF, VLEVEL_M, "Session: DevNonce %u != %u, rejoin\r\n", nvm->Crypto.DevNonce, (uint16_t) nonce);
+			return 0;
+		}
+		uint32_t joined = HAL_RTCEx_BKUPRead(&hrtc, SESS_BKP_JOINED);
+		if ((now - joined) > LORAWAN_REJOIN_POLICY_INTERVAL)
+		{
+			APP_LOG(TS_OFF, VLEVEL_M, "Session: age %u s, rejoin\r\n", now - joined);
+			return 0;
+		}
+		// the counter must not go back (replay protection of the network server)
+		uint32_t watermark = HAL_RTCEx_BKUPRead(&hrtc, SESS_BKP_FCNT);
+		if (watermark > fCnt)
+			fCnt = watermark;
+	}
+	nvm->Crypto.FCntList.FCntUp = fCnt;
+	// the period of the store is counted from the counter in the NVM, not the moved one - the first uplink
+	// after the power-on is stored, another power-on would move the counter from the old NVM again
+	_sessStoredFCnt = stored;
+	APP_LOG(TS_OFF, VLEVEL_M, "Session: resumed, FCntUp %u\r\n", fCnt);
+	return 1;
+}
+
+void loraSession_OnJoined(void)
+{
+	LoRaMacNvmData_t *nvm = session_GetNvm();
+
+	if (nvm == NULL)
+		return;
+	session_SaveWatermarks(nvm->Crypto.DevNonce, 0, SysTimeGetMcuTime().Seconds);
+	_sessStoredFCnt = 0;
+}
+
+int8_t loraSession_OnTxDone(uint32_t uplinkCounter)
+{
+	if ((HAL_RTCEx_BKUPRead(&hrtc, SESS_BKP_NONCE) >> 16) != SESS_BKP_MAGIC)
+		return 0;
+	HAL_RTCEx_BKUPWrite(&hrtc, SESS_BKP_FCNT, uplinkCounter);
+	if ((uplinkCounter - _sessStoredFCnt) < LORAWAN_SESSION_STORE_PERIOD)
+		return 0;
+	_sessStoredFCnt = uplinkCounter;
+	return 1;
+}
@@ -0,0 +1,39 @@
+/*
+ * lora_session.h
+ *
+ * Resume of the stored LoRaWAN session at boot (instead of the forced rejoin)
+ * - the NVM context is restored and CRC checked by the MAC (LmHandlerConfigure)
+ * - the DevNonce and the uplink frame counter are checked against the watermarks in RTC backup registers,
+ *   the NVM is stored only every LORAWAN_SESSION_STORE_PERIOD uplinks, so the counter is moved forward
+ * - the session older than LORAWAN_REJOIN_POLICY_INTERVAL is not resumed (periodic rejoin, new keys)
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ */
+
+#ifndef APP_LORA_SESSION_H_
+#define APP_LORA_SESSION_H_
+
+#include "stm32wlxx_hal.h"
+#include "LmHandler.h"
+#include "LoRaMac.h"
+
+/**
+ * @brief the check of the restored session, must be called after LmHandlerConfigure
+ * @retval 1 - session can be resumed (the uplink counter is moved over the watermark), 0 - rejoin is needed
+ */
+int8_t loraSession_CanResume(void);
+
+/**
+ * @brief new session (join accepted), the join time and the watermarks are stored
+ */
+void loraSession_OnJoined(void);
+
+/**
+ * @brief uplink was sent, the frame counter watermark is updated
+ * @param uplinkCounter - the counter of the sent uplink
+ * @retval 1 - the NVM context should be stored (every LORAWAN_SESSION_STORE_PERIOD uplinks)
+ */
+int8_t loraSession_OnTxDone(uint32_t uplinkCounter);
+
+#endif /* APP_LORA_SESSION_H_ */
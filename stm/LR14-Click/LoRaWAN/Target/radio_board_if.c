@@ -26,7 +26,7 @@
 #include "radio_board_if.h"
 
 /* USER CODE BEGIN Includes */
-
+#include "trace.h"
 /* USER CODE END Includes */
 
 /* External variables ---------------------------------------------------------*/
@@ -147,7 +147,18 @@ int32_t RBI_DeInit(void)
 int32_t RBI_ConfigRFSwitch(RBI_Switch_TypeDef Config)
 {
   /* USER CODE BEGIN RBI_ConfigRFSwitch_1 */
+  // event trace of TX/RX, the switch follows the state of the radio
+  static uint16_t traceRf = TRACE_ID_NBR;	// TX/RX in the trace, TRACE_ID_NBR - off
+  uint16_t rf = (Config == RBI_SWITCH_RX) ? TRACE_RADIO_RX : (Config == RBI_SWITCH_OFF) ? TRACE_ID_NBR : TRACE_RADIO_TX;
 
+  if (rf != traceRf)
+  {
+    if (traceRf != TRACE_ID_NBR)
+      TRACE_END(traceRf, 0);
+    if (rf != TRACE_ID_NBR)
+      TRACE_BEGIN(rf, 0);
+    traceRf = rf;
+  }
   /* USER CODE END RBI_ConfigRFSwitch_1 */
 #if defined(USE_BSP_DRIVER)
 
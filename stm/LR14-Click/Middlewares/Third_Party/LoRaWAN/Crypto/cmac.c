@@ -60,11 +60,50 @@ void AES_CMAC_Init( AES_CMAC_CTX* ctx )
     memset1( ctx->X, 0, sizeof ctx->X );
     ctx->M_n = 0;
     memset1( ctx->rijndael.ksch, '\0', 240 );
+    ctx->SubKeysReady = 0;
 }
 
 void AES_CMAC_SetKey( AES_CMAC_CTX* ctx, const uint8_t key[AES_CMAC_KEY_LENGTH] )
 {
     lorawan_aes_set_key( key, AES_CMAC_KEY_LENGTH, &ctx->rijndael );
+    ctx->SubKeysReady = 0;
+}
+
+static void AES_CMAC_GenSubKeys( AES_CMAC_CTX* ctx, uint8_t K1[16], uint8_t K2[16] )
+{
+    /* generate subkey K1 */
+    memset1( K1, '\0', 16 );
+
+    lorawan_aes_encrypt( K1, K1, &ctx->rijndael );
+
+    if( K1[0] & 0x80 )
+    {
+        LSHIFT( K1, K1 );
+        K1[15] ^= 0x87;
+    }
+    else
+        LSHIFT( K1, K1 );
+
+    /* generate subkey K2 */
+    if( K1[0] & 0x80 )
+    {
+        LSHIFT( K1, K2 );
+        K2[15] ^= 0x87;
+    }
+    else
+        LSHIFT( K1, K2 );
+}
+
+void AES_CMAC_PrepareSubKeys( AES_CMAC_CTX* ctx )
+{
+    AES_CMAC_GenSubKeys( ctx, ctx->K1, ctx->K2 );
+    ctx->SubKeysReady = 1;
+}
+
+void AES_CMAC_Restart( AES_CMAC_CTX* ctx )
+{
+    memset1( ctx->X, 0, sizeof ctx->X );
+    ctx->M_n = 0;
 }
 
 void AES_CMAC_Update( AES_CMAC_CTX* ctx, const uint8_t* data, uint32_t len )
@@ -107,47 +146,38 @@ void AES_CMAC_Update( AES_CMAC_CTX* ctx, const uint8_t* data, uint32_t len )
 
 void AES_CMAC_Final( uint8_t digest[AES_CMAC_DIGEST_LENGTH], AES_CMAC_CTX* ctx )
 {
-    uint8_t K[16];
+    uint8_t K1[16];
+    uint8_t K2[16];
     uint8_t in[16];
-    /* generate subkey K1 */
-    memset1( K, '\0', 16 );
-
-    lorawan_aes_encrypt( K, K, &ctx->rijndael );
 
-    if( K[0] & 0x80 )
+    if( ctx->SubKeysReady )
     {
-        LSHIFT( K, K );
-        K[15] ^= 0x87;
+        memcpy1( K1, ctx->K1, 16 );
+        memcpy1( K2, ctx->K2, 16 );
     }
     else
-        LSHIFT( K, K );
+    {
+        AES_CMAC_GenSubKeys( ctx, K1, K2 );
+    }
 
     if( ctx->M_n == 16 )
     {
         /* last block was a complete block */
-        XOR( K, ctx->M_last );
+        XOR( K1, ctx->M_last );
     }
     else
     {
-        /* generate subkey K2 */
-        if( K[0] & 0x80 )
-        {
-            LSHIFT( K, K );
-            K[15] ^= 0x87;
-        }
-        else
-            LSHIFT( K, K );
-
         /* padding(M_last) */
         ctx->M_last[ctx->M_n] = 0x80;
         while( ++ctx->M_n < 16 )
             ctx->M_last[ctx->M_n] = 0;
 
-        XOR( K, ctx->M_last );
+        XOR( K2, ctx->M_last );
     }
     XOR( ctx->M_last, ctx->X );
 
     memcpy1( in, &ctx->X[0], 16 );  // Otherwise it does not look good
     lorawan_aes_encrypt( in, digest, &ctx->rijndael );
-    memset1( K, 0, sizeof K );
+    memset1( K1, 0, sizeof K1 );
+    memset1( K2, 0, sizeof K2 );
 }
@@ -50,6 +50,9 @@ typedef struct _AES_CMAC_CTX {
             uint8_t        X[16];
             uint8_t        M_last[16];
             uint32_t       M_n;
+            uint8_t        K1[16];
+            uint8_t        K2[16];
+            uint8_t        SubKeysReady;
     } AES_CMAC_CTX;
    
 //#include <sys/cdefs.h>
@@ -57,6 +60,10 @@ typedef struct _AES_CMAC_CTX {
 //__BEGIN_DECLS
 void     AES_CMAC_Init(AES_CMAC_CTX * ctx);
 void     AES_CMAC_SetKey(AES_CMAC_CTX * ctx, const uint8_t key[AES_CMAC_KEY_LENGTH]);
+/* Precompute K1/K2 once per key, AES_CMAC_Final then skips the zero block encryption */
+void     AES_CMAC_PrepareSubKeys(AES_CMAC_CTX * ctx);
+/* Start a new message with the same key, key schedule and subkeys are kept */
+void     AES_CMAC_Restart(AES_CMAC_CTX * ctx);
 void     AES_CMAC_Update(AES_CMAC_CTX * ctx, const uint8_t * data, uint32_t len);
           //          __attribute__((__bounded__(__string__,2,3)));
 void     AES_CMAC_Final(uint8_t digest[AES_CMAC_DIGEST_LENGTH], AES_CMAC_CTX  * ctx);
@@ -62,6 +62,16 @@
 #ifndef KEY_EXTRACTABLE
 #define KEY_EXTRACTABLE 0
 #endif /* KEY_EXTRACTABLE */
+
+/*!
+ * Number of expanded AES key schedules (with CMAC subkeys) kept in RAM.
+ * The session keys are used for every frame, so the key expansion is done once per key.
+ * 0 - disables the cache
+ * \remark Can be overloaded in lorawan_conf.h
+ */
+#ifndef SOFT_SE_KEY_CACHE_SLOTS
+#define SOFT_SE_KEY_CACHE_SLOTS 3
+#endif /* SOFT_SE_KEY_CACHE_SLOTS */
 /*!
  * MIC computation offset
  * \remark required for 1.1.x support
@@ -131,12 +141,37 @@ typedef struct SecureElementKeyLabel
     char *keyStr;
 } SecureElementKeyLabel_t;
 
+#if ((LORAWAN_KMS == 0) && (SOFT_SE_KEY_CACHE_SLOTS > 0))
+/*!
+ * Expanded key schedule and CMAC subkeys of one key
+ */
+typedef struct SecureElementKeyCache
+{
+    KeyIdentifier_t KeyID;
+    uint8_t KeyValue[SE_KEY_SIZE];  /* copy of the key, the NVM restore can change keys without SecureElementSetKey */
+    uint8_t IsValid;
+    AES_CMAC_CTX CmacCtx;
+} SecureElementKeyCache_t;
+#endif /* LORAWAN_KMS == 0 && SOFT_SE_KEY_CACHE_SLOTS > 0 */
+
 /* Private variables ---------------------------------------------------------*/
 /*!
  * Secure element context
  */
 static SecureElementNvmData_t *SeNvm;
 
+#if ((LORAWAN_KMS == 0) && (SOFT_SE_KEY_CACHE_SLOTS > 0))
+/*!
+ * Cache of expanded keys
+ */
+static SecureElementKeyCache_t KeyCache[SOFT_SE_KEY_CACHE_SLOTS];
+
+/*!
+ * Next slot to be replaced (round robin)
+ */
+static uint8_t KeyCacheNext = 0;
+#endif /* LORAWAN_KMS == 0 && SOFT_SE_KEY_CACHE_SLOTS > 0 */
+
 #if ((LORAWAN_KMS == 1) || (KEY_EXTRACTABLE == 1))
 static const SecureElementKeyLabel_t KeyLabel[NUM_OF_KEYS] =
 {
@@ -261,6 +296,23 @@ static uint8_t tag[SE_KEY_SIZE] ALIGN( 4 ) = {0};
  * \retval                    - Status of the operation
  */
 static SecureElementStatus_t GetKeyByID( KeyIdentifier_t keyID, Key_t **keyItem );
+
+/*
+ * Gets the CMAC context (expanded key schedule and subkeys) of the key item.
+ * The context is restarted and ready for AES_CMAC_Update.
+ *
+ * \param [in] keyItem        - Key item
+ * \param [in] localCtx       - Context used when the cache is disabled
+ * \retval                    - CMAC context of the key
+ */
+static AES_CMAC_CTX *GetKeyCmacCtx( Key_t *keyItem, AES_CMAC_CTX *localCtx );
+
+/*
+ * Drops the cached key schedule of the key
+ *
+ * \param [in] keyID          - Key identifier, NO_KEY drops all keys
+ */
+static void InvalidateKeyCache( KeyIdentifier_t keyID );
 #else /* LORAWAN_KMS == 1 */
 /*
  * Gets key index from key list in KMS table
@@ -378,6 +430,53 @@ static SecureElementStatus_t GetKeyByID( KeyIdentifier_t keyID, Key_t **keyItem
     return SECURE_ELEMENT_ERROR_INVALID_KEY_ID;
 }
 
+static AES_CMAC_CTX *GetKeyCmacCtx( Key_t *keyItem, AES_CMAC_CTX *localCtx )
+{
+#if (SOFT_SE_KEY_CACHE_SLOTS > 0)
+    SecureElementKeyCache_t *slot;
+
+    for( uint8_t i = 0; i < SOFT_SE_KEY_CACHE_SLOTS; i++ )
+    {
+        slot = &KeyCache[i];
+        if( ( slot->IsValid != 0 ) && ( slot->KeyID == keyItem->KeyID ) &&
+            ( memcmp( slot->KeyValue, keyItem->KeyValue, SE_KEY_SIZE ) == 0 ) )
+        {
+            AES_CMAC_Restart( &slot->CmacCtx );
+            return &slot->CmacCtx;
+        }
+    }
+
+    /* Not cached yet, expand the key into the next slot */
+    slot = &KeyCache[KeyCacheNext];
+    KeyCacheNext = ( KeyCacheNext + 1 ) % SOFT_SE_KEY_CACHE_SLOTS;
+
+    AES_CMAC_Init( &slot->CmacCtx );
+    AES_CMAC_SetKey( &slot->CmacCtx, keyItem->KeyValue );
+    AES_CMAC_PrepareSubKeys( &slot->CmacCtx );
+    memcpy1( slot->KeyValue, keyItem->KeyValue, SE_KEY_SIZE );
+    slot->KeyID = keyItem->KeyID;
+    slot->IsValid = 1;
+    return &slot->CmacCtx;
+#else /* SOFT_SE_KEY_CACHE_SLOTS == 0 */
+    AES_CMAC_Init( localCtx );
+    AES_CMAC_SetKey( localCtx, keyItem->KeyValue );
+    return localCtx;
+#endif /* SOFT_SE_KEY_CACHE_SLOTS */
+}
+
+static void InvalidateKeyCache( KeyIdentifier_t keyID )
+{
+#if (SOFT_SE_KEY_CACHE_SLOTS > 0)
+    for( uint8_t i = 0; i < SOFT_SE_KEY_CACHE_SLOTS; i++ )
+    {
+        if( ( keyID == NO_KEY ) || ( KeyCache[i].KeyID == keyID ) )
+        {
+            memset1( ( uint8_t * )&KeyCache[i], 0, sizeof( KeyCache[i] ) );
+        }
+    }
+#endif /* SOFT_SE_KEY_CACHE_SLOTS */
+}
+
 #else /* LORAWAN_KMS == 1 */
 static SecureElementStatus_t GetKeyIndexByID( KeyIdentifier_t keyID, CK_OBJECT_HANDLE *keyIndex )
 {
@@ -426,16 +525,19 @@ static SecureElementStatus_t ComputeCmac( uint8_t *micBxBuffer, uint8_t *buffer,
 
 #if (LORAWAN_KMS == 0)
     uint8_t Cmac[16];
-    AES_CMAC_CTX aesCmacCtx[1];
-
-    AES_CMAC_Init( aesCmacCtx );
+#if (SOFT_SE_KEY_CACHE_SLOTS > 0)
+    AES_CMAC_CTX *localCtx = NULL;
+#else /* SOFT_SE_KEY_CACHE_SLOTS == 0 */
+    AES_CMAC_CTX localCtx[1];
+#endif /* SOFT_SE_KEY_CACHE_SLOTS */
+    AES_CMAC_CTX *aesCmacCtx;
 
     Key_t                *keyItem;
     SecureElementStatus_t retval = GetKeyByID( keyID, &keyItem );
 
     if( retval == SECURE_ELEMENT_SUCCESS )
     {
-        AES_CMAC_SetKey( aesCmacCtx, keyItem->KeyValue );
+        aesCmacCtx = GetKeyCmacCtx( keyItem, localCtx );
 
         if( micBxBuffer != NULL )
         {
@@ -587,6 +689,7 @@ SecureElementStatus_t SecureElementInit( SecureElementNvmData_t *nvm )
 #if (LORAWAN_KMS == 0)
     /* Initialize data */
     memcpy1( ( uint8_t * )SeNvm, ( uint8_t * )&seNvmInit, sizeof( seNvmInit ) );
+    InvalidateKeyCache( NO_KEY );
 #else /* LORAWAN_KMS == 1 */
     SeNvm->reserved = 0;
     CK_RV rv;
@@ -871,6 +974,8 @@ SecureElementStatus_t SecureElementSetKey( KeyIdentifier_t keyID, uint8_t *key )
     }
 
 #if (LORAWAN_KMS == 0)
+    InvalidateKeyCache( keyID );
+
     for( uint8_t i = 0; i < NUM_OF_KEYS; i++ )
     {
         if( SeNvm->KeyList[i].KeyID == keyID )
@@ -1161,21 +1266,25 @@ SecureElementStatus_t SecureElementAesEncrypt( uint8_t *buffer, uint32_t size, K
     }
 
 #if (LORAWAN_KMS == 0)
-    lorawan_aes_context aesContext;
-    memset1( aesContext.ksch, '\0', 240 );
+#if (SOFT_SE_KEY_CACHE_SLOTS > 0)
+    AES_CMAC_CTX *localCtx = NULL;
+#else /* SOFT_SE_KEY_CACHE_SLOTS == 0 */
+    AES_CMAC_CTX localCtx[1];
+#endif /* SOFT_SE_KEY_CACHE_SLOTS */
 
     Key_t                *pItem;
     SecureElementStatus_t retval = GetKeyByID( keyID, &pItem );
 
     if( retval == SECURE_ELEMENT_SUCCESS )
     {
-        lorawan_aes_set_key( pItem->KeyValue, SE_KEY_SIZE, &aesContext );
+        /* the CMAC context holds the expanded key schedule */
+        lorawan_aes_context *aesContext = &GetKeyCmacCtx( pItem, localCtx )->rijndael;
 
         uint8_t block = 0;
 
         while( size != 0 )
         {
-            lorawan_aes_encrypt( &buffer[block], &encBuffer[block], &aesContext );
+            lorawan_aes_encrypt( &buffer[block], &encBuffer[block], aesContext );
             block = block + 16;
             size  = size - 16;
         }
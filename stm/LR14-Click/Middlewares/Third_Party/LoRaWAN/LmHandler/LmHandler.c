@@ -595,6 +595,35 @@ TimerTime_t LmHandlerGetDutyCycleWaitTime( void )
     return DutyCycleWaitTime;
 }
 
+LmHandlerErrorStatus_t LmHandlerGetNextTxDelay( uint8_t size, TimerTime_t *nextTxDelay )
+{
+    if( nextTxDelay == NULL )
+    {
+        return LORAMAC_HANDLER_ERROR;
+    }
+
+    if( LoRaMacQueryNextTxDelay( size, nextTxDelay ) != LORAMAC_STATUS_OK )
+    {
+        return LORAMAC_HANDLER_ERROR;
+    }
+    return LORAMAC_HANDLER_SUCCESS;
+}
+
+LmHandlerErrorStatus_t LmHandlerGetMaxPayload( uint8_t *maxPayload )
+{
+    LoRaMacTxInfo_t txInfo;
+
+    if( maxPayload == NULL )
+    {
+        return LORAMAC_HANDLER_ERROR;
+    }
+
+    /* size 0 only queries, the status reports a length error of the given size */
+    LoRaMacQueryTxPossible( 0, &txInfo );
+    *maxPayload = txInfo.MaxPossibleApplicationDataSize;
+    return LORAMAC_HANDLER_SUCCESS;
+}
+
 void LmHandlerJoin( ActivationType_t mode, bool forceRejoin )
 {
     MlmeReq_t mlmeReq;
@@ -675,6 +704,26 @@ void LmHandlerJoin( ActivationType_t mode, bool forceRejoin )
 #endif /* LORAMAC_VERSION */
 }
 
+LmHandlerErrorStatus_t LmHandlerJoinRetry( int8_t datarate )
+{
+    MlmeReq_t mlmeReq;
+    LoRaMacStatus_t status;
+
+    mlmeReq.Type = MLME_JOIN;
+    mlmeReq.Req.Join.NetworkActivation = ACTIVATION_TYPE_OTAA;
+    mlmeReq.Req.Join.Datarate = datarate;
+    mlmeReq.Req.Join.TxPower = LmHandlerParams.TxPower;
+    mlmeReq.ReqReturn.DutyCycleWaitTime = 0;
+
+    JoinParams.Mode = ACTIVATION_TYPE_OTAA;
+    JoinParams.forceRejoin = true;
+
+    status = LoRaMacMlmeRequest( &mlmeReq );
+    DutyCycleWaitTime = mlmeReq.ReqReturn.DutyCycleWaitTime;
+
+    return ( status == LORAMAC_STATUS_OK ) ? LORAMAC_HANDLER_SUCCESS : LORAMAC_HANDLER_ERROR;
+}
+
 LmHandlerFlagStatus_t LmHandlerJoinStatus( void )
 {
     MibRequestConfirm_t mibReq;
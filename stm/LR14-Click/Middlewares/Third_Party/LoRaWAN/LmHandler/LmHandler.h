@@ -358,6 +358,28 @@ LmHandlerErrorStatus_t LmHandlerSend( LmHandlerAppData_t *appData, LmHandlerMsgT
  */
 TimerTime_t LmHandlerGetDutyCycleWaitTime( void );
 
+/*!
+ * Gets the time until the duty cycle allows the next uplink
+ *
+ * \param [in]  size        Application data size of the next uplink
+ * \param [out] nextTxDelay Time to wait in ms, 0 - uplink is possible now
+ *
+ * \retval -1 LORAMAC_HANDLER_ERROR
+ *          0 LORAMAC_HANDLER_SUCCESS
+ */
+LmHandlerErrorStatus_t LmHandlerGetNextTxDelay( uint8_t size, TimerTime_t *nextTxDelay );
+
+/*!
+ * Gets the maximum application payload at the current datarate,
+ * pending MAC commands are taken into account
+ *
+ * \param [out] maxPayload Maximum application data size
+ *
+ * \retval -1 LORAMAC_HANDLER_ERROR
+ *          0 LORAMAC_HANDLER_SUCCESS
+ */
+LmHandlerErrorStatus_t LmHandlerGetMaxPayload( uint8_t *maxPayload );
+
 /*!
  * Join a LoRa Network in classA
  *
@@ -366,6 +388,16 @@ TimerTime_t LmHandlerGetDutyCycleWaitTime( void );
  */
 void LmHandlerJoin( ActivationType_t mode, bool forceRejoin );
 
+/*!
+ * Retries the OTAA join at the given datarate (the join procedure was started by LmHandlerJoin)
+ *
+ * \param [in] datarate Datarate of the join request
+ *
+ * \retval -1 LORAMAC_HANDLER_ERROR (busy or duty cycle restricted, see LmHandlerGetDutyCycleWaitTime)
+ *          0 LORAMAC_HANDLER_SUCCESS
+ */
+LmHandlerErrorStatus_t LmHandlerJoinRetry( int8_t datarate );
+
 /*!
  * Check whether the Device is joined to the network
  *
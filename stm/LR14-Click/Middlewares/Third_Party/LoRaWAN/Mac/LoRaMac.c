@@ -4888,6 +4888,74 @@ LoRaMacStatus_t LoRaMacQueryTxPossible( uint8_t size, LoRaMacTxInfo_t* txInfo )
     }
 }
 
+LoRaMacStatus_t LoRaMacQueryNextTxDelay( uint8_t size, TimerTime_t* nextTxDelay )
+{
+    LoRaMacStatus_t status;
+    NextChanParams_t nextChan;
+    uint8_t channel = 0;
+    TimerTime_t aggregatedTimeOff = Nvm.MacGroup1.AggregatedTimeOff;
+    RegionNvmDataGroup1_t regionGroup1Backup;
+    uint16_t channelsMaskBackup[REGION_NVM_CHANNELS_MASK_SIZE];
+#if (defined( LORAMAC_VERSION ) && (( LORAMAC_VERSION == 0x01000400 ) || ( LORAMAC_VERSION == 0x01010100 )))
+    Band_t bandsBackup[REGION_NVM_MAX_NB_BANDS];
+#endif /* LORAMAC_VERSION */
+
+    if( nextTxDelay == NULL )
+    {
+        return LORAMAC_STATUS_PARAMETER_INVALID;
+    }
+    *nextTxDelay = 0;
+
+    if( ( MacCtx.MacState & LORAMAC_TX_DELAYED ) == LORAMAC_TX_DELAYED )
+    {
+        // A frame is already waiting for the duty cycle
+        *nextTxDelay = MacCtx.DutyCycleWaitTime;
+        return LORAMAC_STATUS_OK;
+    }
+
+    // Same parameters as ScheduleTx, the selection runs on a snapshot of the
+    // band and channel states, which is restored afterwards
+    nextChan.AggrTimeOff = Nvm.MacGroup1.AggregatedTimeOff;
+    nextChan.Datarate = Nvm.MacGroup1.ChannelsDatarate;
+    nextChan.DutyCycleEnabled = Nvm.MacGroup2.DutyCycleOn;
+    nextChan.ElapsedTimeSinceTxBackoffRefTime = SysTimeSub( SysTimeGetMcuTime( ), MacCtx.TxBackoffRefTime );
+    nextChan.LastAggrTx = Nvm.MacGroup1.LastTxDoneTime;
+    nextChan.LastTxIsJoinRequest = false;
+    nextChan.Joined = true;
+    nextChan.PktLen = LORAMAC_FRAME_PAYLOAD_OVERHEAD_SIZE + size;
+
+    if( Nvm.MacGroup2.NetworkActivation == ACTIVATION_TYPE_NONE )
+    {
+        nextChan.LastTxIsJoinRequest = true;
+        nextChan.Joined = false;
+        nextChan.PktLen = LORAMAC_JOIN_REQ_MSG_SIZE;
+    }
+
+    memcpy1( ( uint8_t* )&regionGroup1Backup, ( uint8_t* )&Nvm.RegionGroup1, sizeof( regionGroup1Backup ) );
+    memcpy1( ( uint8_t* )channelsMaskBackup, ( uint8_t* )Nvm.RegionGroup2.ChannelsMask, sizeof( channelsMaskBackup ) );
+#if (defined( LORAMAC_VERSION ) && (( LORAMAC_VERSION == 0x01000400 ) || ( LORAMAC_VERSION == 0x01010100 )))
+    memcpy1( ( uint8_t* )bandsBackup, ( uint8_t* )RegionBands, sizeof( bandsBackup ) );
+#endif /* LORAMAC_VERSION */
+
+    status = RegionNextChannel( Nvm.MacGroup2.Region, &nextChan, &channel, nextTxDelay, &aggregatedTimeOff );
+
+    memcpy1( ( uint8_t* )&Nvm.RegionGroup1, ( uint8_t* )&regionGroup1Backup, sizeof( regionGroup1Backup ) );
+    memcpy1( ( uint8_t* )Nvm.RegionGroup2.ChannelsMask, ( uint8_t* )channelsMaskBackup, sizeof( channelsMaskBackup ) );
+#if (defined( LORAMAC_VERSION ) && (( LORAMAC_VERSION == 0x01000400 ) || ( LORAMAC_VERSION == 0x01010100 )))
+    memcpy1( ( uint8_t* )RegionBands, ( uint8_t* )bandsBackup, sizeof( bandsBackup ) );
+#endif /* LORAMAC_VERSION */
+
+    if( status == LORAMAC_STATUS_DUTYCYCLE_RESTRICTED )
+    {
+        return LORAMAC_STATUS_OK;
+    }
+    if( status == LORAMAC_STATUS_OK )
+    {
+        *nextTxDelay = 0;
+    }
+    return status;
+}
+
 LoRaMacStatus_t LoRaMacMibGetRequestConfirm( MibRequestConfirm_t* mibGet )
 {
     LoRaMacStatus_t status = LORAMAC_STATUS_OK;
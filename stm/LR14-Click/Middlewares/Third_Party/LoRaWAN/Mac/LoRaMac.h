@@ -247,6 +247,22 @@ void LoRaMacProcess( void );
  */
 LoRaMacStatus_t LoRaMacQueryTxPossible( uint8_t size, LoRaMacTxInfo_t* txInfo );
 
+/*!
+ * \brief   Queries the time to wait until the duty cycle allows the next uplink
+ *
+ * \details The channel selection of the next uplink is evaluated on a copy of the
+ *          band and channel states, the MAC context is not changed.
+ *
+ * \param   [in] size - Size of the application data to be sent next.
+ *
+ * \param   [out] nextTxDelay - Time in ms to wait before the next uplink is allowed,
+ *                              0 if the uplink is possible now.
+ *
+ * \retval  LoRaMacStatus_t Status of the operation. \ref LORAMAC_STATUS_NO_CHANNEL_FOUND
+ *          when no channel supports the current datarate.
+ */
+LoRaMacStatus_t LoRaMacQueryNextTxDelay( uint8_t size, TimerTime_t* nextTxDelay );
+
 /*!
  * \brief   LoRaMAC channel add service
  *
@@ -101,6 +101,17 @@ typedef struct
   #define UTIL_SEQ_CONF_PRIO_NBR  (2)
 #endif
 
+/**
+ * @brief hooks around the execution of the task (event trace), can be redefined in utilities_conf.h
+ */
+#ifndef UTIL_SEQ_TASK_BEGIN
+  #define UTIL_SEQ_TASK_BEGIN( id )
+#endif
+
+#ifndef UTIL_SEQ_TASK_END
+  #define UTIL_SEQ_TASK_END( id )
+#endif
+
 /**
  * @brief default memset function.
  */
@@ -287,7 +298,9 @@ void UTIL_SEQ_Run( UTIL_SEQ_bm_t Mask_bm )
     UTIL_SEQ_EXIT_CRITICAL_SECTION( );
 
     /* Execute the task */
+    UTIL_SEQ_TASK_BEGIN( CurrentTaskIdx );
     TaskCb[CurrentTaskIdx]( );
+    UTIL_SEQ_TASK_END( CurrentTaskIdx );
 
     local_taskset = TaskSet;
     local_evtset = EvtSet;
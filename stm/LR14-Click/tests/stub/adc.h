@@ -0,0 +1,19 @@
+/*
+ * adc.h
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * host stub of adc.h, the peripheral is stub/periph.c
+ */
+
+#ifndef STUB_ADC_H_
+#define STUB_ADC_H_
+
+#include "main.h"
+
+extern ADC_HandleTypeDef hadc;
+
+void MX_ADC_Init(void);
+
+#endif /* STUB_ADC_H_ */
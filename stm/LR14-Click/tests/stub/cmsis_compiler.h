@@ -0,0 +1,17 @@
+/*
+ * cmsis_compiler.h
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * host stub of CMSIS compiler macros (utilities_conf.h, stm32_timer.h)
+ */
+
+#ifndef STUB_CMSIS_COMPILER_H_
+#define STUB_CMSIS_COMPILER_H_
+
+#define __STATIC_INLINE		static inline
+#define __WEAK				__attribute__((weak))
+#define __ALIGNED(x)		__attribute__((aligned(x)))
+
+#endif /* STUB_CMSIS_COMPILER_H_ */
@@ -0,0 +1,253 @@
+/*
+ * i2c.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * host stub of the I2C bus: the transfer takes 9 SCL per byte (address, register and data), NACK of the absent
+ * device ends the transfer after the address (also the EEPROM during the programming), the time is accumulated
+ * in us and carried to stub_Tick
+ * - the lines of I2C2 as GPIO (PA11 SDA, PA12 SCL): the slave holding SDA low is released by SCL pulses,
+ *   the peripheral reports the busy bus while SDA is held
+ */
+
+#include <string.h>
+#include "i2c_stub.h"
+
+stubI2CDev_t stub_I2CDev[STUB_I2C_DEV_MAX];
+I2C_TypeDef stub_I2C2 = { };
+GPIO_TypeDef stub_GPIOA = { };
+uint32_t stub_Pclk1Hz = 48000000;
+uint32_t stub_I2CTransfers = 0;
+stubI2CBus_t stub_I2CBus = { };
+
+static uint32_t _us = 0;	// part of ms of the bus time
+
+void HAL_Delay(uint32_t Delay)
+{
+	stub_Tick += Delay + 1;	// HAL waits one more tick (uwTickFreq)
+}
+
+static void busTime(I2C_HandleTypeDef *hi2c, uint32_t bytes)
+{
+	uint32_t hz = (hi2c->Speed != 0) ? hi2c->Speed : I2C_SPEED_DEFAULT;
+
+	_us += (bytes * 9 + 2) * 1000000U / hz;	// + start and stop
+	stub_Tick += _us / 1000;
+	_us %= 1000;
+	stub_I2CTransfers++;
+}
+
+static stubI2CDev_t* findDev(uint16_t address)
+{
+	for (int i = 0; i < STUB_I2C_DEV_MAX; i++)
+		if (stub_I2CDev[i].Address == address)
+			return &stub_I2CDev[i];
+	return NULL;
+}
+
+/*
+ * @brief the address phase, ACK of the present device
+ */
+static stubI2CDev_t* addressDev(I2C_HandleTypeDef *hi2c, uint16_t address)
+{
+	stubI2CDev_t *dev = findDev(address);
+
+	if (dev == NULL || !dev->Present || (int32_t) (stub_Tick - dev->BusyUntil) < 0)
+	{
+		busTime(hi2c, 1);
+		return NULL;
+	}
+	return dev;
+}
+
+stubI2CDev_t* stub_I2CAdd(uint16_t address, uint8_t present)
+{
+	stubI2CDev_t *dev = findDev(address);
+
+	if (dev == NULL)
+		dev = findDev(0);
+	if (dev != NULL)
+	{
+		dev->Address = address;
+		dev->Present = present;
+	}
+	return dev;
+}
+
+uint64_t stub_I2CTimeUs(void)
+{
+	return (uint64_t) stub_Tick * 1000 + _us;
+}
+
+void stub_I2CReset(void)
+{
+	memset(stub_I2CDev, 0, sizeof(stub_I2CDev));
+	memset(&stub_I2CBus, 0, sizeof(stub_I2CBus));
+	stub_I2CTransfers = 0;
+	_us = 0;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+	if (addressDev(hi2c, DevAddress) == NULL)
+		return HAL_ERROR;
+	busTime(hi2c, 1 + Size);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+	stubI2CDev_t *dev = addressDev(hi2c, DevAddress);
+
+	if (dev == NULL)
+		return HAL_ERROR;
+	for (uint16_t i = 0; i < Size; i++)
+		pData[i] = (dev->RxPattern != NULL) ? dev->RxPattern[i % dev->RxPatternLen] : 0;
+	busTime(hi2c, 1 + Size);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData,
+	uint16_t Size, uint32_t Timeout)
+{
+	stubI2CDev_t *dev = addressDev(hi2c, DevAddress);
+	uint32_t blocks = 1;
+
+	if (dev == NULL)
+		return HAL_ERROR;
+	for (uint16_t i = 0; i < Size; i++)
+		if (MemAddress + i < STUB_I2C_MEM_SIZE)
+			dev->Mem[MemAddress + i] = pData[i];
+	busTime(hi2c, 1 + MemAddSize + Size);
+	if (dev->BlockSize != 0)
+	{
+		blocks = (MemAddress + Size + dev->BlockSize - 1) / dev->BlockSize - MemAddress / dev->BlockSize;
+		for (uint32_t b = 0; dev->Wear != NULL && b < blocks; b++)
+			dev->Wear[MemAddress / dev->BlockSize + b]++;
+	}
+	dev->BusyUntil = stub_Tick + dev->WriteMs * blocks;
+	if (dev->OnAccess != NULL)
+		dev->OnAccess(dev, MemAddress, Size, 1);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData,
+	uint16_t Size, uint32_t Timeout)
+{
+	stubI2CDev_t *dev = addressDev(hi2c, DevAddress);
+
+	if (dev == NULL)
+		return HAL_ERROR;
+	for (uint16_t i = 0; i < Size; i++)
+		pData[i] = (MemAddress + i < STUB_I2C_MEM_SIZE) ? dev->Mem[MemAddress + i] : 0;
+	busTime(hi2c, 1 + MemAddSize + 2 + Size);	// write of the register address, repeated start
+	if (dev->OnAccess != NULL)
+		dev->OnAccess(dev, MemAddress, Size, 0);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_IsDeviceReady(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint32_t Trials, uint32_t Timeout)
+{
+	if (stub_I2CBus.SdaHeld != 0)
+		return HAL_BUSY;	// BUSY flag, no START
+	for (uint32_t i = 0; i < Trials; i++)
+	{
+		if (addressDev(hi2c, DevAddress) != NULL)
+		{
+			busTime(hi2c, 1);
+			return HAL_OK;
+		}
+	}
+	return HAL_ERROR;
+}
+
+__weak void HAL_I2C_MspInit(I2C_HandleTypeDef *hi2c)
+{
+}
+
+__weak void HAL_I2C_MspDeInit(I2C_HandleTypeDef *hi2c)
+{
+}
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef *hi2c)
+{
+	if (hi2c == NULL || hi2c->Instance == NULL)
+		return HAL_ERROR;
+	if (hi2c->State == HAL_I2C_STATE_RESET)
+		HAL_I2C_MspInit(hi2c);
+	hi2c->Instance->CR1 = 0;
+	hi2c->Instance->TIMINGR = hi2c->Init.Timing;
+	hi2c->Instance->CR1 = I2C_CR1_PE;
+	hi2c->State = HAL_I2C_STATE_READY;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef *hi2c)
+{
+	if (hi2c == NULL || hi2c->Instance == NULL)
+		return HAL_ERROR;
+	hi2c->Instance->CR1 = 0;
+	HAL_I2C_MspDeInit(hi2c);
+	hi2c->State = HAL_I2C_STATE_RESET;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2CEx_ConfigAnalogFilter(I2C_HandleTypeDef *hi2c, uint32_t AnalogFilter)
+{
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2CEx_ConfigDigitalFilter(I2C_HandleTypeDef *hi2c, uint32_t DigitalFilter)
+{
+	return HAL_OK;
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init)
+{
+}
+
+void HAL_GPIO_DeInit(GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin)
+{
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+	uint32_t old = GPIOx->ODR;
+
+	if (PinState == GPIO_PIN_SET)
+		GPIOx->ODR |= GPIO_Pin;
+	else
+		GPIOx->ODR &= ~(uint32_t) GPIO_Pin;
+	if (GPIOx != GPIOA || !(GPIO_Pin & (GPIO_PIN_11 | GPIO_PIN_12)))
+		return;
+	stub_I2CBus.PinWrites++;
+	// the rising edge of SCL, the slave shifts out the next bit
+	if (!(old & GPIO_PIN_12) && (GPIOx->ODR & GPIO_PIN_12))
+	{
+		stub_I2CBus.SclPulses++;
+		if (stub_I2CBus.SdaHeld != 0 && stub_I2CBus.SdaHeld != STUB_I2C_SDA_STUCK)
+			stub_I2CBus.SdaHeld--;
+	}
+	// the rising edge of SDA (not held by the slave) while SCL is high
+	else if ((old & GPIO_PIN_12) && (GPIOx->ODR & GPIO_PIN_12) && !(old & GPIO_PIN_11) && (GPIOx->ODR & GPIO_PIN_11)
+		&& stub_I2CBus.SdaHeld == 0)
+		stub_I2CBus.Stops++;
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+	if (GPIOx == GPIOA && GPIO_Pin == GPIO_PIN_11 && stub_I2CBus.SdaHeld != 0)
+		return GPIO_PIN_RESET;	// open drain, held by the slave
+	return (GPIOx->ODR & GPIO_Pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef *PeriphClkInit)
+{
+	return HAL_OK;
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void)
+{
+	return stub_Pclk1Hz;
+}
@@ -0,0 +1,69 @@
+/*
+ * i2c_stub.h
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * host model of the I2C bus (stub/i2c.c) for the sensor drivers and for i2c.c, the devices are set by the test
+ */
+
+#ifndef STUB_I2C_STUB_H_
+#define STUB_I2C_STUB_H_
+
+#include "i2c.h"
+
+#define STUB_I2C_DEV_MAX	8
+#define STUB_I2C_MEM_SIZE	0x2200	// registers of the device (ST25DV dynamic registers are the highest)
+
+typedef struct stubI2CDev stubI2CDev_t;
+
+/*
+ * stubI2CDev_t - the device on the bus: the registers (Mem_Read/Write), the data of Master_Receive
+ */
+struct stubI2CDev
+{
+	uint16_t Address;	// 8-bit address of HAL, 0 - free slot
+	uint8_t Present;
+	uint8_t Mem[STUB_I2C_MEM_SIZE];
+	const uint8_t *RxPattern;	// data of Master_Receive (repeated), NULL - zeros
+	uint8_t RxPatternLen;
+	uint8_t WriteMs;	// EEPROM programming after Mem_Write, the device does not acknowledge (0 - registers)
+	uint8_t BlockSize;	// WriteMs per touched block of the size (0 - per write)
+	uint32_t *Wear;		// programming count per block (BlockSize), NULL - not counted
+	uint32_t BusyUntil;
+	void (*OnAccess)(stubI2CDev_t *dev, uint16_t memAddress, uint16_t size, uint8_t write);	// model of the device after Mem_Read/Write, NULL - registers only
+};
+
+#define STUB_I2C_SDA_STUCK	0xFFFF	// SDA is never released
+
+/*
+ * stubI2CBus_t - the lines of I2C2 driven as GPIO (the bus recovery)
+ */
+typedef struct
+{
+	uint16_t SdaHeld;		// SCL pulses until the slave releases SDA, 0 - released, STUB_I2C_SDA_STUCK - never
+	uint32_t SclPulses;		// rising edges of SCL
+	uint32_t PinWrites;		// writes of SDA and SCL
+	uint32_t Stops;			// rising edges of SDA while SCL is high
+} stubI2CBus_t;
+
+extern stubI2CDev_t stub_I2CDev[STUB_I2C_DEV_MAX];
+extern uint32_t stub_I2CTransfers;	// count of transfers (address phases)
+extern stubI2CBus_t stub_I2CBus;
+
+/*
+ * @brief the device is added to the bus (or its slot is returned)
+ */
+stubI2CDev_t* stub_I2CAdd(uint16_t address, uint8_t present);
+
+/*
+ * @brief the bus is empty and released, the counters are cleared
+ */
+void stub_I2CReset(void);
+
+/*
+ * @brief time of the bus and the delays (us)
+ */
+uint64_t stub_I2CTimeUs(void);
+
+#endif /* STUB_I2C_STUB_H_ */
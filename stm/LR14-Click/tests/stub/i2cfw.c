@@ -0,0 +1,29 @@
+/*
+ * i2cfw.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * host stub of i2c.c for the tests of the other modules (the tests of i2c.c link the firmware file instead,
+ * this object is then not taken from the library)
+ * - MX_I2C2_Init/DeInit are counted as the power domain of I2C2 (stub_Periph)
+ */
+
+#include "i2c_stub.h"
+
+I2C_HandleTypeDef hi2c2 = { };
+
+void MX_I2C2_Init(void)
+{
+	stub_Periph.Init[0]++;
+}
+
+void MX_I2C2_DeInit(void)
+{
+	stub_Periph.DeInit[0]++;
+}
+
+HAL_StatusTypeDef I2C_IsDeviceReadyMT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint32_t Trials, uint32_t Timeout)
+{
+	return HAL_I2C_IsDeviceReady(hi2c, DevAddress, Trials, Timeout);
+}
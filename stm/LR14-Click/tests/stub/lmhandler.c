@@ -0,0 +1,56 @@
+/*
+ * lmhandler.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ */
+
+#include "lmhandler_stub.h"
+
+LoRaMacRegion_t stub_Region = LORAMAC_REGION_EU868;
+int8_t stub_Datarate = DR_0;
+uint8_t stub_MaxPayload = 51;
+TimerTime_t stub_NextTxDelay = 0;
+LmHandlerErrorStatus_t stub_NextTxStatus = LORAMAC_HANDLER_SUCCESS;
+TimerTime_t stub_DutyCycleWait = 0;
+LmHandlerFlagStatus_t stub_JoinStatus = LORAMAC_HANDLER_RESET;
+LmHandlerErrorStatus_t (*stub_OnJoinRetry)(int8_t datarate) = NULL;
+
+LmHandlerErrorStatus_t LmHandlerGetActiveRegion(LoRaMacRegion_t *region)
+{
+	*region = stub_Region;
+	return LORAMAC_HANDLER_SUCCESS;
+}
+
+LmHandlerErrorStatus_t LmHandlerGetTxDatarate(int8_t *txDatarate)
+{
+	*txDatarate = stub_Datarate;
+	return LORAMAC_HANDLER_SUCCESS;
+}
+
+LmHandlerErrorStatus_t LmHandlerGetMaxPayload(uint8_t *maxPayload)
+{
+	*maxPayload = stub_MaxPayload;
+	return LORAMAC_HANDLER_SUCCESS;
+}
+
+LmHandlerErrorStatus_t LmHandlerGetNextTxDelay(uint8_t size, TimerTime_t *nextTxDelay)
+{
+	*nextTxDelay = stub_NextTxDelay;
+	return stub_NextTxStatus;
+}
+
+TimerTime_t LmHandlerGetDutyCycleWaitTime(void)
+{
+	return stub_DutyCycleWait;
+}
+
+LmHandlerFlagStatus_t LmHandlerJoinStatus(void)
+{
+	return stub_JoinStatus;
+}
+
+LmHandlerErrorStatus_t LmHandlerJoinRetry(int8_t datarate)
+{
+	return (stub_OnJoinRetry != NULL) ? stub_OnJoinRetry(datarate) : LORAMAC_HANDLER_SUCCESS;
+}
@@ -0,0 +1,25 @@
+/*
+ * lmhandler_stub.h
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * host stub of the LmHandler getters used by lora_planner.c, the values are set by the test
+ * and of the join retry of lora_join.c
+ */
+
+#ifndef STUB_LMHANDLER_STUB_H_
+#define STUB_LMHANDLER_STUB_H_
+
+#include "LmHandler.h"
+
+extern LoRaMacRegion_t stub_Region;
+extern int8_t stub_Datarate;
+extern uint8_t stub_MaxPayload;
+extern TimerTime_t stub_NextTxDelay;
+extern LmHandlerErrorStatus_t stub_NextTxStatus;
+extern TimerTime_t stub_DutyCycleWait;
+extern LmHandlerFlagStatus_t stub_JoinStatus;
+extern LmHandlerErrorStatus_t (*stub_OnJoinRetry)(int8_t datarate);	// NULL - the request is sent
+
+#endif /* STUB_LMHANDLER_STUB_H_ */
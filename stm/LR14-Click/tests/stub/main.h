@@ -0,0 +1,18 @@
+/*
+ * main.h
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * host stub of main.h for utils.c and the modules under test
+ */
+
+#ifndef STUB_MAIN_H_
+#define STUB_MAIN_H_
+
+#include "stm32wlxx_hal.h"
+
+void Error_Handler(void);
+#define writeLog(...)		// release build (no DEBUG)
+
+#endif /* STUB_MAIN_H_ */
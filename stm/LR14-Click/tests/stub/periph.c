@@ -0,0 +1,192 @@
+/*
+ * periph.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * host stub of the peripherals of the power domains and of ADC (stm32wlxx_hal_periph.h)
+ * - MX_xxx_Init/DeInit are counted per domain
+ * - ADC: the calibration is lost by HAL_ADC_DeInit (the regulator is off), the conversions of VREFINT and TEMPSENSOR
+ *   are computed from stub_Periph.VddaMv and .Temperature with the factory calibration
+ * - RTC: the backup registers only
+ * - RCC: SYSCLK of the MSI range (PCLK1 of stub/i2c.c follows it), the faults of the order of the voltage scale
+ *   and the clock
+ */
+
+#include "i2c.h"
+#include "spi.h"
+#include "usart.h"
+#include "adc.h"
+
+stubPeriph_t stub_Periph = { .VddaMv = 3000, .Temperature = 25, .Scale = PWR_REGULATOR_VOLTAGE_SCALE1 };
+uint16_t stub_VrefintCal = 1650;	// 1.33 V at 3.3 V
+uint16_t stub_TsCal1 = 940;			// 30 °C at 3.3 V, 2.5 mV/°C
+uint16_t stub_TsCal2 = 1250;		// 130 °C
+
+ADC_HandleTypeDef hadc;
+SPI_TypeDef stub_SPI1 = { };
+USART_TypeDef stub_USART1 = { .ISR = UART_FLAG_TC };
+SPI_HandleTypeDef hspi1 = { .Instance = &stub_SPI1 };
+UART_HandleTypeDef huart1 = { .Instance = &stub_USART1, .Init = { .BaudRate = 115200 }, .gState = HAL_UART_STATE_READY };
+uint32_t SystemCoreClock = 48000000;
+DWT_Type stub_DWT;
+RTC_HandleTypeDef hrtc;
+uint32_t stub_RtcBkp[RTC_BKP_NUMBER];
+
+static uint8_t _adcRegulator = 0;
+static uint8_t _adcCalibrated = 0;
+static uint8_t _adcRank = 0;
+static uint32_t _adcChannel[2];
+
+void MX_SPI1_Init(void)
+{
+	stub_Periph.Init[1]++;
+}
+
+void MX_SPI1_DeInit(void)
+{
+	stub_Periph.DeInit[1]++;
+}
+
+void MX_USART1_UART_Init(void)
+{
+	stub_Periph.Init[2]++;
+}
+
+HAL_StatusTypeDef HAL_UART_DeInit(UART_HandleTypeDef *huart)
+{
+	stub_Periph.DeInit[2]++;
+	return HAL_OK;
+}
+
+void MX_ADC_Init(void)
+{
+	stub_Periph.Init[3]++;
+	hadc.Instance = ADC;
+	HAL_ADC_Init(&hadc);
+}
+
+HAL_StatusTypeDef HAL_ADC_DeInit(ADC_HandleTypeDef *hadc)
+{
+	stub_Periph.DeInit[3]++;
+	_adcRegulator = 0;
+	_adcCalibrated = 0;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_Init(ADC_HandleTypeDef *hadc)
+{
+	stub_Periph.AdcInit++;
+	if (!_adcRegulator)
+		stub_Periph.AdcRegulator++;
+	_adcRegulator = 1;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_ConfigChannel(ADC_HandleTypeDef *hadc, ADC_ChannelConfTypeDef *sConfig)
+{
+	if (sConfig->Rank < 1 || sConfig->Rank > 2)
+		return HAL_ERROR;
+	_adcChannel[sConfig->Rank - 1] = sConfig->Channel;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADCEx_Calibration_Start(ADC_HandleTypeDef *hadc)
+{
+	stub_Periph.AdcCalib++;
+	_adcCalibrated = 1;
+	return HAL_OK;
+}
+
+uint32_t HAL_ADCEx_Calibration_GetValue(ADC_HandleTypeDef *hadc)
+{
+	return 0x2A;
+}
+
+HAL_StatusTypeDef HAL_ADCEx_Calibration_SetValue(ADC_HandleTypeDef *hadc, uint32_t CalibrationFactor)
+{
+	_adcCalibrated = (CalibrationFactor == 0x2A);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef ADC_Enable(ADC_HandleTypeDef *hadc)
+{
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_Start(ADC_HandleTypeDef *hadc)
+{
+	stub_Periph.AdcSessions++;
+	_adcRank = 0;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_PollForConversion(ADC_HandleTypeDef *hadc, uint32_t Timeout)
+{
+	if (stub_Periph.AdcFail)
+		return HAL_TIMEOUT;
+	stub_Periph.AdcConversions++;
+	return HAL_OK;
+}
+
+uint32_t HAL_ADC_GetValue(ADC_HandleTypeDef *hadc)
+{
+	uint32_t channel = _adcChannel[(hadc->Init.NbrOfConversion > 1) ? _adcRank++ % 2 : 0];
+	uint32_t mv;
+
+	if (!_adcCalibrated)
+		return 0xFFF;	// offset of the uncalibrated ADC, the value is wrong
+	if (channel == ADC_CHANNEL_VREFINT)
+		mv = stub_VrefintCal * 3300U / 4095;
+	else
+		mv = (stub_TsCal1 + (stub_TsCal2 - stub_TsCal1) * (stub_Periph.Temperature - 30) / 100) * 3300U / 4095;
+	return mv * 4095 / stub_Periph.VddaMv;
+}
+
+HAL_StatusTypeDef HAL_ADC_Stop(ADC_HandleTypeDef *hadc)
+{
+	return HAL_OK;
+}
+
+void Error_Handler(void)
+{
+}
+
+void HAL_RTCEx_BKUPWrite(RTC_HandleTypeDef *hrtc, uint32_t BackupRegister, uint32_t Data)
+{
+	stub_RtcBkp[BackupRegister] = Data;
+}
+
+uint32_t HAL_RTCEx_BKUPRead(RTC_HandleTypeDef *hrtc, uint32_t BackupRegister)
+{
+	return stub_RtcBkp[BackupRegister];
+}
+
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct)
+{
+	static const uint32_t msiHz[12] = { 100000, 200000, 400000, 800000, 1000000, 2000000, 4000000, 8000000, 16000000,
+		24000000, 32000000, 48000000 };
+	uint32_t hz = msiHz[(RCC_OscInitStruct->MSIClockRange >> 4) % 12];
+
+	if (stub_Periph.OscFail)
+		return HAL_ERROR;
+	if (stub_Periph.Scale == PWR_REGULATOR_VOLTAGE_SCALE2 && hz > 16000000)
+		stub_Periph.ScaleFaults++;
+	SystemCoreClock = hz;
+	stub_Pclk1Hz = hz;
+	stub_Periph.ClockSwitches++;
+	return HAL_OK;
+}
+
+uint32_t HAL_RCC_GetPCLK2Freq(void)
+{
+	return SystemCoreClock;
+}
+
+HAL_StatusTypeDef HAL_PWREx_ControlVoltageScaling(uint32_t VoltageScaling)
+{
+	if (VoltageScaling == PWR_REGULATOR_VOLTAGE_SCALE2 && SystemCoreClock > 16000000)
+		stub_Periph.ScaleFaults++;
+	stub_Periph.Scale = VoltageScaling;
+	return HAL_OK;
+}
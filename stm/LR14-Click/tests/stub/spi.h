@@ -0,0 +1,20 @@
+/*
+ * spi.h
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * host stub of spi.h, the peripheral is stub/periph.c
+ */
+
+#ifndef STUB_SPI_H_
+#define STUB_SPI_H_
+
+#include "main.h"
+
+extern SPI_HandleTypeDef hspi1;
+
+void MX_SPI1_Init(void);
+void MX_SPI1_DeInit(void);
+
+#endif /* STUB_SPI_H_ */
@@ -0,0 +1,43 @@
+/*
+ * stm32wlxx_hal.h
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * host stub of HAL: the types and the tick used by the tested modules, the tick is set by the test (stub_Tick)
+ * - HAL_Delay and the I2C transfers advance the tick (stub/i2c.c, the devices on the bus are modelled by the test)
+ * - I2C, GPIO and RCC of i2c.c are in stm32wlxx_hal_i2c.h
+ */
+
+#ifndef STUB_STM32WLXX_HAL_H_
+#define STUB_STM32WLXX_HAL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef enum
+{
+	HAL_OK = 0x00,
+	HAL_ERROR = 0x01,
+	HAL_BUSY = 0x02,
+	HAL_TIMEOUT = 0x03
+} HAL_StatusTypeDef;
+
+#ifndef __weak
+#define __weak					__attribute__((weak))
+#endif
+#define HAL_MAX_DELAY			0xFFFFFFFFU
+
+extern uint32_t stub_Tick;	// ms
+
+static inline uint32_t HAL_GetTick(void)
+{
+	return stub_Tick;
+}
+
+void HAL_Delay(uint32_t Delay);
+
+#include "stm32wlxx_hal_periph.h"
+#include "stm32wlxx_hal_i2c.h"
+
+#endif /* STUB_STM32WLXX_HAL_H_ */
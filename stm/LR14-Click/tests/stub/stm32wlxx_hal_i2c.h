@@ -0,0 +1,131 @@
+/*
+ * stm32wlxx_hal_i2c.h
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * host stub of HAL: I2C, GPIO and RCC of i2c.c, included by stm32wlxx_hal.h
+ * - the transfers are modelled by stub/i2c.c (the bus speed is I2C_HandleTypeDef.Speed, not TIMINGR)
+ * - HAL_I2C_Init writes Init.Timing to TIMINGR of the instance, PCLK1 is stub_Pclk1Hz
+ */
+
+#ifndef STUB_STM32WLXX_HAL_I2C_H_
+#define STUB_STM32WLXX_HAL_I2C_H_
+
+#define I2C_MEMADD_SIZE_8BIT	1
+#define I2C_MEMADD_SIZE_16BIT	2
+
+typedef struct
+{
+	__IO uint32_t CR1;
+	__IO uint32_t TIMINGR;
+} I2C_TypeDef;
+
+typedef struct
+{
+	uint32_t Timing;
+	uint32_t OwnAddress1;
+	uint32_t AddressingMode;
+	uint32_t DualAddressMode;
+	uint32_t OwnAddress2;
+	uint32_t OwnAddress2Masks;
+	uint32_t GeneralCallMode;
+	uint32_t NoStretchMode;
+} I2C_InitTypeDef;
+
+typedef enum
+{
+	HAL_I2C_STATE_RESET = 0x00,
+	HAL_I2C_STATE_READY = 0x20,
+	HAL_I2C_STATE_BUSY = 0x24
+} HAL_I2C_StateTypeDef;
+
+typedef struct
+{
+	I2C_TypeDef *Instance;
+	I2C_InitTypeDef Init;
+	__IO HAL_I2C_StateTypeDef State;
+	uint32_t Speed;		// SCL of the modelled bus (Hz), I2C_SPEED_DEFAULT if 0
+} I2C_HandleTypeDef;
+
+extern I2C_TypeDef stub_I2C2;
+#define I2C2						(&stub_I2C2)
+#define I2C_CR1_PE					0x1U
+#define __HAL_I2C_ENABLE(h)			((h)->Instance->CR1 |= I2C_CR1_PE)
+#define __HAL_I2C_DISABLE(h)		((h)->Instance->CR1 &= ~I2C_CR1_PE)
+
+#define I2C_ADDRESSINGMODE_7BIT		1
+#define I2C_DUALADDRESS_DISABLE		0
+#define I2C_OA2_NOMASK				0
+#define I2C_GENERALCALL_DISABLE		0
+#define I2C_NOSTRETCH_DISABLE		0
+#define I2C_ANALOGFILTER_ENABLE		0
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef *hi2c);
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_MspInit(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_MspDeInit(I2C_HandleTypeDef *hi2c);
+HAL_StatusTypeDef HAL_I2CEx_ConfigAnalogFilter(I2C_HandleTypeDef *hi2c, uint32_t AnalogFilter);
+HAL_StatusTypeDef HAL_I2CEx_ConfigDigitalFilter(I2C_HandleTypeDef *hi2c, uint32_t DigitalFilter);
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData,
+	uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData,
+	uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_IsDeviceReady(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint32_t Trials, uint32_t Timeout);
+
+typedef struct
+{
+	__IO uint32_t ODR;
+} GPIO_TypeDef;
+
+typedef struct
+{
+	uint32_t Pin;
+	uint32_t Mode;
+	uint32_t Pull;
+	uint32_t Speed;
+	uint32_t Alternate;
+} GPIO_InitTypeDef;
+
+typedef enum
+{
+	GPIO_PIN_RESET = 0,
+	GPIO_PIN_SET
+} GPIO_PinState;
+
+extern GPIO_TypeDef stub_GPIOA;
+#define GPIOA						(&stub_GPIOA)
+#define GPIO_PIN_11					((uint16_t) 0x0800)
+#define GPIO_PIN_12					((uint16_t) 0x1000)
+#define GPIO_MODE_OUTPUT_PP			0x01
+#define GPIO_MODE_OUTPUT_OD			0x11
+#define GPIO_MODE_AF_OD				0x12
+#define GPIO_NOPULL					0
+#define GPIO_PULLUP					1
+#define GPIO_SPEED_FREQ_LOW			0
+#define GPIO_AF4_I2C2				4
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init);
+void HAL_GPIO_DeInit(GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin);
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+
+typedef struct
+{
+	uint32_t PeriphClockSelection;
+	uint32_t I2c2ClockSelection;
+} RCC_PeriphCLKInitTypeDef;
+
+extern uint32_t stub_Pclk1Hz;
+#define RCC_PERIPHCLK_I2C2			0x20
+#define RCC_I2C2CLKSOURCE_PCLK1		0
+#define __HAL_RCC_GPIOA_CLK_ENABLE()
+#define __HAL_RCC_I2C2_CLK_ENABLE()
+#define __HAL_RCC_I2C2_CLK_DISABLE()
+
+HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef *PeriphClkInit);
+uint32_t HAL_RCC_GetPCLK1Freq(void);
+
+#endif /* STUB_STM32WLXX_HAL_I2C_H_ */
@@ -0,0 +1,245 @@
+/*
+ * stm32wlxx_hal_periph.h
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * host stub of HAL: ADC, SPI and UART of the power domains (pwrdomain.c) and of adc_if.c, MSI and the voltage scale
+ * of the clock profiles (clockprof.c), the cycle counter (DWT) of trace.c, included by stm32wlxx_hal.h
+ * - the RTC backup registers are stub_RtcBkp (kept over the modelled reset, cleared by the test for the power-on)
+ * - the peripheral is modelled by stub/periph.c: the counts of the initializations, calibrations and conversions,
+ *   the conversions of VREFINT and TEMPSENSOR for the VDDA and the temperature set by the test
+ */
+
+#ifndef STUB_STM32WLXX_HAL_PERIPH_H_
+#define STUB_STM32WLXX_HAL_PERIPH_H_
+
+#define __IO		volatile
+#define ENABLE		1
+#define DISABLE		0
+
+typedef struct
+{
+	uint32_t ScanConvMode;
+	uint32_t NbrOfConversion;
+	uint32_t OversamplingMode;
+	struct
+	{
+		uint32_t Ratio;
+		uint32_t RightBitShift;
+		uint32_t TriggeredMode;
+	} Oversampling;
+} ADC_InitTypeDef;
+
+typedef struct
+{
+	void *Instance;
+	ADC_InitTypeDef Init;
+} ADC_HandleTypeDef;
+
+typedef struct
+{
+	uint32_t Channel;
+	uint32_t Rank;
+	uint32_t SamplingTime;
+} ADC_ChannelConfTypeDef;
+
+#define MODIFY_REG(REG, CLEARMASK, SETMASK)	((REG) = (((REG) & (~(CLEARMASK))) | (SETMASK)))
+
+// SPI and UART of the clock profiles (clockprof.c): the prescaler, BRR, the enable bits and the end of TX
+typedef struct
+{
+	__IO uint32_t CR1;
+} SPI_TypeDef;
+
+typedef struct
+{
+	uint32_t BaudRatePrescaler;
+} SPI_InitTypeDef;
+
+typedef struct
+{
+	SPI_TypeDef *Instance;
+	SPI_InitTypeDef Init;
+} SPI_HandleTypeDef;
+
+#define SPI_CR1_SPE							(0x1UL << 6)
+#define SPI_CR1_BR_Pos						3U
+#define SPI_CR1_BR							(0x7UL << SPI_CR1_BR_Pos)
+#define __HAL_SPI_DISABLE(h)				((h)->Instance->CR1 &= ~SPI_CR1_SPE)
+
+typedef struct
+{
+	__IO uint32_t CR1;
+	__IO uint32_t BRR;
+	__IO uint32_t ISR;
+} USART_TypeDef;
+
+typedef struct
+{
+	uint32_t BaudRate;
+	uint32_t ClockPrescaler;
+} UART_InitTypeDef;
+
+typedef enum
+{
+	HAL_UART_STATE_RESET = 0x00,
+	HAL_UART_STATE_READY = 0x20,
+	HAL_UART_STATE_BUSY_TX = 0x21
+} HAL_UART_StateTypeDef;
+
+typedef struct
+{
+	USART_TypeDef *Instance;
+	UART_InitTypeDef Init;
+	__IO HAL_UART_StateTypeDef gState;
+} UART_HandleTypeDef;
+
+#define USART_CR1_UE						0x1UL
+#define UART_FLAG_TC						(0x1UL << 6)
+#define UART_PRESCALER_DIV1					0
+#define UART_DIV_SAMPLING16(clk, baud, presc)	(((clk) + ((baud) / 2U)) / (baud))
+#define __HAL_UART_GET_FLAG(h, flag)		(((h)->Instance->ISR & (flag)) == (flag))
+#define __HAL_UART_ENABLE(h)				((h)->Instance->CR1 |= USART_CR1_UE)
+#define __HAL_UART_DISABLE(h)				((h)->Instance->CR1 &= ~USART_CR1_UE)
+
+// MSI and the voltage scale of the clock profiles, PCLK1 and PCLK2 = SYSCLK
+typedef struct
+{
+	uint32_t PLLState;
+} RCC_PLLInitTypeDef;
+
+typedef struct
+{
+	uint32_t OscillatorType;
+	uint32_t MSIState;
+	uint32_t MSICalibrationValue;
+	uint32_t MSIClockRange;
+	RCC_PLLInitTypeDef PLL;
+} RCC_OscInitTypeDef;
+
+#define RCC_OSCILLATORTYPE_MSI				0x20
+#define RCC_MSI_ON							1
+#define RCC_MSICALIBRATION_DEFAULT			0
+#define RCC_PLL_NONE						0
+#define RCC_MSIRANGE_6						(6UL << 4)	// 4 MHz
+#define RCC_MSIRANGE_8						(8UL << 4)	// 16 MHz
+#define RCC_MSIRANGE_11						(11UL << 4)	// 48 MHz
+#define PWR_REGULATOR_VOLTAGE_SCALE1		(0x1UL << 9)
+#define PWR_REGULATOR_VOLTAGE_SCALE2		(0x2UL << 9)	// SYSCLK max. 16 MHz
+
+extern uint32_t SystemCoreClock;
+
+// cycle counter of the core (trace.c), set by the test
+typedef struct
+{
+	__IO uint32_t CTRL;
+	__IO uint32_t CYCCNT;
+} DWT_Type;
+
+extern DWT_Type stub_DWT;
+#define DWT		(&stub_DWT)
+
+// RTC of Core/Inc/main.h (included by the headers of Core/Inc)
+typedef struct
+{
+	uint8_t Hours, Minutes, Seconds;
+} RTC_TimeTypeDef;
+
+typedef struct
+{
+	uint8_t WeekDay, Month, Date, Year;
+} RTC_DateTypeDef;
+
+typedef struct
+{
+	void *Instance;
+} RTC_HandleTypeDef;
+
+#define RTC_BKP_NUMBER						20
+#define RTC_BKP_DR0							0
+#define RTC_BKP_DR1							1
+#define RTC_BKP_DR2							2
+#define RTC_BKP_DR3							3
+#define RTC_BKP_DR4							4
+#define RTC_BKP_DR5							5
+#define RTC_BKP_DR6							6
+#define RTC_BKP_DR7							7
+#define RTC_BKP_DR8							8
+
+extern uint32_t stub_RtcBkp[RTC_BKP_NUMBER];
+
+#define ADC									((void*) 0x40012400)
+#define ADC_SCAN_ENABLE						1
+#define ADC_OVERSAMPLING_RATIO_16			16
+#define ADC_RIGHTBITSHIFT_4					4
+#define ADC_TRIGGEREDMODE_SINGLE_TRIGGER	0
+#define ADC_CHANNEL_VREFINT					13
+#define ADC_CHANNEL_TEMPSENSOR				12
+#define ADC_REGULAR_RANK_1					1
+#define ADC_REGULAR_RANK_2					2
+#define ADC_SAMPLINGTIME_COMMON_1			0
+#define ADC_RESOLUTION_12B					0
+#define LL_ADC_RESOLUTION_12B				0
+
+// factory calibration (system memory), the values are set by stub/periph.c
+extern uint16_t stub_VrefintCal, stub_TsCal1, stub_TsCal2;
+#define VREFINT_CAL_ADDR					(&stub_VrefintCal)
+#define VREFINT_CAL_VREF					3300UL
+#define TEMPSENSOR_CAL1_ADDR				(&stub_TsCal1)
+#define TEMPSENSOR_CAL2_ADDR				(&stub_TsCal2)
+#define TEMPSENSOR_CAL1_TEMP				((int32_t) 30)
+#define TEMPSENSOR_CAL2_TEMP				((int32_t) 130)
+#define TEMPSENSOR_CAL_VREFANALOG			3300UL
+
+// stm32wlxx_ll_adc.h, 12-bit resolution
+#define __LL_ADC_CALC_VREFANALOG_VOLTAGE(data, res)	(((uint32_t) (*VREFINT_CAL_ADDR) * VREFINT_CAL_VREF) / (data))
+#define __LL_ADC_CALC_TEMPERATURE(vref, data, res)	\
+	(((((int32_t) (((data) * (vref)) / TEMPSENSOR_CAL_VREFANALOG) - (int32_t) *TEMPSENSOR_CAL1_ADDR) \
+	* (TEMPSENSOR_CAL2_TEMP - TEMPSENSOR_CAL1_TEMP)) / ((int32_t) *TEMPSENSOR_CAL2_ADDR - (int32_t) *TEMPSENSOR_CAL1_ADDR)) \
+	+ TEMPSENSOR_CAL1_TEMP)
+#define __LL_ADC_CALC_TEMPERATURE_TYP_PARAMS(slope, v30, t30, vref, data, res)	\
+	((((int32_t) (((data) * (vref)) / 4095) * 1000 - (int32_t) ((v30) * 1000)) / (slope)) + (t30))
+
+HAL_StatusTypeDef HAL_ADC_Init(ADC_HandleTypeDef *hadc);
+HAL_StatusTypeDef HAL_ADC_DeInit(ADC_HandleTypeDef *hadc);
+HAL_StatusTypeDef HAL_ADC_ConfigChannel(ADC_HandleTypeDef *hadc, ADC_ChannelConfTypeDef *sConfig);
+HAL_StatusTypeDef HAL_ADCEx_Calibration_Start(ADC_HandleTypeDef *hadc);
+uint32_t HAL_ADCEx_Calibration_GetValue(ADC_HandleTypeDef *hadc);
+HAL_StatusTypeDef HAL_ADCEx_Calibration_SetValue(ADC_HandleTypeDef *hadc, uint32_t CalibrationFactor);
+HAL_StatusTypeDef ADC_Enable(ADC_HandleTypeDef *hadc);
+HAL_StatusTypeDef HAL_ADC_Start(ADC_HandleTypeDef *hadc);
+HAL_StatusTypeDef HAL_ADC_PollForConversion(ADC_HandleTypeDef *hadc, uint32_t Timeout);
+uint32_t HAL_ADC_GetValue(ADC_HandleTypeDef *hadc);
+HAL_StatusTypeDef HAL_ADC_Stop(ADC_HandleTypeDef *hadc);
+HAL_StatusTypeDef HAL_UART_DeInit(UART_HandleTypeDef *huart);
+void HAL_RTCEx_BKUPWrite(RTC_HandleTypeDef *hrtc, uint32_t BackupRegister, uint32_t Data);
+uint32_t HAL_RTCEx_BKUPRead(RTC_HandleTypeDef *hrtc, uint32_t BackupRegister);
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct);
+uint32_t HAL_RCC_GetPCLK2Freq(void);
+HAL_StatusTypeDef HAL_PWREx_ControlVoltageScaling(uint32_t VoltageScaling);
+
+/*
+ * stubPeriph_t - the counters of the peripherals
+ */
+typedef struct
+{
+	uint32_t Init[4];		// MX_xxx_Init of pwrDomainId_t
+	uint32_t DeInit[4];
+	uint32_t AdcInit;		// HAL_ADC_Init
+	uint32_t AdcRegulator;	// starts of the ADC regulator (HAL_ADC_Init after HAL_ADC_DeInit, 20 us)
+	uint32_t AdcCalib;		// HAL_ADCEx_Calibration_Start
+	uint32_t AdcSessions;	// HAL_ADC_Start
+	uint32_t AdcConversions;
+	uint16_t VddaMv;		// modelled VDDA
+	int16_t Temperature;	// modelled chip temperature
+	uint8_t AdcFail;		// the next conversions time out
+	uint32_t Scale;			// voltage scale of the regulator
+	uint32_t ClockSwitches;	// HAL_RCC_OscConfig
+	uint32_t ScaleFaults;	// SYSCLK over 16 MHz in the scale 2
+	uint8_t OscFail;		// HAL_RCC_OscConfig fails
+} stubPeriph_t;
+
+extern stubPeriph_t stub_Periph;
+
+#endif /* STUB_STM32WLXX_HAL_PERIPH_H_ */
@@ -0,0 +1,15 @@
+/*
+ * stm32wlxx_ll_gpio.h
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * host stub of stm32wlxx_ll_gpio.h for platform.h, the types are in stm32wlxx_hal.h
+ */
+
+#ifndef STUB_STM32WLXX_LL_GPIO_H_
+#define STUB_STM32WLXX_LL_GPIO_H_
+
+#include "stm32wlxx_hal.h"
+
+#endif /* STUB_STM32WLXX_LL_GPIO_H_ */
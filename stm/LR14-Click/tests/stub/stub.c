@@ -0,0 +1,10 @@
+/*
+ * stub.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ */
+
+#include "stm32wlxx_hal.h"
+
+uint32_t stub_Tick = 0;
@@ -0,0 +1,18 @@
+/*
+ * timer_if.h
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * host stub of timer_if.h, RTC of the tested module is given by the test
+ */
+
+#ifndef STUB_TIMER_IF_H_
+#define STUB_TIMER_IF_H_
+
+#include <stdint.h>
+
+uint32_t TIMER_IF_GetTimerValue(void);
+uint32_t TIMER_IF_Convert_ms2Tick(uint32_t timeMilliSec);
+
+#endif /* STUB_TIMER_IF_H_ */
@@ -0,0 +1,19 @@
+/*
+ * usart.h
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * host stub of usart.h, the peripheral is stub/periph.c
+ */
+
+#ifndef STUB_USART_H_
+#define STUB_USART_H_
+
+#include "main.h"
+
+extern UART_HandleTypeDef huart1;
+
+void MX_USART1_UART_Init(void);
+
+#endif /* STUB_USART_H_ */
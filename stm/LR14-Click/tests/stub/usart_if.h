@@ -0,0 +1,17 @@
+/*
+ * usart_if.h
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * host stub of usart_if.h, the console output is captured by the test
+ */
+
+#ifndef STUB_USART_IF_H_
+#define STUB_USART_IF_H_
+
+#include "stm32_adv_trace.h"
+
+UTIL_ADV_TRACE_Status_t Uart_Info(const char *strInfo);
+
+#endif /* STUB_USART_IF_H_ */
@@ -0,0 +1,151 @@
+/*
+ * util.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ */
+
+#include "util_stub.h"
+#include "stm32wlxx_hal.h"
+
+#define STUB_TIMER_MAX		16
+#define STUB_SEQ_TASKS		32
+
+static UTIL_TIMER_Object_t *_timers[STUB_TIMER_MAX];
+static uint8_t _timerCount = 0;
+static void (*_tasks[STUB_SEQ_TASKS])(void);
+static UTIL_SEQ_bm_t _taskPending = 0;
+
+void stub_UtilReset(void)
+{
+	_timerCount = 0;
+	_taskPending = 0;
+	for (int i = 0; i < STUB_SEQ_TASKS; i++)
+		_tasks[i] = NULL;
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_Create(UTIL_TIMER_Object_t *TimerObject, uint32_t PeriodValue, UTIL_TIMER_Mode_t Mode,
+	void (*Callback)(void*), void *Argument)
+{
+	TimerObject->Timestamp = 0;
+	TimerObject->ReloadValue = PeriodValue;
+	TimerObject->IsPending = 0;
+	TimerObject->IsRunning = 0;
+	TimerObject->IsReloadStopped = 0;
+	TimerObject->Mode = Mode;
+	TimerObject->Callback = Callback;
+	TimerObject->argument = Argument;
+	TimerObject->Next = NULL;
+	for (int i = 0; i < _timerCount; i++)
+		if (_timers[i] == TimerObject)
+			return UTIL_TIMER_OK;
+	if (_timerCount >= STUB_TIMER_MAX)
+		return UTIL_TIMER_INVALID_PARAM;
+	_timers[_timerCount++] = TimerObject;
+	return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_Start(UTIL_TIMER_Object_t *TimerObject)
+{
+	TimerObject->Timestamp = stub_Tick + TimerObject->ReloadValue;
+	TimerObject->IsRunning = 1;
+	return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_StartWithPeriod(UTIL_TIMER_Object_t *TimerObject, uint32_t PeriodValue)
+{
+	TimerObject->ReloadValue = PeriodValue;
+	return UTIL_TIMER_Start(TimerObject);
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_Stop(UTIL_TIMER_Object_t *TimerObject)
+{
+	TimerObject->IsRunning = 0;
+	return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_SetPeriod(UTIL_TIMER_Object_t *TimerObject, uint32_t NewPeriodValue)
+{
+	TimerObject->ReloadValue = NewPeriodValue;
+	if (TimerObject->IsRunning)
+		UTIL_TIMER_Start(TimerObject);
+	return UTIL_TIMER_OK;
+}
+
+uint32_t UTIL_TIMER_IsRunning(UTIL_TIMER_Object_t *TimerObject)
+{
+	return TimerObject->IsRunning;
+}
+
+UTIL_TIMER_Time_t UTIL_TIMER_GetCurrentTime(void)
+{
+	return stub_Tick;
+}
+
+UTIL_TIMER_Time_t UTIL_TIMER_GetElapsedTime(UTIL_TIMER_Time_t past)
+{
+	return stub_Tick - past;
+}
+
+void UTIL_SEQ_RegTask(UTIL_SEQ_bm_t TaskId_bm, uint32_t Flags, void (*Task)(void))
+{
+	for (int i = 0; i < STUB_SEQ_TASKS; i++)
+		if (TaskId_bm & (1UL << i))
+			_tasks[i] = Task;
+}
+
+void UTIL_SEQ_SetTask(UTIL_SEQ_bm_t TaskId_bm, uint32_t Task_Prio)
+{
+	_taskPending |= TaskId_bm;
+}
+
+void stub_SeqRun(void)
+{
+	while (_taskPending != 0)
+		for (int i = 0; i < STUB_SEQ_TASKS; i++)
+			if (_taskPending & (1UL << i))
+			{
+				_taskPending &= ~(1UL << i);
+				if (_tasks[i] != NULL)
+					_tasks[i]();
+			}
+}
+
+uint32_t stub_TimerNext(void)
+{
+	uint32_t next = UINT32_MAX;
+
+	for (int i = 0; i < _timerCount; i++)
+		if (_timers[i]->IsRunning && _timers[i]->Timestamp < next)
+			next = _timers[i]->Timestamp;
+	return next;
+}
+
+uint8_t stub_TimerRun(uint32_t until)
+{
+	uint32_t next = stub_TimerNext();
+
+	if (next > until)
+	{
+		stub_Tick = until;
+		return 0;
+	}
+	if (next > stub_Tick)
+		stub_Tick = next;
+	for (int i = 0; i < _timerCount; i++)
+	{
+		UTIL_TIMER_Object_t *t = _timers[i];
+
+		if (!t->IsRunning || t->Timestamp != next)
+			continue;
+		if (t->Mode == UTIL_TIMER_PERIODIC)
+			UTIL_TIMER_Start(t);
+		else
+			t->IsRunning = 0;
+		if (t->Callback != NULL)
+			t->Callback(t->argument);
+		break;
+	}
+	stub_SeqRun();
+	return 1;
+}
@@ -0,0 +1,34 @@
+/*
+ * util_stub.h
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * host stub of the timer server (stm32_timer) and of the sequencer (stm32_seq), the time is stub_Tick (ms)
+ */
+
+#ifndef STUB_UTIL_STUB_H_
+#define STUB_UTIL_STUB_H_
+
+#include "stm32_timer.h"
+#include "stm32_seq.h"
+
+/*
+ * @brief the time of the first running timer, UINT32_MAX - no timer is running
+ */
+uint32_t stub_TimerNext(void);
+
+/*
+ * @brief stub_Tick is moved to the first running timer (at most to until), its callback and the pending tasks are run
+ * @retval 1 - a timer has expired, 0 - no timer before until (stub_Tick = until)
+ */
+uint8_t stub_TimerRun(uint32_t until);
+
+/*
+ * @brief the pending tasks of the sequencer are run (UTIL_SEQ_Run)
+ */
+void stub_SeqRun(void);
+
+void stub_UtilReset(void);
+
+#endif /* STUB_UTIL_STUB_H_ */
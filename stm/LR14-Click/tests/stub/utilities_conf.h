@@ -0,0 +1,16 @@
+/*
+ * utilities_conf.h
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * host stub of utilities_conf.h, the critical sections are empty (one thread)
+ */
+
+#ifndef STUB_UTILITIES_CONF_H_
+#define STUB_UTILITIES_CONF_H_
+
+#define UTILS_ENTER_CRITICAL_SECTION()
+#define UTILS_EXIT_CRITICAL_SECTION()
+
+#endif /* STUB_UTILITIES_CONF_H_ */
@@ -0,0 +1,34 @@
+/*
+ * test.h
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * host tests: CHECK prints the failed condition and counts it, main returns TEST_RESULT()
+ */
+
+#ifndef TEST_H_
+#define TEST_H_
+
+#include <stdio.h>
+#include <time.h>
+
+static int test_Fails = 0;
+
+#define CHECK(cond)	do { if (!(cond)) { test_Fails++; printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); } } while (0)
+#define CHECK_EQ(a, b)	do { long long _a = (long long) (a), _b = (long long) (b); if (_a != _b) { test_Fails++; \
+	printf("%s:%d: %s == %s failed (%lld != %lld)\n", __FILE__, __LINE__, #a, #b, _a, _b); } } while (0)
+#define TEST_RESULT()	(printf("%s\n", test_Fails ? "FAILED" : "OK"), test_Fails ? 1 : 0)
+
+/*
+ * @brief monotonic time (ns) for the benchmarks
+ */
+static inline double test_Ns(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+#endif /* TEST_H_ */
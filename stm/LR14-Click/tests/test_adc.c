@@ -0,0 +1,197 @@
+/*
+ * test_adc.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * VREFINT and TEMPSENSOR in one ADC session with the cached calibration (user-041), adc_if.c and pwrdomain.c
+ * on the counting ADC of stub/periph.c
+ * - 1 h of the reading cycles (30 s): the governor reads the battery at the start of the cycle, every 10th cycle
+ *   the uplink reads the temperature (EnvSensors_Read) and the battery (DevStatus), STOP2 between the cycles;
+ *   the ADC initializations, calibrations and sessions against ADC_ReadChannels of ST (one channel per session,
+ *   the temperature converts the battery level first)
+ * - VDDA and the temperature against the model over the range of the battery and of the chip temperature
+ * - the failed conversion keeps the previous values and the next session is calibrated, the calibration after 24 h
+ */
+
+#include <stdlib.h>
+#include "test.h"
+#include "adc_if.h"
+#include "pwrdomain.h"
+
+#define CYCLE_MS		30000		// _sensorTimeout
+#define UPLINK_CYCLES	10			// TX period 300 s
+
+void clockProf_Retime(pwrDomainId_t id)
+{
+}
+
+/*
+ * @brief ADC_ReadChannels of ST (the code after USER CODE of adc_if.c, not reached)
+ */
+static uint32_t stReadChannels(uint32_t channel)
+{
+	ADC_ChannelConfTypeDef sConfig = { 0 };
+	uint32_t value;
+
+	MX_ADC_Init();
+	HAL_ADCEx_Calibration_Start(&hadc);
+	sConfig.Channel = channel;
+	sConfig.Rank = ADC_REGULAR_RANK_1;
+	sConfig.SamplingTime = ADC_SAMPLINGTIME_COMMON_1;
+	HAL_ADC_ConfigChannel(&hadc, &sConfig);
+	HAL_ADC_Start(&hadc);
+	HAL_ADC_PollForConversion(&hadc, HAL_MAX_DELAY);
+	HAL_ADC_Stop(&hadc);
+	value = HAL_ADC_GetValue(&hadc);
+	HAL_ADC_DeInit(&hadc);
+	return value;
+}
+
+static uint16_t stBattery(void)
+{
+	return __LL_ADC_CALC_VREFANALOG_VOLTAGE(stReadChannels(ADC_CHANNEL_VREFINT), ADC_RESOLUTION_12B);
+}
+
+static int16_t stTemperature(void)
+{
+	uint16_t mv = stBattery();
+
+	return __LL_ADC_CALC_TEMPERATURE(mv, stReadChannels(ADC_CHANNEL_TEMPSENSOR), LL_ADC_RESOLUTION_12B) << 8;
+}
+
+typedef struct
+{
+	uint32_t adcInit;	// HAL_ADC_Init (MX_ADC_Init and the reconfiguration)
+	uint32_t regulator;	// starts of the ADC regulator
+	uint32_t calib;
+	uint32_t sessions;
+	uint32_t domainUps;	// MX_ADC_Init of the power domain
+} adcCount_t;
+
+/*
+ * @brief 1 h of the reading cycles
+ * @param st - ADC_ReadChannels of ST, 0 - adc_if.c
+ */
+static adcCount_t replay(int st)
+{
+	adcCount_t c;
+	stubPeriph_t before = stub_Periph;
+	int mv, deg;
+
+	for (uint32_t cycle = 0; cycle < 3600000 / CYCLE_MS; cycle++)
+	{
+		stub_Tick = cycle * CYCLE_MS;
+		mv = st ? stBattery() : SYS_GetBatteryLevel();	// sensors_Govern
+		CHECK(abs(mv - 3000) <= 3);
+		pwrDomain_OnStop();
+		pwrDomain_OnWake();
+		if (cycle % UPLINK_CYCLES == UPLINK_CYCLES - 1)
+		{
+			stub_Tick += 27000;	// after the readings of the cycle
+			deg = (st ? stTemperature() : SYS_GetTemperatureLevel()) >> 8;	// EnvSensors_Read
+			CHECK(abs(deg - 25) <= 1);
+			stub_Tick += 2;
+			mv = st ? stBattery() : SYS_GetBatteryLevel();	// GetBatteryLevel of DevStatus
+			CHECK(abs(mv - 3000) <= 3);
+			pwrDomain_OnStop();
+			pwrDomain_OnWake();
+		}
+	}
+	c.adcInit = stub_Periph.AdcInit - before.AdcInit;
+	c.regulator = stub_Periph.AdcRegulator - before.AdcRegulator;
+	c.calib = stub_Periph.AdcCalib - before.AdcCalib;
+	c.sessions = stub_Periph.AdcSessions - before.AdcSessions;
+	c.domainUps = stub_Periph.Init[PWR_DOMAIN_ADC] - before.Init[PWR_DOMAIN_ADC];
+	return c;
+}
+
+static void testCycles(void)
+{
+	adcCount_t st, first, next;
+
+	stub_Periph.VddaMv = 3000;
+	stub_Periph.Temperature = 25;
+	st = replay(1);
+	first = replay(0);
+	next = replay(0);
+	printf("1 h (120 cycles, 12 uplinks): ST %lu sessions, %lu calibrations, %lu HAL_ADC_Init (%lu regulator starts)\n",
+		(unsigned long) st.sessions, (unsigned long) st.calib, (unsigned long) st.adcInit, (unsigned long) st.regulator);
+	printf("  adc_if %lu sessions, %lu calibrations (%lu the next hour), %lu HAL_ADC_Init (%lu regulator starts, %lu power-ups "
+		"of the domain)\n", (unsigned long) first.sessions, (unsigned long) first.calib, (unsigned long) next.calib,
+		(unsigned long) first.adcInit, (unsigned long) first.regulator, (unsigned long) first.domainUps);
+	CHECK_EQ(st.sessions, 120 + 12 * 3);
+	CHECK_EQ(st.calib, st.sessions);
+	CHECK_EQ(first.sessions, 120 + 12);	// the DevStatus battery is served from the scan of the temperature
+	CHECK_EQ(first.calib, 1);
+	CHECK_EQ(next.calib, 0);
+	CHECK_EQ(first.domainUps, first.sessions);	// the domain is gated by STOP2 after every session
+	CHECK_EQ(first.regulator, first.sessions);
+	CHECK(first.regulator < st.regulator);
+	CHECK_EQ(pwrDomain_Get(PWR_DOMAIN_ADC)->Refs, 0);
+}
+
+static void testAccuracy(void)
+{
+	int maxMv = 0, maxDeg = 0;
+
+	for (uint16_t mv = 2000; mv <= 3600; mv += 50)
+		for (int16_t deg = -20; deg <= 85; deg += 5)
+		{
+			stub_Tick += 1000;	// out of the validity window
+			stub_Periph.VddaMv = mv;
+			stub_Periph.Temperature = deg;
+			int dMv = abs(SYS_GetBatteryLevel() - mv), dDeg = abs((SYS_GetTemperatureLevel() >> 8) - deg);
+
+			if (dMv > maxMv)
+				maxMv = dMv;
+			if (dDeg > maxDeg)
+				maxDeg = dDeg;
+		}
+	printf("VDDA 2.0..3.6 V, -20..85 C: max. error %d mV, %d C\n", maxMv, maxDeg);
+	CHECK(maxMv <= 3);
+	CHECK(maxDeg <= 1);
+}
+
+static void testFail(void)
+{
+	uint32_t calib;
+	uint16_t mv;
+
+	stub_Tick += 1000;
+	stub_Periph.VddaMv = 3000;
+	stub_Periph.Temperature = 25;
+	mv = SYS_GetBatteryLevel();
+	// the conversion times out, the previous values are kept
+	stub_Tick += 1000;
+	stub_Periph.VddaMv = 2500;
+	stub_Periph.AdcFail = 1;
+	CHECK_EQ(SYS_GetBatteryLevel(), mv);
+	CHECK_EQ(pwrDomain_Get(PWR_DOMAIN_ADC)->Refs, 0);	// released on the error
+	stub_Periph.AdcFail = 0;
+	calib = stub_Periph.AdcCalib;
+	CHECK(abs(SYS_GetBatteryLevel() - 2500) <= 3);	// the failed scan is not cached
+	CHECK_EQ(stub_Periph.AdcCalib, calib + 1);
+	// the calibration is repeated after 24 h
+	stub_Tick += 24 * 3600000U - 1000;
+	CHECK(abs(SYS_GetBatteryLevel() - 2500) <= 3);
+	CHECK_EQ(stub_Periph.AdcCalib, calib + 1);
+	stub_Tick += 1000;
+	CHECK(abs(SYS_GetBatteryLevel() - 2500) <= 3);
+	CHECK_EQ(stub_Periph.AdcCalib, calib + 2);
+	// the cached factor is written after the domain has been gated (calibration lost with the regulator)
+	pwrDomain_OnStop();
+	stub_Tick += 1000;
+	CHECK(abs(SYS_GetBatteryLevel() - 2500) <= 3);
+	CHECK_EQ(stub_Periph.AdcCalib, calib + 2);
+}
+
+int main(void)
+{
+	pwrDomain_Init(0);
+	SYS_InitMeasurement();
+	testCycles();
+	testAccuracy();
+	testFail();
+	return TEST_RESULT();
+}
@@ -0,0 +1,204 @@
+/*
+ * test_cadence.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * per-sensor cadence (user-042), host simulation of one day of the reading cycles of mysensors.c
+ * - cadence_Take / cadence_NextDelay with the cadences of _sensOps, SENS_COALESCE_MS and SENS_WAKEUP_MIN_MS,
+ *   the next cycle from the end of the cycle (sensors_NextDelay), the cycle as long as the slowest due sensor
+ * - the wakeups and the on-time of the sensors per hour against all sensors read in every cycle, the power tier
+ *   without the fast sensors (the slow ones coalesced into one wakeup)
+ * - the flash records of sensors_Summary: the full cycle (the sensor of the slowest cadence) and the channels out
+ *   of the deadbands of the uplink, against one record per cycle; the stored history (the last record) stays
+ *   within the deadband of every channel
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include "test.h"
+#include "utils/utils.h"
+
+#define SENS_COALESCE_MS	5000	// mysensors.h
+#define SENS_WAKEUP_MIN_MS	1000	// mysensors.c
+#define SENS_NBR			5
+#define CH_NBR				7
+#define INTERVAL_MS			30000	// _sensorTimeout
+#define DAY_MS				86400000UL
+#define NO_VALUE			INT32_MIN
+
+// _sensOps: cadence, on time of the reading (warm-up + readings, test_conv), channels
+static const struct
+{
+	const char *name;
+	uint8_t cadence;
+	uint32_t onMS;
+	uint8_t chMask;
+} _sens[SENS_NBR] = {
+	{ "temphum", 2, 4000, 0x03 },
+	{ "ambient", 2, 4000, 0x08 },
+	{ "barometer", 1, 4000, 0x04 },
+	{ "scd41", 10, 13000, 0x10 },
+	{ "sps30", 30, 27000, 0x20 }
+};
+
+/*
+ * @brief deadbands of sensors_SetBands (x100)
+ */
+static void setBands(deltaReporter_t *v)
+{
+	deltaReporter_SetBand(v, 0, 20, 0);
+	deltaReporter_SetBand(v, 1, 200, 0);
+	deltaReporter_SetBand(v, 2, 50, 0);
+	deltaReporter_SetBand(v, 3, 1000, 100);
+	deltaReporter_SetBand(v, 4, 50, 50);
+	deltaReporter_SetBand(v, 5, 200, 100);
+	deltaReporter_SetBand(v, 6, 5, 0);
+}
+
+static int32_t noise(int32_t amplitude)
+{
+	return (rand() % (2 * amplitude + 1)) - amplitude;
+}
+
+/*
+ * @brief the modelled channel at the time of day: daily swings, the drift of the pressure, the light of the day,
+ * the occupancy of the room (CO2), the noise of the datasheets
+ */
+static int32_t channel(int ch, uint32_t t)
+{
+	double day = 2 * M_PI * (t % DAY_MS) / DAY_MS;
+	double h = (t % DAY_MS) / 3600000.0;
+
+	switch (ch)
+	{
+	case 0:
+		return (int32_t) (2200 - 300 * cos(day)) + noise(2);
+	case 1:
+		return (int32_t) (4500 + 1000 * cos(day)) + noise(20);
+	case 2:
+		return 101325 - (int32_t) (t / 43200) + noise(3);		// -2 hPa per day
+	case 3:
+		return (h < 7 || h > 19) ? noise(1) + 1 : (int32_t) (50000 * sin((h - 7) * M_PI / 12)) + noise(250);
+	case 4:
+		return ((h > 8 && h < 12) || (h > 13 && h < 17)) ? 1100 + noise(10) : 450 + noise(10);
+	case 5:
+		return 1200 + noise(30);
+	default:
+		return 87;
+	}
+}
+
+/*
+ * @brief one day of the cycles
+ * @param mask - sensors of the power tier
+ * @param expWakeups - wakeups per day
+ * @param maxRecordsH - max. flash records per hour
+ */
+static void simulate(uint8_t mask, uint32_t expWakeups, uint32_t maxRecordsH)
+{
+	cadenceItem_t items[SENS_NBR] = { };
+	deltaReporter_t history;
+	uint32_t reads[SENS_NBR] = { }, onMS[SENS_NBR] = { }, onAllMS = 0, onCadMS = 0;
+	uint32_t now = 0, wakeups = 0, fullCycles = 0, records = 0, sinceFull = 0, maxSinceFull = 0;
+	int32_t stored[CH_NBR];
+	uint8_t chMask = 0x40, slowest = 1;
+
+	for (int i = 0; i < SENS_NBR; i++)
+	{
+		items[i].Interval = INTERVAL_MS * _sens[i].cadence;
+		if (!(mask & (1 << i)))
+			continue;
+		chMask |= _sens[i].chMask;
+		slowest = (_sens[i].cadence > slowest) ? _sens[i].cadence : slowest;
+		onAllMS += DAY_MS / INTERVAL_MS * _sens[i].onMS;
+	}
+	deltaReporter_Inic(&history, CH_NBR, 0);
+	setBands(&history);
+	for (int ch = 0; ch < CH_NBR; ch++)
+		stored[ch] = NO_VALUE;
+	srand(42);
+	printf("tier 0x%02X:\n", mask);
+	while (now < DAY_MS)
+	{
+		uint32_t due = cadence_Take(items, SENS_NBR, mask, now, SENS_COALESCE_MS), cycleMS = 500, delay;
+		uint8_t dueCh = 0x40;
+
+		wakeups++;
+		for (int i = 0; i < SENS_NBR; i++)
+		{
+			if (!(due & (1 << i)))
+				continue;
+			reads[i]++;
+			onMS[i] += _sens[i].onMS;
+			onCadMS += _sens[i].onMS;
+			dueCh |= _sens[i].chMask;
+			if (_sens[i].onMS + 500 > cycleMS)
+				cycleMS = _sens[i].onMS + 500;
+		}
+		// sensors_Summary
+		for (int ch = 0; ch < CH_NBR; ch++)
+			if (dueCh & (1 << ch))
+				deltaReporter_SetValue(&history, ch, channel(ch, now));
+		if (due == mask)
+			fullCycles++;
+		if (due == mask || deltaReporter_IsReport(&history))
+		{
+			records++;
+			for (int ch = 0; ch < CH_NBR; ch++)
+				stored[ch] = (history.ValidMask & (1 << ch)) ? history.Value[ch] : NO_VALUE;
+			deltaReporter_Reported(&history);
+		}
+		sinceFull = (due == mask) ? 0 : sinceFull + 1;
+		maxSinceFull = (sinceFull > maxSinceFull) ? sinceFull : maxSinceFull;
+		// the history of the flash against the last values of the channels
+		for (int ch = 0; ch < CH_NBR; ch++)
+		{
+			const deltaBand_t *band = &history.Band[ch];
+			int64_t err = llabs((int64_t) history.Value[ch] - stored[ch]);
+			int64_t tol = band->AbsDelta;
+
+			if (!(chMask & (1 << ch)))
+				continue;
+			if ((int64_t) llabs(stored[ch]) * band->RelDelta / 1000 > tol)
+				tol = (int64_t) llabs(stored[ch]) * band->RelDelta / 1000;
+			if (stored[ch] == NO_VALUE || err > tol)
+			{
+				CHECK(stored[ch] != NO_VALUE && err <= tol);
+				return;
+			}
+		}
+		// sensors_NextDelay from the end of the cycle
+		now += cycleMS;
+		delay = cadence_NextDelay(items, SENS_NBR, mask, now);
+		if (delay == UINT32_MAX)
+			delay = INTERVAL_MS;
+		now += (delay < SENS_WAKEUP_MIN_MS) ? SENS_WAKEUP_MIN_MS : delay;
+	}
+	printf("sensor     reads/h  on-time (s/h)\n");
+	for (int i = 0; i < SENS_NBR; i++)
+	{
+		if (!(mask & (1 << i)))
+			continue;
+		printf("%-10s %7.1f  %6.1f\n", _sens[i].name, reads[i] / 24.0, onMS[i] / 24000.0);
+		// one read per cadence, no extra cycle for the deadline of each sensor
+		CHECK(reads[i] >= DAY_MS / items[i].Interval - 1 && reads[i] <= DAY_MS / items[i].Interval + 1);
+	}
+	printf("wakeups/h %.1f, on-time %.0f s/h (all sensors every interval %.0f s/h), full cycles/h %.1f\n",
+		wakeups / 24.0, onCadMS / 24000.0, onAllMS / 24000.0, fullCycles / 24.0);
+	printf("flash records/h %.1f (every cycle %.1f), max. %lu cycles without the full cycle\n", records / 24.0,
+		wakeups / 24.0, (unsigned long) maxSinceFull);
+	CHECK(wakeups <= expWakeups + 1);
+	CHECK(onCadMS < onAllMS);
+	CHECK(records >= fullCycles);
+	CHECK(records <= maxRecordsH * 24);
+	CHECK(maxSinceFull < slowest);
+}
+
+int main(void)
+{
+	simulate(0x1F, 24 * 120, 8);	// the barometer every cycle
+	simulate(0x18, 24 * 12, 6);	// SPS30 coalesced with SCD41
+	simulate(0x07, 24 * 120, 62);	// tier 2
+	return TEST_RESULT();
+}
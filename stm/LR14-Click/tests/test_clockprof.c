@@ -0,0 +1,238 @@
+/*
+ * test_clockprof.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * clock profiles (user-048), clockprof.c with pwrdomain.c and i2c.c on stub/periph.c (MSI, voltage scale, SPI, UART)
+ * - the transitions FULL, MID, LOW in all orders: the scale 1 before the higher clock, the scale 2 after the lower
+ *   one (no SYSCLK over 16 MHz in the scale 2), the switch refused during TX/RX of the radio, the failed MSI
+ *   switch keeps the profile, the same profile does not switch, FULL after STOP2 (clockProf_OnWake)
+ * - clockProf_Retime of the ready domains: TIMINGR of I2C2 for the new PCLK1 with the speed capped by the profile
+ *   (kept lower after the return to FULL, sensors_Bus sets the speed of the device), the finest SPI prescaler
+ *   up to CLOCK_SPI_MAX_HZ, BRR of the UART baud rate; the domains that are not ready are not touched
+ * - the energy model of the work in the profiles (run current of RM0461/DS13105 by the range and SYSCLK, I2C speed
+ *   of the profile and the pull-ups, the busy waits of HAL_Delay, the switches): the sensor step (LOW, sensors_Work),
+ *   the NFC interrupt (MID, sensors_NFCInt) and the crypto of the uplink (FULL)
+ */
+
+#include "test.h"
+#include "i2c_stub.h"
+#include "spi.h"
+#include "usart.h"
+#include "radio.h"
+#include "clockprof.h"
+#include "pwrdomain.h"
+
+#define BAUD			115200
+#define DEVICE_HZ		1000000	// SHT4x, ST25DV (fast mode plus)
+
+static RadioState_t _radio = RF_IDLE;
+static uint32_t _traceClock = 0;
+
+static RadioState_t radioStatus(void)
+{
+	return _radio;
+}
+
+const struct Radio_s Radio = { .GetStatus = radioStatus };
+
+void trace_Clock(void)
+{
+	_traceClock++;
+}
+
+/*
+ * @brief the timings of the ready peripherals match the clock
+ */
+static void checkTimings(uint32_t sysHz, uint32_t i2cMaxHz)
+{
+	uint32_t br = (hspi1.Instance->CR1 & SPI_CR1_BR) >> SPI_CR1_BR_Pos;
+	uint32_t i2cHz = I2C_GetSpeed(&hi2c2);
+	uint32_t baud = sysHz / huart1.Instance->BRR;
+
+	CHECK_EQ(SystemCoreClock, sysHz);
+	CHECK_EQ(clockProf_I2CMaxHz(), i2cMaxHz);
+	CHECK(i2cHz > 0 && i2cHz <= i2cMaxHz);
+	CHECK_EQ(hi2c2.Instance->TIMINGR, hi2c2.Init.Timing);
+	// the finest prescaler within the max. SPI clock
+	CHECK((sysHz >> (br + 1)) <= CLOCK_SPI_MAX_HZ);
+	CHECK(br == 0 || (sysHz >> br) > CLOCK_SPI_MAX_HZ);
+	CHECK_EQ(hspi1.Init.BaudRatePrescaler, br << SPI_CR1_BR_Pos);
+	// baud rate within 2 %, UART enabled again
+	CHECK(baud * 100 >= BAUD * 98 && baud * 100 <= BAUD * 102);
+	CHECK(huart1.Instance->CR1 & USART_CR1_UE);
+}
+
+static void testTransitions(void)
+{
+	static const clockProfile_t order[] = { CLOCK_MID, CLOCK_LOW, CLOCK_FULL, CLOCK_LOW, CLOCK_MID, CLOCK_FULL, CLOCK_MID,
+		CLOCK_MID, CLOCK_LOW, CLOCK_LOW, CLOCK_FULL };
+	static const uint32_t sysHz[CLOCK_NBR] = { 48000000, 16000000, 4000000 };
+	static const uint32_t maxHz[CLOCK_NBR] = { 1000000, 400000, 100000 };
+	clockProfile_t prev = CLOCK_FULL;
+	uint32_t switches = 0;
+
+	stub_I2CReset();
+	pwrDomain_Init(0);
+	clockProf_Init();
+	CHECK_EQ(clockProf_Get(), CLOCK_FULL);
+	pwrDomain_Acquire(PWR_DOMAIN_I2C2);
+	pwrDomain_Acquire(PWR_DOMAIN_SPI1);
+	pwrDomain_Acquire(PWR_DOMAIN_USART1);
+	huart1.Instance->CR1 |= USART_CR1_UE;
+	// sensors_Bus
+	CHECK_EQ(I2C_SetSpeed(&hi2c2, DEVICE_HZ), HAL_OK);
+	checkTimings(48000000, 1000000);
+	CHECK(I2C_GetSpeed(&hi2c2) > 900000);
+	for (unsigned i = 0; i < sizeof(order) / sizeof(order[0]); i++)
+	{
+		clockProfile_t p = order[i];
+
+		CHECK_EQ(clockProf_Set(p), prev);
+		CHECK_EQ(clockProf_Get(), p);
+		switches += (p != prev);
+		CHECK_EQ(stub_Periph.ClockSwitches, switches);
+		CHECK_EQ(_traceClock, switches);
+		CHECK_EQ(stub_Periph.Scale, (p == CLOCK_FULL) ? PWR_REGULATOR_VOLTAGE_SCALE1 : PWR_REGULATOR_VOLTAGE_SCALE2);
+		checkTimings(sysHz[p], maxHz[p]);
+		prev = p;
+	}
+	CHECK_EQ(stub_Periph.ScaleFaults, 0);
+	// the speed capped by LOW is kept at FULL (retimed for 48 MHz), the device speed is set by the caller
+	CHECK(I2C_GetSpeed(&hi2c2) <= 100000 && I2C_GetSpeed(&hi2c2) > 90000);
+	I2C_SetSpeed(&hi2c2, (DEVICE_HZ > clockProf_I2CMaxHz()) ? clockProf_I2CMaxHz() : DEVICE_HZ);
+	CHECK(I2C_GetSpeed(&hi2c2) > 900000);
+}
+
+static void testRefused(void)
+{
+	uint32_t switches = stub_Periph.ClockSwitches, timing;
+
+	// TX/RX of the radio
+	CHECK_EQ(clockProf_Get(), CLOCK_FULL);
+	_radio = RF_TX_RUNNING;
+	CHECK_EQ(clockProf_Set(CLOCK_LOW), CLOCK_FULL);
+	CHECK_EQ(clockProf_Get(), CLOCK_FULL);
+	_radio = RF_RX_RUNNING;
+	CHECK_EQ(clockProf_Set(CLOCK_MID), CLOCK_FULL);
+	CHECK_EQ(clockProf_Get(), CLOCK_FULL);
+	CHECK_EQ(stub_Periph.ClockSwitches, switches);
+	// the lower profile is left for the radio
+	_radio = RF_IDLE;
+	CHECK_EQ(clockProf_Set(CLOCK_LOW), CLOCK_FULL);
+	_radio = RF_TX_RUNNING;
+	CHECK_EQ(clockProf_Set(CLOCK_LOW), CLOCK_LOW);
+	CHECK_EQ(clockProf_Get(), CLOCK_FULL);
+	_radio = RF_IDLE;
+	// the failed MSI switch, the timings are not touched
+	timing = hi2c2.Init.Timing;
+	stub_Periph.OscFail = 1;
+	CHECK_EQ(clockProf_Set(CLOCK_MID), CLOCK_FULL);
+	CHECK_EQ(clockProf_Get(), CLOCK_FULL);
+	CHECK_EQ(SystemCoreClock, 48000000);
+	CHECK_EQ(hi2c2.Init.Timing, timing);
+	stub_Periph.OscFail = 0;
+	CHECK_EQ(stub_Periph.ScaleFaults, 0);
+}
+
+static void testWake(void)
+{
+	uint32_t switches, prescaler;
+
+	// STOP2 in LOW, the domains are gated
+	clockProf_Set(CLOCK_LOW);
+	pwrDomain_OnStop();
+	prescaler = hspi1.Init.BaudRatePrescaler;
+	// SystemClock_Config after the wakeup, the profile is FULL without the switch
+	SystemCoreClock = 48000000;
+	stub_Pclk1Hz = 48000000;
+	stub_Periph.Scale = PWR_REGULATOR_VOLTAGE_SCALE1;
+	switches = stub_Periph.ClockSwitches;
+	clockProf_OnWake();
+	CHECK_EQ(clockProf_Get(), CLOCK_FULL);
+	CHECK_EQ(stub_Periph.ClockSwitches, switches);
+	// the domains that are not ready are not retimed by the switch, the lazy init retimes them
+	clockProf_Set(CLOCK_MID);
+	CHECK_EQ(hspi1.Init.BaudRatePrescaler, prescaler);
+	pwrDomain_OnWake();
+	pwrDomain_Acquire(PWR_DOMAIN_SPI1);
+	CHECK_EQ(hspi1.Init.BaudRatePrescaler, 1 << SPI_CR1_BR_Pos);
+	pwrDomain_Release(PWR_DOMAIN_SPI1);
+	clockProf_Set(CLOCK_FULL);
+	CHECK_EQ(stub_Periph.ScaleFaults, 0);
+}
+
+/*
+ * workload_t - the work done in one profile
+ */
+typedef struct
+{
+	const char *name;
+	clockProfile_t profile;		// the profile of the firmware
+	uint32_t cycles;			// CPU
+	uint32_t i2cBytes;			// at DEVICE_HZ capped by the profile
+	uint32_t spiBytes;			// flash
+	uint32_t waitUs;			// HAL_Delay (busy)
+} workload_t;
+
+/*
+ * @brief energy (uJ) of the work in the profile at 3 V
+ */
+static double energy(const workload_t *w, clockProfile_t p, double *ms)
+{
+	static const double sysHz[CLOCK_NBR] = { 48e6, 16e6, 4e6 };
+	static const double runMA[CLOCK_NBR] = { 3.5, 1.14, 0.36 };	// run from flash, range 1 / 2
+	static const double i2cHz[CLOCK_NBR] = { 1e6, 4e5, 1e5 };
+	static const double spiHz[CLOCK_NBR] = { 6e6, 4e6, 2e6 };
+	const double pullUpMA = 0.64;	// 2 x 4.7 kohm at 3 V, the lines low half of the time
+	const double switchUs = 2 * 50;	// MSI and the regulator (VOSF) there and back, at the FULL current
+	double i2cHzDev = (DEVICE_HZ < i2cHz[p]) ? DEVICE_HZ : i2cHz[p];
+	double i2cS = w->i2cBytes * 9 / i2cHzDev;
+	double s = w->cycles / sysHz[p] + i2cS + w->spiBytes * 8 / spiHz[p] + w->waitUs / 1e6;
+	double uj = 3.0 * (runMA[p] * s + pullUpMA * i2cS) * 1000;
+
+	if (p != CLOCK_FULL)
+		uj += 3.0 * runMA[CLOCK_FULL] * switchUs / 1000;
+	*ms = s * 1000;
+	return uj;
+}
+
+static void testEnergy(void)
+{
+	static const workload_t work[] = {
+		// conversion wait of SHT4x (10 ms), 40 B of the readings, the statistics and the log
+		{ "sensor step", CLOCK_LOW, 50000, 40, 0, 10000 },
+		// IT_STS, MB_CTRL, DATA frame of 247 B to the mailbox, 15 records of the flash
+		{ "nfc frame", CLOCK_MID, 20000, 260, 240, 0 },
+		// AES-CMAC and the encryption of the uplink, LoRaMac
+		{ "uplink", CLOCK_FULL, 200000, 0, 0, 0 },
+	};
+
+	printf("work          FULL uJ (ms)     MID uJ (ms)      LOW uJ (ms)\n");
+	for (unsigned i = 0; i < sizeof(work) / sizeof(work[0]); i++)
+	{
+		const workload_t *w = &work[i];
+		double uj[CLOCK_NBR], ms[CLOCK_NBR], best = 1e9;
+
+		printf("%-12s", w->name);
+		for (int p = 0; p < CLOCK_NBR; p++)
+		{
+			uj[p] = energy(w, p, &ms[p]);
+			best = (uj[p] < best) ? uj[p] : best;
+			printf("  %6.1f (%5.1f)", uj[p], ms[p]);
+		}
+		printf("  -> %s\n", (w->profile == CLOCK_FULL) ? "FULL" : (w->profile == CLOCK_MID) ? "MID" : "LOW");
+		// the profile of the firmware is within 5 % of the best one
+		CHECK(uj[w->profile] <= best * 1.05);
+	}
+}
+
+int main(void)
+{
+	testTransitions();
+	testRefused();
+	testWake();
+	testEnergy();
+	return TEST_RESULT();
+}
@@ -0,0 +1,274 @@
+/*
+ * test_config.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * remote configuration by downlink (user-039), lora_config.c with the sensors and the flash stubbed by the test
+ * - valid TLVs: applied to the sensors, stored once (no erase of the unchanged page), the TX period callback,
+ *   the acknowledge with the counter and the current configuration
+ * - unknown tags, truncated lengths, the trailing byte, out-of-range values and more than 8 TLVs: the bitmap
+ *   of the rejected commands, the accepted commands are applied
+ * - the configuration refused by sensors_SetConfig: the previous configuration stays, all commands are
+ *   reported rejected, nothing is stored
+ * - the persistence over the reboot, the Adler-32 check against the reference, the corrupted, the foreign
+ *   and the refused stored configuration fall back to the defaults
+ */
+
+#include <string.h>
+#include "test.h"
+#include "lora_config.h"
+#include "mysensors.h"
+#include "flash_if.h"
+
+#define CFG_ADDRESS		0x0803E800UL	// lora_config.c
+#define CFG_SIZE		24
+#define FLASH_PAGE		2048
+#define TX_DEFAULT		600000
+
+static uint8_t _flash[FLASH_PAGE];
+static uint32_t _flashWrites = 0;
+static sensConfig_t _sens = { 60000, 1000, 10, 0x1F };
+static sensConfig_t _sensDefault = { 60000, 1000, 10, 0x1F };
+static uint32_t _sensSets = 0;
+static uint8_t _sensReject = 0;		// sensors_SetConfig fails
+static uint32_t _txChanged = 0;		// the last loraConfig_OnTxPeriodChanged, 0 - not called
+
+void sensors_GetConfig(sensConfig_t *cfg)
+{
+	*cfg = _sens;
+}
+
+HAL_StatusTypeDef sensors_SetConfig(const sensConfig_t *cfg)
+{
+	_sensSets++;
+	if (_sensReject)
+		return HAL_ERROR;
+	_sens = *cfg;
+	return HAL_OK;
+}
+
+FLASH_IF_StatusTypedef FLASH_IF_Read(void *pDestination, const void *pSource, uint32_t uLength)
+{
+	memcpy(pDestination, &_flash[(uintptr_t) pSource - CFG_ADDRESS], uLength);
+	return FLASH_IF_OK;
+}
+
+FLASH_IF_StatusTypedef FLASH_IF_Write(void *pDestination, const void *pSource, uint32_t uLength)
+{
+	memset(_flash, 0xFF, sizeof(_flash));	// the page is erased
+	memcpy(&_flash[(uintptr_t) pDestination - CFG_ADDRESS], pSource, uLength);
+	_flashWrites++;
+	return FLASH_IF_OK;
+}
+
+void loraConfig_OnTxPeriodChanged(uint32_t txPeriod)
+{
+	_txChanged = txPeriod;
+}
+
+/*
+ * @brief the boot with the compiled configuration of the sensors
+ */
+static void boot(void)
+{
+	_sens = _sensDefault;
+	_sensSets = 0;
+	_flashWrites = 0;
+	_txChanged = 0;
+	loraConfig_Init(TX_DEFAULT);
+	loraConfig_Acked();
+}
+
+static HAL_StatusTypeDef process(const uint8_t *data, uint8_t size, uint8_t *rejected)
+{
+	uint8_t ack[32];
+	HAL_StatusTypeDef status;
+
+	_flashWrites = 0;
+	_txChanged = 0;
+	status = loraConfig_Process(data, size, 0x1234);
+	CHECK(loraConfig_IsAckPending());
+	CHECK_EQ(loraConfig_GetAck(ack, sizeof(ack)), 4 + 3 * 4 + 2 * 3);
+	CHECK_EQ(ack[0], CFG_TAG_ACK);
+	CHECK_EQ(ack[2], 0x34);
+	*rejected = ack[3];
+	loraConfig_Acked();
+	CHECK(!loraConfig_IsAckPending());
+	return status;
+}
+
+/*
+ * @brief Adler-32 (RFC 1950) of the items before the check
+ */
+static uint32_t adler32(const uint8_t *p, uint32_t len)
+{
+	uint32_t a = 1, b = 0;
+
+	while (len-- > 0)
+	{
+		a = (a + *p++) % 65521;
+		b = (b + a) % 65521;
+	}
+	return (b << 16) | a;
+}
+
+static void testValid(void)
+{
+	static const uint8_t cmd[] = { CFG_TAG_TX_PERIOD, 2, 0x2C, 0x01, CFG_TAG_INTERVAL, 2, 0x58, 0x02,
+		CFG_TAG_READ_PAUSE, 2, 0xF4, 0x01, CFG_TAG_READING_MAX, 1, 5, CFG_TAG_ENABLED, 1, 0x07 };
+	uint8_t ack[32], rejected;
+
+	memset(_flash, 0xFF, sizeof(_flash));
+	boot();
+	CHECK_EQ(loraConfig_GetTxPeriod(), TX_DEFAULT);
+	CHECK_EQ(_sensSets, 0);
+	CHECK(!loraConfig_IsAckPending());
+	CHECK_EQ(loraConfig_GetAck(ack, sizeof(ack)), 0);
+
+	CHECK_EQ(process(cmd, sizeof(cmd), &rejected), HAL_OK);
+	CHECK_EQ(rejected, 0);
+	CHECK_EQ(loraConfig_GetTxPeriod(), 300000);
+	CHECK_EQ(_txChanged, 300000);
+	CHECK_EQ(_sens.interval, 600000);
+	CHECK_EQ(_sens.readPause, 500);
+	CHECK_EQ(_sens.readingMax, 5);
+	CHECK_EQ(_sens.enabled, 0x07);
+	CHECK_EQ(_flashWrites, 1);
+	// the acknowledge carries the current configuration
+	loraConfig_Process(cmd, 0, 7);
+	CHECK_EQ(loraConfig_GetAck(ack, 3), 0);
+	CHECK_EQ(loraConfig_GetAck(ack, 4), 4);
+	CHECK_EQ(loraConfig_GetAck(ack, sizeof(ack)), 4 + sizeof(cmd));
+	CHECK(memcmp(&ack[4], cmd, sizeof(cmd)) == 0);
+	loraConfig_Acked();
+	// the same configuration again: not stored, the TX timer is not touched
+	CHECK_EQ(process(cmd, sizeof(cmd), &rejected), HAL_OK);
+	CHECK_EQ(_flashWrites, 0);
+	CHECK_EQ(_txChanged, 0);
+}
+
+static void testRejected(void)
+{
+	static const uint8_t unknown[] = { CFG_TAG_READING_MAX, 1, 7, 0x33, 1, 0, CFG_TAG_ENABLED, 1, 0x03 };
+	static const uint8_t truncated[] = { CFG_TAG_READING_MAX, 1, 8, CFG_TAG_TX_PERIOD, 5, 0x10, 0x00 };
+	static const uint8_t trailing[] = { CFG_TAG_READING_MAX, 1, 9, CFG_TAG_ENABLED };
+	static const uint8_t range[] = { CFG_TAG_TX_PERIOD, 2, 9, 0, CFG_TAG_INTERVAL, 2, 9, 0, CFG_TAG_READ_PAUSE, 2, 99, 0,
+		CFG_TAG_READ_PAUSE, 2, 0x61, 0xEA, CFG_TAG_READING_MAX, 1, 0, CFG_TAG_READING_MAX, 1, 61,
+		CFG_TAG_ENABLED, 2, 1, 0, CFG_TAG_DEFAULT, 1, 0 };
+	static const uint8_t many[] = { CFG_TAG_READING_MAX, 1, 3, CFG_TAG_READING_MAX, 1, 3, CFG_TAG_READING_MAX, 1, 3,
+		CFG_TAG_READING_MAX, 1, 3, CFG_TAG_READING_MAX, 1, 3, CFG_TAG_READING_MAX, 1, 3, CFG_TAG_READING_MAX, 1, 3,
+		CFG_TAG_READING_MAX, 1, 3, CFG_TAG_READING_MAX, 1, 0, CFG_TAG_READING_MAX, 1, 4 };
+	uint8_t rejected;
+
+	CHECK_EQ(process(unknown, sizeof(unknown), &rejected), HAL_ERROR);
+	CHECK_EQ(rejected, 0x02);
+	CHECK_EQ(_sens.readingMax, 7);
+	CHECK_EQ(_sens.enabled, 0x03);
+	CHECK_EQ(process(truncated, sizeof(truncated), &rejected), HAL_ERROR);
+	CHECK_EQ(rejected, 0x02);
+	CHECK_EQ(_sens.readingMax, 8);
+	CHECK_EQ(loraConfig_GetTxPeriod(), 300000);
+	CHECK_EQ(process(trailing, sizeof(trailing), &rejected), HAL_ERROR);
+	CHECK_EQ(rejected, 0x02);
+	CHECK_EQ(_sens.readingMax, 9);
+	_flashWrites = 0;
+	CHECK_EQ(process(range, sizeof(range), &rejected), HAL_ERROR);
+	CHECK_EQ(rejected, 0xFF);
+	CHECK_EQ(_flashWrites, 0);
+	CHECK_EQ(loraConfig_GetTxPeriod(), 300000);
+	CHECK_EQ(_sens.interval, 600000);
+	CHECK_EQ(_sens.readPause, 500);
+	CHECK_EQ(_sens.readingMax, 9);
+	CHECK_EQ(process(many, sizeof(many), &rejected), HAL_ERROR);
+	CHECK_EQ(rejected, 0x80);
+	CHECK_EQ(_sens.readingMax, 4);
+}
+
+static void testSensorsRefuse(void)
+{
+	static const uint8_t cmd[] = { CFG_TAG_TX_PERIOD, 2, 0x78, 0x00, CFG_TAG_READING_MAX, 1, 12, 0x33, 0 };
+	uint8_t stored[CFG_SIZE], rejected;
+
+	memcpy(stored, _flash, sizeof(stored));
+	_sensReject = 1;
+	CHECK_EQ(process(cmd, sizeof(cmd), &rejected), HAL_ERROR);
+	_sensReject = 0;
+	CHECK_EQ(rejected, 0x07);
+	CHECK_EQ(loraConfig_GetTxPeriod(), 300000);
+	CHECK_EQ(_txChanged, 0);
+	CHECK_EQ(_flashWrites, 0);
+	CHECK(memcmp(stored, _flash, sizeof(stored)) == 0);
+	// the acknowledge reports the previous configuration
+	{
+		uint8_t ack[32];
+
+		loraConfig_Process(cmd, 0, 0);
+		CHECK_EQ(loraConfig_GetAck(ack, sizeof(ack)), 22);
+		CHECK_EQ(ack[4 + 2] | (ack[4 + 3] << 8), 300);
+		CHECK_EQ(ack[4 + 14], 4);
+		loraConfig_Acked();
+	}
+}
+
+static void testPersistence(void)
+{
+	static const uint8_t def[] = { CFG_TAG_DEFAULT, 0 };
+	uint32_t check;
+	uint8_t rejected;
+
+	// the reboot: the stored configuration is applied
+	boot();
+	CHECK_EQ(loraConfig_GetTxPeriod(), 300000);
+	CHECK_EQ(_sensSets, 1);
+	CHECK_EQ(_sens.interval, 600000);
+	CHECK_EQ(_sens.readingMax, 4);
+	CHECK_EQ(_flash[0] | (_flash[1] << 8), 0xC0F1);
+	CHECK_EQ(_flash[2], 1);
+	memcpy(&check, &_flash[16], sizeof(check));
+	CHECK_EQ(check, adler32(_flash, 16));
+	// the corrupted item
+	_flash[5] ^= 0x01;
+	boot();
+	CHECK_EQ(loraConfig_GetTxPeriod(), TX_DEFAULT);
+	CHECK_EQ(_sensSets, 0);
+	_flash[5] ^= 0x01;
+	// the corrupted check
+	_flash[17] ^= 0x80;
+	boot();
+	CHECK_EQ(loraConfig_GetTxPeriod(), TX_DEFAULT);
+	_flash[17] ^= 0x80;
+	// the other version
+	_flash[2] = 2;
+	boot();
+	CHECK_EQ(loraConfig_GetTxPeriod(), TX_DEFAULT);
+	_flash[2] = 1;
+	// refused by the sensors at the boot
+	_sensReject = 1;
+	boot();
+	_sensReject = 0;
+	CHECK_EQ(_sensSets, 1);
+	CHECK_EQ(loraConfig_GetTxPeriod(), TX_DEFAULT);
+	CHECK_EQ(_sens.interval, _sensDefault.interval);
+	boot();
+	CHECK_EQ(loraConfig_GetTxPeriod(), 300000);
+	// the default configuration is restored and stored
+	CHECK_EQ(process(def, sizeof(def), &rejected), HAL_OK);
+	CHECK_EQ(loraConfig_GetTxPeriod(), TX_DEFAULT);
+	CHECK_EQ(_txChanged, TX_DEFAULT);
+	CHECK_EQ(_sens.interval, _sensDefault.interval);
+	CHECK_EQ(_sens.readingMax, _sensDefault.readingMax);
+	CHECK_EQ(_flashWrites, 1);
+	boot();
+	CHECK_EQ(loraConfig_GetTxPeriod(), TX_DEFAULT);
+	CHECK_EQ(_sensSets, 1);
+}
+
+int main(void)
+{
+	testValid();
+	testRejected();
+	testSensorsRefuse();
+	testPersistence();
+	return TEST_RESULT();
+}
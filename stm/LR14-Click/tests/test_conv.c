@@ -0,0 +1,180 @@
+/*
+ * test_conv.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * early finish of the reading cycle (user-031), convDetector_t with the parameters of _sensOps (mysensors.c)
+ * on the modelled warm-up curves of the sensors
+ * - the reading every readPause (3 s) up to readingMax (10), the sensor is off at the settled reading
+ * - the warm-up: the self-heating of SHT4x, the auto-range of the ambient light, the drift of the barometer,
+ *   the first measurements of SCD41 and the fan spin-up of SPS30, with the noise of the datasheets
+ * - the saved on-time against the fixed readingMax readings, the max. error of the reported value (the mean
+ *   of the valid readings of the cycle, sensors_Summary) and of the last reading against the settled value;
+ *   the readings within latencyMS are not reported (SCD41 and SPS30 reported 2 .. 3 of them before)
+ * - the detector: the warm-up, the window, the max. time, the restart
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include "test.h"
+#include "stm32wlxx_hal.h"
+#include "utils/utils.h"
+
+#define READ_PAUSE		3000	// mysensors.c
+#define READING_MAX		10
+#define CYCLES			500
+
+/*
+ * convSensor_t - _sensOps of the sensor and its warm-up: value(t) = final + offset * exp(-t / tau) + noise
+ */
+typedef struct
+{
+	const char *name;
+	uint16_t latencyMS;
+	uint16_t settleMaxMS;
+	int32_t slopeMax, varMax;
+	int32_t final;		// settled value (units of channel)
+	int32_t offset;		// at the start of the sensor
+	uint32_t tauMS;
+	int32_t noise;		// max. amplitude
+	int32_t errMax;		// max. accepted error of the reported value (within the accuracy of the sensor)
+} convSensor_t;
+
+static const convSensor_t _sensors[] = {
+	// 25 °C x100, +0.6 °C of the heater at start, ±0.02 °C
+	{ "temphum", 1000, 0, 5, 25, 2500, 60, 2000, 2, 10 },
+	// 500 lux x100, the first integration at the low gain -60 %, ±0.5 %
+	{ "ambient", 1000, 0, 500, 250000, 50000, -30000, 400, 250, 1000 },
+	// 101325 Pa, +0.4 hPa of the warm-up, ±0.03 hPa
+	{ "barometer", 1000, 0, 10, 100, 101325, 40, 3000, 3, 10 },
+	// 800 ppm, +150 ppm of the first measurements, ±10 ppm, accuracy ±(50 ppm + 5 %)
+	{ "scd41", 10000, 0, 20, 400, 800, 150, 8000, 10, 50 },
+	// 12 ug/m3 x100, -60 % of the fan spin-up, ±0.3 ug/m3
+	{ "sps30", 8000, 24000, 50, 2500, 1200, -720, 6000, 30, 150 },
+};
+
+static int32_t value(const convSensor_t *s, uint32_t t)
+{
+	double v = s->final + s->offset * exp(-(double) t / s->tauMS);
+
+	return (int32_t) v + (rand() % (2 * s->noise + 1)) - s->noise;
+}
+
+static int32_t maxErr(int32_t max, int32_t err)
+{
+	return (abs(err) > max) ? abs(err) : max;
+}
+
+static void testSensors(void)
+{
+	uint64_t onAll = 0, fullAll = 0;
+
+	printf("sensor     on-time (s) saved   error: mean of cycle (max) last (max)  full cycle: mean (max)\n");
+	srand(31);
+	for (unsigned i = 0; i < sizeof(_sensors) / sizeof(_sensors[0]); i++)
+	{
+		const convSensor_t *s = &_sensors[i];
+		convDetector_t conv;
+		uint64_t on = 0;
+		int32_t errMean = 0, errLast = 0, errFull = 0;
+
+		stub_Tick = 0;
+		convDetector_Inic(&conv, s->latencyMS, s->settleMaxMS, s->slopeMax, s->varMax);
+		for (int c = 0; c < CYCLES; c++)
+		{
+			uint32_t start = stub_Tick, off = 0;
+			int64_t sum = 0, sumFull = 0;
+			int32_t last = 0, n = 0, nFull = 0;
+
+			convDetector_Start(&conv);
+			for (int r = 1; r <= READING_MAX; r++)
+			{
+				int32_t v;
+
+				stub_Tick = start + r * READ_PAUSE;
+				v = value(s, stub_Tick - start);
+				// the readings within the warm-up are not valid (sensors_AddSample)
+				if (stub_Tick - start > s->latencyMS)
+				{
+					sumFull += v;
+					nFull++;
+				}
+				if (off != 0)
+					continue;
+				// sensors_Read, sensors_CheckSettled
+				if (convDetector_IsWarm(&conv))
+				{
+					sum += v;
+					n++;
+				}
+				last = v;
+				if (convDetector_Add(&conv, v))
+					off = stub_Tick - start;
+			}
+			if (off == 0)
+				off = READING_MAX * READ_PAUSE;
+			on += off;
+			errMean = maxErr(errMean, (int32_t) (sum / n) - s->final);
+			errLast = maxErr(errLast, last - s->final);
+			errFull = maxErr(errFull, (int32_t) (sumFull / nFull) - s->final);
+			stub_Tick = start + 60000;
+		}
+		printf("%-10s %5.1f / %4.1f %4.0f %%  %18ld %12ld  %16ld\n", s->name, on / (double) CYCLES / 1000,
+			READING_MAX * READ_PAUSE / 1000.0, 100 - on * 100.0 / ((uint64_t) CYCLES * READING_MAX * READ_PAUSE),
+			(long) errMean, (long) errLast, (long) errFull);
+		onAll += on;
+		fullAll += (uint64_t) CYCLES * READING_MAX * READ_PAUSE;
+		CHECK(on < (uint64_t) CYCLES * READING_MAX * READ_PAUSE);
+		CHECK(errMean <= s->errMax);
+		CHECK(errLast <= s->errMax);
+	}
+	printf("on-time of all sensors: %.0f %% saved\n", 100 - onAll * 100.0 / fullAll);
+	CHECK(onAll * 2 < fullAll);
+}
+
+static void testDetector(void)
+{
+	convDetector_t conv;
+
+	stub_Tick = 0;
+	convDetector_Inic(&conv, 1000, 5000, 5, 25);
+	// the stable readings within the warm-up
+	CHECK(!convDetector_Add(&conv, 100));
+	CHECK(!convDetector_Add(&conv, 100));
+	CHECK(!convDetector_Add(&conv, 100));
+	stub_Tick = 1001;
+	CHECK(convDetector_Add(&conv, 100));
+	// the slope over the window
+	convDetector_Start(&conv);
+	stub_Tick += 2000;
+	CHECK(!convDetector_Add(&conv, 100));
+	CHECK(!convDetector_Add(&conv, 106));
+	CHECK(!convDetector_Add(&conv, 112));
+	CHECK(convDetector_Add(&conv, 114));	// 106, 112, 114: slope 4, variance 17
+	CHECK(convDetector_IsSettled(&conv));
+	// the variance
+	convDetector_Start(&conv);
+	stub_Tick += 2000;
+	convDetector_Add(&conv, 100);
+	convDetector_Add(&conv, 110);
+	CHECK(!convDetector_Add(&conv, 100));	// variance 33
+	// the max. time
+	stub_Tick += 5000;
+	CHECK(convDetector_IsSettled(&conv));
+	CHECK(convDetector_Add(&conv, 200));
+	// no max. time
+	convDetector_Inic(&conv, 0, 0, 5, 25);
+	for (int i = 0; i < 10; i++)
+	{
+		stub_Tick += 100000;
+		CHECK(!convDetector_Add(&conv, (i & 1) ? 0 : 1000));
+	}
+}
+
+int main(void)
+{
+	testDetector();
+	testSensors();
+	return TEST_RESULT();
+}
@@ -0,0 +1,238 @@
+/*
+ * test_delta.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * send-on-delta reporting (user-029), replay of the channel values through deltaReporter_t
+ * - the deadbands and the heartbeat of sensors_Init, one value per reading cycle (statAgg mean)
+ * - the receiver keeps the last reported value: the reconstruction error must stay within the deadband
+ * - without the argument a synthetic week is replayed (30 s cycles: diurnal temperature/humidity/light,
+ *   pressure front, office CO2, PM2.5 events, battery), with the argument the device log is replayed:
+ *   the summary lines "t:base+offset ... chN:min/mean/max ..." of sensors_Summary
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+#include "main.h"
+#include "utils/utils.h"
+
+#define CH_NBR			7		// SENS_CH_NBR
+#define CYCLE_MS		30000
+#define HEARTBEAT_MS	3600000	// _reportHeartbeat
+#define TS_RESOLUTION	250		// SENS_TS_RESOLUTION
+
+static const char *_chName[CH_NBR] = { "temp", "hum", "pressure", "lux", "co2", "pm25", "bat" };
+static const deltaBand_t _bands[CH_NBR] = { { 20, 0 }, { 200, 0 }, { 50, 0 }, { 1000, 100 }, { 50, 50 }, { 200, 100 }, { 5, 0 } };
+
+typedef struct
+{
+	deltaReporter_t rep;
+	int32_t received[CH_NBR];	// last value at the receiver
+	int32_t maxError[CH_NBR];
+	int32_t maxRel[CH_NBR];		// max. error in 1/1000 of the received value
+	uint32_t cycles;
+	uint32_t uplinks;
+	int fails;
+} replay_t;
+
+static void replayInic(replay_t *r)
+{
+	memset(r, 0, sizeof(*r));
+	stub_Tick = 0;
+	deltaReporter_Inic(&r->rep, CH_NBR, HEARTBEAT_MS);
+	for (int i = 0; i < CH_NBR; i++)
+		deltaReporter_SetBand(&r->rep, i, _bands[i].AbsDelta, _bands[i].RelDelta);
+}
+
+/*
+ * @brief one reading cycle, valid - bitmap of the channels with the value
+ */
+static void replayCycle(replay_t *r, const int32_t *value, uint16_t valid)
+{
+	for (int i = 0; i < CH_NBR; i++)
+		if (valid & (1 << i))
+			deltaReporter_SetValue(&r->rep, i, value[i]);
+		else
+			deltaReporter_Invalidate(&r->rep, i);
+	r->cycles++;
+	if (deltaReporter_IsReport(&r->rep))
+	{
+		r->uplinks++;
+		deltaReporter_Reported(&r->rep);
+		for (int i = 0; i < CH_NBR; i++)
+			if (valid & (1 << i))
+				r->received[i] = value[i];
+	}
+	// error of the value at the receiver against the deadband
+	for (int i = 0; i < CH_NBR; i++)
+	{
+		if (!(valid & (1 << i)))
+			continue;
+		int64_t err = llabs((int64_t) value[i] - r->received[i]);
+		int64_t ref = llabs((int64_t) r->received[i]);
+
+		if (err > r->maxError[i])
+			r->maxError[i] = (int32_t) err;
+		if (ref != 0 && err * 1000 / ref > r->maxRel[i])
+			r->maxRel[i] = (int32_t) (err * 1000 / ref);
+		if (err > _bands[i].AbsDelta && err * 1000 > ref * _bands[i].RelDelta)
+			r->fails++;
+	}
+}
+
+static void replayPrint(const replay_t *r, const char *name)
+{
+	printf("%s: %lu cycles, %lu uplinks, saved %.1f %%\n", name, (unsigned long) r->cycles, (unsigned long) r->uplinks,
+		100.0 * (r->cycles - r->uplinks) / r->cycles);
+	for (int i = 0; i < CH_NBR; i++)
+		printf("  %-8s max. error %ld, %ld/1000 (band %ld, %u/1000)\n", _chName[i], (long) r->maxError[i], (long) r->maxRel[i],
+			(long) _bands[i].AbsDelta, _bands[i].RelDelta);
+}
+
+static double noise(void)
+{
+	return (rand() / (double) RAND_MAX - 0.5) * 2.0;
+}
+
+/*
+ * @brief synthetic week, the values as logged (x100, CO2 ppm, battery %)
+ */
+static void replaySynthetic(replay_t *r)
+{
+	const uint32_t cycles = 7 * 24 * 3600 / (CYCLE_MS / 1000);
+	int32_t v[CH_NBR];
+	double pm = 800;
+
+	srand(29);
+	for (uint32_t c = 0; c < cycles; c++)
+	{
+		double h = fmod(c * (CYCLE_MS / 1000.0) / 3600.0, 24.0), day = c * (CYCLE_MS / 1000.0) / 86400.0;
+		double sun = (h > 6 && h < 20) ? sin((h - 6) / 14 * M_PI) : 0;
+		int office = (h > 8 && h < 17) && fmod(day, 7) < 5;
+
+		v[0] = (int32_t) (2100 + 250 * sin((h - 9) / 24 * 2 * M_PI) + 3 * noise());
+		v[1] = (int32_t) (4500 - 800 * sin((h - 9) / 24 * 2 * M_PI) + 20 * noise());
+		v[2] = (int32_t) (101300 - 900 * exp(-pow((day - 3.5) * 2, 2)) + 4 * noise());
+		v[3] = (int32_t) (sun * 4000000 * (0.8 + 0.2 * sin(c / 80.0)) * (1 + 0.01 * noise()) + 5000 + 200 * noise());	// clouds
+		v[4] = (int32_t) ((office ? 900 + 200 * sin(h) : 450) + 8 * noise());
+		pm = pm * 0.995 + (rand() % 2000 == 0 ? 3000 : 800 * 0.005) + 20 * noise();
+		v[5] = (int32_t) pm;
+		v[6] = (int32_t) (95 - 10 * day / 7);
+		replayCycle(r, v, (c % 1000 == 999) ? 0x7F & ~(1 << 4) : 0x7F);	// CO2 sensor sometimes missing
+		stub_Tick += CYCLE_MS;
+	}
+}
+
+/*
+ * @brief device log, the summary lines of sensors_Summary
+ */
+static int replayLog(replay_t *r, const char *path)
+{
+	FILE *f = fopen(path, "r");
+	char line[512];
+
+	if (f == NULL)
+		return 0;
+	while (fgets(line, sizeof(line), f))
+	{
+		int32_t v[CH_NBR];
+		uint16_t valid = 0;
+		unsigned long base;
+		unsigned off;
+		char *p;
+
+		for (p = strstr(line, "ch"); p != NULL; p = strstr(p + 2, "ch"))
+		{
+			int ch, mn, mean, mx;
+
+			if (sscanf(p, "ch%d:%d/%d/%d", &ch, &mn, &mean, &mx) == 4 && ch >= 0 && ch < CH_NBR)
+			{
+				v[ch] = mean;
+				valid |= 1 << ch;
+			}
+		}
+		if (valid == 0)
+			continue;
+		p = strstr(line, "t:");
+		if (p != NULL && sscanf(p, "t:%lu+%u", &base, &off) == 2)
+			stub_Tick = (uint32_t) (base * 1000 + off * TS_RESOLUTION);
+		else
+			stub_Tick += CYCLE_MS;
+		replayCycle(r, v, valid);
+	}
+	fclose(f);
+	return 1;
+}
+
+static void testRules(void)
+{
+	deltaReporter_t d;
+
+	stub_Tick = 0;
+	deltaReporter_Inic(&d, 3, 1000);
+	deltaReporter_SetBand(&d, 0, 10, 0);
+	deltaReporter_SetBand(&d, 1, 0, 100);	// 10 %
+	deltaReporter_SetBand(&d, 2, 5, 100);	// 10 %, min. 5
+	CHECK(!deltaReporter_IsReport(&d));		// no value yet
+	deltaReporter_SetValue(&d, 0, 100);
+	CHECK(deltaReporter_IsReport(&d));		// new channel
+	deltaReporter_Reported(&d);
+	deltaReporter_SetValue(&d, 0, 110);
+	CHECK(!deltaReporter_IsReport(&d));		// within the band
+	deltaReporter_SetValue(&d, 0, 111);
+	CHECK(deltaReporter_IsReport(&d));
+	deltaReporter_Reported(&d);
+	deltaReporter_SetValue(&d, 1, -1000);
+	CHECK(deltaReporter_IsReport(&d));
+	deltaReporter_Reported(&d);
+	deltaReporter_SetValue(&d, 1, -1100);
+	CHECK(!deltaReporter_IsReport(&d));		// relative band of the negative value
+	deltaReporter_SetValue(&d, 1, -1101);
+	CHECK(deltaReporter_IsReport(&d));
+	deltaReporter_Reported(&d);
+	deltaReporter_SetValue(&d, 2, 20);
+	deltaReporter_Reported(&d);
+	deltaReporter_SetValue(&d, 2, 25);
+	CHECK(!deltaReporter_IsReport(&d));		// the absolute floor near zero
+	deltaReporter_SetValue(&d, 2, 26);
+	CHECK(deltaReporter_IsReport(&d));
+	deltaReporter_SetValue(&d, 2, 1000);
+	deltaReporter_Reported(&d);
+	deltaReporter_SetValue(&d, 2, 1100);
+	CHECK(!deltaReporter_IsReport(&d));		// the relative band of the large value
+	deltaReporter_SetValue(&d, 2, 1101);
+	CHECK(deltaReporter_IsReport(&d));
+	deltaReporter_Reported(&d);
+	deltaReporter_Invalidate(&d, 2);
+	deltaReporter_Invalidate(&d, 1);		// missing sensor is not compared
+	CHECK(!deltaReporter_IsReport(&d));
+	stub_Tick += 1001;
+	CHECK(deltaReporter_IsReport(&d));		// heartbeat
+	deltaReporter_Reported(&d);
+	CHECK(!deltaReporter_IsReport(&d));
+	deltaReporter_SetValue(&d, 1, -1101);	// back, new channel again
+	CHECK(deltaReporter_IsReport(&d));
+}
+
+int main(int argc, char **argv)
+{
+	static replay_t r;
+
+	testRules();
+	replayInic(&r);
+	replaySynthetic(&r);
+	replayPrint(&r, "synthetic week");
+	CHECK_EQ(r.fails, 0);
+	CHECK(r.uplinks * 10 < r.cycles);
+	if (argc > 1)
+	{
+		replayInic(&r);
+		CHECK(replayLog(&r, argv[1]));
+		replayPrint(&r, argv[1]);
+		CHECK_EQ(r.fails, 0);
+	}
+	return TEST_RESULT();
+}
@@ -0,0 +1,155 @@
+/*
+ * test_drift.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * RTC drift estimation from DeviceTimeAns with CALR calibration (user-037), driftEst_t with the constants
+ * and the CALR quantization of timesync.c
+ * - 30 days of the LSE with the drift +23.4 / -41.7 / +5.2 ppm, the daily variation +-2 ppm (temperature),
+ *   the latency jitter of the correction +-30 ms: the count of syncs against the hourly sync, the error of the estimate,
+ *   the max. time error of the timestamps
+ * - the step of the drift (the device moved to the cold), the interval is shortened and the error is recovered
+ * - the short interval is ignored, the interval grows max. 2x per sync
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include "test.h"
+#include "utils/utils.h"
+
+// timesync.c
+#define TSYNC_INTERVAL_MIN		3600000
+#define TSYNC_INTERVAL_MAX		604800000
+#define TSYNC_MAX_ERROR			1000
+#define TSYNC_CALIB_PULSES		1048576
+
+#define STEP_MS					60000
+#define JITTER_MS				30
+
+typedef struct
+{
+	uint32_t syncs;
+	double maxErrorMS;		// max. |time error| over the run
+	double lastErrorMS;		// max. |time error| of the last week
+	int32_t ppm;			// last estimate
+} driftResult_t;
+
+/*
+ * @brief CALR of timeSync_SetCalib, read back by timeSync_GetCalib (ppm x 100)
+ */
+static int32_t calibQuant(int32_t ppm)
+{
+	int32_t pulses = (int32_t) (((int64_t) ppm * TSYNC_CALIB_PULSES + (ppm >= 0 ? 50000000 : -50000000)) / 100000000);
+
+	if (pulses > 512)
+		pulses = 512;
+	if (pulses < -511)
+		pulses = -511;
+	return (int32_t) (((int64_t) pulses * 100000000) / TSYNC_CALIB_PULSES);
+}
+
+/*
+ * @brief the days of the LSE
+ * @param ppm - drift (ppm, + the RTC is slow), step - the change of the drift at the half of the run
+ */
+static driftResult_t simulate(double ppm, double step, uint32_t days, driftEst_t *d)
+{
+	driftResult_t r = { };
+	double error = 0;		// network time - local time (ms)
+	int32_t applied = 0;	// CALR (ppm x 100)
+	uint32_t elapsed = 0;
+
+	driftEst_Inic(d, TSYNC_INTERVAL_MIN, TSYNC_INTERVAL_MAX, TSYNC_MAX_ERROR);
+	for (uint64_t t = 0; t < days * 86400000ULL; t += STEP_MS)
+	{
+		double now = ppm + 2 * sin(2 * M_PI * t / 86400000.0) + ((t >= days * 43200000ULL) ? step : 0);
+
+		error += STEP_MS * (now - applied / 100.0) * 1e-6;
+		elapsed += STEP_MS;
+		if (fabs(error) > r.maxErrorMS)
+			r.maxErrorMS = fabs(error);
+		if (t >= (days - 7) * 86400000ULL && fabs(error) > r.lastErrorMS)
+			r.lastErrorMS = fabs(error);
+		if (elapsed >= d->Interval)
+		{
+			// DeviceTimeAns: the network time with the latency jitter, SysTime is set to it
+			double jitter = (rand() % (2 * JITTER_MS + 1)) - JITTER_MS;
+
+			if (driftEst_Add(d, elapsed, (int32_t) lround(error + jitter), applied))
+				applied = calibQuant(d->Ppm);
+			error = -jitter;
+			elapsed = 0;
+			r.syncs++;
+		}
+	}
+	r.ppm = d->Ppm;
+	return r;
+}
+
+static void testDrift(void)
+{
+	static const double drifts[] = { 23.4, -41.7, 5.2 };
+	driftEst_t d;
+
+	srand(37);
+	for (unsigned i = 0; i < sizeof(drifts) / sizeof(drifts[0]); i++)
+	{
+		driftResult_t r = simulate(drifts[i], 0, 30, &d);
+
+		printf("drift %+5.1f ppm +-2: %2lu syncs in 30 days (720 hourly), estimate %+6.2f ppm, next interval %3lu h, "
+			"max. error %4.0f ms\n", drifts[i], (unsigned long) r.syncs, r.ppm / 100.0, (unsigned long) (d.Interval / 3600000),
+			r.maxErrorMS);
+		CHECK(r.syncs <= 20);
+		CHECK(fabs(r.ppm / 100.0 - drifts[i]) < 1.0);
+		CHECK(r.maxErrorMS < 1.5 * TSYNC_MAX_ERROR);
+		// without the calibration: the error of one week
+		CHECK(fabs(drifts[i]) * 1e-6 * TSYNC_INTERVAL_MAX > 2 * TSYNC_MAX_ERROR);
+	}
+}
+
+static void testStep(void)
+{
+	driftEst_t d;
+	driftResult_t r;
+
+	srand(37);
+	r = simulate(23.4, -15, 60, &d);	// 23.4 -> 8.4 ppm after 30 days
+	printf("drift +23.4 -> +8.4 ppm at the day 30: %lu syncs in 60 days, estimate %+.2f ppm, max. error %.0f ms, "
+		"last week %.0f ms\n", (unsigned long) r.syncs, r.ppm / 100.0, r.maxErrorMS, r.lastErrorMS);
+	CHECK(fabs(r.ppm / 100.0 - 8.4) < 1.0);
+	CHECK(r.lastErrorMS < 1.5 * TSYNC_MAX_ERROR);
+	CHECK(r.syncs <= 40);
+}
+
+static void testInterval(void)
+{
+	driftEst_t d;
+
+	driftEst_Inic(&d, TSYNC_INTERVAL_MIN, TSYNC_INTERVAL_MAX, TSYNC_MAX_ERROR);
+	CHECK_EQ(d.Interval, TSYNC_INTERVAL_MIN);
+	// the jitter of the short interval is not used
+	CHECK(!driftEst_Add(&d, TSYNC_INTERVAL_MIN / 2 - 1, 500, 0));
+	CHECK_EQ(d.Count, 0);
+	// 1 h, 36 ms: 10 ppm
+	CHECK(driftEst_Add(&d, 3600000, 36, 0));
+	CHECK_EQ(d.Ppm, 1000);
+	CHECK_EQ(d.Interval, 2 * TSYNC_INTERVAL_MIN);	// max. 2x, 1000 ms / 10 ppm = 27.8 h
+	// the perfect calibration: the interval doubles up to the max.
+	for (int i = 0; i < 10; i++)
+		driftEst_Add(&d, d.Interval, 0, 1000);
+	CHECK_EQ(d.Interval, TSYNC_INTERVAL_MAX);
+	CHECK_EQ(d.Ppm, 1000);
+	// the slow clock is corrected by the plus pulses, the range of CALR
+	CHECK(calibQuant(1000) > 950 && calibQuant(1000) < 1050);
+	CHECK_EQ(calibQuant(100000), 512 * 100000000LL / TSYNC_CALIB_PULSES);
+	CHECK_EQ(calibQuant(-100000), -511 * 100000000LL / TSYNC_CALIB_PULSES);
+}
+
+int main(void)
+{
+	testInterval();
+	testDrift();
+	testStep();
+	return TEST_RESULT();
+}
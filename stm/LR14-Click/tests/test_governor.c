@@ -0,0 +1,176 @@
+/*
+ * test_governor.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * battery-aware sampling governor (user-040), host simulation of the discharge
+ * - batGovernor_t with the tiers of mysensors.c, the SCD41 limit of sensors_Govern
+ * - 2 x AA alkaline (2500 mAh) behind the Schottky diode (3 V fresh, README), the voltage by the depth of discharge,
+ *   the sag of the internal resistance under the load of the reading and the night cold, measured once per hour,
+ *   self-discharge 3 % per year
+ * - the load: the sensors of the tier (powerUA, on time and cadence of _sensOps), MCU, uplinks (period x Scale)
+ * - the lifetime to 2.1 V with the governor and without it (all sensors, tier 0), the tier changes with and
+ *   without the hysteresis
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include "test.h"
+#include "utils/utils.h"
+
+// mysensors.h
+#define SENS_GOV_TIER1_MV	2800
+#define SENS_GOV_TIER2_MV	2600
+#define SENS_GOV_TIER3_MV	2400
+#define SENS_GOV_HYST_MV	100
+#define SENS_SCD41_MIN_MV	2700
+
+#define SENS_NBR			5
+#define SENS_SCD41			3
+#define INTERVAL_S			30		// _sensorTimeout
+#define TX_PERIOD_S			300
+#define CAPACITY_MAH		2500.0
+#define END_MV				2100	// brown-out of the radio during TX
+#define DIODE_MV			250
+#define R_INT				1.2		// ohm, 2 cells
+
+static const govTier_t _tiers[] = {
+	{ 0, 0x1F, 1 },
+	{ SENS_GOV_TIER1_MV, 0x0F, 2 },
+	{ SENS_GOV_TIER2_MV, 0x07, 4 },
+	{ SENS_GOV_TIER3_MV, 0x01, 8 }
+};
+
+// _sensOps: consumption, on time of the reading (warm-up + readings), cadence
+static const struct
+{
+	double mA;
+	double onS;
+	int cadence;
+} _sens[SENS_NBR] = { { 0.3, 4, 2 }, { 0.3, 4, 2 }, { 0.02, 4, 1 }, { 15, 13, 10 }, { 60, 27, 30 } };
+
+/*
+ * @brief the open-circuit voltage of the alkaline cell by the depth of discharge
+ */
+static double cellV(double dod)
+{
+	static const double v[] = { 1.60, 1.45, 1.38, 1.33, 1.29, 1.26, 1.22, 1.18, 1.13, 1.07, 1.00 };
+	int i = (int) (dod * 10);
+
+	if (i >= 10)
+		return v[10];
+	return v[i] + (v[i + 1] - v[i]) * (dod * 10 - i);
+}
+
+/*
+ * @brief mean current (mA) of the sensors, the MCU and the radio
+ */
+static double loadMA(uint8_t enabled, uint8_t scale)
+{
+	double ma = 0.05;	// STOP2 with RTC, the sensors in sleep/idle (SPS30 sleep 38 uA), regulator
+
+	for (int i = 0; i < SENS_NBR; i++)
+		if (enabled & (1 << i))
+			ma += _sens[i].mA * _sens[i].onS / (INTERVAL_S * scale * _sens[i].cadence);
+	ma += 3.0 * 0.2 / (INTERVAL_S * scale);		// MCU run, 200 ms per cycle
+	ma += (40.0 * 0.06 + 5.0 * 0.02) / (TX_PERIOD_S * scale);	// TX 60 ms at 14 dBm, two RX windows
+	return ma;
+}
+
+typedef struct
+{
+	double days;
+	uint32_t changes;		// tier changes
+	double tierDays[4];
+	double mAh[SENS_NBR];	// the charge of the sensors
+	uint32_t readings[SENS_NBR];
+} simResult_t;
+
+static simResult_t simulate(int governed, uint16_t hystMV)
+{
+	simResult_t r = { };
+	batGovernor_t gov;
+	double used = 0;
+
+	srand(40);
+	batGovernor_Inic(&gov, _tiers, 4, hystMV);
+	for (uint32_t h = 0;; h++)
+	{
+		const govTier_t *tier = batGovernor_Get(&gov);
+		uint8_t enabled = governed ? tier->Enabled : 0x1F;
+		uint8_t scale = governed ? tier->Scale : 1;
+		double dod = used / CAPACITY_MAH;
+		double night = -40 * cos((h % 24) / 24.0 * 2 * M_PI);	// mV, cold at midnight
+		double ocv = 2 * cellV(dod) * 1000 - DIODE_MV + night;
+		double ma = loadMA(enabled, scale);
+		// the voltage is measured during the reading (sensors on), ADC noise
+		uint16_t mV = (uint16_t) (ocv - R_INT * (10 + ((enabled & (1 << 4)) ? 60 : 0)) + (rand() % 21 - 10));
+
+		if (mV < END_MV || h > 24 * 3650)
+			break;
+		if (governed)
+		{
+			// sensors_Govern
+			r.changes += batGovernor_Update(&gov, mV);
+			tier = batGovernor_Get(&gov);
+			enabled = tier->Enabled;
+			if (mV < SENS_SCD41_MIN_MV)
+				enabled &= ~(1 << SENS_SCD41);
+			scale = tier->Scale;
+			ma = loadMA(enabled, scale);
+			r.tierDays[gov.Tier] += 1 / 24.0;
+		}
+		for (int i = 0; i < SENS_NBR; i++)
+			if (enabled & (1 << i))
+			{
+				r.mAh[i] += _sens[i].mA * _sens[i].onS / (INTERVAL_S * scale * _sens[i].cadence);
+				r.readings[i] += 3600 / (INTERVAL_S * scale * _sens[i].cadence);
+			}
+		used += ma + CAPACITY_MAH * 0.03 / (365 * 24);	// self-discharge 3 % per year
+		r.days = h / 24.0;
+	}
+	return r;
+}
+
+static void testHysteresis(void)
+{
+	batGovernor_t gov;
+
+	batGovernor_Inic(&gov, _tiers, 4, SENS_GOV_HYST_MV);
+	CHECK(!batGovernor_Update(&gov, 2950));
+	CHECK_EQ(batGovernor_Get(&gov)->Scale, 1);
+	CHECK(batGovernor_Update(&gov, 2799));
+	CHECK_EQ(gov.Tier, 1);
+	CHECK(!batGovernor_Update(&gov, 2899));		// within the hysteresis
+	CHECK(batGovernor_Update(&gov, 2900));
+	CHECK_EQ(gov.Tier, 0);
+	CHECK(batGovernor_Update(&gov, 2300));		// the fall over more tiers at once
+	CHECK_EQ(gov.Tier, 3);
+	CHECK_EQ(batGovernor_Get(&gov)->Enabled, 0x01);
+	CHECK(batGovernor_Update(&gov, 2750));		// the recovery (new battery) over more tiers
+	CHECK_EQ(gov.Tier, 1);
+}
+
+int main(void)
+{
+	static const char *names[SENS_NBR] = { "temphum", "ambient", "baro", "scd41", "sps30" };
+	simResult_t fixed, gov, noHyst;
+
+	testHysteresis();
+	fixed = simulate(0, SENS_GOV_HYST_MV);
+	gov = simulate(1, SENS_GOV_HYST_MV);
+	noHyst = simulate(1, 0);
+	printf("lifetime to %d mV: fixed %.1f days, governed %.1f days (x%.2f)\n", END_MV, fixed.days, gov.days, gov.days / fixed.days);
+	printf("governed: tier days %.1f / %.1f / %.1f / %.1f, %lu tier changes (%lu without hysteresis)\n", gov.tierDays[0],
+		gov.tierDays[1], gov.tierDays[2], gov.tierDays[3], (unsigned long) gov.changes, (unsigned long) noHyst.changes);
+	for (int i = 0; i < SENS_NBR; i++)
+		printf("  %-8s readings fixed %7lu, governed %7lu, charge %6.0f / %6.0f mAh\n", names[i], (unsigned long) fixed.readings[i],
+			(unsigned long) gov.readings[i], fixed.mAh[i], gov.mAh[i]);
+	CHECK(gov.days > fixed.days * 1.5);
+	CHECK(gov.changes < noHyst.changes);
+	CHECK(gov.changes <= 2 * 3 + 6);	// tiers are passed in order, a few returns by the night cold
+	// the sensors of the lower tiers are read longer
+	CHECK(gov.readings[0] > fixed.readings[0]);
+	return TEST_RESULT();
+}
@@ -0,0 +1,126 @@
+/*
+ * test_i2crecovery.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * I2C bus recovery (user-033), I2C_BusRecovery and I2C_IsDeviceReadyMT of i2c.c on the stubbed lines of I2C2
+ * - SDA held low by the slave, released after 1 .. 9 SCL pulses: HAL_OK, the pulses stop at the release,
+ *   the STOP condition, the peripheral initialized again, the device ready by the second try
+ * - SDA never released: HAL_ERROR after 9 pulses and STOP, the peripheral initialized, no second try
+ * - the latency bounded by the half periods of SCL (I2C_RecoveryPause after each write of the lines)
+ * - the recovery counter per device address: the free bus is not counted, 8 addresses, the saturation
+ */
+
+#include "test.h"
+#include "i2c_stub.h"
+
+#define RECOVERY_PULSES		9	// i2c.c
+#define RECOVERY_HALF_US	5	// I2C_RecoveryPause
+#define RECOVERY_WRITES		(1 + 2 * RECOVERY_PULSES + 4)	// released lines, pulses, STOP
+#define DEV_ADDR			0x88
+
+static void busInit(void)
+{
+	stub_I2CReset();
+	MX_I2C2_Init();
+	stub_I2CAdd(DEV_ADDR, 1);
+}
+
+static void testReleased(void)
+{
+	uint32_t worst = 0;
+
+	for (uint16_t n = 1; n <= RECOVERY_PULSES; n++)
+	{
+		uint32_t us;
+
+		busInit();
+		stub_I2CBus.SdaHeld = n;
+		CHECK_EQ(HAL_I2C_IsDeviceReady(&hi2c2, DEV_ADDR, 1, 10), HAL_BUSY);
+		CHECK_EQ(I2C_BusRecovery(&hi2c2), HAL_OK);
+		CHECK_EQ(stub_I2CBus.SdaHeld, 0);
+		CHECK_EQ(stub_I2CBus.SclPulses, n + 1);	// + SCL of STOP
+		CHECK_EQ(stub_I2CBus.Stops, 1);
+		CHECK_EQ(hi2c2.State, HAL_I2C_STATE_READY);
+		CHECK(hi2c2.Instance->CR1 & I2C_CR1_PE);
+		CHECK_EQ(hi2c2.Instance->TIMINGR, hi2c2.Init.Timing);
+		CHECK(stub_I2CBus.PinWrites <= RECOVERY_WRITES);
+		us = (stub_I2CBus.PinWrites + 1) * RECOVERY_HALF_US;
+		worst = (us > worst) ? us : worst;
+		// the device behind the recovered bus
+		CHECK_EQ(HAL_I2C_IsDeviceReady(&hi2c2, DEV_ADDR, 1, 10), HAL_OK);
+	}
+	printf("recovery of the released SDA: max. %lu us\n", (unsigned long) worst);
+	CHECK(worst <= (RECOVERY_WRITES + 1) * RECOVERY_HALF_US);
+	// the free bus, no pulses
+	busInit();
+	CHECK_EQ(I2C_BusRecovery(&hi2c2), HAL_OK);
+	CHECK_EQ(stub_I2CBus.SclPulses, 1);
+	CHECK_EQ(stub_I2CBus.Stops, 1);
+}
+
+static void testStuck(void)
+{
+	busInit();
+	stub_I2CBus.SdaHeld = STUB_I2C_SDA_STUCK;
+	CHECK_EQ(I2C_BusRecovery(&hi2c2), HAL_ERROR);
+	CHECK_EQ(stub_I2CBus.SclPulses, RECOVERY_PULSES + 1);
+	CHECK_EQ(stub_I2CBus.Stops, 0);		// SDA is low
+	CHECK_EQ(stub_I2CBus.PinWrites, RECOVERY_WRITES);
+	printf("recovery of the stuck SDA: %lu us\n", (unsigned long) ((stub_I2CBus.PinWrites + 1) * RECOVERY_HALF_US));
+	// the peripheral is initialized anyway, the next transfer reports the busy bus again
+	CHECK_EQ(hi2c2.State, HAL_I2C_STATE_READY);
+	CHECK(hi2c2.Instance->CR1 & I2C_CR1_PE);
+	stub_I2CBus.PinWrites = 0;
+	stub_I2CTransfers = 0;
+	CHECK_EQ(I2C_IsDeviceReadyMT(&hi2c2, DEV_ADDR, 1, 10), HAL_BUSY);
+	CHECK_EQ(stub_I2CBus.PinWrites, RECOVERY_WRITES);	// one recovery, no retry loop
+	CHECK_EQ(stub_I2CTransfers, 0);
+	CHECK_EQ(I2C_GetRecoveryCount(DEV_ADDR), 1);
+	// released later, 10 pulses are not enough, the STOP clocks once more
+	stub_I2CBus.SdaHeld = RECOVERY_PULSES + 2;
+	CHECK_EQ(I2C_BusRecovery(&hi2c2), HAL_ERROR);
+	CHECK_EQ(stub_I2CBus.SdaHeld, 1);
+}
+
+static void testCounter(void)
+{
+	busInit();
+	for (uint16_t a = 0x10; a <= 0x20; a += 2)
+		CHECK_EQ(I2C_GetRecoveryCount(a), 0);
+	// the free bus
+	CHECK_EQ(I2C_IsDeviceReadyMT(&hi2c2, DEV_ADDR, 1, 10), HAL_OK);
+	CHECK_EQ(stub_I2CBus.SclPulses, 0);
+	CHECK_EQ(I2C_GetRecoveryCount(DEV_ADDR), 1);	// testStuck
+	// the recovered bus, the device answers the second try
+	stub_I2CBus.SdaHeld = 3;
+	CHECK_EQ(I2C_IsDeviceReadyMT(&hi2c2, DEV_ADDR, 1, 10), HAL_OK);
+	CHECK_EQ(I2C_GetRecoveryCount(DEV_ADDR), 2);
+	// 7 more addresses fill the table, the next is not tracked
+	for (uint16_t a = 0x10; a <= 0x20; a += 2)
+	{
+		stub_I2CBus.SdaHeld = 1;
+		CHECK_EQ(I2C_IsDeviceReadyMT(&hi2c2, a, 1, 10), HAL_ERROR);	// absent device
+	}
+	for (uint16_t a = 0x10; a <= 0x1C; a += 2)
+		CHECK_EQ(I2C_GetRecoveryCount(a), 1);
+	CHECK_EQ(I2C_GetRecoveryCount(0x1E), 0);
+	CHECK_EQ(I2C_GetRecoveryCount(0x20), 0);
+	CHECK_EQ(I2C_GetRecoveryCount(DEV_ADDR), 2);
+	// the saturation
+	for (uint32_t i = 0; i < 70000; i++)
+	{
+		stub_I2CBus.SdaHeld = 1;
+		I2C_IsDeviceReadyMT(&hi2c2, DEV_ADDR, 1, 10);
+	}
+	CHECK_EQ(I2C_GetRecoveryCount(DEV_ADDR), UINT16_MAX);
+}
+
+int main(void)
+{
+	testReleased();
+	testStuck();
+	testCounter();
+	return TEST_RESULT();
+}
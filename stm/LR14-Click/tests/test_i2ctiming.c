@@ -0,0 +1,244 @@
+/*
+ * test_i2ctiming.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * runtime TIMINGR calculator and the per-device bus speeds (user-049), i2cTiming_Calc and i2cTiming_SclHz of i2c.c
+ * - the reference values of RM0461 (I2C timing settings, 16 and 48 MHz) and of CubeMX (48 MHz): the computed
+ *   setting is within the requested SCL and not slower than 90 % of the reference (capped by the mode of the clock)
+ * - the sweep of the clocks of the profiles, the requested SCL, the rise times and the filters: the timings
+ *   of the bus are checked independently against the limits of the I2C specification and the min. kernel clock
+ * - I2C_SetSpeed and I2C_Retime on the stubbed peripheral: TIMINGR of the speed after the change of PCLK1,
+ *   the peripheral disabled while TIMINGR is written, no setting for 1 MHz
+ * - the bus time of one reading iteration of the sensors at 10 kHz (generated TIMINGR) and at the speed
+ *   of every device (board bus: tr 250 ns, tf 30 ns, analog filter)
+ */
+
+#include "test.h"
+#include "i2c.h"
+
+// i2c.c
+#define I2C_RISE_NS		250
+#define I2C_FALL_NS		30
+
+/*
+ * i2cSpec_t - the limits of the mode (ns), the min. kernel clock (Hz)
+ */
+typedef struct
+{
+	uint32_t maxHz;
+	uint32_t low, high, suDat, hdDat;
+	uint32_t minClk;
+} i2cSpec_t;
+
+static const i2cSpec_t _spec[] = {
+	{ 100000, 4700, 4000, 250, 3450, 2000000 },
+	{ 400000, 1300, 600, 100, 900, 9000000 },
+	{ 1000000, 500, 260, 50, 450, 19000000 },
+};
+
+/*
+ * @brief the timings of TIMINGR on the bus against the specification of the mode of sclHz
+ * @retval NULL - OK, the failed limit
+ */
+static const char* specCheck(const i2cTimingCfg_t *c, uint32_t sclHz, uint32_t t)
+{
+	const i2cSpec_t *m = &_spec[(sclHz <= 100000) ? 0 : (sclHz <= 400000) ? 1 : 2];
+	double clk = 1e9 / c->ClkHz, p = clk * ((t >> 28) + 1);
+	double scldel = (((t >> 20) & 15) + 1) * p, sdadel = ((t >> 16) & 15) * p;
+	double high = (((t >> 8) & 255) + 1) * p, low = ((t & 255) + 1) * p;
+	double af0 = c->AnalogFilter ? 50 : 0, af1 = c->AnalogFilter ? 260 : 0;
+
+	if (c->ClkHz < m->minClk)
+		return "I2CCLK under the min. of the mode";
+	// tLOW, tHIGH on the bus with the min. synchronization of SCL
+	low += c->FallNs + af0 + (c->DigitalFilter + 2) * clk;
+	high += c->RiseNs + af0 + (c->DigitalFilter + 2) * clk;
+	if (low < m->low - 0.01)
+		return "tLOW";
+	if (high < m->high - 0.01)
+		return "tHIGH";
+	if (scldel < c->RiseNs + m->suDat - 0.01)
+		return "SCLDEL";
+	if (sdadel < c->FallNs - af0 - (c->DigitalFilter + 3) * clk - 0.01)
+		return "SDADEL min.";
+	if (sdadel > 0 && sdadel > m->hdDat - c->RiseNs - af1 - (c->DigitalFilter + 4) * clk + 0.01)
+		return "SDADEL max.";
+	return NULL;
+}
+
+static void testReference(void)
+{
+	static const struct
+	{
+		const char *src;
+		uint32_t clk, hz, ref;
+	} refs[] = {
+		{ "RM", 16000000, 10000, 0x3042C3C7 },
+		{ "RM", 16000000, 100000, 0x30420F13 },
+		{ "RM", 16000000, 400000, 0x10320309 },
+		{ "RM", 16000000, 1000000, 0x00200204 },
+		{ "RM", 48000000, 10000, 0xB042C3C7 },
+		{ "RM", 48000000, 100000, 0xB0420F13 },
+		{ "RM", 48000000, 400000, 0x50330309 },
+		{ "RM", 48000000, 1000000, 0x50100103 },
+		{ "MX", 48000000, 100000, 0x20303E5D },
+		{ "MX", 48000000, 400000, 0x2010091A },
+		{ "MX", 48000000, 1000000, 0x20000209 },
+	};
+
+	for (unsigned i = 0; i < sizeof(refs) / sizeof(refs[0]); i++)
+	{
+		i2cTimingCfg_t c = { refs[i].clk, 100, 10, 1, 0 };	// tr, tf of the reference tables
+		uint32_t hz = refs[i].hz, t = i2cTiming_Calc(&c, &hz);
+		uint32_t refHz = i2cTiming_SclHz(&c, refs[i].ref);
+		uint32_t cap = (refs[i].clk >= 19000000) ? 1000000 : (refs[i].clk >= 9000000) ? 400000 : 100000;
+		uint32_t expect = (refHz < refs[i].hz) ? refHz : refs[i].hz;
+		const char *fail = specCheck(&c, hz, t);
+
+		if (expect > cap)
+			expect = cap;
+		printf("%s %2lu MHz %7lu Hz: ref 0x%08lX %7lu Hz, 0x%08lX %7lu Hz %s\n", refs[i].src,
+			(unsigned long) (refs[i].clk / 1000000), (unsigned long) refs[i].hz, (unsigned long) refs[i].ref,
+			(unsigned long) refHz, (unsigned long) t, (unsigned long) hz, (fail != NULL) ? fail : "");
+		CHECK(fail == NULL);
+		CHECK(hz <= refs[i].hz);
+		CHECK((uint64_t) hz * 100 >= (uint64_t) expect * 90);
+		CHECK_EQ(i2cTiming_SclHz(&c, t), hz);
+	}
+}
+
+static void testSweep(void)
+{
+	static const uint32_t clks[] = { 1000000, 4000000, 8000000, 16000000, 24000000, 32000000, 48000000 };
+	static const uint32_t reqs[] = { 10000, 50000, 100000, 200000, 400000, 700000, 1000000 };
+	static const uint16_t rises[] = { 20, 100, 250, 300, 1000 };
+	uint32_t cases = 0, none = 0, fails = 0;
+
+	for (unsigned a = 0; a < sizeof(clks) / sizeof(clks[0]); a++)
+		for (unsigned b = 0; b < sizeof(reqs) / sizeof(reqs[0]); b++)
+			for (unsigned r = 0; r < sizeof(rises) / sizeof(rises[0]); r++)
+				for (uint8_t af = 0; af < 2; af++)
+					for (uint8_t dnf = 0; dnf < 16; dnf += 5)
+					{
+						i2cTimingCfg_t c = { clks[a], rises[r], I2C_FALL_NS, af, dnf };
+						uint32_t hz = reqs[b], t;
+						const char *fail;
+
+						if (rises[r] > 300 && reqs[b] > 100000)
+							continue;	// out of the specification of Fm and Fm+
+						cases++;
+						t = i2cTiming_Calc(&c, &hz);
+						if (hz == 0)
+						{
+							none++;
+							CHECK(clks[a] < _spec[0].minClk);
+							continue;
+						}
+						fail = specCheck(&c, hz, t);
+						if (fail == NULL && (hz > reqs[b] || i2cTiming_SclHz(&c, t) != hz))
+							fail = "SCL";
+						if (fail != NULL)
+						{
+							fails++;
+							printf("%lu Hz of %lu Hz, tr %u ns, AF %u, DNF %u: 0x%08lX %s\n", (unsigned long) reqs[b],
+								(unsigned long) clks[a], rises[r], af, dnf, (unsigned long) t, fail);
+						}
+					}
+	printf("sweep: %lu cases, %lu without setting (1 MHz clock), %lu failed\n", (unsigned long) cases,
+		(unsigned long) none, (unsigned long) fails);
+	CHECK_EQ(fails, 0);
+	CHECK(none > 0);
+}
+
+/*
+ * i2cDevice_t - the bytes on the bus per reading iteration (presence, command and data with the addresses)
+ */
+typedef struct
+{
+	const char *name;
+	uint32_t maxHz;		// sensOps_t.i2cHz
+	uint32_t bytes;
+} i2cDevice_t;
+
+static const i2cDevice_t _devices[] = {
+	{ "SHT45", 1000000, 1 + 2 + 7 },
+	{ "TSL2591", 400000, 1 + 3 + 6 },
+	{ "ILPS22QS", 1000000, 1 + 3 + 7 },
+	{ "SCD41", 100000, 1 + 3 + 12 },
+	{ "SPS30", 100000, 1 + 3 + 64 },
+	{ "ST25DV", 1000000, 1 + 4 + 32 },	// the NDEF update
+};
+
+static void testBusTime(void)
+{
+	static const uint32_t clks[] = { 48000000, 16000000, 4000000 };	// CLOCK_HIGH, MID, LOW
+
+	for (unsigned a = 0; a < sizeof(clks) / sizeof(clks[0]); a++)
+	{
+		i2cTimingCfg_t c = { clks[a], I2C_RISE_NS, I2C_FALL_NS, 1, 0 };
+		double old = 0, fast = 0;
+
+		printf("%2lu MHz:", (unsigned long) (clks[a] / 1000000));
+		for (unsigned d = 0; d < sizeof(_devices) / sizeof(_devices[0]); d++)
+		{
+			uint32_t hz10k = 10000, hz = _devices[d].maxHz;
+
+			i2cTiming_Calc(&c, &hz10k);
+			i2cTiming_Calc(&c, &hz);
+			CHECK(hz > 0 && hz <= _devices[d].maxHz);
+			old += _devices[d].bytes * 9 * 1000.0 / hz10k;
+			fast += _devices[d].bytes * 9 * 1000.0 / hz;
+			printf(" %s %lu kHz", _devices[d].name, (unsigned long) (hz / 1000));
+		}
+		printf(", bus time %.1f ms at 10 kHz -> %.1f ms\n", old, fast);
+		CHECK(fast * 5 < old);	// the standard mode only at 4 MHz
+	}
+}
+
+static void testSetSpeed(void)
+{
+	i2cTimingCfg_t c = { 48000000, I2C_RISE_NS, I2C_FALL_NS, 1, 0 };
+	uint32_t hz = 1000000, t = i2cTiming_Calc(&c, &hz);
+
+	stub_Pclk1Hz = 48000000;
+	MX_I2C2_Init();
+	CHECK_EQ(hi2c2.State, HAL_I2C_STATE_READY);
+	CHECK_EQ(I2C_GetSpeed(&hi2c2), 0);	// generated TIMINGR
+	CHECK_EQ(I2C_SetSpeed(&hi2c2, 1000000), HAL_OK);
+	CHECK_EQ(hi2c2.Instance->TIMINGR, t);
+	CHECK_EQ(hi2c2.Instance->CR1 & I2C_CR1_PE, I2C_CR1_PE);
+	CHECK_EQ(I2C_GetSpeed(&hi2c2), hz);
+	// the clock profile: the same speed, TIMINGR of the new clock
+	stub_Pclk1Hz = 16000000;
+	c.ClkHz = 16000000;
+	hz = 1000000;
+	t = i2cTiming_Calc(&c, &hz);
+	CHECK_EQ(I2C_Retime(&hi2c2), HAL_OK);
+	CHECK_EQ(hi2c2.Instance->TIMINGR, t);
+	CHECK_EQ(I2C_GetSpeed(&hi2c2), hz);
+	CHECK(hz < 400000);
+	// the gated peripheral, TIMINGR is written by HAL_I2C_Init
+	HAL_I2C_DeInit(&hi2c2);
+	CHECK_EQ(I2C_SetSpeed(&hi2c2, 100000), HAL_OK);
+	CHECK(hi2c2.Instance->TIMINGR == t);
+	CHECK_EQ(HAL_I2C_Init(&hi2c2), HAL_OK);
+	CHECK(hi2c2.Instance->TIMINGR != t);
+	// no setting under 2 MHz
+	stub_Pclk1Hz = 1000000;
+	CHECK_EQ(I2C_Retime(&hi2c2), HAL_ERROR);
+	stub_Pclk1Hz = 48000000;
+	CHECK_EQ(I2C_Retime(&hi2c2), HAL_OK);
+	printf("I2C_SetSpeed: 1 MHz at 16 MHz PCLK1 %lu Hz, 100 kHz at 48 MHz %lu Hz\n",
+		(unsigned long) hz, (unsigned long) I2C_GetSpeed(&hi2c2));
+}
+
+int main(void)
+{
+	testReference();
+	testSweep();
+	testSetSpeed();
+	testBusTime();
+	return TEST_RESULT();
+}
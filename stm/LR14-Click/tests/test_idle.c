@@ -0,0 +1,197 @@
+/*
+ * test_idle.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * idle governor choosing awake, sleep or STOP2 from the next timer deadline (user-047), idleGov_t with the currents
+ * of sys_app.c in the energy model of the idle periods
+ * - timer traces of 1 h: the reading cycle (30 s, the waits of the sensor conversions, the flash page program),
+ *   the class A uplink (TX, RX1/RX2 windows, the radio IRQs), the LED, the idle without a deadline
+ * - the charge of the idle time by the governor, by always STOP2 (UTIL_LPM_EnterLowPower of ST), by always sleep
+ *   and by the oracle (the cheapest mode of every period), the missed deadlines (STOP2 longer than the idle time)
+ * - the learning of the overhead: the wrong initial value, the change of the overhead (the console of DEBUG)
+ */
+
+#include <stdlib.h>
+#include "test.h"
+#include "idlegov.h"
+
+// sys_app.c
+#define IDLE_RUN_UA			3450
+#define IDLE_SLEEP_UA		1100
+#define IDLE_STOP2_UA		2
+#define IDLE_OVERHEAD_US	300
+#define IDLE_AWAKE_US		30
+
+#define STOP2_OVERHEAD_US	180		// the modelled entry + exit (SystemClock_Config, the domains held)
+#define STOP2_JITTER_US		20
+
+/*
+ * idleSource_t - the idle periods of one timer source per hour
+ */
+typedef struct
+{
+	const char *name;
+	uint32_t perHour;
+	uint32_t minUS, maxUS;	// the idle time to the deadline
+} idleSource_t;
+
+static const idleSource_t _sources[] = {
+	{ "cycle", 120, 20000000, 29000000 },		// the sleep between the reading cycles
+	{ "conversion", 1200, 1000, 10000 },		// sleeper_SetSleepMS of the sensor conversions (10 readings per cycle)
+	{ "i2c wait", 2400, 200, 900 },				// the conversion time of the fast sensors, the clock stretching
+	{ "flash page", 240, 400, 800 },			// page program of the record (tPP)
+	{ "scd41", 120, 4800000, 5000000 },			// the periodic measurement
+	{ "rx delay", 24, 980000, 990000 },			// TX done -> RX1, RX1 -> RX2 (12 uplinks)
+	{ "radio irq", 120, 50, 400 },				// the IRQ of the radio -> the timer of the MAC
+	{ "rx window", 24, 12000, 30000 },			// the window without the preamble
+	{ "led", 24, 50000, 50000 },
+	{ "pending", 600, 0, 29 },					// the deadline is due
+	{ "no deadline", 2, UINT32_MAX, UINT32_MAX },	// the next deadline is farther than 71 min (saturated)
+};
+
+typedef enum
+{
+	POLICY_GOV = 0,
+	POLICY_STOP2,
+	POLICY_SLEEP,
+	POLICY_ORACLE,
+	POLICY_NBR
+} policy_t;
+
+typedef struct
+{
+	double charge;		// uA.s
+	uint32_t missed;	// STOP2 over the deadline
+	uint32_t modes[IDLE_MODE_NBR];
+} idleResult_t;
+
+/*
+ * @brief charge (uA.us) of the idle period in the mode, the period without a deadline counts 1 s
+ */
+static double idleCharge(idleMode_t mode, uint32_t idleUS, uint32_t overheadUS)
+{
+	double t = (idleUS == UINT32_MAX) ? 1e6 : idleUS;
+
+	switch (mode)
+	{
+		case IDLE_AWAKE:
+			return IDLE_RUN_UA * t;
+		case IDLE_SLEEP:
+			return IDLE_SLEEP_UA * t;
+		default:
+			// the overhead at run current, the deadline is missed by the longer overhead
+			return (t > overheadUS) ? IDLE_RUN_UA * (double) overheadUS + IDLE_STOP2_UA * (t - overheadUS) :
+				IDLE_RUN_UA * (double) overheadUS;
+	}
+}
+
+static uint32_t traceIdle(const idleSource_t *s)
+{
+	if (s->minUS == s->maxUS)
+		return s->minUS;
+	return s->minUS + (uint32_t) (rand() % (s->maxUS - s->minUS + 1));
+}
+
+/*
+ * @brief 1 h of the idle periods, the sources are interleaved randomly
+ */
+static void simulate(idleResult_t *r, idleGov_t *gov, uint32_t overheadUS)
+{
+	uint32_t left[sizeof(_sources) / sizeof(_sources[0])], total = 0;
+	const int nbr = sizeof(_sources) / sizeof(_sources[0]);
+
+	for (int i = 0; i < nbr; i++)
+		total += left[i] = _sources[i].perHour;
+	while (total > 0)
+	{
+		uint32_t pick = (uint32_t) rand() % total;
+		int i = 0;
+
+		while (pick >= left[i])
+			pick -= left[i++];
+		left[i]--;
+		total--;
+
+		uint32_t idleUS = traceIdle(&_sources[i]);
+		uint32_t overhead = overheadUS - STOP2_JITTER_US + (uint32_t) (rand() % (2 * STOP2_JITTER_US + 1));
+		idleMode_t modes[POLICY_NBR];
+
+		modes[POLICY_GOV] = idleGov_Decide(gov, idleUS);
+		modes[POLICY_STOP2] = IDLE_STOP2;
+		modes[POLICY_SLEEP] = IDLE_SLEEP;
+		modes[POLICY_ORACLE] = IDLE_AWAKE;
+		for (idleMode_t m = IDLE_AWAKE; m < IDLE_MODE_NBR; m++)
+			if (idleCharge(m, idleUS, overhead) < idleCharge(modes[POLICY_ORACLE], idleUS, overhead))
+				modes[POLICY_ORACLE] = m;
+		for (int p = 0; p < POLICY_NBR; p++)
+		{
+			double c = idleCharge(modes[p], idleUS, overhead);
+
+			r[p].charge += c / 1e6;
+			r[p].modes[modes[p]]++;
+			if (modes[p] == IDLE_STOP2 && idleUS < overhead)
+				r[p].missed++;
+		}
+		if (modes[POLICY_GOV] == IDLE_STOP2)
+			idleGov_Learn(gov, overhead);	// SYS_IdleLearn of PWR_ExitStopMode
+	}
+}
+
+static void testTrace(void)
+{
+	static const char *names[POLICY_NBR] = { "governor", "always STOP2", "always sleep", "oracle" };
+	idleResult_t r[POLICY_NBR] = { };
+	idleGov_t gov;
+
+	srand(47);
+	idleGov_Inic(&gov, IDLE_RUN_UA, IDLE_SLEEP_UA, IDLE_STOP2_UA, IDLE_OVERHEAD_US, IDLE_AWAKE_US);
+	simulate(r, &gov, STOP2_OVERHEAD_US);
+	for (int p = 0; p < POLICY_NBR; p++)
+		printf("%-13s %8.1f uAs of idle per h, awake/sleep/STOP2 %5lu/%5lu/%5lu, %4lu missed deadlines\n", names[p],
+			r[p].charge, (unsigned long) r[p].modes[IDLE_AWAKE], (unsigned long) r[p].modes[IDLE_SLEEP],
+			(unsigned long) r[p].modes[IDLE_STOP2], (unsigned long) r[p].missed);
+	printf("learned overhead %lu us (%lu), break-even %lu us\n", (unsigned long) gov.OverheadUS,
+		(unsigned long) STOP2_OVERHEAD_US, (unsigned long) gov.BreakEvenUS);
+	CHECK(r[POLICY_GOV].charge < r[POLICY_STOP2].charge);
+	CHECK(r[POLICY_GOV].charge < r[POLICY_SLEEP].charge);
+	CHECK(r[POLICY_GOV].charge < r[POLICY_ORACLE].charge * 1.02);
+	CHECK(r[POLICY_GOV].missed == 0);
+	CHECK(r[POLICY_STOP2].missed > 0);
+}
+
+static void testLearn(void)
+{
+	idleGov_t gov;
+	int n;
+
+	idleGov_Inic(&gov, IDLE_RUN_UA, IDLE_SLEEP_UA, IDLE_STOP2_UA, IDLE_OVERHEAD_US, IDLE_AWAKE_US);
+	CHECK_EQ(gov.BreakEvenUS, (IDLE_OVERHEAD_US * (IDLE_RUN_UA - IDLE_STOP2_UA) + IDLE_SLEEP_UA - IDLE_STOP2_UA - 1)
+		/ (IDLE_SLEEP_UA - IDLE_STOP2_UA));
+	// the first measurement replaces the expected value
+	idleGov_Learn(&gov, STOP2_OVERHEAD_US);
+	CHECK_EQ(gov.OverheadUS, STOP2_OVERHEAD_US);
+	// the console of DEBUG is initialized again after every wakeup: 180 -> 400 us
+	for (n = 1; gov.OverheadUS < 400 * 95 / 100; n++)
+		idleGov_Learn(&gov, 400);
+	printf("the overhead 180 -> 400 us learned within 5 %% after %d STOP2\n", n);
+	CHECK(n <= 24);
+	CHECK(gov.BreakEvenUS >= 400 * (IDLE_RUN_UA - IDLE_STOP2_UA) / (IDLE_SLEEP_UA - IDLE_STOP2_UA) * 95 / 100);
+	// the deadlines
+	CHECK_EQ(idleGov_Decide(&gov, 0), IDLE_AWAKE);
+	CHECK_EQ(idleGov_Decide(&gov, IDLE_AWAKE_US), IDLE_SLEEP);
+	CHECK_EQ(idleGov_Decide(&gov, gov.BreakEvenUS - 1), IDLE_SLEEP);
+	CHECK_EQ(idleGov_Decide(&gov, gov.BreakEvenUS), IDLE_STOP2);
+	CHECK_EQ(idleGov_Decide(&gov, UINT32_MAX), IDLE_STOP2);
+	// STOP2 cannot end before the deadline even if the sleep is as cheap
+	idleGov_Inic(&gov, IDLE_RUN_UA, IDLE_STOP2_UA, IDLE_STOP2_UA, IDLE_OVERHEAD_US, IDLE_AWAKE_US);
+	CHECK(gov.BreakEvenUS >= IDLE_OVERHEAD_US);
+}
+
+int main(void)
+{
+	testTrace();
+	testLearn();
+	return TEST_RESULT();
+}
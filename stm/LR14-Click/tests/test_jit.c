@@ -0,0 +1,157 @@
+/*
+ * test_jit.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * just-in-time sensing (user-028), host simulation of one day: wake windows per hour
+ * - JIT: TxTimer starts the sensors loraPlanner_JitDelay before the uplink, the uplink follows the reading
+ *   in the same window, the uplink waiting for the duty cycle is an extra window (sensors_OnReadDone)
+ * - independent timers (APP_JIT_SENSING 0): the sensor timer (interval after the cycle) and the periodic TxTimer,
+ *   the uplink inside the reading cycle shares the window
+ * - EU868 1 % duty cycle, time on air of APP_JIT_PAYLOAD_SIZE by lora_planner.c
+ * - the period of JIT is kept: the shorter one is raised to the cycle + interval (loraPlanner_JitPeriod),
+ *   the longer one of the duty cycle
+ */
+
+#include "test.h"
+#include "lora_planner.h"
+#include "lmhandler_stub.h"
+
+#define DAY_MS			(24 * 3600000U)
+#define PAYLOAD			16		// APP_JIT_PAYLOAD_SIZE
+#define DUTY_CYCLE		100		// 1 %, the band is free after time on air x 100
+
+typedef struct
+{
+	uint32_t windows;	// wakeups (distinct active windows)
+	uint32_t reads;		// reading cycles
+	uint32_t uplinks;
+	uint32_t minRest;	// min. time of the sensors off between the cycles
+} jitResult_t;
+
+/*
+ * @brief just-in-time: the cycle ends at the uplink, JitSchedule runs when the uplink is sent
+ */
+static jitResult_t simJit(uint32_t period, uint32_t cycle, uint32_t interval, uint32_t toa)
+{
+	jitResult_t r = { 0, 0, 0, UINT32_MAX };
+	uint32_t start = 0, txAllowed = 0, lastEnd = 0;
+
+	// JitPeriod of lora_app.c
+	period = loraPlanner_JitPeriod(period, cycle, interval);
+	while (start < DAY_MS)
+	{
+		uint32_t end = start + cycle, send = end;
+
+		r.windows++;
+		r.reads++;
+		if (r.reads > 1 && start - lastEnd < r.minRest)
+			r.minRest = start - lastEnd;
+		if (txAllowed > end)
+		{
+			send = txAllowed;	// TxTimer of the duty-cycle delay, another wakeup
+			r.windows++;
+		}
+		// JitSchedule before LmHandlerSend, the MAC delay is the one before this uplink
+		uint32_t rest = loraPlanner_JitDelay(period, txAllowed > send ? txAllowed - send : 0, cycle, interval);
+
+		r.uplinks++;
+		txAllowed = send + toa * DUTY_CYCLE;
+		lastEnd = end;
+		start = send + rest;
+	}
+	return r;
+}
+
+/*
+ * @brief independent timers: sensors every interval after the cycle, TxTimer periodic (phase of half interval)
+ */
+static jitResult_t simTimers(uint32_t period, uint32_t cycle, uint32_t interval, uint32_t toa)
+{
+	jitResult_t r = { 0, 0, 0, interval };
+	uint32_t start = 0, tx = interval / 2, txAllowed = 0;
+
+	while (start < DAY_MS || tx < DAY_MS)
+	{
+		if (start <= tx)
+		{
+			r.windows++;
+			r.reads++;
+			// the uplinks within the reading cycle share its window
+			while (tx <= start + cycle && tx < DAY_MS)
+			{
+				if (tx >= txAllowed)
+				{
+					r.uplinks++;
+					txAllowed = tx + toa * DUTY_CYCLE;
+				}
+				tx += period;
+			}
+			start += cycle + interval;
+		}
+		else
+		{
+			r.windows++;
+			if (tx >= txAllowed)
+			{
+				r.uplinks++;
+				txAllowed = tx + toa * DUTY_CYCLE;
+			}
+			tx += period;
+		}
+	}
+	return r;
+}
+
+static void testPeriod(void)
+{
+	// the floor of the period: the cycle and the interval
+	CHECK_EQ(loraPlanner_JitPeriod(60000, 8000, 30000), 60000);
+	CHECK_EQ(loraPlanner_JitPeriod(38000, 8000, 30000), 38000);
+	CHECK_EQ(loraPlanner_JitPeriod(37999, 8000, 30000), 38000);
+	CHECK_EQ(loraPlanner_JitPeriod(1000, 33500, 30000), 63500);
+	// the sensors start the cycle before the uplink of the period, the MAC delay moves it
+	CHECK_EQ(loraPlanner_JitDelay(60000, 0, 8000, 30000), 52000);
+	CHECK_EQ(loraPlanner_JitDelay(38000, 0, 8000, 30000), 30000);
+	CHECK_EQ(loraPlanner_JitDelay(60000, 70000, 8000, 30000), 62000);
+	// the period under the floor is stretched (loraPlanner_JitPeriod raises it before)
+	CHECK_EQ(loraPlanner_JitDelay(10000, 0, 8000, 30000), 30000);
+}
+
+int main(void)
+{
+	static const uint32_t periods[] = { 1000, 60000, 300000, 900000 };
+	static const uint32_t cycles[] = { 8000, 33500 };	// settled early (user-031), max. 500 + 3000 x (10 + 1)
+	static const int8_t drs[] = { DR_5, DR_0 };
+	const uint32_t interval = 30000;
+
+	stub_Region = LORAMAC_REGION_EU868;
+	loraPlanner_Init();
+	testPeriod();
+	printf("period  cycle  DR  ToA    JIT: windows/h reads/h uplinks/h min.off    timers: windows/h reads/h uplinks/h\n");
+	for (unsigned d = 0; d < sizeof(drs); d++)
+		for (unsigned c = 0; c < sizeof(cycles) / sizeof(cycles[0]); c++)
+			for (unsigned p = 0; p < sizeof(periods) / sizeof(periods[0]); p++)
+			{
+				uint32_t toa = loraPlanner_TimeOnAir(drs[d], PAYLOAD);
+				jitResult_t j = simJit(periods[p], cycles[c], interval, toa);
+				jitResult_t t = simTimers(periods[p], cycles[c], interval, toa);
+				uint32_t period = loraPlanner_JitPeriod(periods[p], cycles[c], interval);
+
+				// the uplink period is kept (the raised one, or the one of the duty cycle)
+				if (toa * DUTY_CYCLE > period)
+					period = toa * DUTY_CYCLE;
+
+				printf("%6lu %6lu  %d %5lu  %14.1f %7.1f %9.1f %7lu  %16.1f %7.1f %9.1f\n", (unsigned long) periods[p] / 1000,
+					(unsigned long) cycles[c], drs[d], (unsigned long) toa, j.windows / 24.0, j.reads / 24.0, j.uplinks / 24.0,
+					(unsigned long) j.minRest, t.windows / 24.0, t.reads / 24.0, t.uplinks / 24.0);
+				// fewer wakeups, the sensors are never restarted sooner than the reading interval
+				CHECK(j.windows <= t.windows);
+				CHECK(j.minRest >= interval);
+				// each uplink carries the reading of its own window or the one just before
+				CHECK(j.reads == j.uplinks);
+				CHECK(j.uplinks >= DAY_MS / period && j.uplinks <= DAY_MS / period + 2);	// the first and the last window
+			}
+	return TEST_RESULT();
+}
@@ -0,0 +1,228 @@
+/*
+ * test_join.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * join retry scheduler (user-036), lora_join.c on the stubbed timer server, sequencer and LmHandler
+ * - loraJoin_GetDelay: the doubling from LORAWAN_JOIN_BACKOFF_MIN, the cap for all attempts up to 65535
+ *   (no overflow of the shift), the off-time of the aggregated join duty cycle
+ * - the jitter of loraJoin_OnResult within 1/8 of the delay, the busy MAC waits for the duty cycle
+ * - 24 h without the network (EU868): the count of attempts against the model of the backoff without
+ *   and with the max. jitter, the rotation of DR5 .. DR0, the airtime per the windows of the join duty cycle
+ */
+
+#include <string.h>
+#include "test.h"
+#include "lora_app.h"
+#include "lora_join.h"
+#include "lora_planner.h"
+#include "lmhandler_stub.h"
+#include "util_stub.h"
+
+#define JOIN_REQUEST_SIZE	10		// lora_join.c
+#define JOIN_RX_MS			7000	// RX2 of the join accept (JOIN_ACCEPT_DELAY2 + window) after the request
+#define HOUR_MS				3600000U
+#define DAY_MS				(24 * HOUR_MS)
+#define ATTEMPT_MAX			200
+
+typedef struct
+{
+	uint32_t time;
+	int8_t dr;
+	uint32_t toa;
+} joinAttempt_t;
+
+static joinAttempt_t _attempts[ATTEMPT_MAX];
+static uint32_t _attemptCount = 0;
+static uint32_t _busyCount = 0;		// busy replies left
+
+static LmHandlerErrorStatus_t onJoinRetry(int8_t datarate)
+{
+	if (_busyCount > 0)
+	{
+		_busyCount--;
+		return LORAMAC_HANDLER_BUSY_ERROR;
+	}
+	if (_attemptCount < ATTEMPT_MAX)
+	{
+		_attempts[_attemptCount].time = stub_Tick;
+		_attempts[_attemptCount].dr = datarate;
+		_attempts[_attemptCount].toa = loraPlanner_TimeOnAir(datarate, JOIN_REQUEST_SIZE);
+	}
+	_attemptCount++;
+	return LORAMAC_HANDLER_SUCCESS;
+}
+
+static void joinInic(void)
+{
+	stub_Tick = 0;
+	stub_UtilReset();
+	stub_Region = LORAMAC_REGION_EU868;
+	stub_JoinStatus = LORAMAC_HANDLER_RESET;
+	stub_OnJoinRetry = onJoinRetry;
+	loraPlanner_Init();
+	loraJoin_Init();
+	_attemptCount = 0;
+	_busyCount = 0;
+}
+
+static void testDelay(void)
+{
+	uint32_t prev = 0;
+
+	CHECK_EQ(loraJoin_GetDelay(1, 0, 0), LORAWAN_JOIN_BACKOFF_MIN);
+	CHECK_EQ(loraJoin_GetDelay(2, 0, 0), 2 * LORAWAN_JOIN_BACKOFF_MIN);
+	CHECK_EQ(loraJoin_GetDelay(8, 0, 0), 128 * LORAWAN_JOIN_BACKOFF_MIN);
+	CHECK_EQ(loraJoin_GetDelay(9, 0, 0), LORAWAN_JOIN_BACKOFF_MAX);
+	for (uint32_t a = 1; a <= 0xFFFF; a++)
+	{
+		uint32_t d = loraJoin_GetDelay((uint16_t) a, 0, 0);
+
+		if (d < prev || d > LORAWAN_JOIN_BACKOFF_MAX)
+		{
+			CHECK(d >= prev && d <= LORAWAN_JOIN_BACKOFF_MAX);
+			printf("attempt %lu: %lu ms\n", (unsigned long) a, (unsigned long) d);
+			break;
+		}
+		prev = d;
+	}
+	CHECK_EQ(loraJoin_GetDelay(19, 0, 0), LORAWAN_JOIN_BACKOFF_MAX);
+	CHECK_EQ(loraJoin_GetDelay(33, 0, 0), LORAWAN_JOIN_BACKOFF_MAX);
+	// the off-time of the aggregated duty cycle: 1 %, 0.1 % from 1 h, 0.01 % from 11 h
+	CHECK_EQ(loraJoin_GetDelay(1, 0, 1000), 100000);
+	CHECK_EQ(loraJoin_GetDelay(1, HOUR_MS, 1000), 1000000);
+	CHECK_EQ(loraJoin_GetDelay(20, 11 * HOUR_MS, 1000), 10000000);
+	CHECK_EQ(loraJoin_GetDelay(20, 11 * HOUR_MS - 1, 100), LORAWAN_JOIN_BACKOFF_MAX);
+}
+
+static void testJitter(void)
+{
+	uint32_t lo = UINT32_MAX, hi = 0;
+
+	joinInic();
+	for (int i = 0; i < 1000; i++)
+	{
+		uint32_t base, d;
+
+		loraJoin_Restart();
+		stub_TimerRun(stub_Tick + 1);
+		// the attempt 19 (the shift overflow before the fix) and later
+		for (int a = 0; a < 20; a++)
+			loraJoin_OnResult(0);
+		base = loraJoin_GetDelay(20, UTIL_TIMER_GetElapsedTime(0), loraPlanner_TimeOnAir(_attempts[0].dr, JOIN_REQUEST_SIZE));
+		d = stub_TimerNext() - stub_Tick;
+		lo = (d < lo) ? d : lo;
+		hi = (d > hi) ? d : hi;
+		CHECK(d >= base && d <= base + base / 8);
+	}
+	printf("jitter of %lu ms: %lu .. %lu ms\n", (unsigned long) LORAWAN_JOIN_BACKOFF_MAX, (unsigned long) lo,
+		(unsigned long) hi);
+	CHECK(hi - lo > LORAWAN_JOIN_BACKOFF_MAX / 10);
+	// the busy MAC, the attempt waits for the duty cycle and is not counted
+	joinInic();
+	_busyCount = 1;
+	stub_DutyCycleWait = 5000;
+	loraJoin_Restart();
+	stub_TimerRun(stub_Tick + 1);
+	CHECK_EQ(_attemptCount, 0);
+	CHECK_EQ(stub_TimerNext() - stub_Tick, 5000);
+	stub_TimerRun(UINT32_MAX);
+	CHECK_EQ(_attemptCount, 1);
+	stub_DutyCycleWait = 0;
+	// the joined device does not retry
+	stub_JoinStatus = LORAMAC_HANDLER_SET;
+	loraJoin_Restart();
+	stub_TimerRun(stub_Tick + 1);
+	CHECK_EQ(_attemptCount, 1);
+}
+
+/*
+ * @brief the count of the attempts in 24 h by the backoff and the join duty cycle, jitter - the added part of delay
+ */
+static uint32_t modelAttempts(double jitter)
+{
+	double t = 0;
+	uint32_t n = 0;
+
+	while (t < DAY_MS)
+	{
+		int8_t dr = (n == 0) ? DR_0 : DR_5 - (int8_t) (n % (DR_5 + 1));
+		double toa = loraPlanner_TimeOnAir(dr, JOIN_REQUEST_SIZE);
+		double backoff = LORAWAN_JOIN_BACKOFF_MIN;
+		double end = t + toa + JOIN_RX_MS;
+		double factor = (end < HOUR_MS) ? 100 : (end < 11 * HOUR_MS) ? 1000 : 10000;
+
+		n++;
+		for (uint32_t i = 1; i < n && backoff < LORAWAN_JOIN_BACKOFF_MAX; i++)
+			backoff *= 2;
+		if (backoff > LORAWAN_JOIN_BACKOFF_MAX)
+			backoff = LORAWAN_JOIN_BACKOFF_MAX;
+		if (toa * factor > backoff)
+			backoff = toa * factor;
+		t = end + backoff * (1 + jitter);
+	}
+	return n;
+}
+
+static void testDay(void)
+{
+	uint32_t airtime = 0, hour1 = 0, hour11 = 0, later = 0, perDr[DR_5 + 1] = { };
+	uint32_t count = 0, most, least;
+
+	joinInic();
+	// the first request of LoRaWAN_Init (LmHandlerJoin at the default datarate)
+	onJoinRetry(LORAWAN_DEFAULT_DATA_RATE);
+	while (stub_Tick < DAY_MS)
+	{
+		// no join accept in RX1 and RX2
+		stub_Tick += _attempts[(_attemptCount - 1) % ATTEMPT_MAX].toa + JOIN_RX_MS;
+		loraJoin_OnResult(0);
+		stub_TimerRun(UINT32_MAX);
+	}
+	CHECK(_attemptCount < ATTEMPT_MAX);
+	for (uint32_t i = 0; i < _attemptCount; i++)
+	{
+		joinAttempt_t *a = &_attempts[i];
+
+		if (a->time >= DAY_MS)
+			break;
+		count++;
+		airtime += a->toa;
+		if (a->time < HOUR_MS)
+			hour1 += a->toa;
+		else if (a->time < 11 * HOUR_MS)
+			hour11 += a->toa;
+		else
+			later += a->toa;
+		perDr[a->dr]++;
+		if (i > 0)
+			CHECK_EQ(a->dr, DR_5 - (int8_t) (i % (DR_5 + 1)));
+	}
+	most = least = perDr[0];
+	for (int dr = 0; dr <= DR_5; dr++)
+	{
+		most = (perDr[dr] > most) ? perDr[dr] : most;
+		least = (perDr[dr] < least) ? perDr[dr] : least;
+	}
+	printf("24 h without network: %lu attempts (model %lu .. %lu), DR0..5 %lu %lu %lu %lu %lu %lu, airtime %.1f s "
+		"(1st hour %.1f s, to 11 h %.1f s, later %.1f s), last attempt at %.1f h\n", (unsigned long) count,
+		(unsigned long) modelAttempts(0.125), (unsigned long) modelAttempts(0), (unsigned long) perDr[0],
+		(unsigned long) perDr[1], (unsigned long) perDr[2], (unsigned long) perDr[3], (unsigned long) perDr[4],
+		(unsigned long) perDr[5], airtime / 1000.0, hour1 / 1000.0, hour11 / 1000.0, later / 1000.0,
+		_attempts[count - 1].time / (double) HOUR_MS);
+	CHECK(count >= modelAttempts(0.125) && count <= modelAttempts(0));
+	CHECK(most - least <= 1);
+	// the aggregated join duty cycle: 36 s in the first hour, 36 s in the next 10 h, 8.7 s per 24 h later
+	CHECK(hour1 <= 36000);
+	CHECK(hour11 <= 36000);
+	CHECK(later <= 8700);
+}
+
+int main(void)
+{
+	testDelay();
+	testJitter();
+	testDay();
+	return TEST_RESULT();
+}
@@ -0,0 +1,249 @@
+/*
+ * test_ndef.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * the latest readings as NDEF text in the ST25DV user EEPROM (user-045), blockDiff_Run, nfc4_BuildNDEFText
+ * and nfc4_UpdateEEPROM on the modelled tag of stub/i2c.c (5 ms and the wear per touched 4-byte block)
+ * - blockDiff: no change, the run aligned to the blocks, the gap, the tail cut by len, the unaligned pos
+ * - the image: Capability Container, NDEF TLV, the text record, the terminator, the cleared rest, the too long text
+ * - one day of 1 min cycles with the random walk of the channels, the text of sensors_PublishNDEF: the bytes per
+ *   update, the writes of the hottest block per day and the EEPROM busy time of the full rewrite, of the diff
+ *   with the variable and with the fixed width of the fields, of the fixed width with SENS_NDEF_INTERVAL_MS
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+#include "i2c_stub.h"
+#include "nfctag4.h"
+#include "utils/utils.h"
+
+// mysensors.h
+#define SENS_NDEF_SIZE			160
+#define SENS_NDEF_INTERVAL_MS	600000
+
+#define NFC4_USER		(0x53 << 1)
+#define BLOCKS			(SENS_NDEF_SIZE / 4)
+#define CYCLE_MS		60000
+#define DAY_CYCLES		1440
+#define EPOCH			1792368000	// 19. 10. 2026
+
+static void testBlockDiff(void)
+{
+	uint8_t shadow[10] = { }, image[10] = { };
+	uint16_t start = 0xFFFF;
+
+	CHECK_EQ(blockDiff_Run(shadow, image, 10, 0, 4, &start), 0);
+	CHECK_EQ(start, 0xFFFF);
+	image[5] = 1;
+	CHECK_EQ(blockDiff_Run(shadow, image, 10, 0, 4, &start), 4);
+	CHECK_EQ(start, 4);
+	CHECK_EQ(blockDiff_Run(shadow, image, 10, 6, 4, &start), 4);	// pos is aligned down to the block
+	CHECK_EQ(start, 4);
+	CHECK_EQ(blockDiff_Run(shadow, image, 10, 8, 4, &start), 0);
+	// the adjacent blocks are one run
+	image[3] = 1;
+	CHECK_EQ(blockDiff_Run(shadow, image, 10, 0, 4, &start), 8);
+	CHECK_EQ(start, 0);
+	// the gap of the unchanged block, the tail of 2 bytes
+	image[5] = 0;
+	image[9] = 1;
+	CHECK_EQ(blockDiff_Run(shadow, image, 10, 0, 4, &start), 4);
+	CHECK_EQ(start, 0);
+	CHECK_EQ(blockDiff_Run(shadow, image, 10, 4, 4, &start), 2);
+	CHECK_EQ(start, 8);
+}
+
+static void testImage(void)
+{
+	uint8_t image[SENS_NDEF_SIZE];
+	char text[SENS_NDEF_SIZE];
+
+	memset(image, 0x55, sizeof(image));
+	CHECK_EQ(nfc4_BuildNDEFText(image, sizeof(image), "T 21.5 C"), 8 + 14);
+	CHECK(memcmp(image, "\xE1\x40\x40\x00\x03\x0F\xD1\x01\x0B" "T\x02" "en" "T 21.5 C\xFE", 22) == 0);
+	for (int i = 22; i < SENS_NDEF_SIZE; i++)
+		CHECK_EQ(image[i], 0);
+	// the longest text
+	memset(text, 'x', sizeof(text));
+	text[SENS_NDEF_SIZE - 14] = '\0';
+	CHECK_EQ(nfc4_BuildNDEFText(image, sizeof(image), text), SENS_NDEF_SIZE);
+	CHECK_EQ(image[SENS_NDEF_SIZE - 1], 0xFE);
+	text[SENS_NDEF_SIZE - 14] = 'x';
+	text[SENS_NDEF_SIZE - 13] = '\0';
+	CHECK_EQ(nfc4_BuildNDEFText(image, sizeof(image), text), 0);
+}
+
+/*
+ * ndefDevice_t - the channels of the report (x100 as _report.Value) and the health
+ */
+typedef struct
+{
+	int32_t temp, hum, pressure, lux, co2, pm, bat;
+	uint8_t tier, present;
+	uint32_t next;		// sensorsFlash_GetRange
+	uint32_t time;
+} ndefDevice_t;
+
+typedef enum
+{
+	POLICY_FULL = 0,	// the whole message every cycle
+	POLICY_VAR,			// the diff, the fields without the width
+	POLICY_FIXED,		// the diff of sensors_PublishNDEF
+	POLICY_LIMIT,		// + SENS_NDEF_INTERVAL_MS
+	POLICY_NBR
+} ndefPolicy_t;
+
+/*
+ * @brief sensors_NDEFField, width 0 - the variable width
+ */
+static void ndefField(char *out, int32_t v, int32_t div, uint8_t decimals, uint8_t width)
+{
+	char txt[16];
+	uint32_t unit = (decimals > 0) ? div / 10 : div;
+	uint32_t r = ((uint32_t) ((v < 0) ? -v : v) + unit / 2) / unit;
+
+	if (decimals > 0)
+		sprintf(txt, "%s%lu.%lu", (v < 0) ? "-" : "", (unsigned long) (r / 10), (unsigned long) (r % 10));
+	else
+		sprintf(txt, "%s%lu", (v < 0) ? "-" : "", (unsigned long) r);
+	sprintf(out, "%*s", width, txt);
+}
+
+/*
+ * @brief the text of sensors_PublishNDEF
+ */
+static void ndefText(char *text, const ndefDevice_t *d, uint8_t fixed, calendar_t *cal)
+{
+	char t[16], h[16], p[16], l[16], co2[16], pm[16], bat[16];
+
+	ndefField(t, d->temp, 100, 1, fixed ? 5 : 0);
+	ndefField(h, d->hum, 100, 0, fixed ? 3 : 0);
+	ndefField(p, d->pressure, 100, 1, fixed ? 6 : 0);
+	ndefField(l, d->lux, 100, 0, fixed ? 6 : 0);
+	ndefField(co2, d->co2, 1, 0, fixed ? 5 : 0);
+	ndefField(pm, d->pm, 100, 1, fixed ? 5 : 0);
+	ndefField(bat, d->bat, 1, 0, fixed ? 3 : 0);
+	calendar_Set(cal, d->time);
+	sprintf(text, "T %s C  RH %s %%\nP %s hPa  L %s lx\nCO2 %s ppm  PM2.5 %s\nBat %s %%  tier %u  dev %02X\n#%*lu  %04u-%02u-%02u %02u:%02u",
+		t, h, p, l, co2, pm, bat, (unsigned) d->tier, (unsigned) d->present, fixed ? 7 : 0, (unsigned long) d->next,
+		(unsigned) cal->Year, (unsigned) cal->Month, (unsigned) cal->Day, (unsigned) cal->Hours, (unsigned) cal->Minutes);
+}
+
+static int32_t walk(int32_t v, int32_t step, int32_t min, int32_t max)
+{
+	v += (rand() % (2 * step + 1)) - step;
+	return (v < min) ? min : (v > max) ? max : v;
+}
+
+static void deviceStep(ndefDevice_t *d, uint32_t cycle)
+{
+	d->temp = walk(d->temp, 8, -500, 4000);
+	d->hum = walk(d->hum, 40, 2000, 9000);
+	d->pressure = walk(d->pressure, 3, 95000, 105000);
+	d->lux = walk(d->lux, d->lux / 20 + 100, 0, 10000000);		// the day light
+	d->co2 = walk(d->co2, 15, 400, 3000);
+	d->pm = walk(d->pm, 30, 0, 20000);
+	if (cycle % 240 == 239)
+		d->bat--;
+	d->tier = (d->bat < 20) ? 2 : (d->bat < 50) ? 1 : 0;
+	d->next++;
+	d->time += CYCLE_MS / 1000;
+}
+
+typedef struct
+{
+	uint32_t updates;
+	uint32_t bytes;
+	uint32_t hottest;	// writes of the most written block per day
+	uint32_t busyMs;	// EEPROM programming
+} ndefResult_t;
+
+static ndefResult_t ndefDay(ndefPolicy_t policy)
+{
+	static uint32_t wear[STUB_I2C_MEM_SIZE / 4];
+	uint8_t image[SENS_NDEF_SIZE], shadow[SENS_NDEF_SIZE];
+	char text[256];
+	ndefDevice_t d = { 2150, 4500, 101325, 30000, 600, 500, 87, 0, 0x3F, 1000, EPOCH };
+	ndefResult_t r = { };
+	calendar_t cal;
+	stubI2CDev_t *tag;
+	uint32_t last = 0;
+	uint16_t written;
+
+	stub_I2CReset();
+	memset(wear, 0, sizeof(wear));
+	tag = stub_I2CAdd(NFC4_USER, 1);
+	tag->WriteMs = 5;
+	tag->BlockSize = 4;
+	tag->Wear = wear;
+	CHECK_EQ(nfc4_InitWarm(&hi2c2), HAL_OK);
+	calendar_Inic(&cal);
+	srand(45);
+	CHECK_EQ(nfc4_ReadEEPROM(&hi2c2, 0, shadow, SENS_NDEF_SIZE), HAL_OK);	// the shadow after reset
+	for (uint32_t cycle = 0; cycle < DAY_CYCLES; cycle++)
+	{
+		uint16_t used;
+
+		stub_Tick = cycle * CYCLE_MS;
+		deviceStep(&d, cycle);
+		if (policy == POLICY_LIMIT && r.updates > 0 && stub_Tick - last < SENS_NDEF_INTERVAL_MS)
+			continue;
+		ndefText(text, &d, policy != POLICY_VAR, &cal);
+		used = nfc4_BuildNDEFText(image, SENS_NDEF_SIZE, text);
+		CHECK(used > 0);
+		if (policy == POLICY_FULL)
+		{
+			written = (used + 3) & ~3;
+			CHECK_EQ(nfc4_WriteEEPROM(&hi2c2, 0, image, written), HAL_OK);
+			memcpy(shadow, image, written);
+		}
+		else
+			CHECK_EQ(nfc4_UpdateEEPROM(&hi2c2, 0, image, shadow, SENS_NDEF_SIZE, &written), HAL_OK);
+		CHECK(memcmp(shadow, image, SENS_NDEF_SIZE) == 0);
+		if (written > 0)
+		{
+			r.updates++;
+			r.bytes += written;
+			last = cycle * CYCLE_MS;	// the tick of the check (sensors_PublishNDEF)
+		}
+	}
+	CHECK(memcmp(tag->Mem, image, SENS_NDEF_SIZE) == 0);
+	for (int i = 0; i < BLOCKS; i++)
+	{
+		r.busyMs += wear[i] * tag->WriteMs;
+		if (wear[i] > r.hottest)
+			r.hottest = wear[i];
+	}
+	return r;
+}
+
+static void testDay(void)
+{
+	static const char *names[POLICY_NBR] = { "full rewrite", "diff, var. width", "diff, fixed width", "fixed + 10 min" };
+	ndefResult_t r[POLICY_NBR];
+
+	for (int p = 0; p < POLICY_NBR; p++)
+	{
+		r[p] = ndefDay(p);
+		printf("%-18s %4lu updates, %5.1f B per update, hottest block %4lu writes/day (%5.1f years of 1M), "
+			"busy %5.1f s/day\n", names[p], (unsigned long) r[p].updates, (double) r[p].bytes / r[p].updates,
+			(unsigned long) r[p].hottest, 1e6 / r[p].hottest / 365, r[p].busyMs / 1000.0);
+	}
+	CHECK(r[POLICY_FIXED].bytes < r[POLICY_VAR].bytes);
+	CHECK(r[POLICY_VAR].bytes * 3 < r[POLICY_FULL].bytes);
+	CHECK_EQ(r[POLICY_LIMIT].updates, DAY_CYCLES * CYCLE_MS / SENS_NDEF_INTERVAL_MS);
+	CHECK(r[POLICY_LIMIT].hottest <= DAY_CYCLES * CYCLE_MS / SENS_NDEF_INTERVAL_MS);
+	CHECK(1e6 / r[POLICY_LIMIT].hottest > 10 * 365);
+	CHECK(r[POLICY_LIMIT].busyMs * 20 < r[POLICY_FULL].busyMs);
+}
+
+int main(void)
+{
+	testBlockDiff();
+	testImage();
+	testDay();
+	return TEST_RESULT();
+}
@@ -0,0 +1,175 @@
+/*
+ * test_nfcwrite.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * page-aware ST25DV EEPROM writer with ACK polling (user-043), nfctag4.c on the modelled tag of stub/i2c.c
+ * (NACK while programming, 5 ms per touched 4-byte block)
+ * - the erase of 1 KB by nfc4_ResetEEPROM against the previous writer (byte by byte, 4-byte writes followed
+ *   by HAL_Delay(5)): the awake time (bus and delays) and the count of writes at 10 kHz and 100 kHz
+ * - the data of nfc4_WriteEEPROM over the page boundary, the unaligned write (100 B at 250) touching
+ *   two blocks per 4 bytes, which the fixed delay of the previous writer does not cover
+ * - the timeout of the tag that does not finish the programming
+ */
+
+#include <string.h>
+#include "test.h"
+#include "i2c_stub.h"
+#include "nfctag4.h"
+
+#define NFC4_USER		(0x53 << 1)
+#define ERASE_SIZE		1024
+
+typedef struct
+{
+	uint64_t us;		// awake time of the write (bus and delays)
+	uint32_t writes;	// Mem_Write transactions
+	uint32_t transfers;	// address phases (+ ACK polling)
+} writeCost_t;
+
+static uint32_t _writes;
+
+/*
+ * @brief nfc4_WriteEEPROM before user-043
+ */
+static HAL_StatusTypeDef oldWrite(I2C_HandleTypeDef *hi2c, uint16_t addr, uint8_t *pData, uint16_t len)
+{
+	HAL_StatusTypeDef status = HAL_OK;
+
+	for (uint16_t i = 0; i < len; i += 4)
+	{ // ST25DV writes in blocks
+		uint16_t chunk = (len - i) > 4 ? 4 : (len - i);
+		status = HAL_I2C_Mem_Write(hi2c, NFC4_USER, addr + i, 2, &pData[i], chunk, 100);
+		_writes++;
+		HAL_Delay(5); // EEPROM write cycle time
+		if (status != HAL_OK)
+			break;
+	}
+	return status;
+}
+
+/*
+ * @brief nfc4_ResetEEPROM before user-043
+ */
+static void oldReset(I2C_HandleTypeDef *hi2c, uint16_t len)
+{
+	uint8_t zero = 0;
+
+	for (uint16_t i = 0; i < len; i++)
+		oldWrite(hi2c, i, &zero, 1);
+}
+
+static stubI2CDev_t* tagInic(uint32_t hz)
+{
+	stubI2CDev_t *tag;
+
+	stub_I2CReset();
+	hi2c2.Speed = hz;
+	tag = stub_I2CAdd(NFC4_USER, 1);
+	tag->WriteMs = 5;
+	tag->BlockSize = 4;
+	CHECK_EQ(nfc4_InitWarm(&hi2c2), HAL_OK);
+	return tag;
+}
+
+static void costStart(writeCost_t *c)
+{
+	c->us = stub_I2CTimeUs();
+	c->transfers = stub_I2CTransfers;
+	_writes = 0;
+}
+
+static void costEnd(writeCost_t *c)
+{
+	c->us = stub_I2CTimeUs() - c->us;
+	c->transfers = stub_I2CTransfers - c->transfers;
+	c->writes = _writes;
+}
+
+static void testErase(void)
+{
+	static const uint32_t speeds[] = { 10000, 100000 };
+
+	for (unsigned s = 0; s < sizeof(speeds) / sizeof(speeds[0]); s++)
+	{
+		writeCost_t old, page;
+		stubI2CDev_t *tag = tagInic(speeds[s]);
+
+		memset(tag->Mem, 0xA5, ERASE_SIZE);
+		costStart(&old);
+		oldReset(&hi2c2, ERASE_SIZE);
+		costEnd(&old);
+		memset(tag->Mem, 0xA5, ERASE_SIZE);
+		stub_Tick += 10;
+		costStart(&page);
+		nfc4_ResetEEPROM(&hi2c2, ERASE_SIZE);
+		costEnd(&page);
+		page.writes = ERASE_SIZE / 256;	// one per page, the rest are the polls
+		for (int i = 0; i < ERASE_SIZE; i++)
+			CHECK_EQ(tag->Mem[i], 0);
+		printf("erase of %d B at %3lu kHz: %5.2f s awake, %4lu writes (previous) -> %4.2f s, %lu writes, %lu polls\n",
+			ERASE_SIZE, (unsigned long) (speeds[s] / 1000), old.us / 1e6, (unsigned long) old.writes, page.us / 1e6,
+			(unsigned long) page.writes, (unsigned long) (page.transfers - page.writes));
+		CHECK_EQ(old.writes, ERASE_SIZE);
+		// programming of 256 blocks (5 ms) per 1 KB and the bus, the polls end within 1 ms of the programming
+		CHECK(page.us < 256 * 5000 + 4 * (1 + 2 + 256 + 2 + 1) * 9 * 1000000ULL / speeds[s] + 4 * 2000);
+		CHECK(page.us * 4 < old.us);
+	}
+}
+
+static void testData(void)
+{
+	uint8_t data[600], back[600];
+	stubI2CDev_t *tag = tagInic(100000);
+	HAL_StatusTypeDef status;
+
+	for (unsigned i = 0; i < sizeof(data); i++)
+		data[i] = (uint8_t) (i * 7 + 1);
+	// over two page boundaries
+	CHECK_EQ(nfc4_WriteEEPROM(&hi2c2, 0, data, sizeof(data)), HAL_OK);
+	CHECK_EQ(nfc4_ReadEEPROM(&hi2c2, 0, back, sizeof(back)), HAL_OK);
+	CHECK(memcmp(data, back, sizeof(data)) == 0);
+	// unaligned: every 4-byte write of the previous writer touches two blocks (10 ms)
+	stub_Tick += 10;
+	memset(tag->Mem, 0, sizeof(data));
+	status = oldWrite(&hi2c2, 250, data, 100);
+	printf("100 B at 250: previous writer %s after %lu writes", (status == HAL_OK) ? "OK" : "failed",
+		(unsigned long) _writes);
+	CHECK(status != HAL_OK);
+	CHECK(memcmp(&tag->Mem[250], data, 100) != 0);
+	stub_Tick += 10;
+	memset(tag->Mem, 0, sizeof(data));
+	CHECK_EQ(nfc4_WriteEEPROM(&hi2c2, 250, data, 100), HAL_OK);
+	CHECK_EQ(nfc4_ReadEEPROM(&hi2c2, 250, back, 100), HAL_OK);
+	printf(", nfc4_WriteEEPROM %s\n", (memcmp(data, back, 100) == 0) ? "written and verified" : "wrong data");
+	CHECK(memcmp(data, back, 100) == 0);
+	CHECK_EQ(tag->Mem[249], 0);
+	CHECK_EQ(tag->Mem[350], 0);
+}
+
+static void testTimeout(void)
+{
+	stubI2CDev_t *tag = tagInic(100000);
+	uint8_t data[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+	uint32_t start;
+
+	// the programming longer than 2x the block time
+	tag->WriteMs = 20;
+	start = HAL_GetTick();
+	CHECK_EQ(nfc4_WriteEEPROM(&hi2c2, 0, data, sizeof(data)), HAL_TIMEOUT);
+	CHECK(HAL_GetTick() - start <= 2 * 5 * 2 + 2 + 3);	// + the write and the last HAL_Delay(1)
+	// the absent tag
+	stub_I2CReset();
+	CHECK(nfc4_InitWarm(&hi2c2) != HAL_OK);
+	CHECK_EQ(nfc4_WriteEEPROM(&hi2c2, 0, data, sizeof(data)), HAL_ERROR);
+	CHECK_EQ(nfc4_FillEEPROM(&hi2c2, 0, 0, sizeof(data)), HAL_ERROR);
+}
+
+int main(void)
+{
+	testErase();
+	testData();
+	testTimeout();
+	return TEST_RESULT();
+}
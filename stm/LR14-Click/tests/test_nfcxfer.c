@@ -0,0 +1,409 @@
+/*
+ * test_nfcxfer.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * download of the history by the NFC mailbox (user-044), nfcxfer.c driven by nfc4_ProcessMailBox of nfctag4.c
+ * on the modelled ST25DV of stub/i2c.c, the phone is simulated by the test on the RF side of the mailbox
+ * - the tag: the host message sets HOST_PUT_MSG and MB_LEN, IT_STS is cleared by reading, the RF message is
+ *   released by reading, the message of one side blocks the other one
+ * - the phone: the request by RF_PUT_MSG, the read of the frame by RF_GET_MSG, each event is one GPO interrupt
+ *   (sensors_NFCInt)
+ * - the normal transfer: INFO, GET of all records and of a range, the overwritten oldest records, the errors
+ * - the RF abort: the field lost with an unread frame (released by MB_WDG), RESUME by the next record of the
+ *   phone, STOP and INFO together with the read of a frame (the mailbox busy for the next frame)
+ * - the timeout: the download paused without RESUME and the frame never read are ended after NFCX_TIMEOUT_MS,
+ *   the download with the events in time is not
+ */
+
+#include <string.h>
+#include "test.h"
+#include "i2c_stub.h"
+#include "nfctag4.h"
+#include "nfcxfer.h"
+
+#define NFC4_USER		(0x53 << 1)
+#define REG_IT_STS		0x2005	// nfctag4.c
+#define REG_MB_CTRL		0x2006
+#define REG_MB_LEN		0x2007
+#define REG_MB_RAM		0x2008
+#define MB_EN			0x01
+#define MB_HOST_PUT		0x02
+#define MB_RF_PUT		0x04
+#define IT_FIELD_FALLING	0x08
+#define IT_FIELD_RISING		0x10
+#define IT_RF_PUT		0x20
+#define IT_RF_GET		0x40
+
+#define REC_SIZE		16
+#define REC_NBR			1000
+
+static stubI2CDev_t *_tag;
+static nfcXfer_t _xfer;
+static uint32_t _first = 0, _next = REC_NBR;
+static uint32_t _readFail = UINT32_MAX;	// the record of the history read error
+static uint8_t _error = 0;				// the error of the last download
+
+static void range(uint32_t *first, uint32_t *next)
+{
+	*first = _first;
+	*next = _next;
+}
+
+static HAL_StatusTypeDef readRecord(uint32_t seq, uint8_t *record)
+{
+	if (seq == _readFail)
+		return HAL_ERROR;
+	for (int i = 0; i < REC_SIZE; i++)
+		record[i] = (uint8_t) (seq * 7 + i);
+	return HAL_OK;
+}
+
+static HAL_StatusTypeDef put(const uint8_t *data, uint16_t len)
+{
+	return nfc4_WriteMailbox(&hi2c2, data, len);
+}
+
+static const nfcXferIO_t _io = { .put = put, .range = range, .read = readRecord, .recSize = REC_SIZE };
+
+// mysensors.c
+void nfc4_OnMailboxData(uint8_t *data, uint16_t len)
+{
+	nfcXfer_OnData(&_xfer, data, len);
+}
+
+void nfc4_OnMailboxRead()
+{
+	nfcXfer_OnRead(&_xfer);
+}
+
+void nfc4_OnFieldChange(uint8_t onOff)
+{
+	nfcXfer_OnField(&_xfer, onOff);
+}
+
+/*
+ * @brief the mailbox of ST25DV on the I2C side
+ */
+static void tagAccess(stubI2CDev_t *dev, uint16_t memAddress, uint16_t size, uint8_t write)
+{
+	if (write && memAddress == REG_MB_RAM)
+	{
+		dev->Mem[REG_MB_LEN] = (uint8_t) (size - 1);
+		dev->Mem[REG_MB_CTRL] |= MB_HOST_PUT;
+	}
+	else if (!write && memAddress == REG_IT_STS)
+		dev->Mem[REG_IT_STS] = 0;
+	else if (!write && memAddress == REG_MB_RAM && size == dev->Mem[REG_MB_LEN] + 1)
+		dev->Mem[REG_MB_CTRL] &= ~MB_RF_PUT;
+}
+
+/*
+ * @brief the events of RF, the GPO interrupt
+ */
+static void rfEvent(uint8_t it)
+{
+	_tag->Mem[REG_IT_STS] |= it;
+	CHECK_EQ(nfc4_ProcessMailBox(&hi2c2), HAL_OK);
+}
+
+/*
+ * @brief the request of the phone is written to the mailbox
+ * @param irq - the interrupt is processed, 0 - the event is signalled with the next one
+ */
+static void phoneRequest(const uint8_t *req, uint16_t len, uint8_t irq)
+{
+	CHECK(!(_tag->Mem[REG_MB_CTRL] & (MB_HOST_PUT | MB_RF_PUT)));
+	memcpy(&_tag->Mem[REG_MB_RAM], req, len);
+	_tag->Mem[REG_MB_LEN] = (uint8_t) (len - 1);
+	_tag->Mem[REG_MB_CTRL] |= MB_RF_PUT;
+	_tag->Mem[REG_IT_STS] |= IT_RF_PUT;
+	if (irq)
+		rfEvent(0);
+}
+
+static void phoneGet(uint8_t tag, uint32_t from, uint16_t count)
+{
+	uint8_t req[] = { NFCX_CMD_GET, tag, (uint8_t) from, (uint8_t) (from >> 8), (uint8_t) (from >> 16), (uint8_t) (from >> 24),
+		(uint8_t) count, (uint8_t) (count >> 8) };
+
+	phoneRequest(req, sizeof(req), 1);
+}
+
+static void phoneResume(uint8_t tag, uint32_t from)
+{
+	uint8_t req[] = { NFCX_CMD_RESUME, tag, (uint8_t) from, (uint8_t) (from >> 8), (uint8_t) (from >> 16), (uint8_t) (from >> 24) };
+
+	phoneRequest(req, sizeof(req), 1);
+}
+
+/*
+ * @brief the message of the host is read by the phone
+ * @retval length, 0 - no message
+ */
+static uint16_t phoneRead(uint8_t *msg, uint8_t irq)
+{
+	uint16_t len;
+
+	if (!(_tag->Mem[REG_MB_CTRL] & MB_HOST_PUT))
+		return 0;
+	len = _tag->Mem[REG_MB_LEN] + 1;
+	memcpy(msg, &_tag->Mem[REG_MB_RAM], len);
+	_tag->Mem[REG_MB_CTRL] &= ~MB_HOST_PUT;
+	_tag->Mem[REG_IT_STS] |= IT_RF_GET;
+	if (irq)
+		rfEvent(0);
+	return len;
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+	return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+/*
+ * @brief the DATA frame is checked against the history
+ * @retval records of the frame, -1 - wrong frame
+ */
+static int checkFrame(const uint8_t *msg, uint16_t len, uint8_t tag, uint32_t from)
+{
+	uint8_t rec[REC_SIZE];
+	uint8_t count;
+
+	if (len < NFCX_DATA_HEADER || msg[0] != NFCX_DATA || msg[1] != tag || get32(&msg[2]) != from)
+		return -1;
+	count = msg[6];
+	if (len != NFCX_DATA_HEADER + count * REC_SIZE)
+		return -1;
+	for (uint8_t i = 0; i < count; i++)
+	{
+		readRecord(from + i, rec);
+		if (memcmp(&msg[NFCX_DATA_HEADER + i * REC_SIZE], rec, REC_SIZE) != 0)
+			return -1;
+	}
+	return count;
+}
+
+/*
+ * @brief the phone reads the frames up to the end of download
+ * @param stopAt - the phone stops at the record (the field is lost), UINT32_MAX - the end
+ * @retval the next record of the phone, the error message ends the download (_error)
+ */
+static uint32_t phoneDownload(uint8_t tag, uint32_t from, uint32_t stopAt)
+{
+	uint8_t msg[NFCX_FRAME_MAX];
+	uint16_t len;
+
+	while ((len = phoneRead(msg, 1)) > 0)
+	{
+		int count = checkFrame(msg, len, tag, from);
+
+		_error = (msg[0] == NFCX_ERROR) ? msg[2] : 0;
+		if (_error != 0)
+			break;
+		if (count < 0)
+		{
+			CHECK(count >= 0);
+			break;
+		}
+		if (count == 0)
+			break;
+		from += count;
+		if (from >= stopAt)
+			break;
+	}
+	return from;
+}
+
+static void tagInit(void)
+{
+	stub_I2CReset();
+	_tag = stub_I2CAdd(NFC4_USER, 1);
+	_tag->Mem[REG_MB_CTRL] = MB_EN;
+	_tag->OnAccess = tagAccess;
+	CHECK_EQ(nfc4_InitWarm(&hi2c2), HAL_OK);
+	CHECK(nfc4_IsMailbox());
+	nfcXfer_Inic(&_xfer, &_io);
+	_first = 0;
+	_next = REC_NBR;
+	_readFail = UINT32_MAX;
+}
+
+static void testTransfer(void)
+{
+	uint8_t info[] = { NFCX_CMD_INFO, 1 }, bad[] = { 0x33, 2 }, shortGet[] = { NFCX_CMD_GET, 3, 0 }, msg[NFCX_FRAME_MAX];
+	uint8_t perFrame = (NFCX_FRAME_MAX - NFCX_DATA_HEADER) / REC_SIZE;
+	uint32_t start;
+
+	tagInit();
+	rfEvent(IT_FIELD_RISING);
+	CHECK(_xfer.Field);
+	// INFO
+	phoneRequest(info, sizeof(info), 1);
+	CHECK_EQ(phoneRead(msg, 1), 12);
+	CHECK_EQ(msg[0], NFCX_CMD_INFO | NFCX_RESPONSE);
+	CHECK_EQ(msg[1], 1);
+	CHECK_EQ(get32(&msg[2]), 0);
+	CHECK_EQ(get32(&msg[6]), REC_NBR);
+	CHECK_EQ(msg[10], REC_SIZE);
+	CHECK_EQ(msg[11], perFrame);
+	// all records, the end of download (count 0) closes it
+	start = stub_Tick;
+	phoneGet(5, 0, 0xFFFF);
+	CHECK_EQ(phoneDownload(5, 0, UINT32_MAX), REC_NBR);
+	CHECK_EQ(_xfer.State, NFCX_IDLE);
+	CHECK_EQ(_xfer.Frames, (REC_NBR + perFrame - 1) / perFrame + 1);
+	printf("%u records of %u B: %lu frames, %lu ms of I2C\n", REC_NBR, REC_SIZE, (unsigned long) _xfer.Frames,
+		(unsigned long) (stub_Tick - start));
+	// the range, the count over the end
+	phoneGet(6, 990, 5);
+	CHECK_EQ(phoneDownload(6, 990, UINT32_MAX), 995);
+	phoneGet(7, 990, 100);
+	CHECK_EQ(phoneDownload(7, 990, UINT32_MAX), REC_NBR);
+	// the oldest records have been overwritten
+	_first = 100;
+	phoneGet(8, 0, 20);
+	CHECK_EQ(phoneDownload(8, 100, UINT32_MAX), 120);
+	// the errors
+	phoneGet(9, REC_NBR, 1);
+	CHECK_EQ(phoneRead(msg, 1), NFCX_HEADER + 1);
+	CHECK(msg[0] == NFCX_ERROR && msg[1] == 9 && msg[2] == NFCX_ERR_RANGE);
+	phoneRequest(bad, sizeof(bad), 1);
+	CHECK_EQ(phoneRead(msg, 1), NFCX_HEADER + 1);
+	CHECK(msg[0] == NFCX_ERROR && msg[1] == 2 && msg[2] == NFCX_ERR_CMD);
+	phoneRequest(shortGet, sizeof(shortGet), 1);
+	CHECK_EQ(phoneRead(msg, 1), NFCX_HEADER + 1);
+	CHECK(msg[0] == NFCX_ERROR && msg[1] == 3 && msg[2] == NFCX_ERR_LEN);
+	phoneResume(4, 0);
+	CHECK_EQ(phoneRead(msg, 1), NFCX_HEADER + 1);
+	CHECK(msg[0] == NFCX_ERROR && msg[1] == 4 && msg[2] == NFCX_ERR_STATE);
+	// the history read error ends the download
+	_readFail = 150;
+	phoneGet(10, 100, 0xFFFF);
+	CHECK_EQ(phoneDownload(10, 100, UINT32_MAX), 100 + 3 * perFrame);
+	CHECK_EQ(_error, NFCX_ERR_READ);
+	CHECK_EQ(phoneRead(msg, 1), 0);
+	CHECK_EQ(_xfer.State, NFCX_IDLE);
+	CHECK_EQ(_xfer.Timeouts, 0);
+}
+
+static void testAbort(void)
+{
+	uint8_t stop[] = { NFCX_CMD_STOP, 12 }, info[] = { NFCX_CMD_INFO, 13 }, msg[NFCX_FRAME_MAX];
+	uint8_t perFrame = (NFCX_FRAME_MAX - NFCX_DATA_HEADER) / REC_SIZE;
+	uint32_t next, frames;
+	uint16_t len;
+
+	tagInit();
+	rfEvent(IT_FIELD_RISING);
+	phoneGet(11, 0, 0xFFFF);
+	next = phoneDownload(11, 0, 10 * perFrame);
+	CHECK_EQ(next, 10 * perFrame);
+	// the field is lost with the next frame in the mailbox, MB_WDG releases it
+	CHECK(_tag->Mem[REG_MB_CTRL] & MB_HOST_PUT);
+	rfEvent(IT_FIELD_FALLING);
+	CHECK_EQ(_xfer.State, NFCX_PAUSED);
+	CHECK(!_xfer.Field);
+	_tag->Mem[REG_MB_CTRL] &= ~MB_HOST_PUT;
+	// the frame read without the field does not continue
+	frames = _xfer.Frames;
+	rfEvent(IT_RF_GET);
+	CHECK_EQ(_xfer.Frames, frames);
+	// the phone is back and continues by the next record it needs
+	rfEvent(IT_FIELD_RISING);
+	CHECK_EQ(_xfer.State, NFCX_PAUSED);
+	CHECK(!(_tag->Mem[REG_MB_CTRL] & MB_HOST_PUT));
+	phoneResume(11, next);
+	CHECK_EQ(_xfer.Resent, 1);
+	CHECK_EQ(phoneDownload(11, next, UINT32_MAX), REC_NBR);
+	CHECK_EQ(_xfer.State, NFCX_IDLE);
+	// STOP together with the read of the frame: the next frame waits for the busy mailbox, STOP ends the download
+	phoneGet(12, 0, 0xFFFF);
+	CHECK_EQ(phoneRead(msg, 0), NFCX_DATA_HEADER + perFrame * REC_SIZE);
+	phoneRequest(stop, sizeof(stop), 0);
+	rfEvent(0);
+	CHECK_EQ(_xfer.State, NFCX_IDLE);
+	CHECK(!_xfer.Waiting);
+	len = phoneRead(msg, 1);
+	CHECK(len == NFCX_HEADER && msg[0] == (NFCX_CMD_STOP | NFCX_RESPONSE) && msg[1] == 12);
+	CHECK_EQ(phoneRead(msg, 1), 0);
+	// INFO together with the read of the frame: the next frame is written after the response has been read
+	phoneGet(13, 0, 0xFFFF);
+	CHECK_EQ(phoneRead(msg, 0), NFCX_DATA_HEADER + perFrame * REC_SIZE);
+	phoneRequest(info, sizeof(info), 0);
+	rfEvent(0);
+	CHECK(_xfer.Waiting);
+	CHECK_EQ(phoneRead(msg, 1), 12);
+	CHECK_EQ(msg[0], NFCX_CMD_INFO | NFCX_RESPONSE);
+	CHECK(!_xfer.Waiting);
+	CHECK_EQ(phoneDownload(13, perFrame, UINT32_MAX), REC_NBR);
+	CHECK_EQ(_xfer.Timeouts, 0);
+}
+
+static void testTimeout(void)
+{
+	uint8_t msg[NFCX_FRAME_MAX];
+	uint8_t perFrame = (NFCX_FRAME_MAX - NFCX_DATA_HEADER) / REC_SIZE;
+	uint32_t next;
+
+	tagInit();
+	// paused, the phone does not come back
+	rfEvent(IT_FIELD_RISING);
+	phoneGet(20, 0, 0xFFFF);
+	next = phoneDownload(20, 0, 2 * perFrame);
+	rfEvent(IT_FIELD_FALLING);
+	_tag->Mem[REG_MB_CTRL] &= ~MB_HOST_PUT;
+	stub_Tick += NFCX_TIMEOUT_MS;
+	CHECK_EQ(nfcXfer_CheckTimeout(&_xfer), 0);
+	stub_Tick += 1;
+	CHECK_EQ(nfcXfer_CheckTimeout(&_xfer), 1);
+	CHECK_EQ(_xfer.State, NFCX_IDLE);
+	CHECK_EQ(_xfer.Timeouts, 1);
+	CHECK_EQ(nfcXfer_CheckTimeout(&_xfer), 0);
+	// RESUME of the ended download, the phone starts again by GET
+	rfEvent(IT_FIELD_RISING);
+	phoneResume(20, next);
+	CHECK_EQ(phoneRead(msg, 1), NFCX_HEADER + 1);
+	CHECK(msg[0] == NFCX_ERROR && msg[2] == NFCX_ERR_STATE);
+	phoneGet(21, next, 0xFFFF);
+	CHECK_EQ(phoneDownload(21, next, UINT32_MAX), REC_NBR);
+	// the frame is never read in the field
+	phoneGet(22, 0, 0xFFFF);
+	CHECK_EQ(_xfer.State, NFCX_STREAM);
+	stub_Tick += NFCX_TIMEOUT_MS + 1;
+	CHECK_EQ(nfcXfer_CheckTimeout(&_xfer), 1);
+	CHECK_EQ(_xfer.Timeouts, 2);
+	// the late read of the frame does not continue the ended download
+	CHECK(phoneRead(msg, 1) > 0);
+	CHECK_EQ(phoneRead(msg, 1), 0);
+	// the slow phone, the events within the timeout
+	phoneGet(23, 0, 0xFFFF);
+	next = 0;
+	while (_xfer.State == NFCX_STREAM)
+	{
+		uint16_t len;
+		int count;
+
+		stub_Tick += NFCX_TIMEOUT_MS / 2;
+		CHECK_EQ(nfcXfer_CheckTimeout(&_xfer), 0);
+		len = phoneRead(msg, 1);
+		count = checkFrame(msg, len, 23, next);
+		if (count < 0)
+		{
+			CHECK(count >= 0);
+			break;
+		}
+		next += count;
+	}
+	CHECK_EQ(next, REC_NBR);
+	CHECK_EQ(_xfer.Timeouts, 2);
+}
+
+int main(void)
+{
+	testTransfer();
+	testAbort();
+	testTimeout();
+	return TEST_RESULT();
+}
@@ -0,0 +1,100 @@
+/*
+ * test_planner.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * airtime and duty-cycle planner (user-027), lora_planner.c with LmHandler stubbed
+ * - time on air of all datarates of RegionEU868 and RegionUS915 against the formula of SX126x datasheet
+ *   (floating point), payloads 0..222 bytes
+ * - the plan and the next TX delay from the MAC (busy MAC falls back to the duty-cycle wait)
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include "test.h"
+#include "lora_planner.h"
+#include "lmhandler_stub.h"
+
+/*
+ * @brief reference time on air (ms, rounded up), LoRa: preamble 8, explicit header, CRC, CR 4/5; FSK 50 kbps
+ */
+static uint32_t refToA(uint8_t sf, uint16_t bwKHz, uint8_t size)
+{
+	uint32_t pl = size + LORAMAC_FRAME_PAYLOAD_OVERHEAD_SIZE;
+
+	if (sf == 0)	// FSK: preamble 5, sync 3, length 1, CRC 2 bytes
+		return (uint32_t) ceil((5 + 3 + 1 + pl + 2) * 8 / 50.0);
+
+	double tSym = (double) (1 << sf) / bwKHz;
+	int de = (bwKHz == 125 && sf >= 11) || (bwKHz == 250 && sf == 12);
+	double n = ceil((8.0 * pl - 4 * sf + 28 + 16) / (4 * (sf - 2 * de))) * 5;
+
+	if (n < 0)
+		n = 0;
+	return (uint32_t) ceil(((8 + 4.25) + 8 + n) * tSym - 1e-9);	// exact ms are not rounded up by the float error
+}
+
+static void testRegion(LoRaMacRegion_t region, const char *name, const uint8_t *sf, const uint16_t *bw, int8_t drCount)
+{
+	int worst = 0;
+
+	stub_Region = region;
+	loraPlanner_Init();
+	for (int8_t dr = 0; dr < drCount; dr++)
+		for (int size = 0; size <= 222; size++)
+		{
+			uint32_t toa = loraPlanner_TimeOnAir(dr, (uint8_t) size);
+
+			if (bw[dr] == 0)
+			{
+				CHECK_EQ(toa, 0);
+				continue;
+			}
+			int diff = (int) toa - (int) refToA(sf[dr], bw[dr], (uint8_t) size);
+			if (abs(diff) > abs(worst))
+				worst = diff;
+			CHECK_EQ(diff, 0);
+		}
+	CHECK_EQ(loraPlanner_TimeOnAir(-1, 10), 0);
+	CHECK_EQ(loraPlanner_TimeOnAir(drCount, 10), 0);
+	printf("%s: DR0..DR%d, max. difference %d ms\n", name, drCount - 1, worst);
+}
+
+static void testPlan(void)
+{
+	loraPlan_t plan;
+
+	stub_Region = LORAMAC_REGION_EU868;
+	loraPlanner_Init();
+	stub_Datarate = DR_5;
+	stub_MaxPayload = 222;
+	stub_NextTxDelay = 1234;
+	stub_NextTxStatus = LORAMAC_HANDLER_SUCCESS;
+	CHECK_EQ(loraPlanner_GetPlan(16, &plan), HAL_OK);
+	CHECK_EQ(plan.Datarate, DR_5);
+	CHECK_EQ(plan.MaxPayload, 222);
+	CHECK_EQ(plan.TimeOnAir, loraPlanner_TimeOnAir(DR_5, 16));
+	CHECK_EQ(plan.NextTxDelay, 1234);
+	CHECK_EQ(loraPlanner_NextTxDelay(16), 1234);
+
+	// MAC cannot plan (busy), the wait of the duty cycle is used
+	stub_NextTxStatus = LORAMAC_HANDLER_ERROR;
+	stub_DutyCycleWait = 5000;
+	CHECK_EQ(loraPlanner_GetPlan(16, &plan), HAL_ERROR);
+	CHECK_EQ(loraPlanner_NextTxDelay(16), 5000);
+}
+
+int main(void)
+{
+	// sf 0 - FSK 50 kbps, bw 0 - not supported (LR-FHSS, RFU)
+	static const uint8_t sfEU[] = { 12, 11, 10, 9, 8, 7, 7, 0 };
+	static const uint16_t bwEU[] = { 125, 125, 125, 125, 125, 125, 250, 50 };
+	static const uint8_t sfUS[] = { 10, 9, 8, 7, 8, 0, 0, 0, 12, 11, 10, 9, 8, 7 };
+	static const uint16_t bwUS[] = { 125, 125, 125, 125, 500, 0, 0, 0, 500, 500, 500, 500, 500, 500 };
+
+	testRegion(LORAMAC_REGION_EU868, "EU868", sfEU, bwEU, sizeof(sfEU));
+	testRegion(LORAMAC_REGION_US915, "US915", sfUS, bwUS, sizeof(sfUS));
+	testPlan();
+	return TEST_RESULT();
+}
@@ -0,0 +1,160 @@
+/*
+ * test_presence.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * probing of absent sensors with exponential backoff (user-032), presence_t with the backoffs of mysensors.c
+ * - the backoff sequence, the cap, the restart after the lost device and the tick overflow
+ * - 8 h replay of the sensor removed and re-added: xxx_Is(tryInit) every 3 s (10 readings per 30 s cycle),
+ *   the count of init attempts and the delay of finding the re-added sensor
+ */
+
+#include "test.h"
+#include "main.h"
+#include "utils/utils.h"
+
+#define BACKOFF_MIN		30000		// _presenceBackoffMin
+#define BACKOFF_MAX		3600000		// _presenceBackoffMax
+#define CALL_MS			3000
+
+/*
+ * @brief the sensor and its driver xxx_Is(tryInit) as called by sensors_Read
+ */
+typedef struct
+{
+	int plugged;		// the sensor is physically present
+	uint32_t calls;
+	uint32_t inits;		// xxx_Init attempts (init with timeouts and retries)
+} device_t;
+
+static int8_t deviceIs(device_t *d, presence_t *p, uint8_t dev)
+{
+	int8_t is;
+
+	d->calls++;
+	if (presence_Is(p, dev))
+		is = d->plugged;	// the operation of initialized sensor fails, if it is removed
+	else if (presence_IsProbe(p, dev))	// sensors_TryInit
+	{
+		d->inits++;
+		is = d->plugged;
+	}
+	else
+		is = 0;
+	presence_Set(p, dev, is);	// sensors_Present
+	return is;
+}
+
+static void testBackoff(void)
+{
+	presence_t p;
+	uint32_t expect = BACKOFF_MIN;
+
+	stub_Tick = 1000;
+	presence_Inic(&p, BACKOFF_MIN, BACKOFF_MAX);
+	CHECK(presence_IsProbe(&p, 0));		// unknown
+	presence_Set(&p, 0, 0);
+	CHECK(!presence_Is(&p, 0));
+	// the failed probes double the backoff up to the max.
+	for (int i = 0; i < 10; i++)
+	{
+		stub_Tick += expect - 1;
+		CHECK(!presence_IsProbe(&p, 0));
+		stub_Tick += 1;
+		CHECK(presence_IsProbe(&p, 0));
+		presence_Set(&p, 0, 0);
+		expect = (expect >= BACKOFF_MAX / 2) ? BACKOFF_MAX : expect * 2;
+		CHECK_EQ(p.Backoff[0], expect);
+	}
+	CHECK_EQ(p.Backoff[0], BACKOFF_MAX);
+	// the result outside of the probe (no init) does not change the backoff
+	presence_Set(&p, 0, 0);
+	CHECK_EQ(p.Backoff[0], BACKOFF_MAX);
+
+	// found, lost: the backoff starts at the min.
+	stub_Tick += BACKOFF_MAX;
+	presence_Set(&p, 0, 1);
+	CHECK(presence_Is(&p, 0));
+	CHECK(!presence_IsProbe(&p, 0));
+	presence_Set(&p, 0, 0);
+	CHECK_EQ(p.Backoff[0], BACKOFF_MIN);
+	CHECK(!presence_IsProbe(&p, 0));
+
+	// the other devices are independent, out of range is never probed
+	CHECK(presence_IsProbe(&p, 1));
+	CHECK(!presence_IsProbe(&p, PRESENCE_DEV_MAX));
+	presence_Set(&p, PRESENCE_DEV_MAX, 1);
+	CHECK(!presence_Is(&p, PRESENCE_DEV_MAX));
+
+	// tick overflow (49 days)
+	stub_Tick = UINT32_MAX - 1000;
+	presence_Set(&p, 2, 0);
+	stub_Tick += BACKOFF_MIN - 1;
+	CHECK(!presence_IsProbe(&p, 2));
+	stub_Tick += 1;
+	CHECK(presence_IsProbe(&p, 2));
+}
+
+/*
+ * @brief 8 h replay, plug[] - times (ms) of the change of the sensor presence, the sensor is absent at the start
+ * @retval max. delay (ms) of finding the re-added sensor
+ */
+static uint32_t replay(const uint32_t *plug, int plugCount, device_t *d)
+{
+	presence_t p;
+	uint32_t added = UINT32_MAX, maxDelay = 0;	// added - time of adding, the sensor is not found yet
+	int next = 0;
+
+	presence_Inic(&p, BACKOFF_MIN, BACKOFF_MAX);
+	d->plugged = 0;
+	d->calls = d->inits = 0;
+	for (uint32_t t = 0; t < 8 * 3600000U; t += CALL_MS)
+	{
+		stub_Tick = t;
+		if (next < plugCount && t >= plug[next])
+		{
+			d->plugged = !d->plugged;
+			added = d->plugged ? t : UINT32_MAX;
+			next++;
+		}
+		int8_t is = deviceIs(d, &p, 0);
+
+		// never reported after the sensor has been removed
+		CHECK(!is || d->plugged);
+		if (is && added != UINT32_MAX)
+		{
+			if (t - added > maxDelay)
+				maxDelay = t - added;
+			added = UINT32_MAX;
+		}
+		// the re-added sensor is found within the max. backoff
+		CHECK(added == UINT32_MAX || t - added <= BACKOFF_MAX);
+	}
+	return maxDelay;
+}
+
+static void testReplay(void)
+{
+	// absent at boot, added at 2 h, removed at 5 h, re-added at 6 h, removed at 7:30, re-added at 7:31
+	static const uint32_t plug[] = { 2 * 3600000U, 5 * 3600000U, 6 * 3600000U, 27000000U, 27060000U };
+	device_t d;
+	uint32_t delay = replay(plug, 5, &d);
+
+	printf("8 h, sensor removed and re-added: %lu calls of xxx_Is, %lu init attempts (every call with tryInit = 1), "
+		"max. delay of finding %lu s\n", (unsigned long) d.calls, (unsigned long) d.inits, (unsigned long) delay / 1000);
+	CHECK(d.inits * 100 < d.calls);
+	CHECK(delay <= BACKOFF_MAX);
+
+	// always absent: the backoff up to the hourly rescan
+	replay(NULL, 0, &d);
+	printf("8 h, sensor absent: %lu init attempts\n", (unsigned long) d.inits);
+	CHECK(d.inits <= 1 + 7 + 8);	// 30 s .. 32 min (7 probes), then every hour
+}
+
+int main(void)
+{
+	testBackoff();
+	testReplay();
+	return TEST_RESULT();
+}
@@ -0,0 +1,234 @@
+/*
+ * test_pwrdomain.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * reference-counted power domains with the lazy init after STOP2 (user-046), pwrdomain.c on stub/periph.c
+ * - MX_xxx_Init/DeInit per wake reason: timer only (RX window, LED), the sensor step (I2C2, more transfers),
+ *   the flash (SPI1, more accesses), the trace (USART1), DMA TX pending over STOP2, the battery (ADC),
+ *   the console held by DEBUG (initialized again after every wakeup, RX armed by pwrDomain_OnReady)
+ * - against PWR_ExitStopMode/PWR_EnterStopMode of ST (MX_SPI1_Init, vcom_Resume every wakeup, i2c_OnOff per cycle)
+ * - one day of the wakeups: 5 min cycles of 6 sensor steps, 96 uplinks with 2 RX windows, 200 timer-only wakes
+ */
+
+#include "test.h"
+#include "pwrdomain.h"
+
+#define DOMAINS		PWR_DOMAIN_NBR
+
+typedef struct
+{
+	const char *name;
+	void (*work)(void);
+	uint8_t inits[DOMAINS];		// expected MX_xxx_Init per wake (release build)
+} wakeReason_t;
+
+static uint32_t _onReady[DOMAINS];
+
+void clockProf_Retime(pwrDomainId_t id)
+{
+}
+
+void pwrDomain_OnReady(pwrDomainId_t id)
+{
+	_onReady[id]++;
+}
+
+static void wakeTimer(void)
+{
+}
+
+static void wakeSensor(void)
+{
+	// i2c_OnOff around the sequencer step, the driver does more transfers
+	for (int i = 0; i < 3; i++)
+	{
+		pwrDomain_Acquire(PWR_DOMAIN_I2C2);
+		pwrDomain_Release(PWR_DOMAIN_I2C2);
+	}
+}
+
+static void wakeFlash(void)
+{
+	// spi_OnOff: the record of the batch and the read back
+	pwrDomain_Acquire(PWR_DOMAIN_SPI1);
+	pwrDomain_Release(PWR_DOMAIN_SPI1);
+	pwrDomain_Acquire(PWR_DOMAIN_SPI1);
+	pwrDomain_Release(PWR_DOMAIN_SPI1);
+}
+
+static void wakeTrace(void)
+{
+	// vcom_Trace, blocking
+	pwrDomain_Acquire(PWR_DOMAIN_USART1);
+	pwrDomain_Release(PWR_DOMAIN_USART1);
+}
+
+static void wakeBattery(void)
+{
+	pwrDomain_Acquire(PWR_DOMAIN_ADC);
+	pwrDomain_Release(PWR_DOMAIN_ADC);
+}
+
+static void wakeUplink(void)
+{
+	// the sensors (NFC mailbox on I2C2), the record to the flash, the battery of DevStatus
+	wakeSensor();
+	wakeFlash();
+	wakeBattery();
+}
+
+static const wakeReason_t _reasons[] = {
+	{ "timer", wakeTimer, { 0, 0, 0, 0 } },
+	{ "sensor step", wakeSensor, { 1, 0, 0, 0 } },
+	{ "flash", wakeFlash, { 0, 1, 0, 0 } },
+	{ "trace", wakeTrace, { 0, 0, 1, 0 } },
+	{ "battery", wakeBattery, { 0, 0, 0, 1 } },
+	{ "uplink", wakeUplink, { 1, 1, 0, 1 } },
+};
+
+/*
+ * @brief STOP2 and the wakeup of PWR_EnterStopMode/PWR_ExitStopMode
+ */
+static void stop2(void)
+{
+	pwrDomain_OnStop();
+	pwrDomain_OnWake();
+}
+
+static void boot(uint8_t debug)
+{
+	for (int i = 0; i < DOMAINS; i++)
+		_onReady[i] = 0;
+	// MX_xxx_Init of main
+	pwrDomain_Init((1 << PWR_DOMAIN_I2C2) | (1 << PWR_DOMAIN_SPI1) | (1 << PWR_DOMAIN_USART1));
+	if (debug)
+		pwrDomain_Acquire(PWR_DOMAIN_USART1);	// Uart_Start
+	stop2();	// the peripherals of the boot are gated
+}
+
+/*
+ * @brief one wakeup of the reason
+ * @retval MX_xxx_Init of the domains
+ */
+static uint32_t wake(const wakeReason_t *r, uint32_t *inits, uint32_t *deInits)
+{
+	uint32_t total = 0;
+	stubPeriph_t before = stub_Periph;
+
+	r->work();
+	stop2();
+	for (int i = 0; i < DOMAINS; i++)
+	{
+		inits[i] = stub_Periph.Init[i] - before.Init[i];
+		deInits[i] = stub_Periph.DeInit[i] - before.DeInit[i];
+		total += inits[i];
+	}
+	return total;
+}
+
+static void testReasons(void)
+{
+	uint32_t inits[DOMAINS], deInits[DOMAINS];
+
+	for (int debug = 0; debug < 2; debug++)
+	{
+		boot(debug);
+		printf("%s, per wake (I2C2/SPI1/USART1/ADC, init-deinit), ST: 2 inits (SPI1, USART1) + I2C2 of the cycle\n",
+			debug ? "DEBUG" : "release");
+		for (unsigned r = 0; r < sizeof(_reasons) / sizeof(_reasons[0]); r++)
+		{
+			wake(&_reasons[r], inits, deInits);
+			printf("  %-12s", _reasons[r].name);
+			for (int i = 0; i < DOMAINS; i++)
+			{
+				printf(" %lu-%lu", (unsigned long) inits[i], (unsigned long) deInits[i]);
+				// the console is held, initialized again after every wakeup
+				uint8_t expect = (debug && i == PWR_DOMAIN_USART1) ? 1 : _reasons[r].inits[i];
+
+				CHECK_EQ(inits[i], expect);
+				CHECK_EQ(deInits[i], expect);	// gated by the next STOP2 (or the held one before the init)
+			}
+			printf("\n");
+		}
+		for (int i = 0; i < DOMAINS; i++)
+			CHECK_EQ(pwrDomain_Get(i)->Refs, debug && i == PWR_DOMAIN_USART1);
+		// RX of the console is armed after every init of the held UART
+		CHECK_EQ(_onReady[PWR_DOMAIN_USART1], debug ? pwrDomain_Get(PWR_DOMAIN_USART1)->Inits : 1);
+	}
+}
+
+static void testDmaPending(void)
+{
+	uint32_t inits[DOMAINS], deInits[DOMAINS];
+	const wakeReason_t dma = { "dma", wakeTimer, { } };
+
+	boot(0);
+	// DMA TX is released by HAL_UART_TxCpltCallback after STOP2
+	pwrDomain_Acquire(PWR_DOMAIN_USART1);
+	wake(&dma, inits, deInits);
+	CHECK_EQ(inits[PWR_DOMAIN_USART1], 1);		// the registers are lost, initialized again after the wakeup
+	CHECK_EQ(deInits[PWR_DOMAIN_USART1], 1);	// MSP of the stale one first
+	CHECK(pwrDomain_Get(PWR_DOMAIN_USART1)->Ready);
+	pwrDomain_Release(PWR_DOMAIN_USART1);
+	wake(&dma, inits, deInits);
+	CHECK_EQ(inits[PWR_DOMAIN_USART1], 0);
+	CHECK_EQ(deInits[PWR_DOMAIN_USART1], 1);
+	CHECK(!pwrDomain_Get(PWR_DOMAIN_USART1)->Ready);
+}
+
+/*
+ * @brief one day of the wakeups
+ * @retval MX_xxx_Init of the domains, *st - of PWR_ExitStopMode of ST
+ */
+static uint32_t day(uint8_t debug, uint32_t *st)
+{
+	uint32_t inits[DOMAINS], deInits[DOMAINS], total = 0, wakes = 0, cycles = 0;
+
+	boot(debug);
+	for (uint32_t cycle = 0; cycle < 24 * 60 / 5; cycle++)
+	{
+		total += wake(&_reasons[4], inits, deInits);	// the battery of the governor
+		for (int step = 0; step < 6; step++)
+			total += wake(&_reasons[1], inits, deInits);
+		wakes += 7;
+		cycles++;
+		if (cycle % 3 == 0)
+		{
+			total += wake(&_reasons[5], inits, deInits);
+			total += wake(&_reasons[0], inits, deInits);	// RX1
+			total += wake(&_reasons[0], inits, deInits);	// RX2
+			wakes += 3;
+		}
+		if (cycle % 3 == 1)
+		{
+			total += wake(&_reasons[3], inits, deInits);
+			wakes++;
+		}
+	}
+	for (int i = 0; i < 200; i++)
+		total += wake(&_reasons[0], inits, deInits);	// LED, the timers of the application
+	wakes += 200;
+	// ST: SPI1 and USART1 every wakeup, I2C2 by i2c_OnOff once per cycle, ADC by every reading
+	*st = wakes * 2 + cycles + cycles + 96;
+	return total;
+}
+
+static void testDay(void)
+{
+	uint32_t st, release = day(0, &st), debug = day(1, &st);
+
+	printf("one day: %lu inits (release), %lu (DEBUG), ST %lu\n", (unsigned long) release, (unsigned long) debug,
+		(unsigned long) st);
+	CHECK(release * 2 < st);
+	CHECK(debug < st);
+}
+
+int main(void)
+{
+	testReasons();
+	testDmaPending();
+	testDay();
+	return TEST_RESULT();
+}
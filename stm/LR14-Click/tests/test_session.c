@@ -0,0 +1,247 @@
+/*
+ * test_session.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * resume of the stored LoRaWAN session (user-035), lora_session.c with the NVM context of the MAC, the restore
+ * by LmHandlerConfigure and the RTC time modelled by the test, the backup registers in stub/periph.c
+ * - the reset: the uplink counter is moved to the watermark of DR7 (the uplinks after the last NVM store)
+ * - the power-on (the magic of DR6 lost): the counter is moved by LORAWAN_SESSION_STORE_PERIOD, the age
+ *   of the session is counted from the power-on
+ * - the rejoin: DevNonce of the NVM older than the last join, the session older than 7 days, the context
+ *   not restored
+ * - the NVM store every LORAWAN_SESSION_STORE_PERIOD uplinks and at the first uplink after the power-on (two
+ *   power-ons without the store moved the counter from the same NVM), the random resets and power-ons over
+ *   20000 uplinks: the uplink counter never goes back
+ */
+
+#include <string.h>
+#include "test.h"
+#include "lora_app.h"
+#include "lora_session.h"
+#include "lmhandler_stub.h"
+#include "stm32_systime.h"
+
+#define DAY_S			86400
+
+static LoRaMacNvmData_t _nvm;			// the context of the MAC
+static LoRaMacNvmData_t _nvmStored;		// the context in the flash
+static uint8_t _nvmValid = 0;			// the stored context passed CRC
+static uint8_t _nvmStoreFail = 0;
+static uint32_t _nvmStores = 0;
+static uint8_t _mibFail = 0;
+static uint32_t _now = 0;				// RTC (s)
+
+LoRaMacStatus_t LoRaMacMibGetRequestConfirm(MibRequestConfirm_t *mibGet)
+{
+	if (_mibFail || mibGet->Type != MIB_NVM_CTXS)
+		return LORAMAC_STATUS_PARAMETER_INVALID;
+	mibGet->Param.Contexts = &_nvm;
+	return LORAMAC_STATUS_OK;
+}
+
+SysTime_t SysTimeGetMcuTime(void)
+{
+	SysTime_t t = { .Seconds = _now, .SubSeconds = 0 };
+
+	return t;
+}
+
+static void nvmStore(void)
+{
+	_nvmStores++;
+	if (_nvmStoreFail)
+		return;
+	_nvmStored = _nvm;
+	_nvmValid = 1;
+}
+
+/*
+ * @brief the reset, LmHandlerConfigure restores the stored context
+ * @param powerOn - the backup registers are lost
+ * @retval loraSession_CanResume
+ */
+static int8_t reset(uint8_t powerOn)
+{
+	if (powerOn)
+		memset(stub_RtcBkp, 0, sizeof(stub_RtcBkp));
+	memset(&_nvm, 0, sizeof(_nvm));
+	if (_nvmValid)
+		_nvm = _nvmStored;
+	stub_JoinStatus = _nvmValid ? LORAMAC_HANDLER_SET : LORAMAC_HANDLER_RESET;
+	return loraSession_CanResume();
+}
+
+/*
+ * @brief the join accepted (OnJoinRequest of lora_app.c)
+ */
+static void join(uint16_t devNonce)
+{
+	memset(&_nvm, 0, sizeof(_nvm));
+	_nvm.Crypto.DevNonce = devNonce;
+	stub_JoinStatus = LORAMAC_HANDLER_SET;
+	loraSession_OnJoined();
+	nvmStore();
+}
+
+/*
+ * @brief the uplinks sent (OnTxData of lora_app.c)
+ */
+static void uplinks(uint32_t count)
+{
+	while (count-- > 0)
+	{
+		_nvm.Crypto.FCntList.FCntUp++;
+		if (loraSession_OnTxDone(_nvm.Crypto.FCntList.FCntUp))
+			nvmStore();
+		_now += 60;
+	}
+}
+
+static void testReset(void)
+{
+	memset(stub_RtcBkp, 0, sizeof(stub_RtcBkp));
+	_nvmValid = 0;
+	_now = 1000;
+	CHECK_EQ(reset(1), 0);	// nothing stored
+	join(5);
+	CHECK_EQ(_nvmStores, 1);
+	uplinks(100);
+	CHECK_EQ(_nvmStores, 4);
+	CHECK_EQ(_nvmStored.Crypto.FCntList.FCntUp, 3 * LORAWAN_SESSION_STORE_PERIOD);
+	CHECK_EQ(stub_RtcBkp[RTC_BKP_DR7], 100);
+	// the watermark of DR7 is applied over the stored counter
+	_now += 3600;
+	CHECK_EQ(reset(0), 1);
+	CHECK_EQ(_nvm.Crypto.FCntList.FCntUp, 100);
+	// the next store after the period from the stored counter
+	_nvmStores = 0;
+	uplinks(4 * LORAWAN_SESSION_STORE_PERIOD - 100 - 1);
+	CHECK_EQ(_nvmStores, 0);
+	uplinks(1);
+	CHECK_EQ(_nvmStores, 1);
+	CHECK_EQ(_nvmStored.Crypto.FCntList.FCntUp, 4 * LORAWAN_SESSION_STORE_PERIOD);
+	// the stored counter is not moved back by the lower watermark
+	stub_RtcBkp[RTC_BKP_DR7] = 50;
+	CHECK_EQ(reset(0), 1);
+	CHECK_EQ(_nvm.Crypto.FCntList.FCntUp, 4 * LORAWAN_SESSION_STORE_PERIOD);
+}
+
+static void testPowerOn(void)
+{
+	uint32_t stored = _nvmStored.Crypto.FCntList.FCntUp;
+
+	uplinks(LORAWAN_SESSION_STORE_PERIOD - 1);	// the last uplinks before the store are lost with the power
+	CHECK_EQ(_nvmStored.Crypto.FCntList.FCntUp, stored);
+	CHECK_EQ(reset(1), 1);
+	CHECK_EQ(_nvm.Crypto.FCntList.FCntUp, stored + LORAWAN_SESSION_STORE_PERIOD);
+	CHECK_EQ(stub_RtcBkp[RTC_BKP_DR6] >> 16, 0x5E55);
+	CHECK_EQ((uint16_t) stub_RtcBkp[RTC_BKP_DR6], 5);
+	CHECK_EQ(stub_RtcBkp[RTC_BKP_DR7], stored + LORAWAN_SESSION_STORE_PERIOD);
+	CHECK_EQ(stub_RtcBkp[RTC_BKP_DR8], _now);
+	// the first uplink after the power-on is stored, the next power-on moves the counter from it
+	_nvmStores = 0;
+	uplinks(1);
+	CHECK_EQ(_nvmStores, 1);
+	stored += LORAWAN_SESSION_STORE_PERIOD + 1;
+	CHECK_EQ(_nvmStored.Crypto.FCntList.FCntUp, stored);
+	uplinks(LORAWAN_SESSION_STORE_PERIOD - 1);
+	CHECK_EQ(_nvmStores, 1);
+	CHECK_EQ(reset(1), 1);
+	CHECK_EQ(_nvm.Crypto.FCntList.FCntUp, stored + LORAWAN_SESSION_STORE_PERIOD);
+	// the age is counted from the power-on
+	_now += LORAWAN_REJOIN_POLICY_INTERVAL;
+	CHECK_EQ(reset(0), 1);
+	_now += 1;
+	CHECK_EQ(reset(0), 0);
+	// the uplink without the watermarks (before the join) does not request the store
+	memset(stub_RtcBkp, 0, sizeof(stub_RtcBkp));
+	CHECK_EQ(loraSession_OnTxDone(1000), 0);
+	CHECK_EQ(stub_RtcBkp[RTC_BKP_DR7], 0);
+}
+
+static void testRejoin(void)
+{
+	_now = 10 * DAY_S;
+	memset(stub_RtcBkp, 0, sizeof(stub_RtcBkp));
+	join(7);
+	uplinks(10);
+	// the session of 7 days
+	_now = 10 * DAY_S + LORAWAN_REJOIN_POLICY_INTERVAL;
+	CHECK_EQ(reset(0), 1);
+	_now++;
+	CHECK_EQ(reset(0), 0);
+	// the NVM store failed after the rejoin, the keys of the stored session are not valid
+	_now = 20 * DAY_S;
+	_nvmStoreFail = 1;
+	join(8);
+	_nvmStoreFail = 0;
+	CHECK_EQ(_nvmStored.Crypto.DevNonce, 7);
+	CHECK_EQ(reset(0), 0);
+	join(9);
+	CHECK_EQ(reset(0), 1);
+	CHECK_EQ(_nvm.Crypto.FCntList.FCntUp, 0);
+	// the context not restored (CRC), the MIB failed
+	_nvmValid = 0;
+	CHECK_EQ(reset(0), 0);
+	_nvmValid = 1;
+	_mibFail = 1;
+	CHECK_EQ(reset(0), 0);
+	_mibFail = 0;
+	CHECK_EQ(reset(0), 1);
+}
+
+static void testRandom(void)
+{
+	uint32_t seed = 12345, lastSent = 0, resumes = 0, powerOns = 0, rejoins = 0, sent = 0;
+	uint16_t devNonce = 20;
+
+	_now = 100 * DAY_S;
+	memset(stub_RtcBkp, 0, sizeof(stub_RtcBkp));
+	join(devNonce);
+	while (sent < 20000)
+	{
+		uint32_t n;
+		uint8_t powerOn;
+
+		seed = seed * 1103515245 + 12345;
+		n = (seed >> 16) % 100;
+		uplinks(n);
+		sent += n;
+		lastSent = _nvm.Crypto.FCntList.FCntUp;
+		seed = seed * 1103515245 + 12345;
+		powerOn = ((seed >> 16) % 10) == 0;
+		seed = seed * 1103515245 + 12345;
+		_now += (seed >> 8) % (2 * DAY_S);	// off or without uplinks
+		powerOns += powerOn;
+		if (reset(powerOn))
+		{
+			resumes++;
+			// the next uplink must be over all sent (replay protection of the network server)
+			if (_nvm.Crypto.FCntList.FCntUp < lastSent)
+			{
+				CHECK(_nvm.Crypto.FCntList.FCntUp >= lastSent);
+				break;
+			}
+		}
+		else
+		{
+			rejoins++;
+			join(++devNonce);
+		}
+	}
+	printf("%lu uplinks: %lu resumes (%lu power-ons), %lu rejoins, %lu NVM stores\n", (unsigned long) sent,
+		(unsigned long) resumes, (unsigned long) powerOns, (unsigned long) rejoins, (unsigned long) _nvmStores);
+	CHECK(rejoins > 0);
+	CHECK(resumes > 2 * rejoins);
+}
+
+int main(void)
+{
+	testReset();
+	testPowerOn();
+	testRejoin();
+	testRandom();
+	return TEST_RESULT();
+}
@@ -0,0 +1,198 @@
+/*
+ * test_softse.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * soft-se key cache (user-026): AES and CMAC of the secure element are bit-exact with FIPS-197 and RFC 4493,
+ * with the cache (default) and without it (SOFT_SE_KEY_CACHE_SLOTS=0, test_softse_nocache)
+ * - cache hits, eviction (more keys than slots), SecureElementSetKey, key derivation and NVM restore
+ * - the cost of one MIC with and without the cache
+ */
+
+#include <string.h>
+#include "test.h"
+#include "lorawan_conf.h"	// same key list as soft-se.c (LoRaWAN version)
+#include "LoRaMacVersion.h"
+#include "secure-element.h"
+#include "secure-element-nvm.h"
+#include "cmac.h"
+#include "stm32_adv_trace.h"
+
+#ifndef SOFT_SE_KEY_CACHE_SLOTS
+#define SOFT_SE_KEY_CACHE_SLOTS	3	// default of soft-se.c
+#endif
+
+UTIL_ADV_TRACE_Status_t UTIL_ADV_TRACE_COND_FSend(uint32_t VerboseLevel, uint32_t Region, uint32_t TimeStampState, const char *strFormat, ...)
+{
+	return UTIL_ADV_TRACE_OK;
+}
+
+// RFC 4493, AES-CMAC test vectors
+static const uint8_t _rfcKey[16] = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+static const uint8_t _rfcMsg[64] = {
+	0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+	0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+	0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+	0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10
+};
+static const struct
+{
+	uint32_t len;
+	uint8_t mac[16];
+} _rfcMac[] = {
+	{ 0, { 0xbb, 0x1d, 0x69, 0x29, 0xe9, 0x59, 0x37, 0x28, 0x7f, 0xa3, 0x7d, 0x12, 0x9b, 0x75, 0x67, 0x46 } },
+	{ 16, { 0x07, 0x0a, 0x16, 0xb4, 0x6b, 0x4d, 0x41, 0x44, 0xf7, 0x9b, 0xdd, 0x9d, 0xd0, 0x4a, 0x28, 0x7c } },
+	{ 40, { 0xdf, 0xa6, 0x67, 0x47, 0xde, 0x9a, 0xe6, 0x30, 0x30, 0xca, 0x32, 0x61, 0x14, 0x97, 0xc8, 0x27 } },
+	{ 64, { 0x51, 0xf0, 0xbe, 0xbf, 0x7e, 0x3b, 0x9d, 0x92, 0xfc, 0x49, 0x74, 0x17, 0x79, 0x36, 0x3c, 0xfe } }
+};
+
+// FIPS-197, appendix C.1 (AES-128)
+static const uint8_t _fipsKey[16] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+static const uint8_t _fipsIn[16] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };
+static const uint8_t _fipsOut[16] = { 0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a };
+
+static SecureElementNvmData_t _nvm;
+
+static uint32_t leMac(const uint8_t *mac)
+{
+	return (uint32_t) mac[0] | ((uint32_t) mac[1] << 8) | ((uint32_t) mac[2] << 16) | ((uint32_t) mac[3] << 24);
+}
+
+/*
+ * @brief CMAC of cmac.c only (no secure element, no cache), the reference for the keys without the vectors
+ */
+static uint32_t refMac(const uint8_t *key, const uint8_t *msg, uint32_t len)
+{
+	AES_CMAC_CTX ctx;
+	uint8_t mac[16];
+
+	AES_CMAC_Init(&ctx);
+	AES_CMAC_SetKey(&ctx, key);
+	AES_CMAC_Update(&ctx, msg, len);
+	AES_CMAC_Final(mac, &ctx);
+	return leMac(mac);
+}
+
+static uint32_t seMac(KeyIdentifier_t id, const uint8_t *msg, uint32_t len)
+{
+	uint32_t mac = 0;
+
+	CHECK_EQ(SecureElementComputeAesCmac(NULL, (uint8_t*) msg, len, id, &mac), SECURE_ELEMENT_SUCCESS);
+	return mac;
+}
+
+static Key_t* nvmKey(KeyIdentifier_t id)
+{
+	for (int i = 0; i < NUM_OF_KEYS; i++)
+		if (_nvm.KeyList[i].KeyID == id)
+			return &_nvm.KeyList[i];
+	return NULL;
+}
+
+static void testCmacVectors(void)
+{
+	// cmac.c alone, the subkeys computed in Final and prepared once per key
+	for (unsigned i = 0; i < sizeof(_rfcMac) / sizeof(_rfcMac[0]); i++)
+	{
+		AES_CMAC_CTX ctx;
+		uint8_t mac[16];
+
+		AES_CMAC_Init(&ctx);
+		AES_CMAC_SetKey(&ctx, _rfcKey);
+		AES_CMAC_Update(&ctx, _rfcMsg, _rfcMac[i].len);
+		AES_CMAC_Final(mac, &ctx);
+		CHECK(memcmp(mac, _rfcMac[i].mac, 16) == 0);
+
+		AES_CMAC_Init(&ctx);
+		AES_CMAC_SetKey(&ctx, _rfcKey);
+		AES_CMAC_PrepareSubKeys(&ctx);
+		for (int rep = 0; rep < 2; rep++)
+		{
+			AES_CMAC_Restart(&ctx);
+			AES_CMAC_Update(&ctx, _rfcMsg, _rfcMac[i].len);
+			AES_CMAC_Final(mac, &ctx);
+			CHECK(memcmp(mac, _rfcMac[i].mac, 16) == 0);
+		}
+	}
+}
+
+static void testSecureElement(void)
+{
+	static const KeyIdentifier_t ids[] = { APP_KEY, NWK_KEY, NWK_S_KEY, APP_S_KEY, DATABLOCK_INT_KEY };	// more keys than slots
+	uint8_t key[16], out[16];
+
+	CHECK_EQ(SecureElementInit(&_nvm), SECURE_ELEMENT_SUCCESS);
+
+	// the vectors through the secure element, twice (the second call is the cache hit)
+	CHECK_EQ(SecureElementSetKey(NWK_KEY, (uint8_t*) _rfcKey), SECURE_ELEMENT_SUCCESS);
+	for (int rep = 0; rep < 2; rep++)
+		for (unsigned i = 0; i < sizeof(_rfcMac) / sizeof(_rfcMac[0]); i++)
+			CHECK_EQ(seMac(NWK_KEY, _rfcMsg, _rfcMac[i].len), leMac(_rfcMac[i].mac));
+	CHECK_EQ(SecureElementSetKey(APP_S_KEY, (uint8_t*) _fipsKey), SECURE_ELEMENT_SUCCESS);
+	for (int rep = 0; rep < 2; rep++)
+	{
+		memset(out, 0, sizeof(out));
+		CHECK_EQ(SecureElementAesEncrypt((uint8_t*) _fipsIn, 16, APP_S_KEY, out), SECURE_ELEMENT_SUCCESS);
+		CHECK(memcmp(out, _fipsOut, 16) == 0);
+	}
+
+	// eviction: round robin over more keys than slots, each MIC is the one of cmac.c
+	for (unsigned i = 0; i < sizeof(ids) / sizeof(ids[0]); i++)
+	{
+		for (int j = 0; j < 16; j++)
+			key[j] = (uint8_t) (i * 16 + j);
+		CHECK_EQ(SecureElementSetKey(ids[i], key), SECURE_ELEMENT_SUCCESS);
+	}
+	for (int rep = 0; rep < 3; rep++)
+		for (unsigned i = 0; i < sizeof(ids) / sizeof(ids[0]); i++)
+			CHECK_EQ(seMac(ids[i], _rfcMsg, 40), refMac(nvmKey(ids[i])->KeyValue, _rfcMsg, 40));
+
+	// new key of the cached ID
+	CHECK_EQ(SecureElementSetKey(NWK_KEY, (uint8_t*) _rfcKey), SECURE_ELEMENT_SUCCESS);
+	CHECK_EQ(seMac(NWK_KEY, _rfcMsg, 64), leMac(_rfcMac[3].mac));
+
+	// derivation: target = AES(root, input), the old schedule of target is dropped
+	seMac(APP_S_KEY, _rfcMsg, 16);
+	CHECK_EQ(SecureElementSetKey(NWK_KEY, (uint8_t*) _fipsKey), SECURE_ELEMENT_SUCCESS);
+	CHECK_EQ(SecureElementDeriveAndStoreKey((uint8_t*) _fipsIn, NWK_KEY, APP_S_KEY), SECURE_ELEMENT_SUCCESS);
+	CHECK(memcmp(nvmKey(APP_S_KEY)->KeyValue, _fipsOut, 16) == 0);
+	CHECK_EQ(seMac(APP_S_KEY, _rfcMsg, 16), refMac(_fipsOut, _rfcMsg, 16));
+
+	// NVM restore writes the keys without SecureElementSetKey
+	seMac(NWK_KEY, _rfcMsg, 16);
+	memcpy(nvmKey(NWK_KEY)->KeyValue, _rfcKey, 16);
+	CHECK_EQ(seMac(NWK_KEY, _rfcMsg, 16), leMac(_rfcMac[1].mac));
+
+	// init drops all schedules
+	CHECK_EQ(SecureElementInit(&_nvm), SECURE_ELEMENT_SUCCESS);
+	CHECK_EQ(seMac(NWK_KEY, _rfcMsg, 16), refMac(nvmKey(NWK_KEY)->KeyValue, _rfcMsg, 16));
+}
+
+static void benchMic(void)
+{
+	enum { N = 20000 };
+	uint8_t frame[32];
+	volatile uint32_t sink = 0;
+	double t;
+
+	memcpy(frame, _rfcMsg, sizeof(frame));
+	SecureElementSetKey(NWK_S_KEY, (uint8_t*) _rfcKey);
+	t = test_Ns();
+	for (int i = 0; i < N; i++)
+	{
+		frame[0] = (uint8_t) i;
+		sink += seMac(NWK_S_KEY, frame, sizeof(frame));
+	}
+	t = (test_Ns() - t) / N;
+	printf("MIC of 32 B frame (secure element, %s): %.0f ns\n", (SOFT_SE_KEY_CACHE_SLOTS > 0) ? "cached key" : "no cache", t);
+	(void) sink;
+}
+
+int main(void)
+{
+	testCmacVectors();
+	testSecureElement();
+	benchMic();
+	return TEST_RESULT();
+}
@@ -0,0 +1,157 @@
+/*
+ * test_stat.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * streaming statistics of the reading cycle (user-030), statAgg_t against the double reference
+ * - min/max exact, mean and stddev within the rounding, cycles of 2..1000 samples of the channel ranges
+ *   (temperature x100, pressure Pa, lux x100, CO2 ppm) with the noise
+ * - median window: the spike is rejected, the step change is accepted after N/2 samples
+ * - the cost of statAgg_Add per sample, without and with the median window (5, as sensors_Init)
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include "test.h"
+#include "utils/utils.h"
+
+typedef struct
+{
+	const char *name;
+	int32_t base;
+	int32_t noise;		// max. amplitude of the noise (difference < 2^19, see statAgg_t)
+} statRange_t;
+
+static double _maxMeanErr, _maxDevErr;
+
+static int32_t sample(const statRange_t *r)
+{
+	return r->base + (int32_t) ((rand() / (double) RAND_MAX - 0.5) * 2 * r->noise);
+}
+
+static void checkCycle(const statRange_t *r, int n)
+{
+	statAgg_t s;
+	int32_t x[1000], mn = INT32_MAX, mx = INT32_MIN;
+	double sum = 0, m2 = 0, mean, dev;
+
+	statAgg_Inic(&s, 0, 0);
+	for (int i = 0; i < n; i++)
+	{
+		x[i] = sample(r);
+		CHECK(statAgg_Add(&s, x[i]));
+		sum += x[i];
+		if (x[i] < mn)
+			mn = x[i];
+		if (x[i] > mx)
+			mx = x[i];
+	}
+	mean = sum / n;
+	for (int i = 0; i < n; i++)
+		m2 += (x[i] - mean) * (x[i] - mean);
+	dev = (n > 1) ? sqrt(m2 / (n - 1)) : 0;
+
+	CHECK_EQ(s.Count, n);
+	CHECK_EQ(s.Min, mn);
+	CHECK_EQ(s.Max, mx);
+	double em = fabs(statAgg_GetMean(&s) - mean), ed = fabs(statAgg_GetStdDev(&s) - dev);
+
+	if (em > _maxMeanErr)
+		_maxMeanErr = em;
+	if (ed > _maxDevErr)
+		_maxDevErr = ed;
+	// rounding to the integer (0.5) and the truncation of Q8 per sample
+	if (em > 0.5 + n / 256.0 || ed > 0.5 + n / 256.0)
+	{
+		printf("%s, %d samples: mean %ld/%.2f, stddev %ld/%.2f\n", r->name, n, (long) statAgg_GetMean(&s), mean,
+			(long) statAgg_GetStdDev(&s), dev);
+		CHECK(0);
+	}
+}
+
+static void testAccuracy(void)
+{
+	static const statRange_t ranges[] = {
+		{ "temp", 2150, 30 }, { "temp<0", -1520, 30 }, { "pressure", 101325, 20 }, { "lux", 3000000, 200000 },
+		{ "co2", 612, 15 }, { "flat", 500, 0 }
+	};
+	static const int counts[] = { 1, 2, 3, 10, 100, 1000 };
+
+	srand(30);
+	for (unsigned r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++)
+		for (unsigned c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+			for (int rep = 0; rep < 200; rep++)
+				checkCycle(&ranges[r], counts[c]);
+	printf("accuracy: max. error of mean %.3f, stddev %.3f\n", _maxMeanErr, _maxDevErr);
+}
+
+static void testMedian(void)
+{
+	statAgg_t s;
+
+	statAgg_Inic(&s, 5, 200);
+	for (int i = 0; i < 5; i++)
+		CHECK(statAgg_Add(&s, 2100 + i));
+	CHECK_EQ(statAgg_GetMedian(&s), 2102);
+	CHECK(!statAgg_Add(&s, 8500));		// spike
+	CHECK_EQ(s.Rejected, 1);
+	CHECK_EQ(s.Max, 2104);
+	CHECK(statAgg_Add(&s, 2105));
+	// step change: rejected until it is the median of the window
+	CHECK(!statAgg_Add(&s, 2500));
+	CHECK(!statAgg_Add(&s, 2500));
+	CHECK(statAgg_Add(&s, 2500));
+	CHECK_EQ(s.Count, 7);
+	CHECK_EQ(s.Rejected, 3);
+
+	// first samples are accepted before the half of the window is full
+	statAgg_Reset(&s);
+	CHECK(statAgg_Add(&s, 0));
+	CHECK(statAgg_Add(&s, 9000));
+	CHECK(statAgg_Add(&s, 9000));
+	CHECK_EQ(statAgg_GetMedian(&s), 9000);
+	CHECK(!statAgg_Add(&s, 0));
+
+	// without the window the median is the last sample
+	statAgg_Inic(&s, 0, 0);
+	CHECK_EQ(statAgg_GetMedian(&s), 0);
+	statAgg_Add(&s, 7);
+	statAgg_Add(&s, -3);
+	CHECK_EQ(statAgg_GetMedian(&s), -3);
+	CHECK_EQ(statAgg_GetStdDev(&s), 7);	// sqrt(50)
+}
+
+static double benchAdd(uint8_t ringSize)
+{
+	enum { N = 1000000, CYCLE = 10 };	// _processReadingMax
+	static int32_t x[1024];
+	statAgg_t s;
+	volatile int32_t sink = 0;
+	double t;
+
+	for (int i = 0; i < 1024; i++)
+		x[i] = 2150 + rand() % 60 - 30;
+	statAgg_Inic(&s, ringSize, 200);
+	t = test_Ns();
+	for (int i = 0; i < N; i++)
+	{
+		if (i % CYCLE == 0)
+		{
+			sink += statAgg_GetMean(&s) + statAgg_GetStdDev(&s);
+			statAgg_Reset(&s);
+		}
+		statAgg_Add(&s, x[i & 1023]);
+	}
+	(void) sink;
+	return (test_Ns() - t) / N;
+}
+
+int main(void)
+{
+	testAccuracy();
+	testMedian();
+	printf("statAgg_Add per sample (with the summary of 10 samples): %.1f ns, median window 5: %.1f ns\n", benchAdd(0),
+		benchAdd(5));
+	return TEST_RESULT();
+}
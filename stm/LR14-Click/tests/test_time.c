@@ -0,0 +1,158 @@
+/*
+ * test_time.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * timestamps of the measurement path (user-038)
+ * - tsBatch_t: the time of the record from base + offset is within Resolution / 2 of the original,
+ *   the end of batch (16-bit offset, the time before the base), the batch of the reading cycles
+ * - calendar_t against gmtime_r of the host over 1970..2105 and every second of the days around the leap years,
+ *   the cached day and the jump back
+ * - the cost of calendar_Set (cached day and new day) against SysTimeLocalTime of stm32_systime.c
+ */
+
+#define _POSIX_C_SOURCE	200809L
+#include <stdlib.h>
+#include <time.h>
+#include "test.h"
+#include "utils/utils.h"
+#include "stm32_systime.h"
+
+#define TS_RESOLUTION	250		// SENS_TS_RESOLUTION
+
+const UTIL_SYSTIM_Driver_s UTIL_SYSTIMDriver = { };	// the RTC is not used by SysTimeLocalTime
+
+static void testBatch(void)
+{
+	tsBatch_t b;
+	uint16_t off, ms;
+	uint32_t epoch;
+	int maxErr = 0;
+
+	tsBatch_Inic(&b, TS_RESOLUTION);
+	CHECK(tsBatch_Add(&b, 1760000000, 900, &off));
+	CHECK_EQ(off, 0);
+	tsBatch_GetTime(&b, 0, &epoch, &ms);
+	CHECK_EQ(epoch, 1760000000);
+	CHECK_EQ(ms, 900);
+
+	// the reading cycles of 30 s with the jitter, the time within the half of resolution
+	srand(38);
+	for (uint32_t t = 0; t < 4 * 3600 * 1000; t += 30000 + rand() % 300)
+	{
+		uint64_t at = 1760000000ULL * 1000 + 900 + t;
+
+		CHECK(tsBatch_Add(&b, (uint32_t) (at / 1000), (uint16_t) (at % 1000), &off));
+		tsBatch_GetTime(&b, off, &epoch, &ms);
+		int err = (int) ((int64_t) epoch * 1000 + ms - (int64_t) at);
+
+		if (abs(err) > maxErr)
+			maxErr = abs(err);
+	}
+	CHECK(maxErr <= TS_RESOLUTION / 2);
+	printf("batch of 4 h, 30 s cycles: max. error %d ms (resolution %d ms)\n", maxErr, TS_RESOLUTION);
+
+	// the end of batch: 65535 x 250 ms = 4 h 33 min 3.75 s
+	CHECK(tsBatch_Add(&b, 1760000000 + 16384, 650, &off));
+	CHECK_EQ(off, 0xFFFF);
+	tsBatch_GetTime(&b, off, &epoch, &ms);
+	CHECK_EQ(epoch, 1760000000 + 16384);
+	CHECK_EQ(ms, 650);
+	CHECK(tsBatch_Add(&b, 1760000000 + 16384, 774, &off));	// rounded down to the last offset
+	CHECK(!tsBatch_Add(&b, 1760000000 + 16384, 775, &off));
+	// before the base (the time correction of the network)
+	CHECK(!tsBatch_Add(&b, 1760000000, 899, &off));
+	CHECK(!tsBatch_Add(&b, 1759999999, 999, &off));
+	// new batch
+	tsBatch_Reset(&b);
+	CHECK(tsBatch_Add(&b, 1759999999, 999, &off));
+	CHECK_EQ(off, 0);
+	CHECK(tsBatch_Add(&b, 1760000000, 124, &off));
+	CHECK_EQ(off, 1);	// 125 ms, rounded
+
+	// resolution 0 is 1 ms
+	tsBatch_Inic(&b, 0);
+	tsBatch_Add(&b, 100, 0, &off);
+	CHECK(tsBatch_Add(&b, 165, 535, &off));
+	CHECK_EQ(off, 65535);
+}
+
+static int calCompare(calendar_t *c, uint32_t epoch)
+{
+	struct tm tm;
+	time_t t = epoch;
+
+	calendar_Set(c, epoch);
+	gmtime_r(&t, &tm);
+	return c->Year == tm.tm_year + 1900 && c->Month == tm.tm_mon + 1 && c->Day == tm.tm_mday
+		&& c->WeekDay == (tm.tm_wday == 0 ? 7 : tm.tm_wday) && c->Hours == tm.tm_hour && c->Minutes == tm.tm_min
+		&& c->Seconds == tm.tm_sec;
+}
+
+static void testCalendar(void)
+{
+	static const uint32_t days[] = { 0, 11016, 11017, 11046, 11047, 11322, 16859, 20512, 24837, 48941, 49000 };	// 1970, 2000..2004, 2016, 2026, 2038, 2104
+	calendar_t c;
+	int fails = 0;
+
+	calendar_Inic(&c);
+	CHECK_EQ(c.DayStart, 0xFFFFFFFF);
+	// every 7 h 13 min 1 s over the whole range, in order and random (the cache is invalidated)
+	for (uint32_t e = 0; e < 0xFFFFFFFF - 26000; e += 26001)
+		fails += !calCompare(&c, e);
+	srand(38);
+	for (int i = 0; i < 100000; i++)
+		fails += !calCompare(&c, ((uint32_t) rand() << 16) ^ (uint32_t) rand());
+	// every second of the selected days (1.1.1970, leap days, end of the year, 2038, 2104)
+	for (unsigned d = 0; d < sizeof(days) / sizeof(days[0]); d++)
+		for (uint32_t s = 0; s < 2 * 86400; s++)
+			fails += !calCompare(&c, days[d] * 86400 + s);
+	CHECK_EQ(fails, 0);
+	// the time back within the day
+	calendar_Set(&c, 1760000000);
+	calendar_Set(&c, 1759999000);
+	CHECK(calCompare(&c, 1759999000));
+}
+
+static void benchCalendar(void)
+{
+	enum { N = 2000000 };
+	calendar_t c;
+	struct tm tm;
+	volatile uint32_t sink = 0;
+	double tCache, tNew, tSys;
+
+	calendar_Inic(&c);
+	tCache = test_Ns();
+	for (int i = 0; i < N; i++)
+	{
+		calendar_Set(&c, 1760000000 + (i & 0x3FFF));	// records of one day
+		sink += c.Seconds;
+	}
+	tCache = (test_Ns() - tCache) / N;
+	tNew = test_Ns();
+	for (int i = 0; i < N; i++)
+	{
+		calendar_Set(&c, 1760000000 + i * 86400U);
+		sink += c.Day;
+	}
+	tNew = (test_Ns() - tNew) / N;
+	tSys = test_Ns();
+	for (int i = 0; i < N; i++)
+	{
+		SysTimeLocalTime(1760000000 + (i & 0x3FFF), &tm);
+		sink += tm.tm_sec;
+	}
+	tSys = (test_Ns() - tSys) / N;
+	(void) sink;
+	printf("conversion: calendar_Set %.1f ns (same day), %.1f ns (new day), SysTimeLocalTime %.1f ns\n", tCache, tNew, tSys);
+}
+
+int main(void)
+{
+	testBatch();
+	testCalendar();
+	benchCalendar();
+	return TEST_RESULT();
+}
@@ -0,0 +1,319 @@
+/*
+ * test_trace.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * event trace ring with the UART dump (user-050), trace.c on the stubbed cycle counter, RTC and UART
+ * - the ring: the order, the overwrite of the oldest events, the dump lines of trace_Dump and their parse back
+ * - trace_Event, trace_Sync, trace_Clock and trace_Dump: the events of the ring, the console output, the pause
+ * - the cost of traceRing_Put per event (trace_Bench measures the cycles on the target)
+ * - the whole day of the device as trace_Event/trace_Sync/trace_Clock record it: 30 s reading cycles (10 readings
+ *   3 s apart, STOP2 between them, I2C of the sensors at the MID clock profile, the record to the flash), the uplink
+ *   every 5 min with RX1/RX2; the cycle counter stops in STOP2 and wraps every 89 s, the time is given by RTC
+ *   after the wakeup; the dump is written to trace_day.log for tools/trace2json.py (ctest trace2json)
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+#include "main.h"
+#include "timer_if.h"
+#include "usart_if.h"
+#include "trace.h"
+
+#define TASK_SEND		1		// CFG_SEQ_Task_LoRaSendOnTxTimerOrButtonEvent
+#define TASK_SENSORS	4		// CFG_SEQ_Task_Sensors
+#define DEV_FLASH		5		// SENS_DEV_FLASH
+#define RTC_HZ			1024	// TIMER_IF_Convert_ms2Tick(1000)
+
+#define DAY_EVENTS		(1 << 20)
+#define DAY_STOP2		(2880 * 10 + 288 * 3)	// the wakeups of the readings, TX -> RX1 -> RX2 -> cycle
+
+static void testRing(void)
+{
+	traceEvent_t events[16];
+	traceRing_t r;
+	char line[TRACE_LINE_SIZE];
+
+	traceRing_Inic(&r, events, 16);
+	CHECK_EQ(traceRing_Count(&r), 0);
+	CHECK_EQ(traceRing_Line(&r, 0, line), 0);
+	CHECK_EQ(line[0], '\0');
+	for (uint32_t i = 0; i < 20; i++)
+		traceRing_Put(&r, 0x1000 + i, (uint16_t) i, TRACE_EV_BEGIN, (uint8_t) (0xF0 + i));	// arg wraps
+	CHECK_EQ(traceRing_Count(&r), 16);
+	CHECK_EQ(traceRing_Lost(&r), 4);
+	CHECK_EQ(traceRing_Get(&r, 0)->Time, 0x1004);	// the oldest one
+	CHECK_EQ(traceRing_Get(&r, 15)->Id, 19);
+	// 16 events: 8 + 8, the dump line format
+	CHECK_EQ(traceRing_Line(&r, 0, line), TRACE_LINE_EVENTS);
+	CHECK(strncmp(line, "TRC 00001004000400F4 00001005000500F5", 37) == 0);
+	CHECK_EQ(strlen(line), 3 + TRACE_LINE_EVENTS * 17 + 2);
+	CHECK(strlen(line) < TRACE_LINE_SIZE);
+	CHECK_EQ(traceRing_Line(&r, 12, line), 4);
+	CHECK(strcmp(line, "TRC 0000101000100000 0000101100110001 0000101200120002 0000101300130003\r\n") == 0);
+	CHECK_EQ(traceRing_Line(&r, 16, line), 0);
+}
+
+static uint32_t _rtc = 0;
+static char _uart[4096];
+
+uint32_t TIMER_IF_GetTimerValue(void)
+{
+	return _rtc;
+}
+
+uint32_t TIMER_IF_Convert_ms2Tick(uint32_t timeMilliSec)
+{
+	return (uint32_t) ((uint64_t) timeMilliSec * RTC_HZ / 1000);
+}
+
+UTIL_ADV_TRACE_Status_t Uart_Info(const char *strInfo)
+{
+	strncat(_uart, strInfo, sizeof(_uart) - strlen(_uart) - 1);
+	return UTIL_ADV_TRACE_OK;
+}
+
+static void testTrace(void)
+{
+	SystemCoreClock = 48000000;
+	stub_DWT.CYCCNT = 0x100;
+	_rtc = 0x20;
+	trace_Init();
+	stub_DWT.CYCCNT = 0x200;
+	TRACE_BEGIN(TRACE_TASK, TASK_SENSORS);
+	SystemCoreClock = 16000000;
+	stub_DWT.CYCCNT = 0x300;
+	trace_Clock();	// clockProf_Set
+	stub_DWT.CYCCNT = 0x400;
+	TRACE_END(TRACE_TASK, TASK_SENSORS);
+	TRACE_INSTANT(TRACE_I2C, DEV_FLASH);
+	// SYNC + RTC of trace_Init and 4 events, the sync after the dump is not in the dump
+	_uart[0] = '\0';
+	_rtc = 0x40;
+	trace_Dump();
+	CHECK(strcmp(_uart, "trace: 6 events, lost 0, rtc 1024 Hz\r\n"
+		"TRC 00000100BB800300 0000002000000400 0000020000000004 000003003E800500 0000040000000104 0000040000050205\r\n"
+		"trace: end\r\n") == 0);
+	// the ring over TRACE_SIZE, the oldest events are lost
+	for (int i = 0; i < TRACE_SIZE; i++)
+		TRACE_INSTANT(TRACE_SPI, (uint8_t) i);
+	_uart[0] = '\0';
+	trace_Dump();
+	CHECK(strncmp(_uart, "trace: 256 events, lost 8, rtc 1024 Hz\r\n", 40) == 0);
+	CHECK(strstr(_uart, "\nTRC 0000040000060200 ") != NULL);	// the first instant of SPI is the oldest one
+	// the clear leaves the sync, the benchmark removes its events
+	trace_Clear();
+	trace_Bench();
+	_uart[0] = '\0';
+	trace_Dump();
+	CHECK(strncmp(_uart, "trace: 2 events, lost 0", 23) == 0);
+}
+
+static void benchPut(void)
+{
+	enum { N = 10000000 };
+	static traceEvent_t events[256];	// TRACE_SIZE
+	traceRing_t r;
+	double t;
+
+	traceRing_Inic(&r, events, 256);
+	t = test_Ns();
+	for (uint32_t i = 0; i < N; i++)
+		traceRing_Put(&r, i * 48, (uint16_t) (i & 7), (uint8_t) (i & 1), (uint8_t) i);
+	t = (test_Ns() - t) / N;
+	printf("traceRing_Put %.1f ns per event (ring of 256, %lu B)\n", t, (unsigned long) sizeof(events));
+	CHECK_EQ(traceRing_Count(&r), 256);
+	CHECK(t < 20);	// a few instructions, no division, no branch
+}
+
+/*
+ * simDevice_t - the time of the device: the cycle counter (DWT->CYCCNT), the clock and RTC
+ */
+typedef struct
+{
+	traceRing_t *Ring;
+	uint32_t Cycles;	// DWT->CYCCNT, wraps
+	uint32_t Khz;		// SystemCoreClock / 1000
+	uint64_t Us;		// real time
+	uint64_t Stop2Us;	// the time in STOP2
+} simDevice_t;
+
+static void simRun(simDevice_t *d, uint32_t us)
+{
+	d->Cycles += (uint32_t) ((uint64_t) us * d->Khz / 1000);
+	d->Us += us;
+}
+
+static void simEvent(simDevice_t *d, uint16_t id, uint8_t type, uint8_t arg)
+{
+	traceRing_Put(d->Ring, d->Cycles, id, type, arg);
+}
+
+static void simClock(simDevice_t *d, uint32_t khz)
+{
+	d->Khz = khz;
+	simEvent(d, (uint16_t) khz, TRACE_EV_CLOCK, 0);	// trace_Clock of clockProf_Set
+}
+
+static void simSync(simDevice_t *d)
+{
+	traceRing_Put(d->Ring, d->Cycles, (uint16_t) d->Khz, TRACE_EV_SYNC, 0);
+	traceRing_Put(d->Ring, (uint32_t) (d->Us * RTC_HZ / 1000000), 0, TRACE_EV_RTC, 0);
+}
+
+/*
+ * @brief STOP2 up to the time (us) of the day, PWR_EnterStopMode/PWR_ExitStopMode
+ */
+static void simStop2(simDevice_t *d, uint64_t until)
+{
+	simEvent(d, TRACE_STOP2, TRACE_EV_BEGIN, 0);
+	d->Stop2Us += until - d->Us;
+	d->Us = until;	// the cycle counter is stopped
+	d->Khz = 48000;	// SystemClock_Config
+	simSync(d);
+	simEvent(d, TRACE_STOP2, TRACE_EV_END, 0);
+}
+
+static void simReading(simDevice_t *d, int reading)
+{
+	simEvent(d, TRACE_TASK, TRACE_EV_BEGIN, TASK_SENSORS);
+	simRun(d, 150);
+	if (reading == 0)
+		for (int i = 0; i < 3; i++)
+			simEvent(d, TRACE_SENSOR, TRACE_EV_BEGIN, (uint8_t) i);
+	simClock(d, 16000);	// CLOCK_MID for the I2C
+	for (int i = 0; i < 3; i++)
+	{
+		simEvent(d, TRACE_I2C, TRACE_EV_BEGIN, (uint8_t) i);
+		simRun(d, 300 + 100 * i);
+		simEvent(d, TRACE_I2C, TRACE_EV_END, (uint8_t) i);
+	}
+	simClock(d, 48000);
+	if (reading == 9)
+	{
+		for (int i = 0; i < 3; i++)
+			simEvent(d, TRACE_SENSOR, TRACE_EV_END, (uint8_t) i);
+		simEvent(d, TRACE_SPI, TRACE_EV_BEGIN, DEV_FLASH);
+		simRun(d, 700);		// page program of the record
+		simEvent(d, TRACE_SPI, TRACE_EV_END, DEV_FLASH);
+	}
+	simRun(d, 50);
+	simEvent(d, TRACE_TASK, TRACE_EV_END, TASK_SENSORS);
+}
+
+static void simUplink(simDevice_t *d, uint64_t rx1)
+{
+	simEvent(d, TRACE_TASK, TRACE_EV_BEGIN, TASK_SEND);
+	simRun(d, 2000);
+	simEvent(d, TRACE_TASK, TRACE_EV_END, TASK_SEND);
+	simEvent(d, TRACE_RADIO_TX, TRACE_EV_BEGIN, 0);
+	simRun(d, 60000);	// the MCU waits for TxDone (Sleep is not traced here)
+	simEvent(d, TRACE_RADIO_TX, TRACE_EV_END, 0);
+	for (int w = 0; w < 2; w++)
+	{
+		simStop2(d, rx1 + w * 1000000);
+		simEvent(d, TRACE_RADIO_RX, TRACE_EV_BEGIN, 0);
+		simRun(d, 30000);
+		simEvent(d, TRACE_RADIO_RX, TRACE_EV_END, 0);
+	}
+}
+
+/*
+ * @brief dump of trace_Dump to the file
+ * @retval count of events in the lines
+ */
+static uint32_t dumpDay(const traceRing_t *r, const char *name)
+{
+	char line[TRACE_LINE_SIZE];
+	uint32_t i = 0, n;
+	FILE *f = fopen(name, "w");
+
+	if (f == NULL)
+		return 0;
+	fprintf(f, "trace: %lu events, lost %lu, rtc %d Hz\r\n", (unsigned long) traceRing_Count(r),
+		(unsigned long) traceRing_Lost(r), RTC_HZ);
+	while ((n = traceRing_Line(r, i, line)) > 0)
+	{
+		fputs(line, f);
+		i += n;
+	}
+	fputs("trace: end\r\n", f);
+	fclose(f);
+	return i;
+}
+
+/*
+ * @brief the dump is parsed back as tools/trace2json.py does
+ */
+static uint32_t checkDump(const traceRing_t *r, const char *name)
+{
+	char line[256];
+	uint32_t i = 0, fails = 0;
+	FILE *f = fopen(name, "r");
+
+	if (f == NULL)
+		return 1;
+	while (fgets(line, sizeof(line), f) != NULL)
+	{
+		if (strncmp(line, "TRC ", 4) != 0)
+			continue;
+		for (char *p = line + 3; *p == ' '; p += 17)
+		{
+			unsigned long long h = strtoull(p + 1, NULL, 16);
+			const traceEvent_t *e = traceRing_Get(r, i++);
+
+			fails += e->Time != (uint32_t) (h >> 32) || e->Id != ((h >> 16) & 0xFFFF) || e->Type != ((h >> 8) & 0xFF)
+				|| e->Arg != (h & 0xFF);
+		}
+	}
+	fclose(f);
+	return fails + (i != traceRing_Count(r));
+}
+
+static void testDay(void)
+{
+	static traceEvent_t events[DAY_EVENTS];
+	traceRing_t r;
+	simDevice_t d = { .Ring = &r, .Khz = 48000 };
+	uint32_t stops = 0;
+
+	traceRing_Inic(&r, events, DAY_EVENTS);
+	simSync(&d);	// trace_Init
+	for (uint32_t cycle = 0; cycle < 2880; cycle++)
+	{
+		uint64_t start = cycle * 30000000ULL;
+
+		for (int reading = 0; reading < 10; reading++)
+		{
+			simReading(&d, reading);
+			if (reading < 9)
+				simStop2(&d, start + (reading + 1) * 3000000ULL);
+		}
+		if (cycle % 10 == 9)
+		{
+			simStop2(&d, start + 27500000);
+			simUplink(&d, start + 28500000);
+			stops += 3;
+		}
+		simStop2(&d, start + 30000000);
+		stops += 10;
+	}
+	CHECK_EQ(stops, DAY_STOP2);
+	CHECK_EQ(traceRing_Lost(&r), 0);
+	CHECK_EQ(dumpDay(&r, "trace_day.log"), traceRing_Count(&r));
+	CHECK_EQ(checkDump(&r, "trace_day.log"), 0);
+	printf("one day: %lu events (%lu KiB of the ring), %lu STOP2 of %llu us (%.2f %% of the day), dump trace_day.log\n",
+		(unsigned long) traceRing_Count(&r), (unsigned long) (traceRing_Count(&r) * sizeof(traceEvent_t) / 1024),
+		(unsigned long) stops, (unsigned long long) d.Stop2Us, 100.0 * d.Stop2Us / d.Us);
+}
+
+int main(void)
+{
+	testRing();
+	testTrace();
+	benchPut();
+	testDay();
+	return TEST_RESULT();
+}
@@ -0,0 +1,174 @@
+/*
+ * test_warmboot.c
+ *
+ *  Created on: 19. 10. 2026
+ *      Author: Milan
+ *
+ * warm boot of the sensors (user-034), the drivers on the modelled I2C bus (stub/i2c.c)
+ * - the init of sensors_Init: cold boot xxx_Init of all devices, warm boot xxx_InitWarm of the devices present
+ *   in the snapshot, the absent ones are left to the presence backoff
+ * - boot-to-ready (bus time and HAL_Delay of the drivers) and boot-to-first-sample (+ on, warm-up and read
+ *   of the barometer, the first sensor of the cycle), all present and with the absent sensors
+ * - warm init keeps the state: presence of the drivers, the gain of ambient, the mailbox of the tag
+ */
+
+#include "test.h"
+#include "i2c_stub.h"
+#include "temphum23.h"
+#include "ambient21.h"
+#include "barometer8.h"
+#include "scd41.h"
+#include "sps30.h"
+#include "nfctag4.h"
+
+#define DEV_NBR			6		// SENS_ID_NBR + NFC4 (flash is on SPI)
+#define DEV_NFC4		5
+#define NFC4_USER		(0x53 << 1)
+#define NFC4_SYSTEM		(0x57 << 1)
+#define FIRST_LATENCY	1000	// latencyMS of barometer8
+
+typedef struct
+{
+	const char *name;
+	uint16_t address;
+	uint32_t i2cHz;			// sensOps_t.i2cHz
+	HAL_StatusTypeDef (*init)(I2C_HandleTypeDef *hi2c);
+	HAL_StatusTypeDef (*initWarm)(I2C_HandleTypeDef *hi2c);
+} bootDev_t;
+
+static uint8_t _gain = 0;
+
+static HAL_StatusTypeDef ambientInitWarm(I2C_HandleTypeDef *hi2c)
+{
+	return ambient_InitWarm(hi2c, _gain);
+}
+
+static const bootDev_t _devs[DEV_NBR] = {
+	{ "tempHum23", 0x44 << 1, 1000000, tempHum_Init, NULL },
+	{ "ambient21", 0x29 << 1, 400000, ambient_Init, ambientInitWarm },
+	{ "barometer8", 0x5C << 1, 1000000, barometer_Init, barometer_InitWarm },
+	{ "scd41", 0x62 << 1, 100000, scd41_Init, scd41_InitWarm },
+	{ "sps30", 0x69 << 1, 100000, sps30_Init, sps30_InitWarm },
+	{ "nfc4", NFC4_USER, 1000000, nfc4_Init, nfc4_InitWarm },
+};
+
+/*
+ * @brief the devices on the bus, absent - bitmap of the removed devices
+ */
+static void busInic(uint16_t absent)
+{
+	static const uint8_t sensirion[] = { 0x00, 0x00, 0x81 };	// word 0 with CRC-8 (0x31, 0xFF)
+	stubI2CDev_t *nfc;
+
+	stub_I2CReset();
+	for (int i = 0; i < DEV_NBR; i++)
+	{
+		stubI2CDev_t *dev = stub_I2CAdd(_devs[i].address, !(absent & (1 << i)));
+
+		dev->RxPattern = sensirion;
+		dev->RxPatternLen = sizeof(sensirion);
+	}
+	stub_I2CAdd(0x5C << 1, !(absent & (1 << 2)))->Mem[0x0F] = 0xB4;	// WHO_AM_I of ILPS22QS
+	stub_I2CAdd(NFC4_USER, !(absent & (1 << DEV_NFC4)))->Mem[0x2004] = 0x01;	// I2C_SSO_Dyn, default password
+	// the static registers of the tag are configured by the first boot (EEPROM keeps them)
+	nfc = stub_I2CAdd(NFC4_SYSTEM, !(absent & (1 << DEV_NFC4)));
+	nfc->WriteMs = 5;
+	nfc->Mem[0x0000] = 0xB8;	// GPO, NFC4_GPO_CONFIG
+	nfc->Mem[0x000D] = 0x01;	// MB_MODE
+}
+
+/*
+ * @brief init of sensors_Init
+ * @param warm - presence bitmap of the snapshot, 0 - cold boot
+ * @retval presence bitmap
+ */
+static uint16_t bootInit(uint16_t warm)
+{
+	uint16_t present = 0;
+
+	for (int i = 0; i < DEV_NBR; i++)
+	{
+		const bootDev_t *d = &_devs[i];
+		HAL_StatusTypeDef status;
+
+		hi2c2.Speed = d->i2cHz;	// sensors_Bus
+		if (!warm || d->initWarm == NULL)
+			status = d->init(&hi2c2);
+		else
+			status = (warm & (1 << i)) ? d->initWarm(&hi2c2) : HAL_ERROR;
+		if (status == HAL_OK)
+			present |= 1 << i;
+	}
+	return present;
+}
+
+/*
+ * @brief boot-to-ready and boot-to-first-sample (us)
+ */
+static uint16_t boot(uint16_t warm, uint16_t absent, uint64_t *ready, uint64_t *first, uint32_t *transfers)
+{
+	uint16_t present;
+
+	busInic(absent);
+	stub_Tick = 0;
+	present = bootInit(warm);
+	*ready = stub_I2CTimeUs();
+	*transfers = stub_I2CTransfers;
+	// first cycle, the barometer is read after its warm-up
+	hi2c2.Speed = _devs[2].i2cHz;
+	if (present & (1 << 2))
+	{
+		barometer_On(&hi2c2);
+		HAL_Delay(FIRST_LATENCY);
+		barometer_Read(&hi2c2);
+	}
+	*first = stub_I2CTimeUs();
+	return present;
+}
+
+static void testBoot(const char *name, uint16_t absent)
+{
+	uint64_t coldReady, coldFirst, warmReady, warmFirst;
+	uint32_t coldTr, warmTr;
+	uint16_t presence = boot(0, absent, &coldReady, &coldFirst, &coldTr);
+
+	CHECK_EQ(presence, 0x3F & ~absent);
+	// reset, the sensors stay powered and the snapshot is valid
+	CHECK_EQ(boot(presence, absent, &warmReady, &warmFirst, &warmTr), presence);
+	printf("%-20s cold: ready %6.1f ms, first sample %6.1f ms, %2lu transfers   warm: ready %4.1f ms, first sample %6.1f ms, "
+		"%lu transfers\n", name, coldReady / 1000.0, coldFirst / 1000.0, (unsigned long) coldTr, warmReady / 1000.0,
+		warmFirst / 1000.0, (unsigned long) warmTr);
+	CHECK(warmReady * 10 < coldReady);
+	CHECK(warmFirst < coldFirst);
+	CHECK(warmTr < coldTr);
+}
+
+static void testState(void)
+{
+	uint64_t ready, first;
+	uint32_t transfers;
+
+	// the gain of the snapshot is used by the warm init
+	_gain = 0x20;	// TSL2591 high gain
+	boot(0x3F, 0, &ready, &first, &transfers);
+	CHECK_EQ(ambient_GetGain(), 0x20);
+	CHECK(tempHum_Is(&hi2c2, 0));
+	CHECK(scd41_Is(&hi2c2, 0));
+	CHECK(sps30_Is(&hi2c2, 0));
+
+	// the sensor removed during the reset is found absent by the warm init
+	boot(0x3F, 1 << 3, &ready, &first, &transfers);
+	CHECK(!scd41_Is(&hi2c2, 0));
+
+	// the absent sensor of the snapshot is not initialized at all
+	CHECK_EQ(boot(0x3F & ~(1 << 3), 0, &ready, &first, &transfers), 0x3F & ~(1 << 3));
+}
+
+int main(void)
+{
+	testBoot("all present", 0);
+	testBoot("scd41, sps30 absent", (1 << 3) | (1 << 4));
+	testBoot("nfc4 absent", 1 << DEV_NFC4);
+	testState();
+	return TEST_RESULT();
+}
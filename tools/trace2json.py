@@ -0,0 +1,190 @@
+#!/usr/bin/env python3
+"""
+trace2json.py - event trace of LR14-Click (console command "trace") to Chrome/Perfetto trace JSON
+
+usage: trace2json.py capture.log [-o trace.json] [--all]
+    capture.log - log of the UART, the lines "trace: ..." and "TRC ..." are used, others are skipped
+    --all       - all dumps of the log (default: the last one)
+
+The result is opened by https://ui.perfetto.dev or chrome://tracing.
+The time of events is the cycle counter of the core, it is tied to RTC by SYNC + RTC events
+(boot, after STOP2) and to the clock by CLOCK events (clock profiles). Events before the first
+SYNC of the dump are skipped (the ring has been overwritten).
+
+The names follow Core/Inc/trace.h, Core/Inc/utilities_def.h and the sensor registry (mysensors.c).
+"""
+
+import argparse
+import json
+import re
+import sys
+
+# traceType_t (trace.h)
+EV_BEGIN, EV_END, EV_INSTANT, EV_SYNC, EV_RTC, EV_CLOCK = range(6)
+
+# traceId_t (trace.h): name, track
+TASK, STOP2, SLEEP, RADIO_TX, RADIO_RX, I2C, SPI, SENSOR = range(8)
+ACTIVITIES = {
+    TASK: ("task", 1),
+    STOP2: ("STOP2", 2),
+    SLEEP: ("Sleep", 2),
+    RADIO_TX: ("TX", 3),
+    RADIO_RX: ("RX", 3),
+    I2C: ("I2C", 4),
+    SPI: ("SPI", 5),
+    SENSOR: ("sensor", 10),     # track 10 + sensor, the readings overlap
+}
+TRACKS = {1: "sequencer", 2: "low power", 3: "radio", 4: "I2C", 5: "SPI"}
+
+# CFG_SEQ_Task_Id_t (utilities_def.h)
+TASKS = ["LmHandlerProcess", "LoRaSendOnTxTimerOrButtonEvent", "LoRaStoreContextEvent", "LoRaStopJoinEvent",
+         "Sensors", "Uart_RX", "NFC_INT", "LoRaJoinRetry", "TimeSync"]
+# sensId_t, SENS_DEV_FLASH, SENS_DEV_NFC4 (mysensors.c)
+DEVICES = ["tempHum23", "ambient21", "barometer8", "scd41", "sps30", "flash12", "nfc4"]
+
+HEADER = re.compile(r"trace: (\d+) events, lost (\d+), rtc (\d+) Hz")
+EVENT = re.compile(r"\b([0-9A-F]{16})\b")
+
+
+def read_dumps(lines):
+    """dumps of the log: [(rtcHz, lost, [(time, id, type, arg)])]"""
+    dumps = []
+    cur = None
+    for line in lines:
+        m = HEADER.search(line)
+        if m:
+            cur = (int(m.group(3)), int(m.group(2)), [])
+            dumps.append(cur)
+            continue
+        if cur is None or "TRC " not in line:
+            continue
+        for h in EVENT.findall(line[line.index("TRC "):]):
+            cur[2].append((int(h[0:8], 16), int(h[8:12], 16), int(h[12:14], 16), int(h[14:16], 16)))
+    return dumps
+
+
+def name_of(ident, arg):
+    name, track = ACTIVITIES.get(ident, ("id%d" % ident, 6))
+    if ident == TASK:
+        return (TASKS[arg] if arg < len(TASKS) else "task%d" % arg), track
+    if ident in (I2C, SPI):
+        return (DEVICES[arg] if arg < len(DEVICES) else "dev%d" % arg), track
+    if ident == SENSOR:
+        return (DEVICES[arg] if arg < len(DEVICES) else "sensor%d" % arg), track + arg
+    return name, track
+
+
+class Timeline:
+    """cycle counter to us: absolute cycles since the last SYNC/CLOCK, clock of the segment"""
+
+    def __init__(self, rtc_hz):
+        self.rtc_hz = rtc_hz
+        self.khz = None
+        self.base_us = 0.0
+        self.cycles = 0         # cycles since the base
+        self.last = 0           # last counter value
+        self.sync = None        # (counter, kHz) of SYNC waiting for RTC
+        self.last_us = 0.0
+
+    def advance(self, counter):
+        self.cycles += (counter - self.last) & 0xFFFFFFFF    # the counter wraps in 89 s at 48 MHz
+        self.last = counter
+
+    def now(self):
+        t = self.base_us + self.cycles * 1000.0 / self.khz
+        self.last_us = max(t, self.last_us)     # RTC resolution of SYNC
+        return self.last_us
+
+    def rebase(self, us, counter, khz):
+        self.base_us = us
+        self.cycles = 0
+        self.last = counter
+        self.khz = khz
+
+
+def convert(dumps, pid_base=1):
+    out = []
+    stats = {}
+    skipped = 0
+    for n, (rtc_hz, lost, events) in enumerate(dumps):
+        pid = pid_base + n
+        tl = Timeline(rtc_hz)
+        stacks = {}
+        used_tracks = set()
+        for (time, ident, typ, arg) in events:
+            if typ == EV_SYNC:
+                tl.sync = (time, ident)
+                continue
+            if typ == EV_RTC:
+                if tl.sync is not None:
+                    tl.rebase(time * 1e6 / rtc_hz, tl.sync[0], tl.sync[1])
+                    out.append({"name": "clock", "ph": "C", "ts": tl.now(), "pid": pid, "args": {"MHz": tl.khz / 1000}})
+                tl.sync = None
+                continue
+            if tl.khz is None:
+                skipped += 1
+                continue
+            tl.advance(time)
+            if typ == EV_CLOCK:
+                tl.rebase(tl.now(), time, ident)
+                out.append({"name": "clock", "ph": "C", "ts": tl.now(), "pid": pid, "args": {"MHz": ident / 1000}})
+                continue
+            ts = tl.now()
+            name, tid = name_of(ident, arg)
+            used_tracks.add(tid)
+            if typ == EV_BEGIN:
+                stacks.setdefault(tid, []).append((name, ts))
+                out.append({"name": name, "cat": ACTIVITIES.get(ident, ("?",))[0], "ph": "B", "ts": ts, "pid": pid, "tid": tid})
+            elif typ == EV_END:
+                st = stacks.get(tid)
+                if not st:
+                    skipped += 1    # begin has been overwritten
+                    continue
+                bname, bts = st.pop()
+                out.append({"name": bname, "ph": "E", "ts": ts, "pid": pid, "tid": tid})
+                cat = ACTIVITIES.get(ident, ("?",))[0]
+                s = stats.setdefault(bname if cat == bname else cat + " " + bname, [0, 0.0])
+                s[0] += 1
+                s[1] += ts - bts
+            elif typ == EV_INSTANT:
+                out.append({"name": name, "ph": "i", "s": "t", "ts": ts, "pid": pid, "tid": tid, "args": {"arg": arg}})
+        # open activities are closed at the end of the dump
+        for tid, st in stacks.items():
+            while st:
+                bname, bts = st.pop()
+                out.append({"name": bname, "ph": "E", "ts": tl.last_us, "pid": pid, "tid": tid})
+        out.append({"name": "process_name", "ph": "M", "pid": pid, "args": {"name": "LR14-Click dump %d (lost %d)" % (n + 1, lost)}})
+        for tid in sorted(used_tracks):
+            tname = TRACKS.get(tid) or ("sensor " + (DEVICES[tid - 10] if 0 <= tid - 10 < len(DEVICES) else str(tid)))
+            out.append({"name": "thread_name", "ph": "M", "pid": pid, "tid": tid, "args": {"name": tname}})
+            out.append({"name": "thread_sort_index", "ph": "M", "pid": pid, "tid": tid, "args": {"sort_index": tid}})
+    return out, stats, skipped
+
+
+def main():
+    ap = argparse.ArgumentParser(description="LR14-Click event trace to Chrome/Perfetto JSON")
+    ap.add_argument("log")
+    ap.add_argument("-o", "--output", default=None, help="JSON file (default: log name + .json)")
+    ap.add_argument("--all", action="store_true", help="all dumps of the log")
+    a = ap.parse_args()
+
+    with open(a.log, errors="replace") as f:
+        dumps = read_dumps(f)
+    if not dumps:
+        sys.exit("no trace dump in %s" % a.log)
+    if not a.all:
+        dumps = dumps[-1:]
+    events, stats, skipped = convert(dumps)
+    output = a.output or a.log + ".json"
+    with open(output, "w") as f:
+        json.dump({"traceEvents": events, "displayTimeUnit": "ms"}, f)
+
+    span = [e["ts"] for e in events if "ts" in e]
+    total = (max(span) - min(span)) if span else 0
+    print("%s: %d events, %d skipped, %.3f s" % (output, sum(len(d[2]) for d in dumps), skipped, total / 1e6))
+    for name, (count, us) in sorted(stats.items(), key=lambda x: -x[1][1]):
+        print("  %-32s %6d x %12.1f us %6.2f %%" % (name, count, us, 100.0 * us / total if total else 0))
+
+
+if __name__ == "__main__":
+    main()